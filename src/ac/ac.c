@@ -4,6 +4,11 @@
 #include "capwap_dtls.h"
 #include "capwap_socket.h"
 #include "ac_wlans.h"
+#include "ac_authcache.h"
+#include "ac_profile.h"
+#include "ac_batch.h"
+#include "ac_health.h"
+#include "ac_xdp.h"
 
 #include <libconfig.h>
 
@@ -108,6 +113,35 @@ static int ac_init(void) {
 	g_ac.dfa.decrypterrorreport_interval = AC_DECRYPT_ERROR_PERIOD_INTERVAL / 1000;
 	g_ac.dfa.idletimeout.timeout = AC_IDLE_TIMEOUT_INTERVAL / 1000;
 	g_ac.dfa.wtpfallback.mode = AC_WTP_FALLBACK_MODE;
+	g_ac.dfa.retransmit.initial = AC_RETRANSMIT_INTERVAL;
+	g_ac.dfa.retransmit.min = AC_MIN_RETRANSMIT_INTERVAL;
+	g_ac.dfa.retransmit.max = AC_MAX_RETRANSMIT_INTERVAL;
+	g_ac.dfa.retransmit.count = AC_MAX_RETRANSMIT;
+
+	/* */
+	g_ac.provisioning.window = AC_PROVISIONING_WINDOW;
+	g_ac.provisioning.rate = AC_PROVISIONING_RATE;
+	g_ac.provisioning.timeout = AC_PROVISIONING_TIMEOUT;
+	g_ac.authorization.cachesize = AC_AUTHORIZATION_CACHE_SIZE;
+	g_ac.authorization.negativettl = AC_AUTHORIZATION_NEGATIVE_TTL;
+	g_ac.profile.cachesize = AC_PROFILE_CACHE_SIZE;
+	g_ac.batch.size = AC_BATCH_SIZE;
+	g_ac.batch.interval = AC_BATCH_INTERVAL;
+	g_ac.health.sessiondeadline = AC_HEALTH_SESSION_DEADLINE;
+	g_ac.health.stationdeadline = AC_HEALTH_STATION_DEADLINE;
+	g_ac.health.eventdeadline = AC_HEALTH_EVENT_DEADLINE;
+	g_ac.health.controldeadline = AC_HEALTH_CONTROL_DEADLINE;
+	g_ac.health.window = AC_HEALTH_WINDOW;
+	g_ac.health.minimumcalls = AC_HEALTH_MINIMUM_CALLS;
+	g_ac.health.errorrate = AC_HEALTH_ERROR_RATE;
+	g_ac.health.slowrate = AC_HEALTH_SLOW_RATE;
+	g_ac.health.slowlatency = AC_HEALTH_SLOW_LATENCY;
+	g_ac.health.opentime = AC_HEALTH_OPEN_TIME;
+	g_ac.health.probeinterval = AC_HEALTH_PROBE_INTERVAL;
+	g_ac.health.probesuccess = AC_HEALTH_PROBE_SUCCESS;
+	g_ac.health.loginterval = AC_HEALTH_LOG_INTERVAL;
+	g_ac.health.keeprunning = 1;
+	g_ac.health.datachannel = -1;
 
 	/* */
 	g_ac.dfa.acipv4list.addresses = capwap_array_create(sizeof(struct in_addr), 0, 0);
@@ -125,6 +159,10 @@ static int ac_init(void) {
 	g_ac.authstations->item_cmp = ac_stations_item_cmp;
 
 	capwap_rwlock_init(&g_ac.authstationslock);
+	ac_authcache_init();
+
+	/* WTP profiles */
+	ac_profile_init();
 
 	/* Data Channel Interfaces */
 	g_ac.ifdatachannel = capwap_hash_create(AC_IFDATACHANNEL_HASH_SIZE);
@@ -182,6 +220,13 @@ static void ac_destroy(void) {
 	capwap_hash_free(g_ac.authstations);
 	capwap_rwlock_destroy(&g_ac.authstationslock);
 
+	ac_authcache_log();
+	ac_authcache_free();
+
+	/* WTP profiles */
+	ac_profile_log();
+	ac_profile_free();
+
 	/* Backend */
 	if (g_ac.backendacid) {
 		capwap_free(g_ac.backendacid);
@@ -191,6 +236,11 @@ static void ac_destroy(void) {
 		capwap_free(g_ac.backendversion);
 	}
 
+	/* XDP */
+	if (g_ac.xdp.object) {
+		capwap_free(g_ac.xdp.object);
+	}
+
 	for (i = 0; i < g_ac.availablebackends->count; i++) {
 		ac_soapclient_free_server(*(struct ac_http_soap_server**)capwap_array_get_item_pointer(g_ac.availablebackends, i));
 	}
@@ -207,6 +257,8 @@ static void ac_print_usage(void) {
 static int ac_parsing_configuration_1_0(config_t* config) {
 	int i;
 	int configBool;
+	int keepalivemaxconnections = SOAP_KEEPALIVE_MAX_CONNECTIONS;
+	int keepaliveidletimeout = SOAP_KEEPALIVE_IDLE_TIMEOUT;
 	LIBCONFIG_LOOKUP_INT_ARG configInt;
 	const char* configString;
 	config_setting_t* configSetting;
@@ -462,6 +514,48 @@ static int ac_parsing_configuration_1_0(config_t* config) {
 		}
 	}
 
+	/* Set retransmission timer of AC */
+	if (config_lookup_int(config, "application.timer.retransmit.initial", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.dfa.retransmit.initial = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid application.timer.retransmit.initial value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "application.timer.retransmit.min", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.dfa.retransmit.min = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid application.timer.retransmit.min value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "application.timer.retransmit.max", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.dfa.retransmit.max = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid application.timer.retransmit.max value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "application.timer.retransmit.count", &configInt) == CONFIG_TRUE) {
+		if ((configInt > 0) && (configInt < 256)) {
+			g_ac.dfa.retransmit.count = configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid application.timer.retransmit.count value");
+			return 0;
+		}
+	}
+
+	if ((g_ac.dfa.retransmit.min > g_ac.dfa.retransmit.initial) || (g_ac.dfa.retransmit.initial > g_ac.dfa.retransmit.max)) {
+		capwap_logging_error("Invalid configuration file, application.timer.retransmit values must be min <= initial <= max");
+		return 0;
+	}
+
 	/* Set wtpfallback of AC */
 	if (config_lookup_bool(config, "application.wtpfallback", &configBool) == CONFIG_TRUE) {
 		g_ac.dfa.wtpfallback.mode = ((configBool != 0) ? CAPWAP_WTP_FALLBACK_ENABLED : CAPWAP_WTP_FALLBACK_DISABLED);
@@ -605,6 +699,54 @@ static int ac_parsing_configuration_1_0(config_t* config) {
 		}
 	}
 
+	/* Set XDP fast path of data channel */
+	if (config_lookup_string(config, "application.network.xdp.interface", &configString) == CONFIG_TRUE) {
+		if (strlen(configString) > (IFNAMSIZ - 1)) {
+			capwap_logging_error("Invalid configuration file, application.network.xdp.interface string length exceeded");
+			return 0;
+		}
+
+		strcpy(g_ac.xdp.interface, configString);
+	}
+
+	if (config_lookup_string(config, "application.network.xdp.uplink", &configString) == CONFIG_TRUE) {
+		if (strlen(configString) > (IFNAMSIZ - 1)) {
+			capwap_logging_error("Invalid configuration file, application.network.xdp.uplink string length exceeded");
+			return 0;
+		}
+
+		strcpy(g_ac.xdp.uplink, configString);
+	}
+
+	if (config_lookup_string(config, "application.network.xdp.mode", &configString) == CONFIG_TRUE) {
+		if (!strcmp(configString, "native")) {
+			g_ac.xdp.generic = 0;
+		} else if (!strcmp(configString, "generic")) {
+			g_ac.xdp.generic = 1;
+		} else {
+			capwap_logging_error("Invalid configuration file, unknown application.network.xdp.mode value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_string(config, "application.network.xdp.object", &configString) == CONFIG_TRUE) {
+		if (strlen(configString) > 0) {
+			g_ac.xdp.object = capwap_duplicate_string(configString);
+		}
+	}
+
+	if (g_ac.xdp.interface[0]) {
+#ifdef ENABLE_XDP
+		if (!g_ac.xdp.uplink[0]) {
+			capwap_logging_error("Invalid configuration file, application.network.xdp.uplink is required by XDP fast path");
+			return 0;
+		}
+#else
+		capwap_logging_warning("XDP fast path of data channel is not supported, application.network.xdp is ignored");
+		g_ac.xdp.interface[0] = 0;
+#endif
+	}
+
 	/* Backend */
 	if (config_lookup_string(config, "backend.id", &configString) == CONFIG_TRUE) {
 		if (strlen(configString) > 0) {
@@ -618,6 +760,236 @@ static int ac_parsing_configuration_1_0(config_t* config) {
 		}
 	}
 
+	/* Set bulk WLAN provisioning of AC */
+	if (config_lookup_int(config, "backend.provisioning.window", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.provisioning.window = (unsigned long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.provisioning.window value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.provisioning.rate", &configInt) == CONFIG_TRUE) {
+		if ((configInt > 0) && (configInt <= 1000)) {
+			g_ac.provisioning.rate = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.provisioning.rate value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.provisioning.timeout", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.provisioning.timeout = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.provisioning.timeout value");
+			return 0;
+		}
+	}
+
+	/* Set station authorization cache of AC */
+	if (config_lookup_int(config, "backend.authorization.cachesize", &configInt) == CONFIG_TRUE) {
+		if (configInt >= 0) {
+			g_ac.authorization.cachesize = (unsigned long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.authorization.cachesize value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.authorization.negativettl", &configInt) == CONFIG_TRUE) {
+		if (configInt >= 0) {
+			g_ac.authorization.negativettl = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.authorization.negativettl value");
+			return 0;
+		}
+	}
+
+	/* Set WTP profile cache of AC */
+	if (config_lookup_int(config, "backend.profile.cachesize", &configInt) == CONFIG_TRUE) {
+		if (configInt >= 0) {
+			g_ac.profile.cachesize = (unsigned long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.profile.cachesize value");
+			return 0;
+		}
+	}
+
+	/* Set batching of backend requests */
+	if (config_lookup_int(config, "backend.batch.size", &configInt) == CONFIG_TRUE) {
+		if ((configInt >= 0) && (configInt <= AC_BATCH_MAX_SIZE)) {
+			g_ac.batch.size = (unsigned long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.batch.size value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.batch.interval", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.batch.interval = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.batch.interval value");
+			return 0;
+		}
+	}
+
+	/* Set deadline of backend requests */
+	if (config_lookup_int(config, "backend.health.deadline.session", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.health.sessiondeadline = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.deadline.session value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.health.deadline.station", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.health.stationdeadline = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.deadline.station value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.health.deadline.event", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.health.eventdeadline = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.deadline.event value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.health.deadline.control", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.health.controldeadline = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.deadline.control value");
+			return 0;
+		}
+	}
+
+	/* Set circuit breaker of backend servers */
+	if (config_lookup_int(config, "backend.health.circuitbreaker.window", &configInt) == CONFIG_TRUE) {
+		if ((configInt >= 0) && (configInt <= AC_HEALTH_MAX_WINDOW)) {
+			g_ac.health.window = (unsigned long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.circuitbreaker.window value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.health.circuitbreaker.minimumcalls", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.health.minimumcalls = (unsigned long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.circuitbreaker.minimumcalls value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.health.circuitbreaker.errorrate", &configInt) == CONFIG_TRUE) {
+		if ((configInt > 0) && (configInt <= 100)) {
+			g_ac.health.errorrate = (int)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.circuitbreaker.errorrate value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.health.circuitbreaker.slowlatency", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.health.slowlatency = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.circuitbreaker.slowlatency value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.health.circuitbreaker.slowrate", &configInt) == CONFIG_TRUE) {
+		if ((configInt > 0) && (configInt <= 100)) {
+			g_ac.health.slowrate = (int)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.circuitbreaker.slowrate value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.health.circuitbreaker.opentime", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.health.opentime = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.circuitbreaker.opentime value");
+			return 0;
+		}
+	}
+
+	/* Set health probe of backend servers */
+	if (config_lookup_int(config, "backend.health.probe.interval", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.health.probeinterval = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.probe.interval value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.health.probe.success", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_ac.health.probesuccess = (unsigned long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.probe.success value");
+			return 0;
+		}
+	}
+
+	/* Set periodic log of backend servers latency */
+	if (config_lookup_int(config, "backend.health.log.interval", &configInt) == CONFIG_TRUE) {
+		if (configInt >= 0) {
+			g_ac.health.loginterval = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.log.interval value");
+			return 0;
+		}
+	}
+
+	/* Set local policy while backend servers are unavailable */
+	if (config_lookup_bool(config, "backend.health.degraded.keeprunning", &configBool) == CONFIG_TRUE) {
+		g_ac.health.keeprunning = ((configBool != 0) ? 1 : 0);
+	}
+
+	if (config_lookup_int(config, "backend.health.degraded.datachannel", &configInt) == CONFIG_TRUE) {
+		if (configInt >= -1) {
+			g_ac.health.datachannel = (int)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.health.degraded.datachannel value");
+			return 0;
+		}
+	}
+
+	/* Set keep-alive connections of backend */
+	if (config_lookup_int(config, "backend.keepalive.maxconnections", &configInt) == CONFIG_TRUE) {
+		if (configInt >= 0) {
+			keepalivemaxconnections = (int)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.keepalive.maxconnections value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "backend.keepalive.idletimeout", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			keepaliveidletimeout = (int)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid backend.keepalive.idletimeout value");
+			return 0;
+		}
+	}
+
 	configSetting = config_lookup(config, "backend.server");
 	if (configSetting) {
 		int count = config_setting_length(configSetting);
@@ -637,6 +1009,22 @@ static int ac_parsing_configuration_1_0(config_t* config) {
 						return 0;
 					}
 
+					/* Keep-alive params */
+					ac_soapclient_keepalive_server(server, keepalivemaxconnections, keepaliveidletimeout);
+
+					/* Backend transport */
+					if (config_setting_lookup_string(configServer, "transport", &configString) == CONFIG_TRUE) {
+						if (!strcmp(configString, "soap")) {
+							server->transport = SOAP_TRANSPORT_XML;
+						} else if (!strcmp(configString, "json")) {
+							server->transport = SOAP_TRANSPORT_JSON;
+						} else {
+							capwap_logging_error("Invalid configuration file, unknown backend.server.transport value");
+							ac_soapclient_free_server(server);
+							return 0;
+						}
+					}
+
 					/* HTTPS params */
 					if (server->protocol == SOAP_HTTPS_PROTOCOL) {
 						char* calist = NULL;
@@ -864,8 +1252,16 @@ int main(int argc, char** argv) {
 				if (!ac_kmod_createdatachannel(g_ac.net.localaddr.ss.ss_family, CAPWAP_GET_NETWORK_PORT(&g_ac.net.localaddr) + 1)) {
 					capwap_logging_info("SmartCAPWAP kernel module connected");
 
+					/* The data packets not handled by XDP fast path are received by kernel module */
+					if (ac_xdp_init(CAPWAP_GET_NETWORK_PORT(&g_ac.net.localaddr) + 1)) {
+						capwap_logging_warning("Unable to enable XDP fast path of data channel");
+					}
+
 					/* Running AC */
 					result = ac_execute();
+
+					/* */
+					ac_xdp_free();
 				} else {
 					capwap_logging_fatal("Unable to create kernel data channel");
 				}
@@ -41,14 +41,46 @@
 
 #define AC_DATA_CHECK_INTERVAL						30000
 
+#define AC_MIN_RETRANSMIT_INTERVAL					1000
 #define AC_RETRANSMIT_INTERVAL						3000
+#define AC_MAX_RETRANSMIT_INTERVAL					60000
 #define AC_MAX_RETRANSMIT							5
 
 #define AC_DTLS_SESSION_DELETE_INTERVAL				5000
 
+#define AC_STATION_CONFIGURATION_BATCH_SIZE			16
+#define AC_STATION_CONFIGURATION_BATCH_INTERVAL		100
+
+#define AC_PROVISIONING_WINDOW						32
+#define AC_PROVISIONING_RATE						50
+#define AC_PROVISIONING_TIMEOUT						60000
+
+#define AC_AUTHORIZATION_CACHE_SIZE					4096
+#define AC_AUTHORIZATION_NEGATIVE_TTL				10000
+
+#define AC_PROFILE_CACHE_SIZE						64
+
+#define AC_BATCH_SIZE								0
+#define AC_BATCH_INTERVAL							20
+
+#define AC_HEALTH_SESSION_DEADLINE					5000
+#define AC_HEALTH_STATION_DEADLINE					2000
+#define AC_HEALTH_EVENT_DEADLINE					5000
+#define AC_HEALTH_CONTROL_DEADLINE					10000
+#define AC_HEALTH_WINDOW							20
+#define AC_HEALTH_MINIMUM_CALLS						10
+#define AC_HEALTH_ERROR_RATE						50
+#define AC_HEALTH_SLOW_LATENCY						2000
+#define AC_HEALTH_SLOW_RATE							80
+#define AC_HEALTH_OPEN_TIME							10000
+#define AC_HEALTH_PROBE_INTERVAL					2000
+#define AC_HEALTH_PROBE_SUCCESS						3
+#define AC_HEALTH_LOG_INTERVAL						300000
+
 #define AC_MIN_ECHO_INTERVAL						1000
 #define AC_ECHO_INTERVAL							30000
 #define AC_MAX_ECHO_INTERVAL						256000
+#define AC_ECHO_CHECK_SESSION_INTERVAL				120000
 
 #define AC_MAX_DATA_KEEPALIVE_INTERVAL				256000
 
@@ -79,6 +111,73 @@ struct ac_if_datachannel {
 	char bridge[IFNAMSIZ];
 };
 
+/* Retransmission timer bounds in ms */
+struct ac_retransmit_timer {
+	long initial;
+	long min;
+	long max;
+	int count;
+};
+
+/* Bulk WLAN provisioning rollout */
+struct ac_provisioning_param {
+	unsigned long window;
+	long rate;
+	long timeout;
+};
+
+/* Join and configuration responses shared by WTP profile */
+struct ac_profile_param {
+	unsigned long cachesize;
+};
+
+/* Cross-session batching of backend requests */
+struct ac_batch_param {
+	unsigned long size;
+	long interval;
+};
+
+/* Station authorization cache */
+struct ac_authorization_param {
+	unsigned long cachesize;
+	long negativettl;
+};
+
+/* XDP fast path of data channel */
+struct ac_xdp_param {
+	char interface[IFNAMSIZ];
+	char uplink[IFNAMSIZ];
+	int generic;
+	char* object;
+};
+
+/* Deadlines, circuit breaker and degraded policy of backend servers */
+struct ac_health_param {
+	long sessiondeadline;
+	long stationdeadline;
+	long eventdeadline;
+	long controldeadline;
+
+	/* Circuit breaker */
+	unsigned long window;
+	unsigned long minimumcalls;
+	int errorrate;
+	int slowrate;
+	long slowlatency;
+	long opentime;
+
+	/* Health probe */
+	long probeinterval;
+	unsigned long probesuccess;
+
+	/* Periodic log of latency percentiles, 0 only at shutdown */
+	long loginterval;
+
+	/* Degraded local policy */
+	int keeprunning;
+	int datachannel;
+};
+
 /* */
 struct ac_state {
 	struct capwap_ecnsupport_element ecn;
@@ -87,6 +186,7 @@ struct ac_state {
 	unsigned short decrypterrorreport_interval;
 	struct capwap_idletimeout_element idletimeout;
 	struct capwap_wtpfallback_element wtpfallback;
+	struct ac_retransmit_timer retransmit;
 	
 	/* */
 	struct capwap_acipv4list_element acipv4list;
@@ -129,6 +229,7 @@ struct ac_t {
 
 	/* Kernel module */
 	struct ac_kmod_handle kmodhandle;
+	struct ac_xdp_param xdp;
 
 	/* Sessions */
 	struct capwap_list* sessions;
@@ -151,6 +252,21 @@ struct ac_t {
 	char* backendacid;
 	char* backendversion;
 	struct capwap_array* availablebackends;
+
+	/* Bulk WLAN provisioning */
+	struct ac_provisioning_param provisioning;
+
+	/* Station authorization cache */
+	struct ac_authorization_param authorization;
+
+	/* WTP profile cache */
+	struct ac_profile_param profile;
+
+	/* Batching of backend requests */
+	struct ac_batch_param batch;
+
+	/* Health of backend servers */
+	struct ac_health_param health;
 };
 
 /* AC session thread */
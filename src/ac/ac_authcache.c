@@ -0,0 +1,329 @@
+#include "ac.h"
+#include "ieee80211.h"
+#include "ac_authcache.h"
+
+/* Station authorization key */
+struct ac_authcache_key {
+	uint8_t address[MACADDRESS_EUI48_LENGTH];
+	char ssid[IEEE80211_SSID_MAX_LENGTH + 1];
+	char* group;
+};
+
+/* Decision of backend server for a station */
+struct ac_authcache_entry {
+	struct ac_authcache_key key;
+	struct capwap_list_item* lruitem;
+
+	int authorized;
+	char* json;
+	struct timeval expire;
+};
+
+/* */
+struct ac_authcache_t {
+	capwap_lock_t lock;
+	struct capwap_hash* entries;
+	struct capwap_list* lru;				/* Most recently used at head */
+
+	struct ac_authcache_stats stats;
+};
+
+/* */
+struct ac_authcache_invalidate_param {
+	const uint8_t* address;
+	const char* ssid;
+	const char* group;
+	unsigned long count;
+};
+
+static struct ac_authcache_t g_ac_authcache;
+
+/* Jenkins one-at-a-time hash */
+static uint32_t ac_authcache_hash_update(uint32_t hash, const uint8_t* data, size_t length) {
+	while (length-- > 0) {
+		hash += *data++;
+		hash += (hash << 10);
+		hash ^= (hash >> 6);
+	}
+
+	return hash;
+}
+
+/* */
+static unsigned long ac_authcache_item_gethash(const void* key, unsigned long hashsize) {
+	uint32_t hash;
+	const struct ac_authcache_key* authkey = (const struct ac_authcache_key*)key;
+
+	/* Hash of the whole key, MAC, SSID and group. The terminating NUL separate SSID from group */
+	hash = ac_authcache_hash_update(0, authkey->address, MACADDRESS_EUI48_LENGTH);
+	hash = ac_authcache_hash_update(hash, (const uint8_t*)authkey->ssid, strlen(authkey->ssid) + 1);
+	hash = ac_authcache_hash_update(hash, (const uint8_t*)authkey->group, strlen(authkey->group) + 1);
+
+	hash += (hash << 3);
+	hash ^= (hash >> 11);
+	hash += (hash << 15);
+
+	return (hash % hashsize);
+}
+
+/* */
+static const void* ac_authcache_item_getkey(const void* data) {
+	return (const void*)&((struct ac_authcache_entry*)data)->key;
+}
+
+/* */
+static int ac_authcache_item_cmp(const void* key1, const void* key2) {
+	int result;
+	const struct ac_authcache_key* authkey1 = (const struct ac_authcache_key*)key1;
+	const struct ac_authcache_key* authkey2 = (const struct ac_authcache_key*)key2;
+
+	result = memcmp(authkey1->address, authkey2->address, MACADDRESS_EUI48_LENGTH);
+	if (!result) {
+		result = strcmp(authkey1->ssid, authkey2->ssid);
+		if (!result) {
+			result = strcmp(authkey1->group, authkey2->group);
+		}
+	}
+
+	return result;
+}
+
+/* */
+static void ac_authcache_item_free(void* data) {
+	struct ac_authcache_entry* entry = (struct ac_authcache_entry*)data;
+
+	/* Remove from LRU list, the entry is the item of list */
+	capwap_itemlist_remove(g_ac_authcache.lru, entry->lruitem);
+
+	capwap_free(entry->key.group);
+	if (entry->json) {
+		capwap_free(entry->json);
+	}
+
+	capwap_itemlist_free(entry->lruitem);
+}
+
+/* */
+static int ac_authcache_set_key(struct ac_authcache_key* key, const uint8_t* address, const char* ssid, const char* group) {
+	if (strlen(ssid) > IEEE80211_SSID_MAX_LENGTH) {
+		return 0;
+	}
+
+	memcpy(key->address, address, MACADDRESS_EUI48_LENGTH);
+	strcpy(key->ssid, ssid);
+	key->group = (char*)group;
+
+	return 1;
+}
+
+/* */
+static int ac_authcache_is_expired(struct ac_authcache_entry* entry, struct timeval* now) {
+	return ((now->tv_sec > entry->expire.tv_sec) || ((now->tv_sec == entry->expire.tv_sec) && (now->tv_usec >= entry->expire.tv_usec)));
+}
+
+/* */
+void ac_authcache_init(void) {
+	memset(&g_ac_authcache, 0, sizeof(struct ac_authcache_t));
+
+	/* */
+	capwap_lock_init(&g_ac_authcache.lock);
+	g_ac_authcache.lru = capwap_list_create();
+
+	/* */
+	g_ac_authcache.entries = capwap_hash_create(AC_AUTHCACHE_HASH_SIZE);
+	g_ac_authcache.entries->item_gethash = ac_authcache_item_gethash;
+	g_ac_authcache.entries->item_getkey = ac_authcache_item_getkey;
+	g_ac_authcache.entries->item_cmp = ac_authcache_item_cmp;
+	g_ac_authcache.entries->item_free = ac_authcache_item_free;
+}
+
+/* */
+void ac_authcache_free(void) {
+	capwap_hash_free(g_ac_authcache.entries);
+
+	ASSERT(g_ac_authcache.lru->count == 0);
+	capwap_list_free(g_ac_authcache.lru);
+	capwap_lock_destroy(&g_ac_authcache.lock);
+}
+
+/* */
+int ac_authcache_search(const uint8_t* address, const char* ssid, const char* group, struct json_object** jsonroot) {
+	int result = AC_AUTHCACHE_MISS;
+	char* json = NULL;
+	struct timeval now;
+	struct ac_authcache_key key;
+	struct ac_authcache_entry* entry;
+
+	ASSERT(address != NULL);
+	ASSERT(ssid != NULL);
+	ASSERT(group != NULL);
+	ASSERT(jsonroot != NULL);
+
+	/* */
+	*jsonroot = NULL;
+	if (!g_ac.authorization.cachesize || !ac_authcache_set_key(&key, address, ssid, group)) {
+		return AC_AUTHCACHE_MISS;
+	}
+
+	/* */
+	gettimeofday(&now, NULL);
+	capwap_lock_enter(&g_ac_authcache.lock);
+
+	entry = (struct ac_authcache_entry*)capwap_hash_search(g_ac_authcache.entries, &key);
+	if (entry && ac_authcache_is_expired(entry, &now)) {
+		g_ac_authcache.stats.expired++;
+		capwap_hash_delete(g_ac_authcache.entries, &key);
+		entry = NULL;
+	}
+
+	if (entry) {
+		g_ac_authcache.stats.hits++;
+		result = entry->authorized;
+		if (entry->json) {
+			json = capwap_duplicate_string(entry->json);
+		}
+
+		/* Move to head of LRU list */
+		capwap_itemlist_remove(g_ac_authcache.lru, entry->lruitem);
+		capwap_itemlist_insert_before(g_ac_authcache.lru, NULL, entry->lruitem);
+	} else {
+		g_ac_authcache.stats.misses++;
+	}
+
+	capwap_lock_exit(&g_ac_authcache.lock);
+
+	/* Rebuild backend response out of critical section */
+	if (json) {
+		*jsonroot = json_tokener_parse(json);
+		capwap_free(json);
+
+		if (!*jsonroot) {
+			result = AC_AUTHCACHE_MISS;
+		}
+	} else if (result == AC_AUTHCACHE_AUTHORIZED) {
+		result = AC_AUTHCACHE_MISS;
+	}
+
+	return result;
+}
+
+/* */
+void ac_authcache_add(const uint8_t* address, const char* ssid, const char* group, struct json_object* jsonroot, int authorized, long ttl) {
+	struct ac_authcache_key key;
+	struct ac_authcache_entry* entry;
+	struct capwap_list_item* itemlist;
+
+	ASSERT(address != NULL);
+	ASSERT(ssid != NULL);
+	ASSERT(group != NULL);
+
+	/* */
+	if (!g_ac.authorization.cachesize || (ttl <= 0) || (authorized && !jsonroot) || !ac_authcache_set_key(&key, address, ssid, group)) {
+		return;
+	}
+
+	/* Entry is allocated as item of LRU list */
+	itemlist = capwap_itemlist_create(sizeof(struct ac_authcache_entry));
+	entry = (struct ac_authcache_entry*)itemlist->item;
+	memset(entry, 0, sizeof(struct ac_authcache_entry));
+
+	memcpy(&entry->key, &key, sizeof(struct ac_authcache_key));
+	entry->key.group = capwap_duplicate_string(group);
+	entry->lruitem = itemlist;
+	entry->authorized = (authorized ? AC_AUTHCACHE_AUTHORIZED : AC_AUTHCACHE_DENIED);
+	if (authorized) {
+		entry->json = capwap_duplicate_string(json_object_to_json_string(jsonroot));
+	}
+
+	gettimeofday(&entry->expire, NULL);
+	entry->expire.tv_sec += ttl / 1000;
+	entry->expire.tv_usec += (ttl % 1000) * 1000;
+	if (entry->expire.tv_usec >= 1000000) {
+		entry->expire.tv_sec++;
+		entry->expire.tv_usec -= 1000000;
+	}
+
+	/* */
+	capwap_lock_enter(&g_ac_authcache.lock);
+
+	/* Replace the old decision */
+	capwap_hash_delete(g_ac_authcache.entries, &entry->key);
+	capwap_hash_add(g_ac_authcache.entries, (void*)entry);
+	capwap_itemlist_insert_before(g_ac_authcache.lru, NULL, itemlist);
+
+	/* Evict the least recently used decisions */
+	while (g_ac_authcache.lru->count > g_ac.authorization.cachesize) {
+		struct ac_authcache_entry* last = (struct ac_authcache_entry*)g_ac_authcache.lru->last->item;
+
+		g_ac_authcache.stats.evictions++;
+		capwap_hash_delete(g_ac_authcache.entries, &last->key);
+	}
+
+	capwap_lock_exit(&g_ac_authcache.lock);
+}
+
+/* */
+static int ac_authcache_invalidate_item(void* data, void* param) {
+	struct ac_authcache_entry* entry = (struct ac_authcache_entry*)data;
+	struct ac_authcache_invalidate_param* invalidate = (struct ac_authcache_invalidate_param*)param;
+
+	/* NULL field is a wildcard */
+	if (invalidate->address && memcmp(entry->key.address, invalidate->address, MACADDRESS_EUI48_LENGTH)) {
+		return HASH_CONTINUE;
+	} else if (invalidate->ssid && strcmp(entry->key.ssid, invalidate->ssid)) {
+		return HASH_CONTINUE;
+	} else if (invalidate->group && strcmp(entry->key.group, invalidate->group)) {
+		return HASH_CONTINUE;
+	}
+
+	invalidate->count++;
+	return HASH_DELETE_AND_CONTINUE;
+}
+
+/* */
+unsigned long ac_authcache_invalidate(const uint8_t* address, const char* ssid, const char* group) {
+	struct ac_authcache_invalidate_param invalidate;
+
+	/* */
+	invalidate.address = address;
+	invalidate.ssid = ssid;
+	invalidate.group = group;
+	invalidate.count = 0;
+
+	/* */
+	capwap_lock_enter(&g_ac_authcache.lock);
+
+	if (!address && !ssid && !group) {
+		invalidate.count = g_ac_authcache.lru->count;
+		capwap_hash_deleteall(g_ac_authcache.entries);
+	} else if (g_ac_authcache.lru->count > 0) {
+		capwap_hash_foreach(g_ac_authcache.entries, ac_authcache_invalidate_item, &invalidate);
+	}
+
+	g_ac_authcache.stats.invalidations += invalidate.count;
+
+	capwap_lock_exit(&g_ac_authcache.lock);
+
+	return invalidate.count;
+}
+
+/* */
+void ac_authcache_get_stats(struct ac_authcache_stats* stats) {
+	ASSERT(stats != NULL);
+
+	capwap_lock_enter(&g_ac_authcache.lock);
+
+	memcpy(stats, &g_ac_authcache.stats, sizeof(struct ac_authcache_stats));
+	stats->count = g_ac_authcache.lru->count;
+
+	capwap_lock_exit(&g_ac_authcache.lock);
+}
+
+/* */
+void ac_authcache_log(void) {
+	struct ac_authcache_stats stats;
+
+	ac_authcache_get_stats(&stats);
+	capwap_logging_debug("Station authorization cache: %lu entries, %lu hits, %lu misses, %lu expired, %lu evictions, %lu invalidations",
+		stats.count, stats.hits, stats.misses, stats.expired, stats.evictions, stats.invalidations);
+}
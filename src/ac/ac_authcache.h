@@ -0,0 +1,35 @@
+#ifndef __AC_AUTHCACHE_HEADER__
+#define __AC_AUTHCACHE_HEADER__
+
+/* */
+#define AC_AUTHCACHE_HASH_SIZE				4096
+
+/* Result of search into station authorization cache */
+#define AC_AUTHCACHE_MISS					-1
+#define AC_AUTHCACHE_DENIED					0
+#define AC_AUTHCACHE_AUTHORIZED				1
+
+/* */
+struct ac_authcache_stats {
+	unsigned long count;
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long expired;
+	unsigned long evictions;
+	unsigned long invalidations;
+};
+
+/* */
+void ac_authcache_init(void);
+void ac_authcache_free(void);
+
+/* */
+int ac_authcache_search(const uint8_t* address, const char* ssid, const char* group, struct json_object** jsonroot);
+void ac_authcache_add(const uint8_t* address, const char* ssid, const char* group, struct json_object* jsonroot, int authorized, long ttl);
+unsigned long ac_authcache_invalidate(const uint8_t* address, const char* ssid, const char* group);
+
+/* */
+void ac_authcache_get_stats(struct ac_authcache_stats* stats);
+void ac_authcache_log(void);
+
+#endif /* __AC_AUTHCACHE_HEADER__ */
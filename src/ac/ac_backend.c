@@ -3,11 +3,17 @@
 #include "ac_backend.h"
 #include "ac_soap.h"
 #include "ac_session.h"
+#include "ac_provisioning.h"
+#include "ac_authcache.h"
+#include "ac_profile.h"
+#include "ac_health.h"
 
 /* */
 #define AC_BACKEND_WAIT_TIMEOUT							10000
 #define SOAP_PROTOCOL_RESPONSE_WAIT_EVENT_TIMEOUT		70000
 
+#define AC_BACKEND_STREAM_LINE_LENGTH					65536
+
 /* */
 struct ac_backend_t {
 	pthread_t threadid;
@@ -27,6 +33,18 @@ struct ac_backend_t {
 
 	/* Soap Request */
 	struct ac_http_soap_request* soaprequest;
+
+	/* Event stream */
+	struct ac_http_soap_request* streamrequest;
+	int streamunsupported;
+	char streambuffer[AC_BACKEND_STREAM_LINE_LENGTH];
+	int streamlength;
+
+	/* Sequence of last event processed and acknowledged, survive the change of Backend Server */
+	unsigned long eventsequence;
+	unsigned long acksequence;
+	unsigned long ackinflight;
+	struct timeval acksubmitted;
 };
 
 static struct ac_backend_t g_ac_backend;
@@ -36,6 +54,23 @@ static struct ac_http_soap_server* ac_backend_get_server(void) {
 	return *(struct ac_http_soap_server**)capwap_array_get_item_pointer(g_ac.availablebackends, g_ac_backend.activebackend);
 }
 
+/* Next Backend Server with closed circuit, otherwise in round robin */
+static void ac_backend_change_server(void) {
+	unsigned long i;
+	unsigned long count = g_ac.availablebackends->count;
+
+	for (i = 1; i <= count; i++) {
+		int index = (int)((g_ac_backend.activebackend + i) % count);
+
+		if (ac_health_isavailable(*(struct ac_http_soap_server**)capwap_array_get_item_pointer(g_ac.availablebackends, index))) {
+			g_ac_backend.activebackend = index;
+			return;
+		}
+	}
+
+	g_ac_backend.activebackend = (g_ac_backend.activebackend + 1) % count;
+}
+
 /* */
 static int ac_backend_parsing_closewtpsession_event(const char* idevent, struct json_object* jsonparams) {
 	int result = -1;
@@ -170,7 +205,7 @@ static int ac_backend_parsing_addwlan_event(const char* idevent, struct json_obj
 
 	/* Params AddWLAN Action
 		{
-			WTPID: [string],
+			WTPID: [string] | [array of string],
 			RadioID: [int],
 			WLANID: [int],
 			Capability: [int],
@@ -189,9 +224,9 @@ static int ac_backend_parsing_addwlan_event(const char* idevent, struct json_obj
 		}
 	*/
 
-	/* WTPID */
+	/* WTPID, array of WTP for bulk provisioning */
 	jsonwtpid = compat_json_object_object_get(jsonparams, "WTPID");
-	if (!jsonwtpid || (json_object_get_type(jsonwtpid) != json_type_string)) {
+	if (!jsonwtpid || ((json_object_get_type(jsonwtpid) != json_type_string) && (json_object_get_type(jsonwtpid) != json_type_array))) {
 		return -1;
 	}
 
@@ -260,6 +295,24 @@ static int ac_backend_parsing_addwlan_event(const char* idevent, struct json_obj
 	/* IE */
 	/* TODO */
 
+	/* Bulk provisioning, common WLAN message elements are encoded once */
+	if (json_object_get_type(jsonwtpid) == json_type_array) {
+		struct ac_notify_addwlan_t addwlan;
+
+		memset(&addwlan, 0, sizeof(struct ac_notify_addwlan_t));
+		addwlan.radioid = (uint8_t)json_object_get_int(jsonradioid);
+		addwlan.wlanid = (uint8_t)json_object_get_int(jsonwlanid);
+		addwlan.capability = (uint16_t)json_object_get_int(jsoncapability);
+		addwlan.qos = (uint8_t)json_object_get_int(jsonqos);
+		addwlan.authmode = (uint8_t)json_object_get_int(jsonauthtype);
+		addwlan.macmode = (uint8_t)json_object_get_int(jsonmacmode);
+		addwlan.tunnelmode = (uint8_t)json_object_get_int(jsontunnelmode);
+		addwlan.suppressssid = (uint8_t)(json_object_get_boolean(jsonhidessid) ? 1 : 0);
+		strcpy(addwlan.ssid, ssid);
+
+		return ac_provisioning_addwlan(idevent, &addwlan, jsonwtpid);
+	}
+
 	/* Get session */
 	session = ac_search_session_from_wtpid(json_object_get_string(jsonwtpid));
 	if (session) {
@@ -270,6 +323,7 @@ static int ac_backend_parsing_addwlan_event(const char* idevent, struct json_obj
 		/* Notification data */
 		length = sizeof(struct ac_notify_addwlan_t);
 		addwlan = (struct ac_notify_addwlan_t*)capwap_alloc(length);
+		memset(addwlan, 0, length);
 
 		/* */
 		addwlan->radioid = (uint8_t)json_object_get_int(jsonradioid);
@@ -301,6 +355,26 @@ static int ac_backend_parsing_addwlan_event(const char* idevent, struct json_obj
 	return result;
 }
 
+/* */
+static int ac_backend_parsing_querywlanprovisioning_event(const char* idevent, struct json_object* jsonparams) {
+	struct json_object* jsonprovisioning;
+
+	/* Params QueryWLANProvisioning Action
+		{
+			ProvisioningID: [string]
+		}
+	*/
+
+	/* ProvisioningID */
+	jsonprovisioning = compat_json_object_object_get(jsonparams, "ProvisioningID");
+	if (!jsonprovisioning || (json_object_get_type(jsonprovisioning) != json_type_string)) {
+		return -1;
+	}
+
+	/* Progress is sent with updateWLANProvisioning */
+	return ac_provisioning_query(json_object_get_string(jsonprovisioning), idevent);
+}
+
 /* */
 static int ac_backend_parsing_updatewlan_event(const char* idevent, struct json_object* jsonparams) {
 	int result = -1;
@@ -315,12 +389,98 @@ static int ac_backend_parsing_deletewlan_event(const char* idevent, struct json_
 	return result;
 }
 
+/* */
+static int ac_backend_parsing_invalidatestationauthorization_event(const char* idevent, struct json_object* jsonparams) {
+	unsigned long count;
+	const char* ssid = NULL;
+	const char* group = NULL;
+	uint8_t address[MACADDRESS_EUI48_LENGTH];
+	int hasaddress = 0;
+	struct json_object* jsonvalue;
+
+	/* Params InvalidateStationAuthorization Action, every missing param matches all stations
+		{
+			Station: [string],
+			SSID: [string],
+			AuthorizationGroup: [string]
+		}
+	*/
+
+	/* Station */
+	jsonvalue = compat_json_object_object_get(jsonparams, "Station");
+	if (jsonvalue) {
+		if ((json_object_get_type(jsonvalue) != json_type_string) || !capwap_scanf_macaddress(address, json_object_get_string(jsonvalue), MACADDRESS_EUI48_LENGTH)) {
+			return -1;
+		}
+
+		hasaddress = 1;
+	}
+
+	/* SSID */
+	jsonvalue = compat_json_object_object_get(jsonparams, "SSID");
+	if (jsonvalue) {
+		if (json_object_get_type(jsonvalue) != json_type_string) {
+			return -1;
+		}
+
+		ssid = json_object_get_string(jsonvalue);
+	}
+
+	/* AuthorizationGroup */
+	jsonvalue = compat_json_object_object_get(jsonparams, "AuthorizationGroup");
+	if (jsonvalue) {
+		if (json_object_get_type(jsonvalue) != json_type_string) {
+			return -1;
+		}
+
+		group = json_object_get_string(jsonvalue);
+	}
+
+	/* */
+	count = ac_authcache_invalidate((hasaddress ? address : NULL), ssid, group);
+	capwap_logging_debug("Invalidate %lu station authorizations", count);
+	ac_authcache_log();
+
+	return 0;
+}
+
+/* */
+static int ac_backend_parsing_invalidateprofile_event(const char* idevent, struct json_object* jsonparams) {
+	unsigned long count;
+	const char* key = NULL;
+	struct json_object* jsonvalue;
+
+	/* Params InvalidateProfile Action, without key matches all profiles
+		{
+			Key: [string]
+		}
+	*/
+
+	/* Key */
+	jsonvalue = compat_json_object_object_get(jsonparams, "Key");
+	if (jsonvalue) {
+		if (json_object_get_type(jsonvalue) != json_type_string) {
+			return -1;
+		}
+
+		key = json_object_get_string(jsonvalue);
+	}
+
+	/* The WTPs already joined keep their configuration */
+	count = ac_profile_invalidate(key);
+	capwap_logging_debug("Invalidate %lu WTP profiles", count);
+	ac_profile_log();
+
+	return 0;
+}
+
 /* */
 static int ac_backend_soap_update_event(const char* idevent, int status) {
 	int result = 0;
 	char buffer[256];
 	struct ac_soap_request* request = NULL;
 	struct ac_http_soap_server* server;
+	struct ac_soap_response* response;
 
 	ASSERT(g_ac_backend.soaprequest == NULL);
 	ASSERT(g_ac_backend.backendsessionid != NULL);
@@ -354,11 +514,9 @@ static int ac_backend_soap_update_event(const char* idevent, int status) {
 	}
 
 	/* Send Request & Recv Response */
-	if (ac_soapclient_send_request(g_ac_backend.soaprequest, "")) {
-		struct ac_soap_response* response = ac_soapclient_recv_response(g_ac_backend.soaprequest);
-		if (response) {
-			ac_soapclient_free_response(response);
-		}
+	response = ac_backend_execute(g_ac_backend.soaprequest);
+	if (response) {
+		ac_soapclient_free_response(response);
 	}
 
 	/* Critical section */
@@ -379,6 +537,7 @@ static int ac_backend_soap_getconfiguration(void) {
 	struct ac_soap_request* request = NULL;
 	struct ac_http_soap_server* server;
 	struct json_object* jsonroot = NULL;
+	struct ac_soap_response* response;
 
 	ASSERT(g_ac_backend.soaprequest == NULL);
 	ASSERT(g_ac_backend.backendsessionid != NULL);
@@ -410,13 +569,11 @@ static int ac_backend_soap_getconfiguration(void) {
 	}
 
 	/* Send Request & Recv Response */
-	if (ac_soapclient_send_request(g_ac_backend.soaprequest, "")) {
-		struct ac_soap_response* response = ac_soapclient_recv_response(g_ac_backend.soaprequest);
-		if (response) {
-			/* Get Configuration result */
-			jsonroot = ac_soapclient_parse_json_response(response);
-			ac_soapclient_free_response(response);
-		}
+	response = ac_backend_execute(g_ac_backend.soaprequest);
+	if (response) {
+		/* Get Configuration result */
+		jsonroot = ac_soapclient_parse_json_response(response);
+		ac_soapclient_free_response(response);
 	}
 
 	/* Critical section */
@@ -443,6 +600,7 @@ static int ac_backend_soap_getconfiguration(void) {
 static int ac_backend_soap_join(int forcereset) {
 	struct ac_soap_request* request = NULL;
 	struct ac_http_soap_server* server;
+	struct ac_soap_response* response;
 
 	ASSERT(g_ac_backend.soaprequest == NULL);
 	ASSERT(g_ac_backend.backendsessionid == NULL);
@@ -476,22 +634,20 @@ static int ac_backend_soap_join(int forcereset) {
 	}
 
 	/* Send Request & Recv Response */
-	if (ac_soapclient_send_request(g_ac_backend.soaprequest, "")) {
-		struct ac_soap_response* response = ac_soapclient_recv_response(g_ac_backend.soaprequest);
-		if (response) {
-			/* Get join result */
-			if ((response->responsecode == HTTP_RESULT_OK) && response->xmlResponseReturn) {
-				xmlChar* xmlResult = xmlNodeGetContent(response->xmlResponseReturn);
-				if (xmlStrlen(xmlResult)) {
-					g_ac_backend.backendsessionid = capwap_duplicate_string((const char*)xmlResult);
-				}
-
-				xmlFree(xmlResult);
+	response = ac_backend_execute(g_ac_backend.soaprequest);
+	if (response) {
+		/* Get join result */
+		char* result = ac_soapclient_get_string_response(response);
+		if (result) {
+			if (*result) {
+				g_ac_backend.backendsessionid = result;
+			} else {
+				capwap_free(result);
 			}
-
-			/* */
-			ac_soapclient_free_response(response);
 		}
+
+		/* */
+		ac_soapclient_free_response(response);
 	}
 
 	/* Critical section */
@@ -518,6 +674,7 @@ static int ac_backend_soap_join(int forcereset) {
 /* */
 static int ac_backend_parsing_event(struct json_object* jsonitem) {
 	int result = -1;
+	int status = SOAP_EVENT_STATUS_RUNNING;
 	struct json_object* jsonvalue;
 
 	ASSERT(jsonitem != NULL);
@@ -551,14 +708,22 @@ static int ac_backend_parsing_event(struct json_object* jsonitem) {
 						result = ac_backend_parsing_resetwtp_event(idevent, jsonvalue);
 					} else if (!strcmp(action, "AddWLAN")) {
 						result = ac_backend_parsing_addwlan_event(idevent, jsonvalue);
+					} else if (!strcmp(action, "QueryWLANProvisioning")) {
+						result = ac_backend_parsing_querywlanprovisioning_event(idevent, jsonvalue);
 					} else if (!strcmp(action, "UpdateWLAN")) {
 						result = ac_backend_parsing_updatewlan_event(idevent, jsonvalue);
 					} else if (!strcmp(action, "DeleteWLAN")) {
 						result = ac_backend_parsing_deletewlan_event(idevent, jsonvalue);
+					} else if (!strcmp(action, "InvalidateStationAuthorization")) {
+						result = ac_backend_parsing_invalidatestationauthorization_event(idevent, jsonvalue);
+						status = SOAP_EVENT_STATUS_COMPLETE;
+					} else if (!strcmp(action, "InvalidateProfile")) {
+						result = ac_backend_parsing_invalidateprofile_event(idevent, jsonvalue);
+						status = SOAP_EVENT_STATUS_COMPLETE;
 					}
 
 					/* Notify result action */
-					ac_backend_soap_update_event(idevent, (!result ? SOAP_EVENT_STATUS_RUNNING : SOAP_EVENT_STATUS_GENERIC_ERROR));
+					ac_backend_soap_update_event(idevent, (!result ? status : SOAP_EVENT_STATUS_GENERIC_ERROR));
 				}
 			}
 		}
@@ -573,6 +738,7 @@ static int ac_backend_soap_waitevent(void) {
 	struct ac_soap_request* request = NULL;
 	struct ac_http_soap_server* server;
 	struct json_object* jsonroot = NULL;
+	struct ac_soap_response* response;
 
 	ASSERT(g_ac_backend.soaprequest == NULL);
 	ASSERT(g_ac_backend.backendsessionid != NULL);
@@ -607,13 +773,11 @@ static int ac_backend_soap_waitevent(void) {
 	}
 
 	/* Send Request & Recv Response */
-	if (ac_soapclient_send_request(g_ac_backend.soaprequest, "")) {
-		struct ac_soap_response* response = ac_soapclient_recv_response(g_ac_backend.soaprequest);
-		if (response) {
-			/* Wait event result */
-			jsonroot = ac_soapclient_parse_json_response(response);
-			ac_soapclient_free_response(response);
-		}
+	response = ac_soapclient_async_execute(g_ac_backend.soaprequest, "");
+	if (response) {
+		/* Wait event result */
+		jsonroot = ac_soapclient_parse_json_response(response);
+		ac_soapclient_free_response(response);
 	}
 
 	/* Critical section */
@@ -655,10 +819,236 @@ static int ac_backend_soap_waitevent(void) {
 	return result;
 }
 
+/* */
+static void ac_backend_soap_ackevent_callback(struct ac_http_soap_request* httprequest, struct ac_soap_response* response, void* param) {
+	if (!httprequest->shutdown) {
+		ac_health_record(httprequest->server, "ackBackendEvent", &g_ac_backend.acksubmitted, (response ? 1 : 0));
+	}
+
+	capwap_lock_enter(&g_ac_backend.lock);
+
+	if (response && (response->responsecode == HTTP_RESULT_OK)) {
+		g_ac_backend.acksequence = max(g_ac_backend.acksequence, g_ac_backend.ackinflight);
+	}
+
+	g_ac_backend.ackinflight = 0;
+
+	capwap_lock_exit(&g_ac_backend.lock);
+
+	/* */
+	if (response) {
+		ac_soapclient_free_response(response);
+	}
+
+	ac_soapclient_close_request(httprequest, 1);
+}
+
+/* Cumulative acknowledge of processed events, without wait the response */
+static void ac_backend_soap_ackevent(void) {
+	long timeout;
+	char buffer[32];
+	struct ac_soap_request* request;
+	struct ac_http_soap_request* soaprequest = NULL;
+
+	ASSERT(g_ac_backend.backendsessionid != NULL);
+
+	/* Critical section */
+	capwap_lock_enter(&g_ac_backend.lock);
+
+	if (!g_ac_backend.endthread && !g_ac_backend.ackinflight && (g_ac_backend.eventsequence > g_ac_backend.acksequence)) {
+		request = ac_soapclient_create_request("ackBackendEvent", SOAP_NAMESPACE_URI);
+		if (request) {
+			sprintf(buffer, "%lu", g_ac_backend.eventsequence);
+			ac_soapclient_add_param(request, "xs:string", "idsession", g_ac_backend.backendsessionid);
+			ac_soapclient_add_param(request, "xs:long", "sequence", buffer);
+			soaprequest = ac_soapclient_prepare_request(request, ac_backend_get_server());
+			if (soaprequest) {
+				soaprequest->deadline = ac_health_get_deadline("ackBackendEvent");
+				g_ac_backend.ackinflight = g_ac_backend.eventsequence;
+				gettimeofday(&g_ac_backend.acksubmitted, NULL);
+			} else {
+				ac_soapclient_free_request(request);
+			}
+		}
+	}
+
+	capwap_lock_exit(&g_ac_backend.lock);
+
+	/* */
+	if (soaprequest) {
+		timeout = ac_soapclient_get_timeout(soaprequest);
+		if (!ac_soapclient_async_submit(soaprequest, "", timeout, ac_backend_soap_ackevent_callback, NULL)) {
+			capwap_lock_enter(&g_ac_backend.lock);
+			g_ac_backend.ackinflight = 0;
+			capwap_lock_exit(&g_ac_backend.lock);
+
+			ac_soapclient_close_request(soaprequest, 1);
+		}
+	}
+}
+
+/* */
+static void ac_backend_stream_event(char* line) {
+	unsigned long sequence = 0;
+	struct json_object* jsonitem;
+	struct json_object* jsonvalue;
+
+	/* Receive event with sequence number
+		{
+			Sequence: [int],
+			EventID: [int],
+			Action: [string],
+			Params: {
+				<Depends on the Action>
+			}
+		}
+	*/
+
+	jsonitem = json_tokener_parse(line);
+	if (!jsonitem) {
+		capwap_logging_debug("Invalid event received from Backend Server");
+		return;
+	}
+
+	if (json_object_get_type(jsonitem) == json_type_object) {
+		jsonvalue = compat_json_object_object_get(jsonitem, "Sequence");
+		if (jsonvalue && (json_object_get_type(jsonvalue) == json_type_int)) {
+			sequence = (unsigned long)json_object_get_int64(jsonvalue);
+		}
+
+		/* Event already processed before resume of stream */
+		if (sequence && (sequence <= g_ac_backend.eventsequence)) {
+			capwap_logging_debug("Discard duplicate event %lu from Backend Server", sequence);
+		} else {
+			/* The result of event is notified to Backend Server with updateBackendEvent */
+			ac_backend_parsing_event(jsonitem);
+
+			if (sequence) {
+				capwap_lock_enter(&g_ac_backend.lock);
+				g_ac_backend.eventsequence = sequence;
+				capwap_lock_exit(&g_ac_backend.lock);
+			}
+		}
+	}
+
+	json_object_put(jsonitem);
+}
+
+/* Persistent channel where Backend Server push events, one JSON event for line.
+   Return 0 when the stream is closed by Backend Server, 1 if Backend Server
+   does not support the event stream and -1 for connection error */
+static int ac_backend_soap_streamevent(void) {
+	int length;
+	int result = -1;
+	char buffer[32];
+	char* line;
+	char* endline;
+	struct ac_soap_request* request = NULL;
+	struct ac_http_soap_server* server;
+
+	ASSERT(g_ac_backend.streamrequest == NULL);
+	ASSERT(g_ac_backend.backendsessionid != NULL);
+
+	/* Get HTTP Soap Server */
+	server = ac_backend_get_server();
+
+	/* Critical section */
+	capwap_lock_enter(&g_ac_backend.lock);
+
+	/* Build Soap Request, resume from last event processed */
+	if (!g_ac_backend.endthread) {
+		request = ac_soapclient_create_request("streamBackendEvent", SOAP_NAMESPACE_URI);
+		if (request) {
+			sprintf(buffer, "%lu", g_ac_backend.eventsequence);
+			ac_soapclient_add_param(request, "xs:string", "idsession", g_ac_backend.backendsessionid);
+			ac_soapclient_add_param(request, "xs:long", "sequence", buffer);
+			g_ac_backend.streamrequest = ac_soapclient_prepare_request(request, server);
+
+			/* Backend Server sends an empty line as heartbeat */
+			g_ac_backend.streamrequest->responsetimeout = SOAP_PROTOCOL_RESPONSE_WAIT_EVENT_TIMEOUT;
+		}
+	}
+
+	capwap_lock_exit(&g_ac_backend.lock);
+
+	/* */
+	if (!g_ac_backend.streamrequest) {
+		if (request) {
+			ac_soapclient_free_request(request);
+		}
+
+		return -1;
+	}
+
+	/* Send Request and receive events until the stream is open */
+	g_ac_backend.streamlength = 0;
+	if (ac_soapclient_send_request(g_ac_backend.streamrequest, "")) {
+		ac_soapclient_reset_response(g_ac_backend.streamrequest);
+
+		for (;;) {
+			length = ac_soapclient_recv_stream(g_ac_backend.streamrequest, &g_ac_backend.streambuffer[g_ac_backend.streamlength], sizeof(g_ac_backend.streambuffer) - g_ac_backend.streamlength - 1);
+			if (length == SOAP_STREAM_UNSUPPORTED) {
+				result = 1;
+				break;
+			} else if (!length) {
+				result = 0;
+				break;
+			} else if (length < 0) {
+				break;
+			}
+
+			/* Dispatch every complete line */
+			g_ac_backend.streamlength += length;
+			g_ac_backend.streambuffer[g_ac_backend.streamlength] = 0;
+
+			line = g_ac_backend.streambuffer;
+			while ((endline = strchr(line, '\n')) != NULL) {
+				*endline = 0;
+				if ((endline > line) && (*(endline - 1) == '\r')) {
+					*(endline - 1) = 0;
+				}
+
+				if (*line) {
+					ac_backend_stream_event(line);
+				}
+
+				line = endline + 1;
+			}
+
+			g_ac_backend.streamlength -= (int)(line - g_ac_backend.streambuffer);
+			if (g_ac_backend.streamlength >= (sizeof(g_ac_backend.streambuffer) - 1)) {
+				capwap_logging_debug("Event from Backend Server too long");
+				break;
+			} else if (g_ac_backend.streamlength > 0) {
+				memmove(g_ac_backend.streambuffer, line, g_ac_backend.streamlength);
+			}
+
+			/* */
+			if (g_ac_backend.endthread) {
+				break;
+			}
+
+			ac_backend_soap_ackevent();
+		}
+	}
+
+	/* Critical section */
+	capwap_lock_enter(&g_ac_backend.lock);
+
+	/* Free resource */
+	ac_soapclient_close_request(g_ac_backend.streamrequest, 1);
+	g_ac_backend.streamrequest = NULL;
+
+	capwap_lock_exit(&g_ac_backend.lock);
+
+	return result;
+}
+
 /* */
 static void ac_backend_soap_leave(void) {
 	struct ac_soap_request* request;
 	struct ac_http_soap_server* server;
+	struct ac_soap_response* response;
 
 	ASSERT(g_ac_backend.soaprequest == NULL);
 
@@ -692,11 +1082,9 @@ static void ac_backend_soap_leave(void) {
 	}
 
 	/* Send Request & Recv Response */
-	if (ac_soapclient_send_request(g_ac_backend.soaprequest, "")) {
-		struct ac_soap_response* response = ac_soapclient_recv_response(g_ac_backend.soaprequest);
-		if (response) {
-			ac_soapclient_free_response(response);
-		}
+	response = ac_backend_execute(g_ac_backend.soaprequest);
+	if (response) {
+		ac_soapclient_free_response(response);
 	}
 
 	/* Critical section */
@@ -711,6 +1099,7 @@ static void ac_backend_soap_leave(void) {
 
 /* */
 static void ac_backend_run(void) {
+	int result;
 	int connected = 0;
 	int forcereset = 1;
 
@@ -718,7 +1107,18 @@ static void ac_backend_run(void) {
 
 	while (!g_ac_backend.endthread) {
 		if (connected) {
-			if (ac_backend_soap_waitevent()) {
+			if (!g_ac_backend.streamunsupported) {
+				result = ac_backend_soap_streamevent();
+				if (result > 0) {
+					capwap_logging_info("Backend Server does not support event stream, use waitBackendEvent");
+					g_ac_backend.streamunsupported = 1;
+					result = 0;
+				}
+			} else {
+				result = ac_backend_soap_waitevent();
+			}
+
+			if (result) {
 				if (g_ac_backend.endthread) {
 					break;
 				}
@@ -732,14 +1132,33 @@ static void ac_backend_run(void) {
 				capwap_free(g_ac_backend.backendsessionid);
 				g_ac_backend.backendsessionid = NULL;
 
+				/* Drop persistent connections */
+				ac_soapclient_log_server(ac_backend_get_server());
+				ac_soapclient_flush_server(ac_backend_get_server());
+
+				/* Invalidation events may be lost */
+				ac_authcache_invalidate(NULL, NULL, NULL);
+				ac_profile_invalidate(NULL);
+
 				/* Change backend */
-				g_ac_backend.activebackend = (g_ac_backend.activebackend + 1) % g_ac.availablebackends->count;
+				ac_backend_change_server();
 			}
 		} else {
 			/* Join with a Backend Server */
 			if (!ac_backend_soap_join(forcereset)) {
 				capwap_logging_debug("Joined with Backend Server");
 
+				/* A reset of AC does not resume the events */
+				if (forcereset) {
+					capwap_lock_enter(&g_ac_backend.lock);
+					g_ac_backend.eventsequence = 0;
+					g_ac_backend.acksequence = 0;
+					g_ac_backend.ackinflight = 0;
+					capwap_lock_exit(&g_ac_backend.lock);
+				}
+
+				g_ac_backend.streamunsupported = 0;
+
 				/* Join Complete */
 				connected = 1;
 				forcereset = 0;
@@ -748,7 +1167,7 @@ static void ac_backend_run(void) {
 				capwap_lock_exit(&g_ac_backend.backendlock);
 			} else {
 				/* Change Backend Server */
-				g_ac_backend.activebackend = (g_ac_backend.activebackend + 1) % g_ac.availablebackends->count;
+				ac_backend_change_server();
 				g_ac_backend.errorjoinbackend++;
 
 				/* Wait timeout before continue */
@@ -806,6 +1225,74 @@ int ac_backend_isconnect(void) {
 	return (g_ac_backend.backendstatus ? 1 : 0);
 }
 
+/* Backend Server connected but with open circuit */
+int ac_backend_isdegraded(void) {
+	int result = 0;
+
+	capwap_lock_enter(&g_ac_backend.backendlock);
+
+	if (ac_backend_isconnect() && !ac_health_isavailable(ac_backend_get_server())) {
+		result = 1;
+	}
+
+	capwap_lock_exit(&g_ac_backend.backendlock);
+
+	return result;
+}
+
+/* Leave the Backend Server with open circuit when another one is available */
+void ac_backend_failover(void) {
+	unsigned long i;
+	int available = 0;
+
+	capwap_lock_enter(&g_ac_backend.lock);
+
+	if (!g_ac_backend.endthread && ac_backend_isconnect() && !ac_health_isavailable(ac_backend_get_server())) {
+		for (i = 0; i < g_ac.availablebackends->count; i++) {
+			if (ac_health_isavailable(*(struct ac_http_soap_server**)capwap_array_get_item_pointer(g_ac.availablebackends, i))) {
+				available = 1;
+				break;
+			}
+		}
+
+		/* The Backend Management Thread rejoin with another Backend Server */
+		if (available) {
+			if (g_ac_backend.soaprequest) {
+				ac_soapclient_shutdown_request(g_ac_backend.soaprequest);
+			}
+
+			if (g_ac_backend.streamrequest) {
+				ac_soapclient_shutdown_request(g_ac_backend.streamrequest);
+			}
+		}
+	}
+
+	capwap_lock_exit(&g_ac_backend.lock);
+}
+
+/* Send request and track the health of Backend Server */
+struct ac_soap_response* ac_backend_execute(struct ac_http_soap_request* soaprequest) {
+	struct timeval start;
+	struct ac_soap_response* response;
+
+	ASSERT(soaprequest != NULL);
+
+	if (!soaprequest->deadline) {
+		soaprequest->deadline = ac_health_get_deadline(soaprequest->request->method);
+	}
+
+	/* */
+	gettimeofday(&start, NULL);
+	response = ac_soapclient_async_execute(soaprequest, "");
+
+	/* Request aborted by AC is not a failure of Backend Server */
+	if (!soaprequest->shutdown) {
+		ac_health_record(soaprequest->server, soaprequest->request->method, &start, (response ? 1 : 0));
+	}
+
+	return response;
+}
+
 /* */
 struct ac_http_soap_request* ac_backend_createrequest_with_session(char* method, char* uri) {
 	struct ac_http_soap_server* server;
@@ -818,11 +1305,12 @@ struct ac_http_soap_request* ac_backend_createrequest_with_session(char* method,
 	if (ac_backend_isconnect()) {
 		server = ac_backend_get_server();
 
-		/* Build Soap Request */
-		request = ac_soapclient_create_request(method, SOAP_NAMESPACE_URI);
+		/* Build Soap Request, the requests are rejected while the circuit is open */
+		request = (ac_health_isavailable(server) ? ac_soapclient_create_request(method, SOAP_NAMESPACE_URI) : NULL);
 		if (request) {
 			soaprequest = ac_soapclient_prepare_request(request, server);
 			if (soaprequest) {
+				soaprequest->deadline = ac_health_get_deadline(method);
 				ac_soapclient_add_param(request, "xs:string", "idsession", g_ac_backend.backendsessionid);
 			} else {
 				ac_soapclient_free_request(request);
@@ -858,10 +1346,16 @@ int ac_backend_start(void) {
 	capwap_lock_init(&g_ac_backend.backendlock);
 	capwap_event_init(&g_ac_backend.wait);
 
+	/* Health of Backend Servers */
+	if (!ac_health_start()) {
+		return 0;
+	}
+
 	/* Create thread */
 	result = pthread_create(&g_ac_backend.threadid, NULL, ac_backend_thread, NULL);
 	if (result) {
 		capwap_logging_debug("Unable create backend thread");
+		ac_health_stop();
 		return 0;
 	}
 
@@ -881,16 +1375,26 @@ void ac_backend_stop(void) {
 		ac_soapclient_shutdown_request(g_ac_backend.soaprequest);
 	}
 
+	if (g_ac_backend.streamrequest) {
+		ac_soapclient_shutdown_request(g_ac_backend.streamrequest);
+	}
+
 	/* */
 	capwap_lock_exit(&g_ac_backend.lock);
 	capwap_event_signal(&g_ac_backend.wait);
 
 	/* Wait close thread */
 	pthread_join(g_ac_backend.threadid, &dummy);
+
+	/* */
+	ac_health_stop();
 }
 
 /* */
 void ac_backend_free(void) {
+	ac_health_free();
+
+	/* */
 	capwap_event_destroy(&g_ac_backend.wait);
 	capwap_lock_destroy(&g_ac_backend.lock);
 	capwap_lock_destroy(&g_ac_backend.backendlock);
@@ -17,6 +17,11 @@ void ac_backend_free(void);
 
 /* */
 int ac_backend_isconnect(void);
+int ac_backend_isdegraded(void);
+void ac_backend_failover(void);
+
+/* */
 struct ac_http_soap_request* ac_backend_createrequest_with_session(char* method, char* uri);
+struct ac_soap_response* ac_backend_execute(struct ac_http_soap_request* soaprequest);
 
 #endif /* __AC_BACKEND_HEADER__ */
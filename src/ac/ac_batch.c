@@ -0,0 +1,523 @@
+#include "ac.h"
+#include "ac_backend.h"
+#include "ac_soap.h"
+#include "ac_batch.h"
+#include "ac_health.h"
+
+/* Session requests that can be batched */
+static const char* g_ac_batch_methods[] = {
+	"authorizeWTPSession",
+	"joinWTPSession",
+	"configureStatusWTPSession",
+	"changeStateWTPSession",
+	"runningWTPSession",
+	"teardownWTPSession",
+	"checkWTPSession",
+	"authorizeStation",
+	NULL
+};
+
+#define AC_BATCH_METHODS_COUNT				((sizeof(g_ac_batch_methods) / sizeof(g_ac_batch_methods[0])) - 1)
+
+/* Batch sent to backend server */
+struct ac_batch {
+	int method;
+	struct timeval submitted;
+	unsigned long count;
+	struct ac_batch_request* requests[AC_BATCH_MAX_SIZE];
+};
+
+/* */
+struct ac_batch_t {
+	pthread_t threadid;
+	int running;
+	int endthread;
+
+	capwap_event_t wait;
+	capwap_lock_t lock;
+	struct capwap_list* queue[AC_BATCH_METHODS_COUNT];
+
+	/* Statistics */
+	unsigned long batches;
+	unsigned long requests;
+	unsigned long failed;
+};
+
+static struct ac_batch_t g_ac_batch;
+
+/* */
+static long ac_batch_get_elapsed(struct timeval* last, struct timeval* now) {
+	return ((now->tv_sec - last->tv_sec) * 1000) + ((now->tv_usec - last->tv_usec) / 1000);
+}
+
+/* Deliver the response to session, must be called with lock */
+static void ac_batch_complete_request(struct ac_batch_request* batchrequest, struct ac_soap_response* response) {
+	batchrequest->status = AC_BATCH_REQUEST_COMPLETE;
+	batchrequest->response = response;
+	batchrequest->batch = NULL;
+	capwap_event_signal(&batchrequest->complete);
+}
+
+/* */
+static void ac_batch_complete(struct ac_batch* batch, struct json_object* jsonroot) {
+	int i;
+	int length = 0;
+	struct json_object* jsonresponses = NULL;
+	struct ac_soap_response* responses[AC_BATCH_MAX_SIZE];
+
+	/* Receive JSON result
+		{
+			Responses: [
+				{
+					RequestID: [int],
+					Return: [string/object],
+					Fault: [string]
+				}
+			]
+		}
+	*/
+
+	/* Demultiplexing backend responses out of critical section */
+	memset(responses, 0, sizeof(responses));
+	if (jsonroot) {
+		jsonresponses = compat_json_object_object_get(jsonroot, "Responses");
+		if (jsonresponses && (json_object_get_type(jsonresponses) == json_type_array)) {
+			length = json_object_array_length(jsonresponses);
+		}
+	}
+
+	for (i = 0; i < length; i++) {
+		int index;
+		struct json_object* jsonitem;
+		struct json_object* jsonelement;
+		struct json_object* jsonresponse = json_object_array_get_idx(jsonresponses, i);
+
+		if (!jsonresponse || (json_object_get_type(jsonresponse) != json_type_object)) {
+			continue;
+		}
+
+		/* RequestID */
+		jsonitem = compat_json_object_object_get(jsonresponse, "RequestID");
+		if (!jsonitem || (json_object_get_type(jsonitem) != json_type_int)) {
+			continue;
+		}
+
+		index = json_object_get_int(jsonitem);
+		if ((index < 0) || (index >= (int)batch->count) || responses[index]) {
+			continue;
+		}
+
+		/* Fault or Return */
+		jsonitem = compat_json_object_object_get(jsonresponse, "Fault");
+		jsonelement = compat_json_object_object_get(jsonresponse, "Return");
+		if (jsonitem && (json_object_get_type(jsonitem) == json_type_string)) {
+			responses[index] = ac_soapclient_create_response(HTTP_RESULT_INTERNAL_SERVER_ERROR, json_object_get_string(jsonitem));
+		} else if (jsonelement && (json_object_get_type(jsonelement) == json_type_string)) {
+			responses[index] = ac_soapclient_create_response(HTTP_RESULT_OK, json_object_get_string(jsonelement));
+		} else if (jsonelement) {
+			responses[index] = ac_soapclient_create_json_response(HTTP_RESULT_OK, jsonelement);
+		} else {
+			responses[index] = ac_soapclient_create_response(HTTP_RESULT_OK, NULL);
+		}
+	}
+
+	/* Wakeup the sessions, a request already abandoned by its session is detached */
+	capwap_lock_enter(&g_ac_batch.lock);
+
+	for (i = 0; i < (int)batch->count; i++) {
+		if (batch->requests[i]) {
+			if (!responses[i]) {
+				g_ac_batch.failed++;
+			}
+
+			ac_batch_complete_request(batch->requests[i], responses[i]);
+		} else if (responses[i]) {
+			ac_soapclient_free_response(responses[i]);
+		}
+	}
+
+	capwap_lock_exit(&g_ac_batch.lock);
+
+	capwap_free(batch);
+}
+
+/* */
+static void ac_batch_callback(struct ac_http_soap_request* httprequest, struct ac_soap_response* response, void* param) {
+	struct json_object* jsonroot = NULL;
+	struct ac_batch* batch = (struct ac_batch*)param;
+
+	/* The batch is accounted as single request of batched method */
+	if (!httprequest->shutdown) {
+		ac_health_record(httprequest->server, g_ac_batch_methods[batch->method], &batch->submitted, (response ? 1 : 0));
+	}
+
+	if (response) {
+		jsonroot = ac_soapclient_parse_json_response(response);
+		if (!jsonroot) {
+			capwap_logging_warning("Backend Server rejected batched %s request", g_ac_batch_methods[((struct ac_batch*)param)->method]);
+		}
+
+		ac_soapclient_free_response(response);
+	}
+
+	ac_soapclient_close_request(httprequest, 1);
+
+	/* */
+	ac_batch_complete((struct ac_batch*)param, jsonroot);
+	if (jsonroot) {
+		json_object_put(jsonroot);
+	}
+}
+
+/* */
+static void ac_batch_submit(struct ac_batch* batch) {
+	unsigned long i;
+	long timeout;
+	struct json_object* jsonroot;
+	struct json_object* jsonrequests;
+	struct ac_http_soap_request* soaprequest;
+
+	/* Create SOAP request with JSON param
+		{
+			Method: [string],
+			Requests: [
+				{
+					RequestID: [int],
+					Params: {
+						<Params of the single request>
+					}
+				}
+			]
+		}
+	*/
+
+	/* */
+	jsonrequests = json_object_new_array();
+	for (i = 0; i < batch->count; i++) {
+		struct json_object* jsonrequest = json_object_new_object();
+
+		json_object_object_add(jsonrequest, "RequestID", json_object_new_int((int)i));
+		json_object_object_add(jsonrequest, "Params", json_tokener_parse(batch->requests[i]->params));
+		json_object_array_add(jsonrequests, jsonrequest);
+	}
+
+	jsonroot = json_object_new_object();
+	json_object_object_add(jsonroot, "Method", json_object_new_string(g_ac_batch_methods[batch->method]));
+	json_object_object_add(jsonroot, "Requests", jsonrequests);
+
+	/* JSON param is encoded by backend transport */
+	soaprequest = ac_backend_createrequest_with_session("executeBatch", SOAP_NAMESPACE_URI);
+	if (soaprequest) {
+		if (ac_soapclient_add_param(soaprequest->request, "xs:string", "method", g_ac_batch_methods[batch->method]) && ac_soapclient_add_param(soaprequest->request, "xs:base64Binary", "batch", json_object_to_json_string(jsonroot))) {
+			soaprequest->deadline = ac_health_get_deadline(g_ac_batch_methods[batch->method]);
+			timeout = ac_soapclient_get_timeout(soaprequest);
+
+			gettimeofday(&batch->submitted, NULL);
+			if (ac_soapclient_async_submit(soaprequest, "", timeout, ac_batch_callback, (void*)batch)) {
+				soaprequest = NULL;
+				batch = NULL;
+			}
+		}
+
+		if (soaprequest) {
+			ac_soapclient_close_request(soaprequest, 1);
+		}
+	}
+
+	json_object_put(jsonroot);
+
+	/* Unable to send batch */
+	if (batch) {
+		ac_batch_complete(batch, NULL);
+	}
+}
+
+/* Take a batch from queue, must be called with lock */
+static struct ac_batch* ac_batch_dequeue(int method) {
+	struct ac_batch* batch;
+	struct capwap_list_item* itemlist;
+	struct capwap_list* queue = g_ac_batch.queue[method];
+
+	/* */
+	batch = (struct ac_batch*)capwap_alloc(sizeof(struct ac_batch));
+	memset(batch, 0, sizeof(struct ac_batch));
+	batch->method = method;
+
+	while (queue->first && (batch->count < g_ac.batch.size)) {
+		struct ac_batch_request* batchrequest;
+
+		itemlist = capwap_itemlist_remove_head(queue);
+		batchrequest = (struct ac_batch_request*)itemlist->item;
+		capwap_itemlist_free(itemlist);
+
+		/* */
+		batchrequest->status = AC_BATCH_REQUEST_SUBMITTED;
+		batchrequest->batch = batch;
+		batchrequest->index = batch->count;
+		batch->requests[batch->count++] = batchrequest;
+	}
+
+	/* */
+	g_ac_batch.batches++;
+	g_ac_batch.requests += batch->count;
+
+	return batch;
+}
+
+/* */
+static void* ac_batch_thread(void* param) {
+	int i;
+	long elapsed;
+	long timeout;
+	struct timeval now;
+	struct ac_batch* batch;
+	struct capwap_list* batches;
+	struct capwap_list_item* itemlist;
+
+	capwap_logging_debug("Backend batch start");
+
+	/* */
+	batches = capwap_list_create();
+	while (!g_ac_batch.endthread) {
+		timeout = g_ac.batch.interval;
+
+		/* Close the batches that reached the size or the time window */
+		capwap_lock_enter(&g_ac_batch.lock);
+
+		gettimeofday(&now, NULL);
+		for (i = 0; i < AC_BATCH_METHODS_COUNT; i++) {
+			struct capwap_list* queue = g_ac_batch.queue[i];
+
+			while (queue->first) {
+				elapsed = ac_batch_get_elapsed(&((struct ac_batch_request*)queue->first->item)->queued, &now);
+				if ((queue->count < g_ac.batch.size) && (elapsed < g_ac.batch.interval)) {
+					timeout = min(timeout, g_ac.batch.interval - elapsed);
+					break;
+				}
+
+				itemlist = capwap_itemlist_create_with_item(ac_batch_dequeue(i), 0);
+				itemlist->autodelete = 0;
+				capwap_itemlist_insert_after(batches, NULL, itemlist);
+			}
+		}
+
+		capwap_lock_exit(&g_ac_batch.lock);
+
+		/* Submit out of critical section */
+		while (batches->first) {
+			itemlist = capwap_itemlist_remove_head(batches);
+			batch = (struct ac_batch*)itemlist->item;
+			capwap_itemlist_free(itemlist);
+
+			ac_batch_submit(batch);
+		}
+
+		/* */
+		capwap_event_wait_timeout(&g_ac_batch.wait, timeout);
+	}
+
+	capwap_list_free(batches);
+
+	capwap_logging_debug("Backend batch stop");
+	pthread_exit(NULL);
+	return NULL;
+}
+
+/* */
+int ac_batch_start(void) {
+	int i;
+	int result;
+
+	memset(&g_ac_batch, 0, sizeof(struct ac_batch_t));
+
+	/* Init */
+	capwap_event_init(&g_ac_batch.wait);
+	capwap_lock_init(&g_ac_batch.lock);
+	for (i = 0; i < AC_BATCH_METHODS_COUNT; i++) {
+		g_ac_batch.queue[i] = capwap_list_create();
+	}
+
+	/* Batching disabled */
+	if (!g_ac.batch.size) {
+		return 1;
+	}
+
+	/* Create thread */
+	g_ac_batch.running = 1;
+	result = pthread_create(&g_ac_batch.threadid, NULL, ac_batch_thread, NULL);
+	if (result) {
+		capwap_logging_debug("Unable create backend batch thread");
+		g_ac_batch.running = 0;
+		return 0;
+	}
+
+	return 1;
+}
+
+/* */
+void ac_batch_stop(void) {
+	int i;
+	void* dummy;
+
+	if (g_ac_batch.running) {
+		capwap_lock_enter(&g_ac_batch.lock);
+		g_ac_batch.running = 0;
+		g_ac_batch.endthread = 1;
+		capwap_lock_exit(&g_ac_batch.lock);
+
+		capwap_event_signal(&g_ac_batch.wait);
+
+		/* Wait close thread */
+		pthread_join(g_ac_batch.threadid, &dummy);
+
+		/* */
+		capwap_logging_debug("Backend batch: %lu batches, %lu requests, %lu failed", g_ac_batch.batches, g_ac_batch.requests, g_ac_batch.failed);
+	}
+
+	/* Fail the requests not yet sent */
+	for (i = 0; i < AC_BATCH_METHODS_COUNT; i++) {
+		while (g_ac_batch.queue[i]->first) {
+			struct capwap_list_item* itemlist = capwap_itemlist_remove_head(g_ac_batch.queue[i]);
+
+			ac_batch_complete_request((struct ac_batch_request*)itemlist->item, NULL);
+			capwap_itemlist_free(itemlist);
+		}
+
+		capwap_list_free(g_ac_batch.queue[i]);
+	}
+
+	/* */
+	capwap_event_destroy(&g_ac_batch.wait);
+	capwap_lock_destroy(&g_ac_batch.lock);
+}
+
+/* */
+static int ac_batch_get_method(const char* method) {
+	int i;
+
+	for (i = 0; g_ac_batch_methods[i]; i++) {
+		if (!strcmp(method, g_ac_batch_methods[i])) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/* */
+int ac_batch_isbatchable(const char* method) {
+	ASSERT(method != NULL);
+
+	return ((g_ac_batch.running && (ac_batch_get_method(method) >= 0)) ? 1 : 0);
+}
+
+/* */
+struct ac_batch_request* ac_batch_create_request(const char* method, struct json_object* jsonparams) {
+	struct ac_batch_request* batchrequest;
+
+	ASSERT(method != NULL);
+	ASSERT(jsonparams != NULL);
+
+	/* */
+	batchrequest = (struct ac_batch_request*)capwap_alloc(sizeof(struct ac_batch_request));
+	memset(batchrequest, 0, sizeof(struct ac_batch_request));
+
+	batchrequest->method = ac_batch_get_method(method);
+	batchrequest->params = capwap_duplicate_string(json_object_to_json_string(jsonparams));
+	capwap_event_init(&batchrequest->complete);
+
+	ASSERT(batchrequest->method >= 0);
+
+	return batchrequest;
+}
+
+/* Queue request and wait the demultiplexed response */
+struct ac_soap_response* ac_batch_execute(struct ac_batch_request* batchrequest) {
+	int queued = 0;
+	struct ac_soap_response* response;
+	struct capwap_list_item* itemlist;
+
+	ASSERT(batchrequest != NULL);
+
+	/* */
+	itemlist = capwap_itemlist_create_with_item(batchrequest, 0);
+	itemlist->autodelete = 0;
+	gettimeofday(&batchrequest->queued, NULL);
+
+	capwap_lock_enter(&g_ac_batch.lock);
+
+	if (g_ac_batch.running && !batchrequest->shutdown) {
+		struct capwap_list* queue = g_ac_batch.queue[batchrequest->method];
+
+		capwap_itemlist_insert_after(queue, NULL, itemlist);
+		batchrequest->status = AC_BATCH_REQUEST_QUEUED;
+		queued = ((queue->count == 1) || (queue->count >= g_ac.batch.size));
+		itemlist = NULL;
+	}
+
+	capwap_lock_exit(&g_ac_batch.lock);
+
+	/* */
+	if (itemlist) {
+		capwap_itemlist_free(itemlist);
+		return NULL;
+	}
+
+	/* Start time window or close a full batch */
+	if (queued) {
+		capwap_event_signal(&g_ac_batch.wait);
+	}
+
+	/* */
+	capwap_event_wait(&batchrequest->complete);
+
+	/* Detach from batch if session was terminated before the response */
+	capwap_lock_enter(&g_ac_batch.lock);
+
+	if (batchrequest->status == AC_BATCH_REQUEST_QUEUED) {
+		struct capwap_list* queue = g_ac_batch.queue[batchrequest->method];
+
+		for (itemlist = queue->first; itemlist; itemlist = itemlist->next) {
+			if (itemlist->item == (void*)batchrequest) {
+				capwap_itemlist_free(capwap_itemlist_remove(queue, itemlist));
+				break;
+			}
+		}
+	} else if (batchrequest->status == AC_BATCH_REQUEST_SUBMITTED) {
+		batchrequest->batch->requests[batchrequest->index] = NULL;
+	}
+
+	response = batchrequest->response;
+	batchrequest->response = NULL;
+	batchrequest->batch = NULL;
+	batchrequest->status = AC_BATCH_REQUEST_COMPLETE;
+
+	capwap_lock_exit(&g_ac_batch.lock);
+
+	return response;
+}
+
+/* */
+void ac_batch_shutdown_request(struct ac_batch_request* batchrequest) {
+	ASSERT(batchrequest != NULL);
+
+	capwap_lock_enter(&g_ac_batch.lock);
+	batchrequest->shutdown = 1;
+	capwap_lock_exit(&g_ac_batch.lock);
+
+	capwap_event_signal(&batchrequest->complete);
+}
+
+/* */
+void ac_batch_free_request(struct ac_batch_request* batchrequest) {
+	ASSERT(batchrequest != NULL);
+	ASSERT(batchrequest->batch == NULL);
+
+	if (batchrequest->response) {
+		ac_soapclient_free_response(batchrequest->response);
+	}
+
+	capwap_event_destroy(&batchrequest->complete);
+	capwap_free(batchrequest->params);
+	capwap_free(batchrequest);
+}
@@ -0,0 +1,46 @@
+#ifndef __AC_BATCH_HEADER__
+#define __AC_BATCH_HEADER__
+
+/* */
+#define AC_BATCH_MAX_SIZE					256
+
+/* Status of a session request into batch */
+#define AC_BATCH_REQUEST_QUEUED				0
+#define AC_BATCH_REQUEST_SUBMITTED			1
+#define AC_BATCH_REQUEST_COMPLETE			2
+
+/* */
+struct ac_batch;
+struct ac_soap_response;
+
+/* Session request waiting the batched response */
+struct ac_batch_request {
+	int method;
+	char* params;
+	int status;
+	int shutdown;
+	struct timeval queued;
+
+	/* */
+	capwap_event_t complete;
+	struct ac_soap_response* response;
+
+	/* Position into submitted batch */
+	struct ac_batch* batch;
+	unsigned long index;
+};
+
+/* */
+int ac_batch_start(void);
+void ac_batch_stop(void);
+
+/* */
+int ac_batch_isbatchable(const char* method);
+
+/* */
+struct ac_batch_request* ac_batch_create_request(const char* method, struct json_object* jsonparams);
+struct ac_soap_response* ac_batch_execute(struct ac_batch_request* batchrequest);
+void ac_batch_shutdown_request(struct ac_batch_request* batchrequest);
+void ac_batch_free_request(struct ac_batch_request* batchrequest);
+
+#endif /* __AC_BATCH_HEADER__ */
@@ -4,6 +4,7 @@
 #include "ac_session.h"
 #include "ac_json.h"
 #include "ac_wlans.h"
+#include "ac_profile.h"
 #include <json/json.h>
 #include <arpa/inet.h>
 
@@ -32,10 +33,8 @@ static void ac_dfa_state_configure_set_radio_configuration(struct ac_session_t*
 }
 
 /* */
-static struct ac_soap_response* ac_dfa_state_configure_parsing_request(struct ac_session_t* session, struct capwap_parsed_packet* packet) {
+static struct json_object* ac_dfa_state_configure_parsing_request(struct ac_session_t* session, struct capwap_parsed_packet* packet) {
 	int i;
-	const char* jsonmessage;
-	char* base64confstatus;
 	struct json_object* jsonarray;
 	struct json_object* jsonparam;
 	struct json_object* jsonhash;
@@ -43,7 +42,7 @@ static struct ac_soap_response* ac_dfa_state_configure_parsing_request(struct ac
 	struct capwap_statisticstimer_element* statisticstimer;
 	struct capwap_wtprebootstat_element* wtprebootstat;
 	struct capwap_wtpstaticipaddress_element* wtpstaticipaddress;
-	struct ac_soap_response* response;
+	struct json_object* jsonroot;
 	unsigned short binding = GET_WBID_HEADER(packet->rxmngpacket->header);
 
 	/* Create SOAP request with JSON param
@@ -241,26 +240,19 @@ static struct ac_soap_response* ac_dfa_state_configure_parsing_request(struct ac
 		ac_json_ieee80211_free(&wtpradio);
 	}
 
-	/* Get JSON param and convert base64 */
-	jsonmessage = json_object_to_json_string(jsonparam);
-	base64confstatus = capwap_alloc(AC_BASE64_ENCODE_LENGTH(strlen(jsonmessage)));
-	ac_base64_string_encode(jsonmessage, base64confstatus);
-
-	/* Send message */
-	response = ac_soap_configurestatuswtpsession(session, session->wtpid, base64confstatus);
+	/* Send message, the response can be shared by the WTPs of same profile */
+	jsonroot = ac_profile_send_soap_request(session, AC_PROFILE_CONFIGURE, jsonparam);
 
 	/* Free JSON */
 	json_object_put(jsonparam);
-	capwap_free(base64confstatus);
 
-	return response;
+	return jsonroot;
 }
 
 /* */
-static uint32_t ac_dfa_state_configure_create_response(struct ac_session_t* session, struct capwap_parsed_packet* packet, struct ac_soap_response* response, struct capwap_packet_txmng* txmngpacket) {
+static uint32_t ac_dfa_state_configure_create_response(struct ac_session_t* session, struct capwap_parsed_packet* packet, struct json_object* jsonroot, struct capwap_packet_txmng* txmngpacket) {
 	int length;
 	unsigned long i;
-	struct json_object* jsonroot;
 	struct json_object* jsonelement;
 	struct capwap_array* radioadmstate;
 	struct capwap_timers_element responsetimers;
@@ -394,11 +386,6 @@ static uint32_t ac_dfa_state_configure_create_response(struct ac_session_t* sess
 	*/
 
 	/* Add message elements response, every local value can be overwrite from backend server */
-	jsonroot = ac_soapclient_parse_json_response(response);
-	if (!jsonroot) {
-		return CAPWAP_RESULTCODE_FAILURE;
-	}
-
 	/* CAPWAP Timers */
 	memcpy(&responsetimers, &session->dfa.timers, sizeof(struct capwap_timers_element));
 	if (jsonroot) {
@@ -703,16 +690,12 @@ static uint32_t ac_dfa_state_configure_create_response(struct ac_session_t* sess
 
 	/* CAPWAP_ELEMENT_VENDORPAYLOAD */					/* TODO */
 
-	if (jsonroot) {
-		json_object_put(jsonroot);
-	}
-
 	return CAPWAP_RESULTCODE_SUCCESS;
 }
 
 /* */
 void ac_dfa_state_configure(struct ac_session_t* session, struct capwap_parsed_packet* packet) {
-	struct ac_soap_response* response;
+	struct json_object* jsonroot;
 	struct capwap_header_data capwapheader;
 	struct capwap_packet_txmng* txmngpacket;
 	uint32_t result = CAPWAP_RESULTCODE_FAILURE;
@@ -725,10 +708,10 @@ void ac_dfa_state_configure(struct ac_session_t* session, struct capwap_parsed_p
 	txmngpacket = capwap_packet_txmng_create_ctrl_message(&capwapheader, CAPWAP_CONFIGURATION_STATUS_RESPONSE, packet->rxmngpacket->ctrlmsg.seq, session->mtu);
 
 	/* Parsing request and add message element for respone message */
-	response = ac_dfa_state_configure_parsing_request(session, packet);
-	if (response) {
-		result = ac_dfa_state_configure_create_response(session, packet, response, txmngpacket);
-		ac_soapclient_free_response(response);
+	jsonroot = ac_dfa_state_configure_parsing_request(session, packet);
+	if (jsonroot) {
+		result = ac_dfa_state_configure_create_response(session, packet, jsonroot, txmngpacket);
+		json_object_put(jsonroot);
 	}
 
 	/* With error add result code message element */
@@ -8,8 +8,6 @@
 /* */
 static struct ac_soap_response* ac_dfa_state_datacheck_parsing_request(struct ac_session_t* session, struct capwap_parsed_packet* packet) {
 	int i;
-	const char* jsonmessage;
-	char* base64confstatus;
 	struct capwap_array* elemarray;
 	struct json_object* jsonarray;
 	struct json_object* jsonparam;
@@ -110,17 +108,11 @@ static struct ac_soap_response* ac_dfa_state_datacheck_parsing_request(struct ac
 		ac_json_ieee80211_free(&wtpradio);
 	}
 
-	/* Get JSON param and convert base64 */
-	jsonmessage = json_object_to_json_string(jsonparam);
-	base64confstatus = capwap_alloc(AC_BASE64_ENCODE_LENGTH(strlen(jsonmessage)));
-	ac_base64_string_encode(jsonmessage, base64confstatus);
-
-	/* Send message */
-	response = ac_soap_changestatewtpsession(session, session->wtpid, base64confstatus);
+	/* Send message, JSON param is encoded by backend transport */
+	response = ac_soap_changestatewtpsession(session, session->wtpid, (char*)json_object_to_json_string(jsonparam));
 
 	/* Free JSON */
 	json_object_put(jsonparam);
-	capwap_free(base64confstatus);
 
 	return response;
 }
@@ -4,40 +4,39 @@
 #include "ac_session.h"
 #include "ac_backend.h"
 #include "ac_json.h"
+#include "ac_profile.h"
 #include <json/json.h>
 #include <arpa/inet.h>
 
 /* */
 static int ac_dfa_state_join_check_authorizejoin(struct ac_session_t* session, struct ac_soap_response* response) {
-	xmlChar* xmlResult;
+	char* result;
 
-	if ((response->responsecode != HTTP_RESULT_OK) || !response->xmlResponseReturn) {
+	if (response->responsecode != HTTP_RESULT_OK) {
 		/* TODO: check return failed code */
 		return CAPWAP_RESULTCODE_JOIN_FAILURE_UNKNOWN_SOURCE;
 	}
 
 	// Check return value
-	xmlResult = xmlNodeGetContent(response->xmlResponseReturn);
-	if (!xmlResult) {
+	result = ac_soapclient_get_string_response(response);
+	if (!result) {
 		return CAPWAP_RESULTCODE_JOIN_FAILURE_UNKNOWN_SOURCE;
-	} else if (xmlStrcmp(xmlResult, (const xmlChar *)"true")) {
-		xmlFree(xmlResult);
+	} else if (strcmp(result, "true")) {
+		capwap_free(result);
 		return CAPWAP_RESULTCODE_JOIN_FAILURE_UNKNOWN_SOURCE;
 	}
 
-	xmlFree(xmlResult);
+	capwap_free(result);
 	return CAPWAP_RESULTCODE_SUCCESS;
 }
 
 /* */
-static struct ac_soap_response* ac_dfa_state_join_parsing_request(struct ac_session_t* session, struct capwap_parsed_packet* packet) {
+static struct json_object* ac_dfa_state_join_parsing_request(struct ac_session_t* session, struct capwap_parsed_packet* packet) {
 	int i;
-	const char* jsonmessage;
-	char* base64confstatus;
 	struct json_object* jsonarray;
 	struct json_object* jsonparam;
 	struct json_object* jsonhash;
-	struct ac_soap_response* response;
+	struct json_object* jsonroot;
 	struct capwap_location_element* location;
 	struct capwap_wtpboarddata_element* wtpboarddata;
 	struct capwap_wtpdescriptor_element* wtpdescriptor;
@@ -301,27 +300,20 @@ static struct ac_soap_response* ac_dfa_state_join_parsing_request(struct ac_sess
 		json_object_object_add(jsonparam, "WTPRebootStatistics", jsonhash);
 	}
 
-	/* Get JSON param and convert base64 */
-	jsonmessage = json_object_to_json_string(jsonparam);
-	base64confstatus = capwap_alloc(AC_BASE64_ENCODE_LENGTH(strlen(jsonmessage)));
-	ac_base64_string_encode(jsonmessage, base64confstatus);
-
-	/* Send message */
-	response = ac_soap_joinwtpsession(session, session->wtpid, base64confstatus);
+	/* Send message, the response can be shared by the WTPs of same profile */
+	jsonroot = ac_profile_send_soap_request(session, AC_PROFILE_JOIN, jsonparam);
 
 	/* Free JSON */
 	json_object_put(jsonparam);
-	capwap_free(base64confstatus);
 
-	return response;
+	return jsonroot;
 }
 
 /* */
-static uint32_t ac_dfa_state_join_create_response(struct ac_session_t* session, struct capwap_parsed_packet* packet, struct ac_soap_response* response, struct capwap_packet_txmng* txmngpacket) {
+static uint32_t ac_dfa_state_join_create_response(struct ac_session_t* session, struct capwap_parsed_packet* packet, struct json_object* jsonroot, struct capwap_packet_txmng* txmngpacket) {
 	int i;
 	int j;
 	int length;
-	struct json_object* jsonroot;
 	struct json_object* jsonelement;
 	struct capwap_list* controllist;
 	struct capwap_list_item* item;
@@ -359,9 +351,14 @@ static uint32_t ac_dfa_state_join_create_response(struct ac_session_t* session,
 	*/
 
 	/* Add message elements response, every local value can be overwrite from backend server */
-	jsonroot = ac_soapclient_parse_json_response(response);
-	if (!jsonroot) {
-		return CAPWAP_RESULTCODE_FAILURE;
+	/* Group of WTPs sharing the station authorization decisions */
+	jsonelement = compat_json_object_object_get(jsonroot, "AuthorizationGroup");
+	if (jsonelement && (json_object_get_type(jsonelement) == json_type_string)) {
+		if (session->authgroup) {
+			capwap_free(session->authgroup);
+		}
+
+		session->authgroup = capwap_duplicate_string(json_object_get_string(jsonelement));
 	}
 
 	/* AC Descriptor */
@@ -546,16 +543,13 @@ static uint32_t ac_dfa_state_join_create_response(struct ac_session_t* session,
 	/* CAPWAP_ELEMENT_MAXIMUMLENGTH */					/* TODO */
 	/* CAPWAP_ELEMENT_VENDORPAYLOAD */					/* TODO */
 
-	if (jsonroot) {
-		json_object_put(jsonroot);
-	}
-
 	return CAPWAP_RESULTCODE_SUCCESS;
 }
 
 /* */
 void ac_dfa_state_join(struct ac_session_t* session, struct capwap_parsed_packet* packet) {
 	unsigned short binding;
+	struct json_object* jsonroot;
 	struct ac_soap_response* response;
 	struct capwap_header_data capwapheader;
 	struct capwap_packet_txmng* txmngpacket;
@@ -623,10 +617,12 @@ void ac_dfa_state_join(struct ac_session_t* session, struct capwap_parsed_packet
 
 	/* */
 	if (CAPWAP_RESULTCODE_OK(resultcode.code)) {
-		response = ac_dfa_state_join_parsing_request(session, packet);
-		if (response) {
-			resultcode.code = ac_dfa_state_join_create_response(session, packet, response, txmngpacket);
-			ac_soapclient_free_response(response);
+		jsonroot = ac_dfa_state_join_parsing_request(session, packet);
+		if (jsonroot) {
+			resultcode.code = ac_dfa_state_join_create_response(session, packet, jsonroot, txmngpacket);
+			json_object_put(jsonroot);
+		} else {
+			resultcode.code = CAPWAP_RESULTCODE_FAILURE;
 		}
 	}
 
@@ -4,6 +4,7 @@
 #include "capwap_array.h"
 #include "ac_session.h"
 #include "ac_wlans.h"
+#include "ac_provisioning.h"
 
 /* */
 static int receive_echo_request(struct ac_session_t* session, struct capwap_parsed_packet* packet) {
@@ -15,15 +16,13 @@ static int receive_echo_request(struct ac_session_t* session, struct capwap_pars
 	/* Check session */
 	response = ac_soap_checkwtpsession(session, session->wtpid);
 	if (response) {
-		if ((response->responsecode == HTTP_RESULT_OK) && response->xmlResponseReturn) {
-			xmlChar* xmlResult = xmlNodeGetContent(response->xmlResponseReturn);
-			if (xmlResult) {
-				if (!xmlStrcmp(xmlResult, (const xmlChar *)"true")) {
-					validsession = 1;
-				}
-
-				xmlFree(xmlResult);
+		char* result = ac_soapclient_get_string_response(response);
+		if (result) {
+			if (!strcmp(result, "true")) {
+				validsession = 1;
 			}
+
+			capwap_free(result);
 		}
 
 		ac_soapclient_free_response(response);
@@ -33,6 +32,9 @@ static int receive_echo_request(struct ac_session_t* session, struct capwap_pars
 		return -1;
 	}
 
+	/* Backend confirmed session, following Echo Request can use fast path */
+	ac_session_echo_complete(session);
+
 	/* Create response */
 	capwap_header_init(&capwapheader, CAPWAP_RADIOID_NONE, GET_WBID_HEADER(packet->rxmngpacket->header));
 	txmngpacket = capwap_packet_txmng_create_ctrl_message(&capwapheader, CAPWAP_ECHO_RESPONSE, packet->rxmngpacket->ctrlmsg.seq, session->mtu);
@@ -146,38 +148,54 @@ static void receive_ieee80211_wlan_configuration_response(struct ac_session_t* s
 	}
 
 	/* */
+	ac_provisioning_complete(session, CAPWAP_RESULTCODE_OK(resultcode->code));
 	ac_free_reference_last_request(session);
 }
 
 /* */
 static void execute_ieee80211_station_configuration_response_addstation(struct ac_session_t* session, struct capwap_parsed_packet* packet, struct capwap_parsed_packet* requestpacket) {
+	int i;
 	struct ac_wlan* wlan;
 	struct ac_station* station;
-	struct capwap_addstation_element* addstation;
-	struct capwap_80211_station_element* station80211;
+	struct capwap_array* addstations;
+	struct capwap_array* stations80211;
 	struct capwap_resultcode_element* resultcode;
 
 	/* */
 	resultcode = (struct capwap_resultcode_element*)capwap_get_message_element_data(packet, CAPWAP_ELEMENT_RESULTCODE);
-	addstation = (struct capwap_addstation_element*)capwap_get_message_element_data(requestpacket, CAPWAP_ELEMENT_ADDSTATION);
+	addstations = (struct capwap_array*)capwap_get_message_element_data(requestpacket, CAPWAP_ELEMENT_ADDSTATION);
 
 	/* */
 	if (GET_WBID_HEADER(packet->rxmngpacket->header) == CAPWAP_WIRELESS_BINDING_IEEE80211) {
-		station80211 = (struct capwap_80211_station_element*)capwap_get_message_element_data(requestpacket, CAPWAP_ELEMENT_80211_STATION);
-		if (station80211) {
-			wlan = ac_wlans_get_bssid_with_wlanid(session, station80211->radioid, station80211->wlanid);
-			if (wlan) {
-				station = ac_stations_get_station(session, station80211->radioid, wlan->address, addstation->address);
-				if (station) {
-					if (CAPWAP_RESULTCODE_OK(resultcode->code)) {
-						capwap_logging_info("Authorized station: %s", station->addrtext);
-
-						/* */
-						station->flags |= AC_STATION_FLAGS_AUTHORIZED;
-						capwap_timeout_deletetimer(session->timeout, station->idtimeout);
-						station->idtimeout = CAPWAP_TIMEOUT_INDEX_NO_SET;
-					} else {
-						ac_stations_delete_station(session, station);
+		stations80211 = (struct capwap_array*)capwap_get_message_element_data(requestpacket, CAPWAP_ELEMENT_80211_STATION);
+		if (stations80211 && (addstations->count == stations80211->count)) {
+			for (i = 0; i < addstations->count; i++) {
+				struct capwap_addstation_element* addstation = *(struct capwap_addstation_element**)capwap_array_get_item_pointer(addstations, i);
+				struct capwap_80211_station_element* station80211 = *(struct capwap_80211_station_element**)capwap_array_get_item_pointer(stations80211, i);
+
+				wlan = ac_wlans_get_bssid_with_wlanid(session, station80211->radioid, station80211->wlanid);
+				if (wlan) {
+					station = ac_stations_get_station(session, station80211->radioid, wlan->address, addstation->address);
+					if (station) {
+						if (CAPWAP_RESULTCODE_OK(resultcode->code)) {
+							capwap_logging_info("Authorized station: %s", station->addrtext);
+
+							/* */
+							station->flags |= AC_STATION_FLAGS_AUTHORIZED;
+							capwap_timeout_deletetimer(session->timeout, station->idtimeout);
+							station->idtimeout = CAPWAP_TIMEOUT_INDEX_NO_SET;
+						} else {
+							/* The WTP rolls back all stations of a failed request */
+							ac_kmod_deauthorize_station(&session->sessionid, station->address);
+
+							/* Retry one by one the stations of a batch, so only the failed station is deleted */
+							if (addstations->count > 1) {
+								capwap_logging_info("Retry authorization of station: %s", station->addrtext);
+								ac_stations_retry_authorize_station(session, station);
+							} else {
+								ac_stations_delete_station(session, station);
+							}
+						}
 					}
 				}
 			}
@@ -187,21 +205,26 @@ static void execute_ieee80211_station_configuration_response_addstation(struct a
 
 /* */
 static void execute_ieee80211_station_configuration_response_deletestation(struct ac_session_t* session, struct capwap_parsed_packet* packet, struct capwap_parsed_packet* requestpacket) {
+	int i;
 	struct ac_station* station;
+	struct capwap_array* deletestations;
 	struct capwap_resultcode_element* resultcode;
-	struct capwap_deletestation_element* deletestation;
 
 	/* */
 	resultcode = (struct capwap_resultcode_element*)capwap_get_message_element_data(packet, CAPWAP_ELEMENT_RESULTCODE);
-	deletestation = (struct capwap_deletestation_element*)capwap_get_message_element_data(requestpacket, CAPWAP_ELEMENT_DELETESTATION);
+	deletestations = (struct capwap_array*)capwap_get_message_element_data(requestpacket, CAPWAP_ELEMENT_DELETESTATION);
 
 	/* */
-	station = ac_stations_get_station(session, deletestation->radioid, NULL, deletestation->address);
-	if (station) {
-		capwap_logging_info("Deauthorized station: %s with %d result code", station->addrtext, (int)resultcode->code);
+	for (i = 0; i < deletestations->count; i++) {
+		struct capwap_deletestation_element* deletestation = *(struct capwap_deletestation_element**)capwap_array_get_item_pointer(deletestations, i);
 
-		/* */
-		ac_stations_delete_station(session, station);
+		station = ac_stations_get_station(session, deletestation->radioid, NULL, deletestation->address);
+		if (station) {
+			capwap_logging_info("Deauthorized station: %s with %d result code", station->addrtext, (int)resultcode->code);
+
+			/* */
+			ac_stations_delete_station(session, station);
+		}
 	}
 }
 
@@ -243,13 +266,13 @@ void ac_dfa_state_run(struct ac_session_t* session, struct capwap_parsed_packet*
 				/* TODO */
 
 				/* */
-				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 				break;
 			}
 
 			case CAPWAP_CHANGE_STATE_EVENT_REQUEST: {
 				/* TODO */
-				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 				break;
 			}
 
@@ -263,7 +286,7 @@ void ac_dfa_state_run(struct ac_session_t* session, struct capwap_parsed_packet*
 #endif
 
 				if (!receive_echo_request(session, packet)) {
-					capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+					capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 				} else {
 					ac_session_teardown(session);
 				}
@@ -275,19 +298,19 @@ void ac_dfa_state_run(struct ac_session_t* session, struct capwap_parsed_packet*
 				/* TODO */
 
 				/* */
-				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 				break;
 			}
 
 			case CAPWAP_WTP_EVENT_REQUEST: {
 				/* TODO */
-				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 				break;
 			}
 
 			case CAPWAP_DATA_TRANSFER_REQUEST: {
 				/* TODO */
-				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 				break;
 			}
 
@@ -295,19 +318,19 @@ void ac_dfa_state_run(struct ac_session_t* session, struct capwap_parsed_packet*
 				/* TODO */
 
 				/* */
-				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 				break;
 			}
 
 			case CAPWAP_STATION_CONFIGURATION_RESPONSE: {
 				receive_ieee80211_station_configuration_response(session, packet);
-				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 				break;
 			}
 
 			case CAPWAP_IEEE80211_WLAN_CONFIGURATION_RESPONSE: {
 				receive_ieee80211_wlan_configuration_response(session, packet);
-				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+				capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 				break;
 			}
 		}
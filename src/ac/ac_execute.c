@@ -3,6 +3,9 @@
 #include "ac_session.h"
 #include "ac_discovery.h"
 #include "ac_backend.h"
+#include "ac_soap.h"
+#include "ac_provisioning.h"
+#include "ac_batch.h"
 #include "ac_wlans.h"
 
 #include <signal.h>
@@ -416,10 +419,7 @@ static struct ac_session_t* ac_search_session_from_wtpaddress(union sockaddr_cap
 		
 		if (!capwap_compare_ip(address, &session->dtls.peeraddr)) {
 			/* Increment session count */
-			capwap_lock_enter(&session->sessionlock);
-			session->count++;
-			capwap_event_signal(&session->changereference);
-			capwap_lock_exit(&session->sessionlock);
+			capwap_atomic_inc(&session->count);
 
 			/*  */
 			result = session;
@@ -450,10 +450,7 @@ struct ac_session_t* ac_search_session_from_wtpid(const char* wtpid) {
 		
 		if (session->wtpid && !strcmp(session->wtpid, wtpid)) {
 			/* Increment session count */
-			capwap_lock_enter(&session->sessionlock);
-			session->count++;
-			capwap_event_signal(&session->changereference);
-			capwap_lock_exit(&session->sessionlock);
+			capwap_atomic_inc(&session->count);
 
 			/*  */
 			result = session;
@@ -484,10 +481,7 @@ struct ac_session_t* ac_search_session_from_sessionid(struct capwap_sessionid_el
 		
 		if (!memcmp(sessionid, &session->sessionid, sizeof(struct capwap_sessionid_element))) {
 			/* Increment session count */
-			capwap_lock_enter(&session->sessionlock);
-			session->count++;
-			capwap_event_signal(&session->changereference);
-			capwap_lock_exit(&session->sessionlock);
+			capwap_atomic_inc(&session->count);
 
 			/*  */
 			result = session;
@@ -630,7 +624,7 @@ static struct ac_session_t* ac_create_session(int sock, union sockaddr_capwap* f
 	ac_wlans_init(session);
 
 	/* */
-	session->count = 2;
+	capwap_atomic_init(&session->count, 2);
 	capwap_event_init(&session->changereference);
 
 	/* */
@@ -651,6 +645,9 @@ static struct ac_session_t* ac_create_session(int sock, union sockaddr_capwap* f
 		memcpy(capwap_array_get_item_pointer(session->dfa.acipv6list.addresses, 0), &session->dtls.localaddr.sin6.sin6_addr, sizeof(struct in6_addr));
 	}
 
+	/* Retransmission timer estimation */
+	capwap_rtt_init(&session->rtt, session->dfa.retransmit.initial, session->dfa.retransmit.min, session->dfa.retransmit.max);
+
 	/* Init */
 	capwap_event_init(&session->waitpacket);
 	capwap_lock_init(&session->sessionlock);
@@ -693,11 +690,12 @@ static struct ac_session_t* ac_create_session(int sock, union sockaddr_capwap* f
 void ac_session_release_reference(struct ac_session_t* session) {
 	ASSERT(session != NULL);
 
-	capwap_lock_enter(&session->sessionlock);
-	ASSERT(session->count > 0);
-	session->count--;
-	capwap_event_signal(&session->changereference);
-	capwap_lock_exit(&session->sessionlock);
+	ASSERT(capwap_atomic_read(&session->count) > 0);
+
+	/* Only last reference wakes up session destroy */
+	if (capwap_atomic_dec_and_test(&session->count)) {
+		capwap_event_signal(&session->changereference);
+	}
 }
 
 /* Update statistics */
@@ -845,14 +843,45 @@ int ac_execute(void) {
 		return AC_ERROR_SYSTEM_FAILER;
 	}
 
+	/* Enable asynchronous SOAP client */
+	if (!ac_soapclient_async_start()) {
+		ac_execute_free_fdspool(&fds);
+		ac_discovery_stop();
+		capwap_logging_error("Unable start SOAP client");
+		return AC_ERROR_SYSTEM_FAILER;
+	}
+
+	/* Enable batching of backend requests */
+	if (!ac_batch_start()) {
+		ac_execute_free_fdspool(&fds);
+		ac_soapclient_async_stop();
+		ac_batch_stop();
+		ac_discovery_stop();
+		capwap_logging_error("Unable start backend batching");
+		return AC_ERROR_SYSTEM_FAILER;
+	}
+
 	/* Enable Backend Management */
 	if (!ac_backend_start()) {
 		ac_execute_free_fdspool(&fds);
+		ac_soapclient_async_stop();
+		ac_batch_stop();
 		ac_discovery_stop();
 		capwap_logging_error("Unable start backend management");
 		return AC_ERROR_SYSTEM_FAILER;
 	}
 
+	/* Enable Bulk WLAN provisioning */
+	if (!ac_provisioning_start()) {
+		ac_execute_free_fdspool(&fds);
+		ac_backend_stop();
+		ac_soapclient_async_stop();
+		ac_batch_stop();
+		ac_discovery_stop();
+		capwap_logging_error("Unable start WLAN provisioning");
+		return AC_ERROR_SYSTEM_FAILER;
+	}
+
 	/* */
 	while (g_ac.running) {
 		/* Receive packet */
@@ -869,7 +898,9 @@ int ac_execute(void) {
 			session = ac_search_session_from_wtpaddress(&fromaddr);
 			if (session) {
 				/* Add packet*/
-				ac_session_add_packet(session, buffer, buffersize, 0);
+				if (!ac_session_recv_echo_request(session, buffer, buffersize, 0)) {
+					ac_session_add_packet(session, buffer, buffersize, 0);
+				}
 
 				/* Release reference */
 				ac_session_release_reference(session);
@@ -926,6 +957,9 @@ int ac_execute(void) {
 		}
 	}
 
+	/* Disable Bulk WLAN provisioning */
+	ac_provisioning_stop();
+
 	/* Disable Backend Management */
 	ac_backend_stop();
 
@@ -938,6 +972,10 @@ int ac_execute(void) {
 	/* Wait to terminate all sessions */
 	ac_wait_terminate_allsessions();
 
+	/* Disable asynchronous SOAP client, the batches still in flight are completed */
+	ac_soapclient_async_stop();
+	ac_batch_stop();
+
 	/* Close data channel interfaces */
 	capwap_hash_deleteall(g_ac.ifdatachannel);
 
@@ -0,0 +1,570 @@
+#include "ac.h"
+#include "ac_soap.h"
+#include "ac_backend.h"
+#include "ac_health.h"
+
+/* Log-linear histogram of latency in microseconds, every power of two is split
+   into 16 buckets so the error of percentile is below 1/16 */
+#define AC_HEALTH_HISTOGRAM_SUBBITS			4
+#define AC_HEALTH_HISTOGRAM_SUBBUCKETS		(1 << AC_HEALTH_HISTOGRAM_SUBBITS)
+#define AC_HEALTH_HISTOGRAM_BUCKETS			((32 - AC_HEALTH_HISTOGRAM_SUBBITS + 1) * AC_HEALTH_HISTOGRAM_SUBBUCKETS)
+
+/* Outcome of call into circuit breaker window */
+#define AC_HEALTH_CALL_ERROR				0x01
+#define AC_HEALTH_CALL_SLOW					0x02
+
+/* */
+struct ac_health_histogram {
+	unsigned long count;
+	unsigned long buckets[AC_HEALTH_HISTOGRAM_BUCKETS];
+};
+
+/* */
+struct ac_health_backend {
+	struct ac_http_soap_server* server;
+
+	/* Circuit breaker */
+	int state;
+	struct timeval opened;
+	unsigned long probesuccess;
+	int probing;
+
+	/* Outcome of last calls */
+	uint8_t window[AC_HEALTH_MAX_WINDOW];
+	unsigned long windowpos;
+	unsigned long windowcount;
+	unsigned long errors;
+	unsigned long slows;
+
+	/* Statistics */
+	unsigned long failed;
+	unsigned long trips;
+	struct ac_health_histogram latency[AC_HEALTH_OPERATION_COUNT];
+};
+
+/* */
+struct ac_health_t {
+	pthread_t threadid;
+	int running;
+	int endthread;
+
+	capwap_event_t wait;
+	capwap_lock_t lock;
+
+	unsigned long count;
+	struct ac_health_backend* backends;
+};
+
+static struct ac_health_t g_ac_health;
+
+/* Operation of backend methods, the long polling of events is not tracked */
+struct ac_health_method {
+	const char* method;
+	int operation;
+};
+
+static const struct ac_health_method g_ac_health_methods[] = {
+	{ "authorizeWTPSession", AC_HEALTH_OPERATION_SESSION },
+	{ "joinWTPSession", AC_HEALTH_OPERATION_SESSION },
+	{ "configureStatusWTPSession", AC_HEALTH_OPERATION_SESSION },
+	{ "changeStateWTPSession", AC_HEALTH_OPERATION_SESSION },
+	{ "runningWTPSession", AC_HEALTH_OPERATION_SESSION },
+	{ "teardownWTPSession", AC_HEALTH_OPERATION_SESSION },
+	{ "checkWTPSession", AC_HEALTH_OPERATION_SESSION },
+	{ "authorizeStation", AC_HEALTH_OPERATION_STATION },
+	{ "updateBackendEvent", AC_HEALTH_OPERATION_EVENT },
+	{ "ackBackendEvent", AC_HEALTH_OPERATION_EVENT },
+	{ "joinBackend", AC_HEALTH_OPERATION_CONTROL },
+	{ "leaveBackend", AC_HEALTH_OPERATION_CONTROL },
+	{ "getConfiguration", AC_HEALTH_OPERATION_CONTROL },
+	{ "updateWLANProvisioning", AC_HEALTH_OPERATION_CONTROL },
+	{ NULL, 0 }
+};
+
+static const char* g_ac_health_operations[AC_HEALTH_OPERATION_COUNT] = {
+	"session",
+	"station",
+	"event",
+	"control"
+};
+
+/* */
+static int ac_health_get_operation(const char* method) {
+	int i;
+
+	for (i = 0; g_ac_health_methods[i].method; i++) {
+		if (!strcmp(g_ac_health_methods[i].method, method)) {
+			return g_ac_health_methods[i].operation;
+		}
+	}
+
+	return -1;
+}
+
+/* */
+static long ac_health_get_elapsed(struct timeval* start, struct timeval* now) {
+	return ((now->tv_sec - start->tv_sec) * 1000000) + (now->tv_usec - start->tv_usec);
+}
+
+/* Search backend, must be called with lock */
+static struct ac_health_backend* ac_health_get_backend(struct ac_http_soap_server* server) {
+	unsigned long i;
+
+	for (i = 0; i < g_ac_health.count; i++) {
+		if (g_ac_health.backends[i].server == server) {
+			return &g_ac_health.backends[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* */
+static void ac_health_histogram_add(struct ac_health_histogram* histogram, unsigned long value) {
+	int index;
+	int exponent;
+
+	if (value < AC_HEALTH_HISTOGRAM_SUBBUCKETS) {
+		index = (int)value;
+	} else {
+		if (value > 0xffffffffUL) {
+			value = 0xffffffffUL;
+		}
+
+		/* Position of most significant bit */
+		exponent = (sizeof(unsigned long) * 8 - 1) - __builtin_clzl(value);
+		index = ((exponent - AC_HEALTH_HISTOGRAM_SUBBITS + 1) << AC_HEALTH_HISTOGRAM_SUBBITS) + (int)((value >> (exponent - AC_HEALTH_HISTOGRAM_SUBBITS)) & (AC_HEALTH_HISTOGRAM_SUBBUCKETS - 1));
+	}
+
+	histogram->count++;
+	histogram->buckets[index]++;
+}
+
+/* Upper bound of bucket */
+static unsigned long ac_health_histogram_value(int index) {
+	int shift;
+
+	if (index < AC_HEALTH_HISTOGRAM_SUBBUCKETS) {
+		return (unsigned long)index;
+	}
+
+	shift = (index >> AC_HEALTH_HISTOGRAM_SUBBITS) - 1;
+	return ((((unsigned long)(index & (AC_HEALTH_HISTOGRAM_SUBBUCKETS - 1)) + AC_HEALTH_HISTOGRAM_SUBBUCKETS + 1) << shift) - 1);
+}
+
+/* */
+static unsigned long ac_health_histogram_percentile(struct ac_health_histogram* histogram, int permille) {
+	int i;
+	unsigned long rank;
+	unsigned long count = 0;
+
+	if (!histogram->count) {
+		return 0;
+	}
+
+	/* Nearest rank */
+	rank = (histogram->count * (unsigned long)permille + 999) / 1000;
+	if (!rank) {
+		rank = 1;
+	}
+
+	for (i = 0; i < AC_HEALTH_HISTOGRAM_BUCKETS; i++) {
+		count += histogram->buckets[i];
+		if (count >= rank) {
+			return ac_health_histogram_value(i);
+		}
+	}
+
+	return ac_health_histogram_value(AC_HEALTH_HISTOGRAM_BUCKETS - 1);
+}
+
+/* */
+static void ac_health_reset_window(struct ac_health_backend* backend) {
+	backend->windowpos = 0;
+	backend->windowcount = 0;
+	backend->errors = 0;
+	backend->slows = 0;
+}
+
+/* Add outcome into window and check the thresholds, must be called with lock */
+static int ac_health_add_window(struct ac_health_backend* backend, uint8_t outcome) {
+	/* Replace the oldest outcome */
+	if (backend->windowcount == g_ac.health.window) {
+		uint8_t oldest = backend->window[backend->windowpos];
+
+		backend->errors -= ((oldest & AC_HEALTH_CALL_ERROR) ? 1 : 0);
+		backend->slows -= ((oldest & AC_HEALTH_CALL_SLOW) ? 1 : 0);
+	} else {
+		backend->windowcount++;
+	}
+
+	backend->window[backend->windowpos] = outcome;
+	backend->windowpos = (backend->windowpos + 1) % g_ac.health.window;
+	backend->errors += ((outcome & AC_HEALTH_CALL_ERROR) ? 1 : 0);
+	backend->slows += ((outcome & AC_HEALTH_CALL_SLOW) ? 1 : 0);
+
+	/* */
+	if (backend->windowcount < g_ac.health.minimumcalls) {
+		return 0;
+	}
+
+	return (((backend->errors * 100) >= (backend->windowcount * g_ac.health.errorrate)) || ((backend->slows * 100) >= (backend->windowcount * g_ac.health.slowrate)));
+}
+
+/* */
+static void ac_health_probe_callback(struct ac_http_soap_request* httprequest, struct ac_soap_response* response, void* param) {
+	int closed = 0;
+	struct ac_health_backend* backend = (struct ac_health_backend*)param;
+
+	/* Also a fault proves that Backend Server is able to answer */
+	capwap_lock_enter(&g_ac_health.lock);
+
+	backend->probing = 0;
+	if (backend->state == AC_HEALTH_CIRCUIT_HALFOPEN) {
+		if (response) {
+			backend->probesuccess++;
+			if (backend->probesuccess >= g_ac.health.probesuccess) {
+				closed = 1;
+				backend->state = AC_HEALTH_CIRCUIT_CLOSED;
+				ac_health_reset_window(backend);
+			}
+		} else {
+			backend->state = AC_HEALTH_CIRCUIT_OPEN;
+			gettimeofday(&backend->opened, NULL);
+		}
+	}
+
+	capwap_lock_exit(&g_ac_health.lock);
+
+	/* */
+	if (closed) {
+		capwap_logging_info("Backend Server %s is healthy, circuit closed", backend->server->host);
+	}
+
+	if (response) {
+		ac_soapclient_free_response(response);
+	}
+
+	ac_soapclient_close_request(httprequest, 1);
+}
+
+/* Probe Backend Server without session, a probe slower than slow calls fails */
+static void ac_health_probe(struct ac_health_backend* backend) {
+	struct ac_soap_request* request;
+	struct ac_http_soap_request* soaprequest;
+
+	request = ac_soapclient_create_request("pingBackend", SOAP_NAMESPACE_URI);
+	if (request) {
+		ac_soapclient_add_param(request, "xs:string", "idac", g_ac.backendacid);
+		soaprequest = ac_soapclient_prepare_request(request, backend->server);
+		if (soaprequest) {
+			soaprequest->deadline = g_ac.health.slowlatency;
+			if (ac_soapclient_async_submit(soaprequest, "", soaprequest->deadline, ac_health_probe_callback, (void*)backend)) {
+				return;
+			}
+
+			ac_soapclient_close_request(soaprequest, 1);
+		} else {
+			ac_soapclient_free_request(request);
+		}
+	}
+
+	/* Retry with next probe */
+	capwap_lock_enter(&g_ac_health.lock);
+	backend->probing = 0;
+	capwap_lock_exit(&g_ac_health.lock);
+}
+
+/* */
+static void* ac_health_thread(void* param) {
+	unsigned long i;
+	unsigned long count;
+	long waittime;
+	struct timeval now;
+	struct timeval lastlog;
+	struct ac_health_backend* probes[g_ac_health.count];
+
+	capwap_logging_debug("Backend health start");
+
+	/* Wake up for probe and log of latency */
+	waittime = (g_ac.health.window ? g_ac.health.probeinterval : g_ac.health.loginterval);
+	if (g_ac.health.window && g_ac.health.loginterval && (g_ac.health.loginterval < waittime)) {
+		waittime = g_ac.health.loginterval;
+	}
+
+	/* */
+	gettimeofday(&lastlog, NULL);
+	while (!g_ac_health.endthread) {
+		count = 0;
+		gettimeofday(&now, NULL);
+
+		/* Latency percentiles of Backend Server */
+		if (g_ac.health.loginterval && ((ac_health_get_elapsed(&lastlog, &now) / 1000) >= g_ac.health.loginterval)) {
+			ac_health_log();
+			lastlog = now;
+		}
+
+		/* Backend Server with open circuit is probed after open time */
+		capwap_lock_enter(&g_ac_health.lock);
+
+		for (i = 0; i < g_ac_health.count; i++) {
+			struct ac_health_backend* backend = &g_ac_health.backends[i];
+
+			if ((backend->state == AC_HEALTH_CIRCUIT_OPEN) && ((ac_health_get_elapsed(&backend->opened, &now) / 1000) >= g_ac.health.opentime)) {
+				backend->state = AC_HEALTH_CIRCUIT_HALFOPEN;
+				backend->probesuccess = 0;
+			}
+
+			if ((backend->state == AC_HEALTH_CIRCUIT_HALFOPEN) && !backend->probing) {
+				backend->probing = 1;
+				probes[count++] = backend;
+			}
+		}
+
+		capwap_lock_exit(&g_ac_health.lock);
+
+		/* */
+		for (i = 0; i < count; i++) {
+			ac_health_probe(probes[i]);
+		}
+
+		capwap_event_wait_timeout(&g_ac_health.wait, waittime);
+	}
+
+	capwap_logging_debug("Backend health stop");
+
+	/* Thread exit */
+	pthread_exit(NULL);
+	return NULL;
+}
+
+/* */
+int ac_health_start(void) {
+	int result;
+	unsigned long i;
+
+	memset(&g_ac_health, 0, sizeof(struct ac_health_t));
+
+	/* */
+	capwap_lock_init(&g_ac_health.lock);
+	capwap_event_init(&g_ac_health.wait);
+
+	/* */
+	g_ac_health.count = g_ac.availablebackends->count;
+	g_ac_health.backends = (struct ac_health_backend*)capwap_alloc(sizeof(struct ac_health_backend) * g_ac_health.count);
+	memset(g_ac_health.backends, 0, sizeof(struct ac_health_backend) * g_ac_health.count);
+	for (i = 0; i < g_ac_health.count; i++) {
+		g_ac_health.backends[i].server = *(struct ac_http_soap_server**)capwap_array_get_item_pointer(g_ac.availablebackends, i);
+		g_ac_health.backends[i].state = AC_HEALTH_CIRCUIT_CLOSED;
+	}
+
+	/* Without circuit breaker and periodic log the Backend Servers are never checked */
+	if (!g_ac.health.window && !g_ac.health.loginterval) {
+		return 1;
+	}
+
+	/* Create thread */
+	result = pthread_create(&g_ac_health.threadid, NULL, ac_health_thread, NULL);
+	if (result) {
+		capwap_logging_debug("Unable create backend health thread");
+		return 0;
+	}
+
+	g_ac_health.running = 1;
+	return 1;
+}
+
+/* */
+void ac_health_stop(void) {
+	void* dummy;
+
+	if (g_ac_health.running) {
+		g_ac_health.endthread = 1;
+		capwap_event_signal(&g_ac_health.wait);
+
+		/* Wait close thread */
+		pthread_join(g_ac_health.threadid, &dummy);
+		g_ac_health.running = 0;
+	}
+}
+
+/* */
+void ac_health_free(void) {
+	ac_health_log();
+
+	/* */
+	if (g_ac_health.backends) {
+		capwap_free(g_ac_health.backends);
+		g_ac_health.backends = NULL;
+		g_ac_health.count = 0;
+	}
+
+	capwap_event_destroy(&g_ac_health.wait);
+	capwap_lock_destroy(&g_ac_health.lock);
+}
+
+/* Maximum time of request in milliseconds, 0 for untracked methods */
+long ac_health_get_deadline(const char* method) {
+	ASSERT(method != NULL);
+
+	switch (ac_health_get_operation(method)) {
+		case AC_HEALTH_OPERATION_SESSION: {
+			return g_ac.health.sessiondeadline;
+		}
+
+		case AC_HEALTH_OPERATION_STATION: {
+			return g_ac.health.stationdeadline;
+		}
+
+		case AC_HEALTH_OPERATION_EVENT: {
+			return g_ac.health.eventdeadline;
+		}
+
+		case AC_HEALTH_OPERATION_CONTROL: {
+			return g_ac.health.controldeadline;
+		}
+	}
+
+	return 0;
+}
+
+/* Track latency and outcome of request, open the circuit when thresholds are crossed */
+void ac_health_record(struct ac_http_soap_server* server, const char* method, struct timeval* start, int success) {
+	int opened = 0;
+	int operation;
+	long latency;
+	struct timeval now;
+	struct ac_health_backend* backend;
+
+	ASSERT(server != NULL);
+	ASSERT(method != NULL);
+	ASSERT(start != NULL);
+
+	/* */
+	operation = ac_health_get_operation(method);
+	if (operation < 0) {
+		return;
+	}
+
+	gettimeofday(&now, NULL);
+	latency = ac_health_get_elapsed(start, &now);
+	if (latency < 0) {
+		latency = 0;
+	}
+
+	/* */
+	capwap_lock_enter(&g_ac_health.lock);
+
+	backend = ac_health_get_backend(server);
+	if (backend) {
+		ac_health_histogram_add(&backend->latency[operation], (unsigned long)latency);
+		if (!success) {
+			backend->failed++;
+		}
+
+		if (g_ac.health.window && (backend->state == AC_HEALTH_CIRCUIT_CLOSED)) {
+			uint8_t outcome = ((!success ? AC_HEALTH_CALL_ERROR : 0) | (((latency / 1000) >= g_ac.health.slowlatency) ? AC_HEALTH_CALL_SLOW : 0));
+
+			if (ac_health_add_window(backend, outcome)) {
+				opened = 1;
+				backend->trips++;
+				backend->state = AC_HEALTH_CIRCUIT_OPEN;
+				memcpy(&backend->opened, &now, sizeof(struct timeval));
+				capwap_logging_warning("Backend Server %s is unhealthy, circuit opened: %lu failed and %lu slow of last %lu requests", server->host, backend->errors, backend->slows, backend->windowcount);
+				ac_health_reset_window(backend);
+			}
+		}
+	}
+
+	capwap_lock_exit(&g_ac_health.lock);
+
+	/* Shed the load to another Backend Server */
+	if (opened) {
+		ac_backend_failover();
+	}
+}
+
+/* */
+int ac_health_isavailable(struct ac_http_soap_server* server) {
+	int result = 1;
+	struct ac_health_backend* backend;
+
+	ASSERT(server != NULL);
+
+	capwap_lock_enter(&g_ac_health.lock);
+
+	backend = ac_health_get_backend(server);
+	if (backend && (backend->state != AC_HEALTH_CIRCUIT_CLOSED)) {
+		result = 0;
+	}
+
+	capwap_lock_exit(&g_ac_health.lock);
+
+	return result;
+}
+
+/* Answer of AC while the Backend Server is unavailable, NULL reject the request.
+   New WTPs are never admitted, the WTPs already joined can keep running and the
+   stations can be authorized into a local data channel interface */
+struct ac_soap_response* ac_health_local_response(const char* method) {
+	struct json_object* jsonroot;
+	struct json_object* jsonsection;
+	struct ac_soap_response* response = NULL;
+
+	ASSERT(method != NULL);
+
+	if (!strcmp(method, "authorizeStation")) {
+		if (g_ac.health.datachannel >= 0) {
+			/* Same result of backend, without CacheTTL the decision is not cached */
+			jsonsection = json_object_new_object();
+			json_object_object_add(jsonsection, "Index", json_object_new_int(g_ac.health.datachannel));
+
+			jsonroot = json_object_new_object();
+			json_object_object_add(jsonroot, "DataChannelInterface", jsonsection);
+
+			response = ac_soapclient_create_json_response(HTTP_RESULT_OK, jsonroot);
+			json_object_put(jsonroot);
+		}
+	} else if (g_ac.health.keeprunning) {
+		if (!strcmp(method, "checkWTPSession") || !strcmp(method, "runningWTPSession") || !strcmp(method, "teardownWTPSession")) {
+			response = ac_soapclient_create_response(HTTP_RESULT_OK, "true");
+		} else if (!strcmp(method, "changeStateWTPSession")) {
+			jsonroot = json_object_new_object();
+			response = ac_soapclient_create_json_response(HTTP_RESULT_OK, jsonroot);
+			json_object_put(jsonroot);
+		}
+	}
+
+	return response;
+}
+
+/* */
+void ac_health_log(void) {
+	int i;
+	unsigned long j;
+
+	capwap_lock_enter(&g_ac_health.lock);
+
+	for (j = 0; j < g_ac_health.count; j++) {
+		struct ac_health_backend* backend = &g_ac_health.backends[j];
+
+		capwap_logging_info("Backend %s health: circuit %s, %lu failed, %lu trips", backend->server->host,
+			((backend->state == AC_HEALTH_CIRCUIT_CLOSED) ? "closed" : ((backend->state == AC_HEALTH_CIRCUIT_OPEN) ? "open" : "half-open")), backend->failed, backend->trips);
+
+		for (i = 0; i < AC_HEALTH_OPERATION_COUNT; i++) {
+			struct ac_health_histogram* histogram = &backend->latency[i];
+
+			if (histogram->count) {
+				capwap_logging_info("Backend %s %s latency: %lu requests, p50 %lu us, p99 %lu us, p999 %lu us", backend->server->host, g_ac_health_operations[i], histogram->count,
+					ac_health_histogram_percentile(histogram, 500), ac_health_histogram_percentile(histogram, 990), ac_health_histogram_percentile(histogram, 999));
+			}
+		}
+	}
+
+	capwap_lock_exit(&g_ac_health.lock);
+
+	/* Effectiveness of keep-alive connection pool */
+	for (j = 0; j < g_ac_health.count; j++) {
+		ac_soapclient_log_server(g_ac_health.backends[j].server);
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef __AC_HEALTH_HEADER__
+#define __AC_HEALTH_HEADER__
+
+/* */
+#define AC_HEALTH_MAX_WINDOW				256
+
+/* Operations with own deadline and latency histogram */
+#define AC_HEALTH_OPERATION_SESSION			0
+#define AC_HEALTH_OPERATION_STATION			1
+#define AC_HEALTH_OPERATION_EVENT			2
+#define AC_HEALTH_OPERATION_CONTROL			3
+#define AC_HEALTH_OPERATION_COUNT			4
+
+/* State of circuit breaker */
+#define AC_HEALTH_CIRCUIT_CLOSED			0
+#define AC_HEALTH_CIRCUIT_OPEN				1
+#define AC_HEALTH_CIRCUIT_HALFOPEN			2
+
+/* */
+struct ac_http_soap_server;
+struct ac_soap_response;
+
+/* */
+int ac_health_start(void);
+void ac_health_stop(void);
+void ac_health_free(void);
+
+/* */
+long ac_health_get_deadline(const char* method);
+void ac_health_record(struct ac_http_soap_server* server, const char* method, struct timeval* start, int success);
+int ac_health_isavailable(struct ac_http_soap_server* server);
+
+/* Degraded local policy */
+struct ac_soap_response* ac_health_local_response(const char* method);
+
+/* */
+void ac_health_log(void);
+
+#endif /* __AC_HEALTH_HEADER__ */
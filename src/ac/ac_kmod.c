@@ -3,6 +3,7 @@
 #include <netlink/genl/family.h>
 #include <netlink/genl/ctrl.h>
 #include "ac_session.h"
+#include "ac_xdp.h"
 #include "nlsmartcapwap.h"
 
 /* Compatibility functions */
@@ -37,6 +38,8 @@ static void nl_socket_free(struct nl_sock* handle) {
 
 	nl_handle_destroy(handle);
 }
+
+#define NLE_AGAIN			EAGAIN
 #endif
 
 /* */
@@ -82,6 +85,18 @@ static int ac_kmod_ack_handler(struct nl_msg* msg, void* arg) {
 	return NL_STOP;
 }
 
+/* */
+static void ac_kmod_recv_data(struct nlattr** tb_msg) {
+	if (tb_msg[NLSMARTCAPWAP_ATTR_SESSION_ID] && tb_msg[NLSMARTCAPWAP_ATTR_DATA_FRAME]) {
+		struct ac_session_t* session = ac_search_session_from_sessionid((struct capwap_sessionid_element*)nla_data(tb_msg[NLSMARTCAPWAP_ATTR_SESSION_ID]));
+
+		if (session) {
+			ac_session_send_action(session, AC_SESSION_ACTION_RECV_IEEE80211_MGMT_PACKET, 0, nla_data(tb_msg[NLSMARTCAPWAP_ATTR_DATA_FRAME]), nla_len(tb_msg[NLSMARTCAPWAP_ATTR_DATA_FRAME]));
+			ac_session_release_reference(session);
+		}
+	}
+}
+
 /* */
 static int ac_kmod_event_handler(struct genlmsghdr* gnlh, struct nlattr** tb_msg, void* data) {
 	switch (gnlh->cmd) {
@@ -91,8 +106,15 @@ static int ac_kmod_event_handler(struct genlmsghdr* gnlh, struct nlattr** tb_msg
 				struct ac_session_t* session = ac_search_session_from_sessionid(sessionid);
 
 				if (session) {
+					if (tb_msg[NLSMARTCAPWAP_ATTR_ADDRESS]) {
+						ac_xdp_update_session(sessionid, (struct sockaddr_storage*)nla_data(tb_msg[NLSMARTCAPWAP_ATTR_ADDRESS]));
+					}
+
 					ac_kmod_send_keepalive(sessionid);
-					ac_session_send_action(session, AC_SESSION_ACTION_RECV_KEEPALIVE, 0, NULL, 0);
+					if (!ac_session_recv_keepalive(session)) {
+						ac_session_send_action(session, AC_SESSION_ACTION_RECV_KEEPALIVE, 0, NULL, 0);
+					}
+
 					ac_session_release_reference(session);
 				}
 			}
@@ -101,15 +123,7 @@ static int ac_kmod_event_handler(struct genlmsghdr* gnlh, struct nlattr** tb_msg
 		}
 
 		case NLSMARTCAPWAP_CMD_RECV_DATA: {
-			if (tb_msg[NLSMARTCAPWAP_ATTR_SESSION_ID] && tb_msg[NLSMARTCAPWAP_ATTR_DATA_FRAME]) {
-				struct ac_session_t* session = ac_search_session_from_sessionid((struct capwap_sessionid_element*)nla_data(tb_msg[NLSMARTCAPWAP_ATTR_SESSION_ID]));
-
-				if (session) {
-					ac_session_send_action(session, AC_SESSION_ACTION_RECV_IEEE80211_MGMT_PACKET, 0, nla_data(tb_msg[NLSMARTCAPWAP_ATTR_DATA_FRAME]), nla_len(tb_msg[NLSMARTCAPWAP_ATTR_DATA_FRAME]));
-					ac_session_release_reference(session);
-				}
-			}
-
+			ac_kmod_recv_data(tb_msg);
 			break;
 		}
 	}
@@ -119,9 +133,22 @@ static int ac_kmod_event_handler(struct genlmsghdr* gnlh, struct nlattr** tb_msg
 
 /* */
 static int ac_kmod_valid_handler(struct nl_msg* msg, void* data) {
+	int remaining;
+	struct nlattr* item;
 	struct nlattr* tb_msg[NLSMARTCAPWAP_ATTR_MAX + 1];
 	struct genlmsghdr* gnlh = nlmsg_data(nlmsg_hdr(msg));
 
+	/* Management frames aggregated by kernel module */
+	if (gnlh->cmd == NLSMARTCAPWAP_CMD_RECV_DATA_BATCH) {
+		nla_for_each_attr(item, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), remaining) {
+			if ((nla_type(item) == NLSMARTCAPWAP_ATTR_DATA_ITEM) && !nla_parse_nested(tb_msg, NLSMARTCAPWAP_ATTR_MAX, item, NULL)) {
+				ac_kmod_recv_data(tb_msg);
+			}
+		}
+
+		return NL_SKIP;
+	}
+
 	nla_parse(tb_msg, NLSMARTCAPWAP_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), NULL);
 
 	return ac_kmod_event_handler(gnlh, tb_msg, data);
@@ -202,16 +229,23 @@ static int ac_kmod_link(void) {
 
 /* */
 static void ac_kmod_event_receive(int fd, void** params, int paramscount) {
+	int i;
 	int res;
 
 	ASSERT(fd >= 0);
 	ASSERT(params != NULL);
 	ASSERT(paramscount == 2); 
 
-	/* */
-	res = nl_recvmsgs((struct nl_sock*)params[0], (struct nl_cb*)params[1]);
-	if (res) {
-		capwap_logging_warning("Receive kernel module message failed: %d", res);
+	/* Drain the pending messages of non blocking socket */
+	for (i = 0; i < AC_KMOD_EVENT_MAX_RECV; i++) {
+		res = nl_recvmsgs((struct nl_sock*)params[0], (struct nl_cb*)params[1]);
+		if (res) {
+			if (res != -NLE_AGAIN) {
+				capwap_logging_warning("Receive kernel module message failed: %d", res);
+			}
+
+			break;
+		}
 	}
 }
 
@@ -373,6 +407,8 @@ int ac_kmod_new_datasession(struct capwap_sessionid_element* sessionid, uint8_t
 	result = ac_kmod_send_and_recv_msg(msg, NULL, NULL);
 	if (result) {
 		capwap_logging_error("Unable to create data session: %d", result);
+	} else {
+		ac_xdp_new_session(sessionid);
 	}
 
 	/* */
@@ -393,6 +429,9 @@ int ac_kmod_delete_datasession(struct capwap_sessionid_element* sessionid) {
 		return -1;
 	}
 
+	/* */
+	ac_xdp_delete_session(sessionid);
+
 	/* */
 	genlmsg_put(msg, 0, 0, g_ac.kmodhandle.nlsmartcapwap_id, 0, 0, NLSMARTCAPWAP_CMD_DELETE_SESSION, 0);
 	nla_put(msg, NLSMARTCAPWAP_ATTR_SESSION_ID, sizeof(struct capwap_sessionid_element), sessionid);
@@ -581,6 +620,8 @@ int ac_kmod_authorize_station(struct capwap_sessionid_element* sessionid, const
 	result = ac_kmod_send_and_recv_msg(msg, NULL, NULL);
 	if (result) {
 		capwap_logging_error("Unable to authorize station: %d", result);
+	} else {
+		ac_xdp_authorize_station(sessionid, macaddress, ifindex, vlan);
 	}
 
 	/* */
@@ -602,6 +643,9 @@ int ac_kmod_deauthorize_station(struct capwap_sessionid_element* sessionid, cons
 		return -1;
 	}
 
+	/* */
+	ac_xdp_deauthorize_station(macaddress);
+
 	/* */
 	genlmsg_put(msg, 0, 0, g_ac.kmodhandle.nlsmartcapwap_id, 0, 0, NLSMARTCAPWAP_CMD_DEAUTH_STATION, 0);
 	nla_put(msg, NLSMARTCAPWAP_ATTR_SESSION_ID, sizeof(struct capwap_sessionid_element), sessionid);
@@ -660,6 +704,9 @@ int ac_kmod_init(void) {
 		return result;
 	}
 
+	/* The events are received until the socket is empty */
+	fcntl(g_ac.kmodhandle.nl_fd, F_SETFL, fcntl(g_ac.kmodhandle.nl_fd, F_GETFL) | O_NONBLOCK);
+
 	/* Configure netlink message socket */
 	g_ac.kmodhandle.nlmsg_cb = nl_cb_alloc(NL_CB_DEFAULT);
 	if (!g_ac.kmodhandle.nlmsg_cb) {
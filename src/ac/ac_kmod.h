@@ -31,6 +31,7 @@ struct ac_kmod_handle {
 
 /* */
 #define AC_KMOD_EVENT_MAX_ITEMS				2
+#define AC_KMOD_EVENT_MAX_RECV				64
 struct ac_kmod_event {
 	void (*event_handler)(int fd, void** params, int paramscount);
 	int paramscount;
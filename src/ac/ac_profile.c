@@ -0,0 +1,408 @@
+#include "ac.h"
+#include "ac_soap.h"
+#include "ac_session.h"
+#include "ac_profile.h"
+
+/* Profile key */
+struct ac_profile_key {
+	int type;
+	char* key;
+};
+
+/* Backend response shared by the WTPs of a profile */
+struct ac_profile_entry {
+	struct ac_profile_key key;
+	struct capwap_list_item* lruitem;
+
+	unsigned long version;
+	char* json;
+};
+
+/* */
+struct ac_profile_t {
+	capwap_lock_t lock;
+	struct capwap_hash* entries;
+	struct capwap_list* lru;				/* Most recently used at head */
+
+	struct ac_profile_stats stats;
+};
+
+/* */
+struct ac_profile_invalidate_param {
+	const char* key;
+	unsigned long count;
+};
+
+static struct ac_profile_t g_ac_profile;
+
+/* */
+static unsigned long ac_profile_item_gethash(const void* key, unsigned long hashsize) {
+	const struct ac_profile_key* profilekey = (const struct ac_profile_key*)key;
+	const unsigned char* name = (const unsigned char*)profilekey->key;
+	unsigned long hash = (unsigned long)profilekey->type;
+
+	while (*name) {
+		hash = (hash * 31) + *name++;
+	}
+
+	return (hash % hashsize);
+}
+
+/* */
+static const void* ac_profile_item_getkey(const void* data) {
+	return (const void*)&((struct ac_profile_entry*)data)->key;
+}
+
+/* */
+static int ac_profile_item_cmp(const void* key1, const void* key2) {
+	const struct ac_profile_key* profilekey1 = (const struct ac_profile_key*)key1;
+	const struct ac_profile_key* profilekey2 = (const struct ac_profile_key*)key2;
+
+	if (profilekey1->type != profilekey2->type) {
+		return ((profilekey1->type < profilekey2->type) ? -1 : 1);
+	}
+
+	return strcmp(profilekey1->key, profilekey2->key);
+}
+
+/* */
+static void ac_profile_item_free(void* data) {
+	struct ac_profile_entry* entry = (struct ac_profile_entry*)data;
+
+	/* Remove from LRU list, the entry is the item of list */
+	capwap_itemlist_remove(g_ac_profile.lru, entry->lruitem);
+
+	capwap_free(entry->key.key);
+	capwap_free(entry->json);
+	capwap_itemlist_free(entry->lruitem);
+}
+
+/* Profile of backend response */
+static int ac_profile_get_profile(struct json_object* jsonroot, const char** key, unsigned long* version, int* cached) {
+	struct json_object* jsonprofile;
+	struct json_object* jsonelement;
+
+	jsonprofile = compat_json_object_object_get(jsonroot, "Profile");
+	if (!jsonprofile || (json_object_get_type(jsonprofile) != json_type_object)) {
+		return 0;
+	}
+
+	/* Key */
+	jsonelement = compat_json_object_object_get(jsonprofile, "Key");
+	if (!jsonelement || (json_object_get_type(jsonelement) != json_type_string)) {
+		return 0;
+	}
+
+	*key = json_object_get_string(jsonelement);
+	if (!*key || !**key) {
+		return 0;
+	}
+
+	/* Version */
+	jsonelement = compat_json_object_object_get(jsonprofile, "Version");
+	if (!jsonelement || (json_object_get_type(jsonelement) != json_type_int)) {
+		return 0;
+	}
+
+	*version = (unsigned long)json_object_get_int64(jsonelement);
+
+	/* Cached */
+	*cached = 0;
+	jsonelement = compat_json_object_object_get(jsonprofile, "Cached");
+	if (jsonelement && (json_object_get_type(jsonelement) == json_type_boolean)) {
+		*cached = (json_object_get_boolean(jsonelement) ? 1 : 0);
+	}
+
+	return 1;
+}
+
+/* */
+static void ac_profile_store(int type, const char* key, unsigned long version, struct json_object* jsonroot) {
+	struct ac_profile_entry* entry;
+	struct capwap_list_item* itemlist;
+
+	/* Entry is allocated as item of LRU list */
+	itemlist = capwap_itemlist_create(sizeof(struct ac_profile_entry));
+	entry = (struct ac_profile_entry*)itemlist->item;
+	memset(entry, 0, sizeof(struct ac_profile_entry));
+
+	entry->key.type = type;
+	entry->key.key = capwap_duplicate_string(key);
+	entry->lruitem = itemlist;
+	entry->version = version;
+	entry->json = capwap_duplicate_string(json_object_to_json_string(jsonroot));
+
+	/* */
+	capwap_lock_enter(&g_ac_profile.lock);
+
+	/* Replace the old version */
+	g_ac_profile.stats.stores++;
+	capwap_hash_delete(g_ac_profile.entries, &entry->key);
+	capwap_hash_add(g_ac_profile.entries, (void*)entry);
+	capwap_itemlist_insert_before(g_ac_profile.lru, NULL, itemlist);
+
+	/* Evict the least recently used profiles */
+	while (g_ac_profile.lru->count > g_ac.profile.cachesize) {
+		struct ac_profile_entry* last = (struct ac_profile_entry*)g_ac_profile.lru->last->item;
+
+		g_ac_profile.stats.evictions++;
+		capwap_hash_delete(g_ac_profile.entries, &last->key);
+	}
+
+	capwap_lock_exit(&g_ac_profile.lock);
+}
+
+/* */
+static struct json_object* ac_profile_search(int type, const char* key, unsigned long version) {
+	char* json = NULL;
+	struct ac_profile_key profilekey;
+	struct ac_profile_entry* entry;
+	struct json_object* jsonroot = NULL;
+
+	profilekey.type = type;
+	profilekey.key = (char*)key;
+
+	/* */
+	capwap_lock_enter(&g_ac_profile.lock);
+
+	entry = (struct ac_profile_entry*)capwap_hash_search(g_ac_profile.entries, &profilekey);
+	if (entry && (entry->version == version)) {
+		g_ac_profile.stats.hits++;
+		json = capwap_duplicate_string(entry->json);
+
+		/* Move to head of LRU list */
+		capwap_itemlist_remove(g_ac_profile.lru, entry->lruitem);
+		capwap_itemlist_insert_before(g_ac_profile.lru, NULL, entry->lruitem);
+	} else {
+		g_ac_profile.stats.misses++;
+	}
+
+	capwap_lock_exit(&g_ac_profile.lock);
+
+	/* Every session translates its own copy, out of critical section */
+	if (json) {
+		jsonroot = json_tokener_parse(json);
+		capwap_free(json);
+	}
+
+	return jsonroot;
+}
+
+/* */
+void ac_profile_init(void) {
+	memset(&g_ac_profile, 0, sizeof(struct ac_profile_t));
+
+	/* */
+	capwap_lock_init(&g_ac_profile.lock);
+	g_ac_profile.lru = capwap_list_create();
+
+	/* */
+	g_ac_profile.entries = capwap_hash_create(AC_PROFILE_HASH_SIZE);
+	g_ac_profile.entries->item_gethash = ac_profile_item_gethash;
+	g_ac_profile.entries->item_getkey = ac_profile_item_getkey;
+	g_ac_profile.entries->item_cmp = ac_profile_item_cmp;
+	g_ac_profile.entries->item_free = ac_profile_item_free;
+}
+
+/* */
+void ac_profile_free(void) {
+	capwap_hash_free(g_ac_profile.entries);
+
+	ASSERT(g_ac_profile.lru->count == 0);
+	capwap_list_free(g_ac_profile.lru);
+	capwap_lock_destroy(&g_ac_profile.lock);
+}
+
+/* Announce to Backend Server the profiles already known by AC */
+static void ac_profile_add_cached(int type, struct json_object* jsonparam) {
+	struct json_object* jsonarray = NULL;
+	struct capwap_list_item* itemlist;
+
+	ASSERT(jsonparam != NULL);
+
+	/* Add param
+		{
+			CachedProfiles: [
+				{
+					Key: [string],
+					Version: [int]
+				}
+			]
+		}
+	*/
+
+	if (!g_ac.profile.cachesize) {
+		return;
+	}
+
+	/* */
+	capwap_lock_enter(&g_ac_profile.lock);
+
+	for (itemlist = g_ac_profile.lru->first; itemlist; itemlist = itemlist->next) {
+		struct ac_profile_entry* entry = (struct ac_profile_entry*)itemlist->item;
+
+		if (entry->key.type == type) {
+			struct json_object* jsonprofile = json_object_new_object();
+
+			json_object_object_add(jsonprofile, "Key", json_object_new_string(entry->key.key));
+			json_object_object_add(jsonprofile, "Version", json_object_new_int64((int64_t)entry->version));
+
+			if (!jsonarray) {
+				jsonarray = json_object_new_array();
+			}
+
+			json_object_array_add(jsonarray, jsonprofile);
+		}
+	}
+
+	capwap_lock_exit(&g_ac_profile.lock);
+
+	/* */
+	if (jsonarray) {
+		json_object_object_add(jsonparam, "CachedProfiles", jsonarray);
+	}
+}
+
+/* Backend response, full or replaced by a profile already known by AC */
+static struct json_object* ac_profile_parse_json_response(int type, struct ac_soap_response* response, int* missing) {
+	int cached;
+	const char* key;
+	unsigned long version;
+	struct json_object* jsonroot;
+	struct json_object* jsonprofile = NULL;
+
+	ASSERT(response != NULL);
+	ASSERT(missing != NULL);
+
+	/* Receive SOAP response with JSON result
+		{
+			Profile: {
+				Key: [string],
+				Version: [int],
+				Cached: [bool]
+			},
+			<Elements of response, omitted when Cached is true>
+		}
+	*/
+
+	/* */
+	*missing = 0;
+	jsonroot = ac_soapclient_parse_json_response(response);
+	if (!jsonroot || !g_ac.profile.cachesize || !ac_profile_get_profile(jsonroot, &key, &version, &cached)) {
+		return jsonroot;
+	}
+
+	/* */
+	if (cached) {
+		jsonprofile = ac_profile_search(type, key, version);
+		if (!jsonprofile) {
+			/* Profile invalidated or evicted after the request */
+			*missing = 1;
+		}
+	} else {
+		ac_profile_store(type, key, version, jsonroot);
+		jsonprofile = json_object_get(jsonroot);
+	}
+
+	json_object_put(jsonroot);
+	return jsonprofile;
+}
+
+/* Send join or configuration request of WTP session */
+struct json_object* ac_profile_send_soap_request(struct ac_session_t* session, int type, struct json_object* jsonparam) {
+	int missing;
+	struct ac_soap_response* response;
+	struct json_object* jsonroot = NULL;
+
+	ASSERT(session != NULL);
+	ASSERT(jsonparam != NULL);
+	ASSERT((type == AC_PROFILE_JOIN) || (type == AC_PROFILE_CONFIGURE));
+
+	/* */
+	ac_profile_add_cached(type, jsonparam);
+
+	for (;;) {
+		/* JSON param is encoded by backend transport */
+		if (type == AC_PROFILE_JOIN) {
+			response = ac_soap_joinwtpsession(session, session->wtpid, (char*)json_object_to_json_string(jsonparam));
+		} else {
+			response = ac_soap_configurestatuswtpsession(session, session->wtpid, (char*)json_object_to_json_string(jsonparam));
+		}
+
+		if (!response) {
+			break;
+		}
+
+		/* */
+		jsonroot = ac_profile_parse_json_response(type, response, &missing);
+		ac_soapclient_free_response(response);
+
+		/* Ask again the whole response without the profiles known by AC */
+		if (!missing || !compat_json_object_object_get(jsonparam, "CachedProfiles")) {
+			break;
+		}
+
+		json_object_object_del(jsonparam, "CachedProfiles");
+	}
+
+	return jsonroot;
+}
+
+/* */
+static int ac_profile_invalidate_item(void* data, void* param) {
+	struct ac_profile_entry* entry = (struct ac_profile_entry*)data;
+	struct ac_profile_invalidate_param* invalidate = (struct ac_profile_invalidate_param*)param;
+
+	if (strcmp(entry->key.key, invalidate->key)) {
+		return HASH_CONTINUE;
+	}
+
+	invalidate->count++;
+	return HASH_DELETE_AND_CONTINUE;
+}
+
+/* */
+unsigned long ac_profile_invalidate(const char* key) {
+	struct ac_profile_invalidate_param invalidate;
+
+	/* */
+	invalidate.key = key;
+	invalidate.count = 0;
+
+	/* */
+	capwap_lock_enter(&g_ac_profile.lock);
+
+	if (!key) {
+		invalidate.count = g_ac_profile.lru->count;
+		capwap_hash_deleteall(g_ac_profile.entries);
+	} else if (g_ac_profile.lru->count > 0) {
+		capwap_hash_foreach(g_ac_profile.entries, ac_profile_invalidate_item, &invalidate);
+	}
+
+	g_ac_profile.stats.invalidations += invalidate.count;
+
+	capwap_lock_exit(&g_ac_profile.lock);
+
+	return invalidate.count;
+}
+
+/* */
+void ac_profile_get_stats(struct ac_profile_stats* stats) {
+	ASSERT(stats != NULL);
+
+	capwap_lock_enter(&g_ac_profile.lock);
+
+	memcpy(stats, &g_ac_profile.stats, sizeof(struct ac_profile_stats));
+	stats->count = g_ac_profile.lru->count;
+
+	capwap_lock_exit(&g_ac_profile.lock);
+}
+
+/* */
+void ac_profile_log(void) {
+	struct ac_profile_stats stats;
+
+	ac_profile_get_stats(&stats);
+	capwap_logging_debug("WTP profile cache: %lu entries, %lu hits, %lu misses, %lu stores, %lu evictions, %lu invalidations",
+		stats.count, stats.hits, stats.misses, stats.stores, stats.evictions, stats.invalidations);
+}
@@ -0,0 +1,36 @@
+#ifndef __AC_PROFILE_HEADER__
+#define __AC_PROFILE_HEADER__
+
+/* */
+#define AC_PROFILE_HASH_SIZE				256
+
+/* Response of backend shared by WTPs of same profile */
+#define AC_PROFILE_JOIN						0
+#define AC_PROFILE_CONFIGURE				1
+
+/* */
+struct ac_session_t;
+
+/* */
+struct ac_profile_stats {
+	unsigned long count;
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long stores;
+	unsigned long evictions;
+	unsigned long invalidations;
+};
+
+/* */
+void ac_profile_init(void);
+void ac_profile_free(void);
+
+/* */
+struct json_object* ac_profile_send_soap_request(struct ac_session_t* session, int type, struct json_object* jsonparam);
+unsigned long ac_profile_invalidate(const char* key);
+
+/* */
+void ac_profile_get_stats(struct ac_profile_stats* stats);
+void ac_profile_log(void);
+
+#endif /* __AC_PROFILE_HEADER__ */
@@ -0,0 +1,534 @@
+#include "ac.h"
+#include "capwap_array.h"
+#include "ac_session.h"
+#include "ac_backend.h"
+#include "ac_soap.h"
+#include "ac_provisioning.h"
+
+/* */
+#define AC_PROVISIONING_ELEMENT_LENGTH				256
+#define AC_PROVISIONING_CHECK_INTERVAL				1000
+#define AC_PROVISIONING_REPORT_INTERVAL				5000
+
+/* */
+struct ac_provisioning_wtp {
+	char* wtpid;
+	int status;
+	struct timeval sendtime;
+};
+
+/* Bulk WLAN provisioning */
+struct ac_provisioning {
+	char idevent[65];
+	char idquery[65];
+
+	/* Notification data with IEEE 802.11 Add WLAN already encoded */
+	struct ac_notify_addwlan_t* addwlan;
+	long addwlanlength;
+
+	/* */
+	struct capwap_array* wtps;
+	unsigned long next;
+	unsigned long running;
+	unsigned long complete;
+	unsigned long failed;
+
+	/* */
+	int changed;
+	struct timeval lastreport;
+};
+
+/* */
+struct ac_provisioning_t {
+	pthread_t threadid;
+	int endthread;
+
+	capwap_event_t wait;
+	capwap_lock_t lock;
+	struct capwap_list* provisioning;
+	struct timeval lastsend;
+
+	/* Soap Request */
+	struct ac_http_soap_request* soaprequest;
+};
+
+static struct ac_provisioning_t g_ac_provisioning;
+
+/* */
+static long ac_provisioning_get_elapsed(struct timeval* last, struct timeval* now) {
+	return ((now->tv_sec - last->tv_sec) * 1000) + ((now->tv_usec - last->tv_usec) / 1000);
+}
+
+/* */
+static void ac_provisioning_free(struct ac_provisioning* provisioning) {
+	unsigned long i;
+
+	for (i = 0; i < provisioning->wtps->count; i++) {
+		capwap_free(((struct ac_provisioning_wtp*)capwap_array_get_item_pointer(provisioning->wtps, i))->wtpid);
+	}
+
+	capwap_array_free(provisioning->wtps);
+	capwap_free(provisioning->addwlan);
+}
+
+/* */
+static void ac_provisioning_set_status(struct ac_provisioning* provisioning, struct ac_provisioning_wtp* wtp, int status) {
+	ASSERT(wtp->status == AC_PROVISIONING_WTP_RUNNING);
+
+	wtp->status = status;
+	provisioning->running--;
+	if (status == AC_PROVISIONING_WTP_COMPLETE) {
+		provisioning->complete++;
+	} else {
+		provisioning->failed++;
+	}
+
+	provisioning->changed = 1;
+}
+
+/* */
+static char* ac_provisioning_build_report(struct ac_provisioning* provisioning) {
+	unsigned long i;
+	char* report;
+	struct json_object* jsonroot;
+	struct json_object* jsonwtps;
+
+	/* Progress of bulk provisioning
+		{
+			Total: [int],
+			Pending: [int],
+			Running: [int],
+			Complete: [int],
+			Failed: [int],
+			WTP: [
+				{
+					WTPID: [string],
+					Status: [int]
+				}
+			]
+		}
+	*/
+
+	jsonwtps = json_object_new_array();
+	for (i = 0; i < provisioning->wtps->count; i++) {
+		struct ac_provisioning_wtp* wtp = (struct ac_provisioning_wtp*)capwap_array_get_item_pointer(provisioning->wtps, i);
+		struct json_object* jsonwtp = json_object_new_object();
+
+		json_object_object_add(jsonwtp, "WTPID", json_object_new_string(wtp->wtpid));
+		json_object_object_add(jsonwtp, "Status", json_object_new_int(wtp->status));
+		json_object_array_add(jsonwtps, jsonwtp);
+	}
+
+	jsonroot = json_object_new_object();
+	json_object_object_add(jsonroot, "Total", json_object_new_int((int)provisioning->wtps->count));
+	json_object_object_add(jsonroot, "Pending", json_object_new_int((int)(provisioning->wtps->count - provisioning->next)));
+	json_object_object_add(jsonroot, "Running", json_object_new_int((int)provisioning->running));
+	json_object_object_add(jsonroot, "Complete", json_object_new_int((int)provisioning->complete));
+	json_object_object_add(jsonroot, "Failed", json_object_new_int((int)provisioning->failed));
+	json_object_object_add(jsonroot, "WTP", jsonwtps);
+
+	/* Get JSON param, it is encoded by backend transport */
+	report = capwap_duplicate_string(json_object_to_json_string(jsonroot));
+
+	json_object_put(jsonroot);
+	return report;
+}
+
+/* */
+static int ac_provisioning_send_soap_request(char* method, const char* idevent, const char* type, const char* name, const char* value) {
+	int result = -1;
+	struct ac_soap_response* response;
+	struct ac_http_soap_request* soaprequest = NULL;
+
+	/* Build Soap Request */
+	capwap_lock_enter(&g_ac_provisioning.lock);
+	if (!g_ac_provisioning.endthread) {
+		g_ac_provisioning.soaprequest = ac_backend_createrequest_with_session(method, SOAP_NAMESPACE_URI);
+		soaprequest = g_ac_provisioning.soaprequest;
+	}
+
+	capwap_lock_exit(&g_ac_provisioning.lock);
+
+	/* */
+	if (!soaprequest) {
+		return -1;
+	}
+
+	/* Send Request & Recv Response */
+	if (ac_soapclient_add_param(soaprequest->request, "xs:string", "idevent", idevent) && ac_soapclient_add_param(soaprequest->request, type, name, value)) {
+		response = ac_backend_execute(soaprequest);
+		if (response) {
+			if (response->responsecode == HTTP_RESULT_OK) {
+				result = 0;
+			}
+
+			ac_soapclient_free_response(response);
+		}
+	}
+
+	/* Critical section */
+	capwap_lock_enter(&g_ac_provisioning.lock);
+
+	/* Free resource */
+	ac_soapclient_close_request(g_ac_provisioning.soaprequest, 1);
+	g_ac_provisioning.soaprequest = NULL;
+
+	capwap_lock_exit(&g_ac_provisioning.lock);
+
+	return result;
+}
+
+/* */
+static void ac_provisioning_send_report(const char* idevent, char* report, const char* idquery, int status) {
+	char buffer[5];
+
+	/* Update progress of bulk provisioning */
+	if (ac_provisioning_send_soap_request("updateWLANProvisioning", idevent, "xs:base64Binary", "provisioning", report)) {
+		capwap_logging_warning("Unable to update WLAN provisioning %s", idevent);
+	}
+
+	/* Complete query event */
+	if (idquery && *idquery) {
+		ac_provisioning_send_soap_request("updateBackendEvent", idquery, "xs:int", "status", capwap_itoa(SOAP_EVENT_STATUS_COMPLETE, buffer));
+	}
+
+	/* Complete provisioning event */
+	if (status != SOAP_EVENT_STATUS_RUNNING) {
+		ac_provisioning_send_soap_request("updateBackendEvent", idevent, "xs:int", "status", capwap_itoa(status, buffer));
+	}
+}
+
+/* */
+static void ac_provisioning_send_addwlan(struct ac_provisioning* provisioning, unsigned long index, const char* wtpid) {
+	struct ac_session_t* session;
+	struct ac_provisioning_wtp* wtp;
+
+	/* Encoded message element is shared, only index change for every WTP */
+	session = ac_search_session_from_wtpid(wtpid);
+	if (session) {
+		provisioning->addwlan->provisioningindex = index;
+		ac_session_send_action(session, AC_SESSION_ACTION_ADDWLAN, 0, (void*)provisioning->addwlan, provisioning->addwlanlength);
+		ac_session_release_reference(session);
+	} else {
+		capwap_logging_warning("Unable to provisioning WLAN to WTP %s, session not found", wtpid);
+
+		capwap_lock_enter(&g_ac_provisioning.lock);
+		wtp = (struct ac_provisioning_wtp*)capwap_array_get_item_pointer(provisioning->wtps, index);
+		ac_provisioning_set_status(provisioning, wtp, AC_PROVISIONING_WTP_FAILED);
+		capwap_lock_exit(&g_ac_provisioning.lock);
+	}
+}
+
+/* */
+static long ac_provisioning_execute(void) {
+	unsigned long i;
+	long elapsed;
+	long interval;
+	long waittimeout;
+	int status = SOAP_EVENT_STATUS_RUNNING;
+	char* wtpid = NULL;
+	unsigned long index = 0;
+	char* report = NULL;
+	char idevent[65];
+	char idquery[65];
+	struct timeval now;
+	struct capwap_list_item* item;
+	struct ac_provisioning* provisioning;
+
+	/* */
+	interval = 1000 / g_ac.provisioning.rate;
+	waittimeout = AC_PROVISIONING_CHECK_INTERVAL;
+	gettimeofday(&now, NULL);
+
+	capwap_lock_enter(&g_ac_provisioning.lock);
+
+	/* Rollout one provisioning at a time, the others wait into queue */
+	item = g_ac_provisioning.provisioning->first;
+	if (!item) {
+		capwap_lock_exit(&g_ac_provisioning.lock);
+		return CAPWAP_TIMEOUT_INFINITE;
+	}
+
+	provisioning = (struct ac_provisioning*)item->item;
+
+	/* WTP without response */
+	if (provisioning->running > 0) {
+		for (i = 0; i < provisioning->next; i++) {
+			struct ac_provisioning_wtp* wtp = (struct ac_provisioning_wtp*)capwap_array_get_item_pointer(provisioning->wtps, i);
+
+			if ((wtp->status == AC_PROVISIONING_WTP_RUNNING) && (ac_provisioning_get_elapsed(&wtp->sendtime, &now) >= g_ac.provisioning.timeout)) {
+				capwap_logging_warning("WLAN provisioning timeout for WTP %s", wtp->wtpid);
+				ac_provisioning_set_status(provisioning, wtp, AC_PROVISIONING_WTP_FAILED);
+			}
+		}
+	}
+
+	/* Send next WTP into window according to rate */
+	if ((provisioning->running < g_ac.provisioning.window) && (provisioning->next < provisioning->wtps->count)) {
+		elapsed = ac_provisioning_get_elapsed(&g_ac_provisioning.lastsend, &now);
+		if ((elapsed < 0) || (elapsed >= interval)) {
+			struct ac_provisioning_wtp* wtp = (struct ac_provisioning_wtp*)capwap_array_get_item_pointer(provisioning->wtps, provisioning->next);
+
+			wtp->status = AC_PROVISIONING_WTP_RUNNING;
+			wtp->sendtime = now;
+			provisioning->running++;
+			provisioning->changed = 1;
+
+			index = provisioning->next++;
+			wtpid = capwap_duplicate_string(wtp->wtpid);
+			g_ac_provisioning.lastsend = now;
+			waittimeout = interval;
+		} else {
+			waittimeout = interval - elapsed;
+		}
+	}
+
+	/* Report progress */
+	if ((provisioning->complete + provisioning->failed) == provisioning->wtps->count) {
+		status = (provisioning->failed ? SOAP_EVENT_STATUS_GENERIC_ERROR : SOAP_EVENT_STATUS_COMPLETE);
+		capwap_itemlist_remove(g_ac_provisioning.provisioning, item);
+		waittimeout = 0;
+	} else if (provisioning->idquery[0] || (provisioning->changed && (ac_provisioning_get_elapsed(&provisioning->lastreport, &now) >= AC_PROVISIONING_REPORT_INTERVAL))) {
+		provisioning->lastreport = now;
+	} else {
+		provisioning = NULL;
+	}
+
+	if (provisioning) {
+		report = ac_provisioning_build_report(provisioning);
+		strcpy(idevent, provisioning->idevent);
+		strcpy(idquery, provisioning->idquery);
+		provisioning->idquery[0] = 0;
+		provisioning->changed = 0;
+	}
+
+	capwap_lock_exit(&g_ac_provisioning.lock);
+
+	/* */
+	if (wtpid) {
+		ac_provisioning_send_addwlan((struct ac_provisioning*)item->item, index, wtpid);
+		capwap_free(wtpid);
+	}
+
+	if (report) {
+		ac_provisioning_send_report(idevent, report, idquery, status);
+		capwap_free(report);
+	}
+
+	/* Provisioning complete */
+	if (status != SOAP_EVENT_STATUS_RUNNING) {
+		capwap_logging_info("WLAN provisioning %s complete: %lu success, %lu failed", idevent, ((struct ac_provisioning*)item->item)->complete, ((struct ac_provisioning*)item->item)->failed);
+		ac_provisioning_free((struct ac_provisioning*)item->item);
+		capwap_itemlist_free(item);
+	}
+
+	return waittimeout;
+}
+
+/* */
+static void* ac_provisioning_thread(void* param) {
+	long waittimeout;
+
+	capwap_logging_debug("WLAN provisioning start");
+
+	while (!g_ac_provisioning.endthread) {
+		waittimeout = ac_provisioning_execute();
+		if (waittimeout) {
+			capwap_event_wait_timeout(&g_ac_provisioning.wait, waittimeout);
+		}
+	}
+
+	capwap_logging_debug("WLAN provisioning stop");
+
+	/* Thread exit */
+	pthread_exit(NULL);
+	return NULL;
+}
+
+/* */
+int ac_provisioning_addwlan(const char* idevent, struct ac_notify_addwlan_t* addwlan, struct json_object* jsonwtps) {
+	int i;
+	int length;
+	struct capwap_list_item* item;
+	struct ac_provisioning* provisioning;
+	struct capwap_80211_addwlan_element element;
+	uint8_t buffer[AC_PROVISIONING_ELEMENT_LENGTH];
+
+	ASSERT(idevent != NULL);
+	ASSERT(addwlan != NULL);
+	ASSERT(jsonwtps != NULL);
+
+	/* Encode once the IEEE 802.11 Add WLAN common to all WTP */
+	memset(&element, 0, sizeof(struct capwap_80211_addwlan_element));
+	element.radioid = addwlan->radioid;
+	element.wlanid = addwlan->wlanid;
+	element.capability = addwlan->capability;
+	element.qos = addwlan->qos;
+	element.authmode = addwlan->authmode;
+	element.macmode = addwlan->macmode;
+	element.tunnelmode = addwlan->tunnelmode;
+	element.suppressssid = addwlan->suppressssid;
+	element.ssid = (uint8_t*)addwlan->ssid;
+
+	length = capwap_message_element_encode(CAPWAP_ELEMENT_80211_ADD_WLAN, &element, buffer, sizeof(buffer));
+	if (length <= 0) {
+		return -1;
+	}
+
+	/* */
+	item = capwap_itemlist_create(sizeof(struct ac_provisioning));
+	provisioning = (struct ac_provisioning*)item->item;
+	memset(provisioning, 0, sizeof(struct ac_provisioning));
+	strcpy(provisioning->idevent, idevent);
+
+	/* */
+	provisioning->addwlanlength = sizeof(struct ac_notify_addwlan_t) + length;
+	provisioning->addwlan = (struct ac_notify_addwlan_t*)capwap_alloc(provisioning->addwlanlength);
+	memcpy(provisioning->addwlan, addwlan, sizeof(struct ac_notify_addwlan_t));
+	strcpy(provisioning->addwlan->idprovisioning, idevent);
+	provisioning->addwlan->elementlength = (unsigned short)length;
+	memcpy(provisioning->addwlan->element, buffer, length);
+
+	/* */
+	provisioning->wtps = capwap_array_create(sizeof(struct ac_provisioning_wtp), 0, 0);
+	for (i = 0; i < json_object_array_length(jsonwtps); i++) {
+		struct json_object* jsonwtpid = json_object_array_get_idx(jsonwtps, i);
+
+		if (jsonwtpid && (json_object_get_type(jsonwtpid) == json_type_string)) {
+			struct ac_provisioning_wtp* wtp = (struct ac_provisioning_wtp*)capwap_array_get_item_pointer(provisioning->wtps, provisioning->wtps->count);
+
+			wtp->wtpid = capwap_duplicate_string(json_object_get_string(jsonwtpid));
+			wtp->status = AC_PROVISIONING_WTP_PENDING;
+		}
+	}
+
+	if (!provisioning->wtps->count) {
+		ac_provisioning_free(provisioning);
+		capwap_itemlist_free(item);
+		return -1;
+	}
+
+	/* Append to provisioning queue */
+	capwap_logging_debug("Receive WLAN provisioning %s for %lu WTP with SSID: %s", idevent, provisioning->wtps->count, addwlan->ssid);
+
+	capwap_lock_enter(&g_ac_provisioning.lock);
+	capwap_itemlist_insert_after(g_ac_provisioning.provisioning, NULL, item);
+	capwap_event_signal(&g_ac_provisioning.wait);
+	capwap_lock_exit(&g_ac_provisioning.lock);
+
+	return 0;
+}
+
+/* */
+int ac_provisioning_query(const char* idevent, const char* idquery) {
+	int result = -1;
+	struct capwap_list_item* search;
+
+	ASSERT(idevent != NULL);
+	ASSERT(idquery != NULL);
+
+	capwap_lock_enter(&g_ac_provisioning.lock);
+
+	for (search = g_ac_provisioning.provisioning->first; search != NULL; search = search->next) {
+		struct ac_provisioning* provisioning = (struct ac_provisioning*)search->item;
+
+		if (!strcmp(provisioning->idevent, idevent)) {
+			strcpy(provisioning->idquery, idquery);
+			capwap_event_signal(&g_ac_provisioning.wait);
+			result = 0;
+			break;
+		}
+	}
+
+	capwap_lock_exit(&g_ac_provisioning.lock);
+
+	return result;
+}
+
+/* */
+void ac_provisioning_complete(struct ac_session_t* session, int success) {
+	struct capwap_list_item* search;
+
+	ASSERT(session != NULL);
+
+	if (!session->idprovisioning[0]) {
+		return;
+	}
+
+	/* */
+	capwap_lock_enter(&g_ac_provisioning.lock);
+
+	for (search = g_ac_provisioning.provisioning->first; search != NULL; search = search->next) {
+		struct ac_provisioning* provisioning = (struct ac_provisioning*)search->item;
+
+		if (!strcmp(provisioning->idevent, session->idprovisioning)) {
+			if (session->provisioningindex < provisioning->wtps->count) {
+				struct ac_provisioning_wtp* wtp = (struct ac_provisioning_wtp*)capwap_array_get_item_pointer(provisioning->wtps, session->provisioningindex);
+
+				/* Ignore response after timeout */
+				if ((wtp->status == AC_PROVISIONING_WTP_RUNNING) && session->wtpid && !strcmp(wtp->wtpid, session->wtpid)) {
+					ac_provisioning_set_status(provisioning, wtp, (success ? AC_PROVISIONING_WTP_COMPLETE : AC_PROVISIONING_WTP_FAILED));
+					capwap_event_signal(&g_ac_provisioning.wait);
+				}
+			}
+
+			break;
+		}
+	}
+
+	capwap_lock_exit(&g_ac_provisioning.lock);
+
+	/* */
+	session->idprovisioning[0] = 0;
+}
+
+/* */
+int ac_provisioning_start(void) {
+	int result;
+
+	memset(&g_ac_provisioning, 0, sizeof(struct ac_provisioning_t));
+
+	/* Init */
+	capwap_event_init(&g_ac_provisioning.wait);
+	capwap_lock_init(&g_ac_provisioning.lock);
+	g_ac_provisioning.provisioning = capwap_list_create();
+
+	/* Create thread */
+	result = pthread_create(&g_ac_provisioning.threadid, NULL, ac_provisioning_thread, NULL);
+	if (result) {
+		capwap_logging_debug("Unable create WLAN provisioning thread");
+		return 0;
+	}
+
+	return 1;
+}
+
+/* */
+void ac_provisioning_stop(void) {
+	void* dummy;
+
+	/* */
+	capwap_lock_enter(&g_ac_provisioning.lock);
+
+	g_ac_provisioning.endthread = 1;
+	if (g_ac_provisioning.soaprequest) {
+		ac_soapclient_shutdown_request(g_ac_provisioning.soaprequest);
+	}
+
+	capwap_event_signal(&g_ac_provisioning.wait);
+	capwap_lock_exit(&g_ac_provisioning.lock);
+
+	pthread_join(g_ac_provisioning.threadid, &dummy);
+
+	/* Free memory */
+	while (g_ac_provisioning.provisioning->first) {
+		struct capwap_list_item* item = capwap_itemlist_remove_head(g_ac_provisioning.provisioning);
+
+		ac_provisioning_free((struct ac_provisioning*)item->item);
+		capwap_itemlist_free(item);
+	}
+
+	capwap_event_destroy(&g_ac_provisioning.wait);
+	capwap_lock_destroy(&g_ac_provisioning.lock);
+	capwap_list_free(g_ac_provisioning.provisioning);
+}
@@ -0,0 +1,25 @@
+#ifndef __AC_PROVISIONING_HEADER__
+#define __AC_PROVISIONING_HEADER__
+
+/* Status of single WTP into bulk provisioning */
+#define AC_PROVISIONING_WTP_PENDING				0
+#define AC_PROVISIONING_WTP_RUNNING				1
+#define AC_PROVISIONING_WTP_COMPLETE			2
+#define AC_PROVISIONING_WTP_FAILED				3
+
+/* */
+struct ac_notify_addwlan_t;
+struct ac_session_t;
+
+/* */
+int ac_provisioning_start(void);
+void ac_provisioning_stop(void);
+
+/* */
+int ac_provisioning_addwlan(const char* idevent, struct ac_notify_addwlan_t* addwlan, struct json_object* jsonwtps);
+int ac_provisioning_query(const char* idevent, const char* idquery);
+
+/* */
+void ac_provisioning_complete(struct ac_session_t* session, int success);
+
+#endif /* __AC_PROVISIONING_HEADER__ */
@@ -4,6 +4,10 @@
 #include "ac_session.h"
 #include "ac_wlans.h"
 #include "ac_backend.h"
+#include "ac_provisioning.h"
+#include "ac_authcache.h"
+#include "ac_batch.h"
+#include "ac_health.h"
 #include <arpa/inet.h>
 
 #define AC_NO_ERROR						-1000
@@ -11,8 +15,6 @@
 
 /* */
 static struct ac_soap_response* ac_session_action_authorizestation_request(struct ac_session_t* session, uint8_t radioid, uint8_t wlanid, uint8_t* address) {
-	const char* jsonmessage;
-	char* base64confstatus;
 	struct json_object* jsonparam;
 	struct ac_soap_response* response;
 	char addrtext[CAPWAP_MACADDRESS_EUI48_BUFFER];
@@ -37,33 +39,24 @@ static struct ac_soap_response* ac_session_action_authorizestation_request(struc
 	/* Station */
 	json_object_object_add(jsonparam, "Station", json_object_new_string(capwap_printf_macaddress(addrtext, address, MACADDRESS_EUI48_LENGTH)));
 
-	/* Get JSON param and convert base64 */
-	jsonmessage = json_object_to_json_string(jsonparam);
-	base64confstatus = capwap_alloc(AC_BASE64_ENCODE_LENGTH(strlen(jsonmessage)));
-	ac_base64_string_encode(jsonmessage, base64confstatus);
-
-	/* Send message */
-	response = ac_soap_authorizestation(session, session->wtpid, base64confstatus);
+	/* Send message, JSON param is encoded by backend transport */
+	response = ac_soap_authorizestation(session, session->wtpid, (char*)json_object_to_json_string(jsonparam));
 
 	/* Free JSON */
 	json_object_put(jsonparam);
-	capwap_free(base64confstatus);
 
 	return response;
 }
 
 /* */
-static int ac_session_action_authorizestation_response(struct ac_session_t* session, struct ac_soap_response* response, struct ac_notify_station_configuration_ieee8011_add_station* notify) {
+static int ac_session_action_authorizestation_response(struct ac_session_t* session, struct json_object* jsonroot, struct ac_notify_station_configuration_ieee8011_add_station* notify, struct capwap_packet_txmng* txmngpacket, int* authorized) {
 	int result = -1;
 	int ifindex = -1;
 	uint16_t vlan = 0;
 	struct ac_if_datachannel* datachannel;
 	struct ac_wlan* wlan;
-	struct json_object* jsonroot;
 	struct json_object* jsonsection;
 	struct json_object* jsonelement;
-	struct capwap_header_data capwapheader;
-	struct capwap_packet_txmng* txmngpacket;
 	struct capwap_addstation_element addstation;
 	struct capwap_80211_station_element station;
 
@@ -73,22 +66,21 @@ static int ac_session_action_authorizestation_response(struct ac_session_t* sess
 				Index: [int],
 				VLAN: [int/string]
 			},
+			CacheTTL: [int]
 		}
 	*/
 
 	/* */
-	jsonroot = ac_soapclient_parse_json_response(response);
-	if (!jsonroot) {
-		return -1;
-	}
-
-	/* */
+	*authorized = AC_AUTHCACHE_DENIED;
 	jsonsection = compat_json_object_object_get(jsonroot, "DataChannelInterface");
 	if (jsonsection && (json_object_get_type(jsonsection) == json_type_object)) {
 		jsonelement = compat_json_object_object_get(jsonsection, "Index");
 		if (jsonelement && (json_object_get_type(jsonelement) == json_type_int)) {
 			unsigned long index = (unsigned long)json_object_get_int(jsonelement);
 
+			/* Station authorized from backend */
+			*authorized = AC_AUTHCACHE_AUTHORIZED;
+
 			/* Retrieve interface index */
 			capwap_rwlock_rdlock(&g_ac.ifdatachannellock);
 
@@ -115,6 +107,15 @@ static int ac_session_action_authorizestation_response(struct ac_session_t* sess
 								addstation.vlan = (uint8_t*)wtpvlan;		/* Free with jsonroot */
 							}
 						}
+					} else {
+						/* Retrive VLAN */
+						jsonelement = compat_json_object_object_get(jsonroot, "DataChannelInterface.VLAN");
+						if (jsonelement && (json_object_get_type(jsonelement) == json_type_int)) {
+							int acvlan = json_object_get_int(jsonelement);
+							if ((acvlan > 0) && (acvlan < VLAN_MAX)) {
+								vlan = (uint16_t)acvlan;
+							}
+						}
 					}
 
 					/* */
@@ -127,63 +128,140 @@ static int ac_session_action_authorizestation_response(struct ac_session_t* sess
 					station.supportedratescount = notify->supportedratescount;
 					memcpy(station.supportedrates, notify->supportedrates, station.supportedratescount);
 
-					/* Build packet */
-					capwap_header_init(&capwapheader, CAPWAP_RADIOID_NONE, session->binding);
-					txmngpacket = capwap_packet_txmng_create_ctrl_message(&capwapheader, CAPWAP_STATION_CONFIGURATION_REQUEST, session->localseqnumber, session->mtu);
+					/* Authorize station also into kernel module */
+					if (!ac_kmod_authorize_station(&session->sessionid, addstation.address, ifindex, notify->radioid, notify->wlanid, vlan)) {
+						result = 0;
 
-					/* Add message element */
-					capwap_packet_txmng_add_message_element(txmngpacket, CAPWAP_ELEMENT_ADDSTATION, &addstation);
-					capwap_packet_txmng_add_message_element(txmngpacket, CAPWAP_ELEMENT_80211_STATION, &station);
+						/* Add message element */
+						capwap_packet_txmng_add_message_element(txmngpacket, CAPWAP_ELEMENT_ADDSTATION, &addstation);
+						capwap_packet_txmng_add_message_element(txmngpacket, CAPWAP_ELEMENT_80211_STATION, &station);
+					} else {
+						capwap_logging_warning("Unable to authorize station into kernel module data channel");
+					}
+				}
+			}
+		}
+	}
 
-					/* CAPWAP_ELEMENT_VENDORPAYLOAD */				/* TODO */
+	return result;
+}
 
-					/* Station Configuration Request complete, get fragment packets */
-					capwap_packet_txmng_get_fragment_packets(txmngpacket, session->requestfragmentpacket, session->fragmentid);
-					if (session->requestfragmentpacket->count > 1) {
-						session->fragmentid++;
-					}
+/* */
+static long ac_session_action_authorizestation_ttl(struct json_object* jsonroot, long defaultttl) {
+	struct json_object* jsonelement;
 
-					/* Free packets manager */
-					capwap_packet_txmng_free(txmngpacket);
+	/* Validity of backend decision in milliseconds */
+	jsonelement = compat_json_object_object_get(jsonroot, "CacheTTL");
+	if (jsonelement && (json_object_get_type(jsonelement) == json_type_int)) {
+		return (long)json_object_get_int(jsonelement);
+	}
 
-					/* Send Station Configuration Request to WTP */
-					if (capwap_crypt_sendto_fragmentpacket(&session->dtls, session->requestfragmentpacket)) {
-						/* Retrive VLAN */
-						if (wlan->tunnelmode != CAPWAP_ADD_WLAN_TUNNELMODE_LOCAL) {
-							jsonelement = compat_json_object_object_get(jsonroot, "DataChannelInterface.VLAN");
-							if (jsonelement && (json_object_get_type(jsonelement) == json_type_int)) {
-								int acvlan = json_object_get_int(jsonelement);
-								if ((acvlan > 0) && (acvlan < VLAN_MAX)) {
-									vlan = (uint16_t)acvlan;
-								}
-							}
-						}
+	return defaultttl;
+}
 
-						/* Authorize station also into kernel module */
-						if (!ac_kmod_authorize_station(&session->sessionid, addstation.address, ifindex, notify->radioid, notify->wlanid, vlan)) {
-							result = 0;
-							session->retransmitcount = 0;
-							capwap_timeout_set(session->timeout, session->idtimercontrol, AC_RETRANSMIT_INTERVAL, ac_dfa_retransmition_timeout, session, NULL);
-						} else {
-							capwap_logging_warning("Unable to authorize station into kernel module data channel");
-							ac_free_reference_last_request(session);
-							ac_session_teardown(session);
-						}
-					} else {
-						capwap_logging_debug("Warning: error to send Station Configuration Request packet");
-						ac_free_reference_last_request(session);
-						ac_session_teardown(session);
-					}
-				}
-			}
+/* */
+static int ac_session_action_authorizestation(struct ac_session_t* session, struct ac_notify_station_configuration_ieee8011_add_station* notify, struct capwap_packet_txmng* txmngpacket) {
+	int result;
+	int authorized;
+	const char* group;
+	struct ac_wlan* wlan;
+	struct json_object* jsonroot;
+	struct ac_soap_response* response;
+
+	/* Decision already received for the same station, SSID and group of WTPs */
+	wlan = ac_wlans_get_bssid_with_wlanid(session, notify->radioid, notify->wlanid);
+	group = (session->authgroup ? session->authgroup : session->wtpid);
+	if (wlan) {
+		authorized = ac_authcache_search(notify->address, wlan->ssid, group, &jsonroot);
+		if (authorized == AC_AUTHCACHE_DENIED) {
+			return -1;
+		} else if (authorized == AC_AUTHCACHE_AUTHORIZED) {
+			result = ac_session_action_authorizestation_response(session, jsonroot, notify, txmngpacket, &authorized);
+			json_object_put(jsonroot);
+			return result;
 		}
 	}
 
+	/* Ask to backend */
+	response = ac_session_action_authorizestation_request(session, notify->radioid, notify->wlanid, notify->address);
+	if (!response) {
+		return -1;
+	}
+
+	jsonroot = ac_soapclient_parse_json_response(response);
+	ac_soapclient_free_response(response);
+	if (!jsonroot) {
+		return -1;
+	}
+
 	/* */
+	result = ac_session_action_authorizestation_response(session, jsonroot, notify, txmngpacket, &authorized);
+	if (wlan) {
+		if (authorized == AC_AUTHCACHE_DENIED) {
+			ac_authcache_add(notify->address, wlan->ssid, group, NULL, 0, ac_session_action_authorizestation_ttl(jsonroot, g_ac.authorization.negativettl));
+		} else if (!result) {
+			ac_authcache_add(notify->address, wlan->ssid, group, jsonroot, 1, ac_session_action_authorizestation_ttl(jsonroot, 0));
+		}
+	}
+
 	json_object_put(jsonroot);
 	return result;
 }
 
+/* Send Station Configuration Request with all message elements added */
+static void ac_session_send_station_configuration_request(struct ac_session_t* session, struct capwap_packet_txmng* txmngpacket) {
+	/* CAPWAP_ELEMENT_VENDORPAYLOAD */				/* TODO */
+
+	/* Station Configuration Request complete, get fragment packets */
+	capwap_packet_txmng_get_fragment_packets(txmngpacket, session->requestfragmentpacket, session->fragmentid);
+	if (session->requestfragmentpacket->count > 1) {
+		session->fragmentid++;
+	}
+
+	/* Free packets manager */
+	capwap_packet_txmng_free(txmngpacket);
+
+	/* Send Station Configuration Request to WTP */
+	if (capwap_crypt_sendto_fragmentpacket(&session->dtls, session->requestfragmentpacket)) {
+		ac_dfa_retransmition_start(session);
+	} else {
+		capwap_logging_debug("Warning: error to send Station Configuration Request packet");
+		ac_free_reference_last_request(session);
+		ac_session_teardown(session);
+	}
+}
+
+/* Coalesce the next pending action of the same type into the current Station Configuration Request */
+static struct capwap_list_item* ac_session_get_next_station_action(struct ac_session_t* session, long action, int count, struct timeval* start) {
+	struct timeval now;
+	struct capwap_list_item* itemaction = NULL;
+
+	/* Bounded batch size and latency */
+	if (count >= AC_STATION_CONFIGURATION_BATCH_SIZE) {
+		return NULL;
+	}
+
+	gettimeofday(&now, NULL);
+	if (((now.tv_sec - start->tv_sec) * 1000 + (now.tv_usec - start->tv_usec) / 1000) >= AC_STATION_CONFIGURATION_BATCH_INTERVAL) {
+		return NULL;
+	}
+
+	/* */
+	capwap_lock_enter(&session->sessionlock);
+
+	if (session->running && session->action->first) {
+		struct ac_session_action* nextaction = (struct ac_session_action*)session->action->first->item;
+
+		if ((nextaction->action == action) && ((action != AC_SESSION_ACTION_STATION_CONFIGURATION_IEEE80211_ADD_STATION) || !((struct ac_notify_station_configuration_ieee8011_add_station*)nextaction->data)->single)) {
+			itemaction = capwap_itemlist_remove_head(session->action);
+		}
+	}
+
+	capwap_lock_exit(&session->sessionlock);
+
+	return itemaction;
+}
+
 /* */
 static int ac_session_action_resetwtp(struct ac_session_t* session, struct ac_notify_reset_t* reset) {
 	struct capwap_header_data capwapheader;
@@ -215,9 +293,8 @@ static int ac_session_action_resetwtp(struct ac_session_t* session, struct ac_no
 
 	/* Send Reset Request to WTP */
 	if (capwap_crypt_sendto_fragmentpacket(&session->dtls, session->requestfragmentpacket)) {
-		session->retransmitcount = 0;
 		ac_dfa_change_state(session, CAPWAP_RESET_STATE);
-		capwap_timeout_set(session->timeout, session->idtimercontrol, AC_RETRANSMIT_INTERVAL, ac_dfa_retransmition_timeout, session, NULL);
+		ac_dfa_retransmition_start(session);
 	} else {
 		capwap_logging_debug("Warning: error to send Reset Request packet");
 		ac_free_reference_last_request(session);
@@ -235,10 +312,16 @@ static int ac_session_action_addwlan(struct ac_session_t* session, struct ac_not
 
 	ASSERT(session->requestfragmentpacket->count == 0);
 
+	/* Bulk provisioning */
+	strcpy(session->idprovisioning, notify->idprovisioning);
+	session->provisioningindex = notify->provisioningindex;
+
 	/* Check if WLAN id is valid and not used */
 	if (!IS_VALID_RADIOID(notify->radioid) || !IS_VALID_WLANID(notify->wlanid)) {
+		ac_provisioning_complete(session, 0);
 		return AC_NO_ERROR;
 	} else if (ac_wlans_get_bssid_with_wlanid(session, notify->radioid, notify->wlanid)) {
+		ac_provisioning_complete(session, 1);
 		return AC_NO_ERROR;
 	}
 
@@ -259,7 +342,11 @@ static int ac_session_action_addwlan(struct ac_session_t* session, struct ac_not
 	txmngpacket = capwap_packet_txmng_create_ctrl_message(&capwapheader, CAPWAP_IEEE80211_WLAN_CONFIGURATION_REQUEST, session->localseqnumber, session->mtu);
 
 	/* Add message element */
-	capwap_packet_txmng_add_message_element(txmngpacket, CAPWAP_ELEMENT_80211_ADD_WLAN, &addwlan);
+	if (notify->elementlength > 0) {
+		capwap_packet_txmng_add_encoded_message_element(txmngpacket, CAPWAP_ELEMENT_80211_ADD_WLAN, notify->element, notify->elementlength);
+	} else {
+		capwap_packet_txmng_add_message_element(txmngpacket, CAPWAP_ELEMENT_80211_ADD_WLAN, &addwlan);
+	}
 
 	/* CAPWAP_ELEMENT_80211_IE */
 
@@ -276,11 +363,11 @@ static int ac_session_action_addwlan(struct ac_session_t* session, struct ac_not
 
 	/* Send WLAN Configuration Request to WTP */
 	if (capwap_crypt_sendto_fragmentpacket(&session->dtls, session->requestfragmentpacket)) {
-		session->retransmitcount = 0;
-		capwap_timeout_set(session->timeout, session->idtimercontrol, AC_RETRANSMIT_INTERVAL, ac_dfa_retransmition_timeout, session, NULL);
+		ac_dfa_retransmition_start(session);
 	} else {
 		capwap_logging_debug("Warning: error to send WLAN Configuration Request packet");
 		ac_free_reference_last_request(session);
+		ac_provisioning_complete(session, 0);
 		ac_session_teardown(session);
 	}
 
@@ -289,24 +376,55 @@ static int ac_session_action_addwlan(struct ac_session_t* session, struct ac_not
 
 /* */
 static int ac_session_action_station_configuration_ieee8011_add_station(struct ac_session_t* session, struct ac_notify_station_configuration_ieee8011_add_station* notify) {
-	struct ac_soap_response* response;
+	int count = 0;
+	struct timeval start;
+	struct capwap_header_data capwapheader;
+	struct capwap_packet_txmng* txmngpacket;
+	struct capwap_list_item* itemaction = NULL;
 
 	ASSERT(session->requestfragmentpacket->count == 0);
 
-	/* Check if RADIO id and WLAN id is valid */
-	if (!IS_VALID_RADIOID(notify->radioid) || !IS_VALID_WLANID(notify->wlanid)) {
-		return AC_NO_ERROR;
-	}
+	/* Build packet */
+	gettimeofday(&start, NULL);
+	capwap_header_init(&capwapheader, CAPWAP_RADIOID_NONE, session->binding);
+	txmngpacket = capwap_packet_txmng_create_ctrl_message(&capwapheader, CAPWAP_STATION_CONFIGURATION_REQUEST, session->localseqnumber, session->mtu);
 
-	/* Need authorization of Director */
-	response = ac_session_action_authorizestation_request(session, notify->radioid, notify->wlanid, notify->address);
-	if (response) {
-		if (ac_session_action_authorizestation_response(session, response, notify)) {
-			capwap_logging_info("Station is not authorized");
-			/* TODO kickoff station */
+	/* Add all pending stations into a single request */
+	for (;;) {
+		/* Check if RADIO id and WLAN id is valid */
+		if (IS_VALID_RADIOID(notify->radioid) && IS_VALID_WLANID(notify->wlanid)) {
+			/* Need authorization of Director */
+			if (!ac_session_action_authorizestation(session, notify, txmngpacket)) {
+				count++;
+			} else {
+				capwap_logging_info("Station is not authorized");
+				/* TODO kickoff station */
+			}
+		}
+
+		/* Retry of a failed batch is not coalesced with other stations */
+		if (notify->single) {
+			break;
+		}
+
+		/* Next station */
+		if (itemaction) {
+			capwap_itemlist_free(itemaction);
+		}
+
+		itemaction = ac_session_get_next_station_action(session, AC_SESSION_ACTION_STATION_CONFIGURATION_IEEE80211_ADD_STATION, count, &start);
+		if (!itemaction) {
+			break;
 		}
 
-		ac_soapclient_free_response(response);
+		notify = (struct ac_notify_station_configuration_ieee8011_add_station*)((struct ac_session_action*)itemaction->item)->data;
+	}
+
+	/* */
+	if (count > 0) {
+		ac_session_send_station_configuration_request(session, txmngpacket);
+	} else {
+		capwap_packet_txmng_free(txmngpacket);
 	}
 
 	return AC_NO_ERROR;
@@ -314,48 +432,52 @@ static int ac_session_action_station_configuration_ieee8011_add_station(struct a
 
 /* */
 static int ac_session_action_station_configuration_ieee8011_delete_station(struct ac_session_t* session, struct ac_notify_station_configuration_ieee8011_delete_station* notify) {
+	int count = 0;
+	struct timeval start;
 	struct capwap_header_data capwapheader;
 	struct capwap_packet_txmng* txmngpacket;
 	struct capwap_deletestation_element deletestation;
+	struct capwap_list_item* itemaction = NULL;
 
 	ASSERT(session->requestfragmentpacket->count == 0);
 
-	/* Check if RADIO id is valid */
-	if (!IS_VALID_RADIOID(notify->radioid)) {
-		return AC_NO_ERROR;
-	}
-
-	/* */
-	memset(&deletestation, 0, sizeof(struct capwap_deletestation_element));
-	deletestation.radioid = notify->radioid;
-	deletestation.length = MACADDRESS_EUI48_LENGTH;
-	deletestation.address = notify->address;
-
 	/* Build packet */
+	gettimeofday(&start, NULL);
 	capwap_header_init(&capwapheader, CAPWAP_RADIOID_NONE, session->binding);
 	txmngpacket = capwap_packet_txmng_create_ctrl_message(&capwapheader, CAPWAP_STATION_CONFIGURATION_REQUEST, session->localseqnumber, session->mtu);
 
-	/* Add message element */
-	capwap_packet_txmng_add_message_element(txmngpacket, CAPWAP_ELEMENT_DELETESTATION, &deletestation);
-	/* CAPWAP_ELEMENT_VENDORPAYLOAD */				/* TODO */
+	/* Add all pending stations into a single request */
+	for (;;) {
+		/* Check if RADIO id is valid */
+		if (IS_VALID_RADIOID(notify->radioid)) {
+			memset(&deletestation, 0, sizeof(struct capwap_deletestation_element));
+			deletestation.radioid = notify->radioid;
+			deletestation.length = MACADDRESS_EUI48_LENGTH;
+			deletestation.address = notify->address;
+
+			/* Add message element */
+			capwap_packet_txmng_add_message_element(txmngpacket, CAPWAP_ELEMENT_DELETESTATION, &deletestation);
+			count++;
+		}
 
-	/* Station Configuration Request complete, get fragment packets */
-	capwap_packet_txmng_get_fragment_packets(txmngpacket, session->requestfragmentpacket, session->fragmentid);
-	if (session->requestfragmentpacket->count > 1) {
-		session->fragmentid++;
-	}
+		/* Next station */
+		if (itemaction) {
+			capwap_itemlist_free(itemaction);
+		}
 
-	/* Free packets manager */
-	capwap_packet_txmng_free(txmngpacket);
+		itemaction = ac_session_get_next_station_action(session, AC_SESSION_ACTION_STATION_CONFIGURATION_IEEE80211_DELETE_STATION, count, &start);
+		if (!itemaction) {
+			break;
+		}
 
-	/* Send Station Configuration Request to WTP */
-	if (capwap_crypt_sendto_fragmentpacket(&session->dtls, session->requestfragmentpacket)) {
-		session->retransmitcount = 0;
-		capwap_timeout_set(session->timeout, session->idtimercontrol, AC_RETRANSMIT_INTERVAL, ac_dfa_retransmition_timeout, session, NULL);
+		notify = (struct ac_notify_station_configuration_ieee8011_delete_station*)((struct ac_session_action*)itemaction->item)->data;
+	}
+
+	/* */
+	if (count > 0) {
+		ac_session_send_station_configuration_request(session, txmngpacket);
 	} else {
-		capwap_logging_debug("Warning: error to send Station Configuration Request packet");
-		ac_free_reference_last_request(session);
-		ac_session_teardown(session);
+		capwap_packet_txmng_free(txmngpacket);
 	}
 
 	return AC_NO_ERROR;
@@ -404,7 +526,7 @@ static int ac_session_action_execute(struct ac_session_t* session, struct ac_ses
 #endif
 			/* Send keep-alive response */
 			//ac_kmod_send_keepalive(&session->sessionid);
-			capwap_timeout_set(session->timeout, session->idtimerkeepalivedead, AC_MAX_DATA_KEEPALIVE_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+			capwap_timeout_set(session->timeout, session->idtimerkeepalivedead, AC_MAX_DATA_KEEPALIVE_INTERVAL, ac_dfa_keepalive_timeout, session, NULL);
 
 			/* */
 			if (session->state == CAPWAP_DATA_CHECK_TO_RUN_STATE) {
@@ -415,7 +537,7 @@ static int ac_session_action_execute(struct ac_session_t* session, struct ac_ses
 				if (response) {
 					if (response->responsecode == HTTP_RESULT_OK) {
 						ac_dfa_change_state(session, CAPWAP_RUN_STATE);
-						capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_teardown_timeout, session, NULL);
+						capwap_timeout_set(session->timeout, session->idtimercontrol, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout, session, NULL);
 					} else {
 						result = CAPWAP_ERROR_CLOSE;
 					}
@@ -651,43 +773,41 @@ static void ac_send_invalid_request(struct ac_session_t* session, uint32_t error
 
 /* Release reference of session */
 static void ac_session_destroy(struct ac_session_t* session) {
-#ifdef DEBUG
 	char sessionname[33];
-#endif
+	struct capwap_rtt rtt;
 
 	ASSERT(session != NULL);
 
-#ifdef DEBUG
+	/* Round trip time estimated from control channel, for monitoring of WTP link */
 	capwap_sessionid_printf(&session->sessionid, sessionname);
-	capwap_logging_debug("Release Session AC %s", sessionname);
-#endif
-
-	/* Release last reference */
-	capwap_lock_enter(&session->sessionlock);
-	session->count--;
+	ac_session_get_rtt(session, &rtt);
+	capwap_logging_info("Release Session AC %s: srtt %ld us, rttvar %ld us, rto %ld ms", sessionname, rtt.srtt, rtt.rttvar, rtt.rto);
 
 	/* Terminate SOAP request pending */
+	capwap_lock_enter(&session->sessionlock);
 	if (session->soaprequest) {
 		ac_soapclient_shutdown_request(session->soaprequest);
 	}
 
-	/* Check if all reference is release */
-	while (session->count > 0) {
+	if (session->batchrequest) {
+		ac_batch_shutdown_request(session->batchrequest);
+	}
+
+	capwap_lock_exit(&session->sessionlock);
+
+	/* Session is already out of g_ac.sessions, the write lock taken by teardown
+	   is the grace period for the lookups. Release own reference and wait the last
+	   holder, the event is sticky so a release before the wait is not lost */
+	if (!capwap_atomic_dec_and_test(&session->count)) {
 #ifdef DEBUG
-		capwap_logging_debug("Wait for release Session AC %s (count=%d)", sessionname, session->count);
+		capwap_logging_debug("Wait for release Session AC %s (count=%ld)", sessionname, capwap_atomic_read(&session->count));
 #endif
-		/* */
-		capwap_event_reset(&session->changereference);
-		capwap_lock_exit(&session->sessionlock);
-
-		/* Wait */
-		capwap_event_wait(&session->changereference);
 
-		capwap_lock_enter(&session->sessionlock);
+		while (capwap_atomic_read(&session->count) > 0) {
+			capwap_event_wait(&session->changereference);
+		}
 	}
 
-	capwap_lock_exit(&session->sessionlock);
-
 	/* Close data channel */
 	ac_kmod_delete_datasession(&session->sessionid);
 
@@ -727,6 +847,10 @@ static void ac_session_destroy(struct ac_session_t* session) {
 		capwap_free(session->wtpid);
 	}
 
+	if (session->authgroup) {
+		capwap_free(session->authgroup);
+	}
+
 	/* Free item */
 	capwap_itemlist_free(session->itemlist);
 }
@@ -760,6 +884,11 @@ static void ac_session_run(struct ac_session_t* session) {
 				ac_session_teardown(session);
 			}
 		} else if (length > 0) {
+			/* Echo Request of DTLS session, plain session is replied by receive thread */
+			if (session->dtls.enable && ac_session_recv_echo_request(session, buffer, length, 1)) {
+				continue;
+			}
+
 			/* Check generic capwap packet */
 			check = capwap_sanity_check(CAPWAP_UNDEF_STATE, buffer, length, 0);
 			if (check == CAPWAP_PLAIN_PACKET) {
@@ -791,6 +920,11 @@ static void ac_session_run(struct ac_session_t* session) {
 
 								/* Validate packet */
 								if (!capwap_validate_parsed_packet(&packet, NULL)) {
+									/* Response of pending request */
+									if (!hasrequest && session->requestfragmentpacket->count && (session->localseqnumber == session->rxmngpacket->ctrlmsg.seq)) {
+										ac_dfa_retransmition_complete(session);
+									}
+
 									/* Search into notify event */
 									search = session->notifyevent->first;
 									while (search != NULL) {
@@ -880,6 +1014,140 @@ static void ac_session_run(struct ac_session_t* session) {
 	ac_session_destroy(session);
 }
 
+/* */
+static long ac_session_get_elapsed(struct timeval* last) {
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return ((now.tv_sec - last->tv_sec) * 1000) + ((now.tv_usec - last->tv_usec) / 1000);
+}
+
+/* Prebuild Echo Response and enable the receive fast path */
+static void ac_session_enable_fastpath(struct ac_session_t* session) {
+	struct capwap_list* fragmentlist;
+	struct capwap_header_data capwapheader;
+	struct capwap_packet_txmng* txmngpacket;
+	struct capwap_fragment_packet_item* fragmentpacket;
+
+	/* Echo Response without message elements, the sequence number is patched at send time */
+	capwap_header_init(&capwapheader, CAPWAP_RADIOID_NONE, session->binding);
+	txmngpacket = capwap_packet_txmng_create_ctrl_message(&capwapheader, CAPWAP_ECHO_RESPONSE, 0, session->mtu);
+
+	fragmentlist = capwap_list_create();
+	capwap_packet_txmng_get_fragment_packets(txmngpacket, fragmentlist, 0);
+	capwap_packet_txmng_free(txmngpacket);
+
+	/* */
+	capwap_lock_enter(&session->sessionlock);
+
+	fragmentpacket = (struct capwap_fragment_packet_item*)fragmentlist->first->item;
+	if ((fragmentlist->count == 1) && (fragmentpacket->offset <= AC_ECHO_RESPONSE_TEMPLATE_LENGTH)) {
+		memcpy(session->echoresponse, fragmentpacket->buffer, fragmentpacket->offset);
+		session->echoresponselength = fragmentpacket->offset;
+		session->fastpath = 1;
+
+		/* Backend has just confirmed the session */
+		gettimeofday(&session->lastcheckwtpsession, NULL);
+		session->lastecho = session->lastcheckwtpsession;
+		session->lastkeepalive = session->lastcheckwtpsession;
+	}
+
+	capwap_lock_exit(&session->sessionlock);
+
+	capwap_list_free(fragmentlist);
+}
+
+/* */
+static void ac_session_disable_fastpath(struct ac_session_t* session) {
+	capwap_lock_enter(&session->sessionlock);
+	session->fastpath = 0;
+	capwap_lock_exit(&session->sessionlock);
+}
+
+/* Reply to a well-formed Echo Request of a RUN session without waking the DFA */
+int ac_session_recv_echo_request(struct ac_session_t* session, void* buffer, int length, int plainbuffer) {
+	int headerlength;
+	int responselength;
+	struct capwap_header* header;
+	struct capwap_control_message* ctrlmsg;
+	char response[AC_ECHO_RESPONSE_TEMPLATE_LENGTH];
+
+	ASSERT(session != NULL);
+	ASSERT(buffer != NULL);
+
+	/* Only plain Echo Request without message elements and fragmentation */
+	if ((length <= sizeof(struct capwap_preamble)) || (capwap_sanity_check(CAPWAP_UNDEF_STATE, buffer, length, 0) != CAPWAP_PLAIN_PACKET)) {
+		return 0;
+	}
+
+	header = (struct capwap_header*)buffer;
+	headerlength = GET_HLEN_HEADER(header) * 4;
+	if (IS_FLAG_F_HEADER(header) || IS_FLAG_T_HEADER(header) || (length != (headerlength + sizeof(struct capwap_control_message)))) {
+		return 0;
+	}
+
+	ctrlmsg = (struct capwap_control_message*)((char*)buffer + headerlength);
+	if ((ntohl(ctrlmsg->type) != CAPWAP_ECHO_REQUEST) || (ntohs(ctrlmsg->length) != CAPWAP_CONTROL_MESSAGE_MIN_LENGTH) || ctrlmsg->flags) {
+		return 0;
+	}
+
+	/* */
+	capwap_lock_enter(&session->sessionlock);
+
+	if (!session->fastpath || (!plainbuffer && session->dtls.enable) || (GET_WBID_HEADER(header) != session->binding) || (ac_session_get_elapsed(&session->lastcheckwtpsession) >= AC_ECHO_CHECK_SESSION_INTERVAL)) {
+		capwap_lock_exit(&session->sessionlock);
+		return 0;
+	}
+
+	/* */
+	responselength = session->echoresponselength;
+	memcpy(response, session->echoresponse, responselength);
+	gettimeofday(&session->lastecho, NULL);
+
+	capwap_lock_exit(&session->sessionlock);
+
+	/* The remotetype and remoteseqnumber of session are not updated. They are owned by session
+	   thread, and its duplicate check would answer a retransmitted Echo Request with the cached
+	   response of previous DFA request. A retransmitted Echo Request reach this path again and
+	   it is answered with the same template */
+	header = (struct capwap_header*)response;
+	((struct capwap_control_message*)(response + GET_HLEN_HEADER(header) * 4))->seq = ctrlmsg->seq;
+
+	if (capwap_crypt_sendto(&session->dtls, response, responselength) <= 0) {
+		capwap_logging_debug("Warning: error to send echo response packet");
+	}
+
+	return 1;
+}
+
+/* Refresh Keep-Alive deadline of a RUN session without waking the DFA */
+int ac_session_recv_keepalive(struct ac_session_t* session) {
+	int result = 0;
+
+	ASSERT(session != NULL);
+
+	capwap_lock_enter(&session->sessionlock);
+
+	if (session->fastpath) {
+		gettimeofday(&session->lastkeepalive, NULL);
+		result = 1;
+	}
+
+	capwap_lock_exit(&session->sessionlock);
+
+	return result;
+}
+
+/* */
+void ac_session_echo_complete(struct ac_session_t* session) {
+	ASSERT(session != NULL);
+
+	capwap_lock_enter(&session->sessionlock);
+	gettimeofday(&session->lastcheckwtpsession, NULL);
+	session->lastecho = session->lastcheckwtpsession;
+	capwap_lock_exit(&session->sessionlock);
+}
+
 /* Change WTP state machine */
 void ac_dfa_change_state(struct ac_session_t* session, int state) {
 	struct capwap_list_item* search;
@@ -895,6 +1163,13 @@ void ac_dfa_change_state(struct ac_session_t* session, int state) {
 
 		session->state = state;
 
+		/* */
+		if (state == CAPWAP_RUN_STATE) {
+			ac_session_enable_fastpath(session);
+		} else {
+			ac_session_disable_fastpath(session);
+		}
+
 		/* Search into notify event */
 		search = session->notifyevent->first;
 		while (search != NULL) {
@@ -959,6 +1234,9 @@ void ac_session_teardown(struct ac_session_t* session) {
 		}
 	}
 
+	/* WLAN provisioning without response */
+	ac_provisioning_complete(session, 0);
+
 	/* Remove timer */
 	if (session->idtimercontrol != CAPWAP_TIMEOUT_INDEX_NO_SET) {
 		capwap_timeout_unset(session->timeout, session->idtimercontrol);
@@ -1049,8 +1327,55 @@ struct ac_soap_response* ac_session_send_soap_request(struct ac_session_t* sessi
 
 	ASSERT(session != NULL);
 	ASSERT(session->soaprequest == NULL);
+	ASSERT(session->batchrequest == NULL);
 	ASSERT(method != NULL);
 
+	/* Backend Server is unhealthy, answer with local policy without wait the timeout */
+	if (ac_backend_isdegraded()) {
+		return ac_health_local_response(method);
+	}
+
+	/* Request sent with the same requests of other sessions */
+	if (ac_batch_isbatchable(method)) {
+		struct json_object* jsonparams = json_object_new_object();
+
+		va_start(listparam, numparam);
+		for (i = 0; i < numparam; i++) {
+			char* type = va_arg(listparam, char*);
+			char* name = va_arg(listparam, char*);
+			char* value = va_arg(listparam, char*);
+
+			/* JSON param is carried as JSON document */
+			if (!strcmp(type, "xs:base64Binary")) {
+				json_object_object_add(jsonparams, name, json_tokener_parse(value));
+			} else {
+				json_object_object_add(jsonparams, name, json_object_new_string(value));
+			}
+		}
+		va_end(listparam);
+
+		/* */
+		capwap_lock_enter(&session->sessionlock);
+		session->batchrequest = ac_batch_create_request(method, jsonparams);
+		capwap_lock_exit(&session->sessionlock);
+
+		json_object_put(jsonparams);
+
+		/* Send Request & Recv Response */
+		response = ac_batch_execute(session->batchrequest);
+
+		/* Critical section */
+		capwap_lock_enter(&session->sessionlock);
+
+		/* Free resource */
+		ac_batch_free_request(session->batchrequest);
+		session->batchrequest = NULL;
+
+		capwap_lock_exit(&session->sessionlock);
+
+		return response;
+	}
+
 	/* Build Soap Request */
 	capwap_lock_enter(&session->sessionlock);
 	session->soaprequest = ac_backend_createrequest_with_session(method, SOAP_NAMESPACE_URI);
@@ -1078,9 +1403,7 @@ struct ac_soap_response* ac_session_send_soap_request(struct ac_session_t* sessi
 
 	/* Send Request & Recv Response */
 	if (session->soaprequest) {
-		if (ac_soapclient_send_request(session->soaprequest, "")) {
-			response = ac_soapclient_recv_response(session->soaprequest);
-		}
+		response = ac_backend_execute(session->soaprequest);
 
 		/* Critical section */
 		capwap_lock_enter(&session->sessionlock);
@@ -1095,8 +1418,53 @@ struct ac_soap_response* ac_session_send_soap_request(struct ac_session_t* sessi
 	return response;
 }
 
+/* */
+void ac_dfa_retransmition_start(struct ac_session_t* session) {
+	long durate;
+
+	ASSERT(session != NULL);
+
+	/* */
+	capwap_lock_enter(&session->sessionlock);
+	durate = capwap_rtt_start(&session->rtt);
+	capwap_lock_exit(&session->sessionlock);
+
+	/* */
+	session->retransmitcount = 0;
+	capwap_timeout_set(session->timeout, session->idtimercontrol, durate, ac_dfa_retransmition_timeout, session, NULL);
+}
+
+/* */
+void ac_dfa_retransmition_complete(struct ac_session_t* session) {
+	ASSERT(session != NULL);
+
+	/* Update round-trip time estimation */
+	capwap_lock_enter(&session->sessionlock);
+	capwap_rtt_update(&session->rtt);
+	capwap_lock_exit(&session->sessionlock);
+
+#ifdef DEBUG
+	{
+		char sessionname[33];
+		capwap_sessionid_printf(&session->sessionid, sessionname);
+		capwap_logging_debug("Session AC %s: srtt %ld us, rttvar %ld us, rto %ld ms", sessionname, session->rtt.srtt, session->rtt.rttvar, session->rtt.rto);
+	}
+#endif
+}
+
+/* */
+void ac_session_get_rtt(struct ac_session_t* session, struct capwap_rtt* rtt) {
+	ASSERT(session != NULL);
+	ASSERT(rtt != NULL);
+
+	capwap_lock_enter(&session->sessionlock);
+	memcpy(rtt, &session->rtt, sizeof(struct capwap_rtt));
+	capwap_lock_exit(&session->sessionlock);
+}
+
 /* */
 void ac_dfa_retransmition_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param) {
+	long durate;
 	struct ac_session_t* session = (struct ac_session_t*)context;
 
 	if (!session->requestfragmentpacket->count) {
@@ -1104,7 +1472,7 @@ void ac_dfa_retransmition_timeout(struct capwap_timeout* timeout, unsigned long
 		ac_session_teardown(session);
 	} else {
 		session->retransmitcount++;
-		if (session->retransmitcount >= AC_MAX_RETRANSMIT) {
+		if (session->retransmitcount >= session->dfa.retransmit.count) {
 			capwap_logging_info("Retransmition request packet timeout");
 
 			/* Timeout reset state */
@@ -1117,8 +1485,12 @@ void ac_dfa_retransmition_timeout(struct capwap_timeout* timeout, unsigned long
 				capwap_logging_error("Error to send request packet");
 			}
 
-			/* Update timeout */
-			capwap_timeout_set(session->timeout, session->idtimercontrol, AC_RETRANSMIT_INTERVAL, ac_dfa_retransmition_timeout, session, NULL);
+			/* Update timeout with exponential backoff */
+			capwap_lock_enter(&session->sessionlock);
+			durate = capwap_rtt_backoff(&session->rtt);
+			capwap_lock_exit(&session->sessionlock);
+
+			capwap_timeout_set(session->timeout, session->idtimercontrol, durate, ac_dfa_retransmition_timeout, session, NULL);
 		}
 	}
 }
@@ -1127,3 +1499,32 @@ void ac_dfa_teardown_timeout(struct capwap_timeout* timeout, unsigned long index
 	capwap_logging_info("Session timeout, teardown");
 	ac_session_teardown((struct ac_session_t*)context);
 }
+
+/* Deadline refreshed by fast path, re-arm for the remaining time */
+static void ac_dfa_deadline_timeout(struct capwap_timeout* timeout, unsigned long index, struct ac_session_t* session, struct timeval* last, long interval, capwap_timeout_expire callback) {
+	long elapsed;
+
+	capwap_lock_enter(&session->sessionlock);
+	elapsed = (session->fastpath ? ac_session_get_elapsed(last) : interval);
+	capwap_lock_exit(&session->sessionlock);
+
+	if ((elapsed >= 0) && (elapsed < interval)) {
+		capwap_timeout_set(timeout, index, interval - elapsed, callback, session, NULL);
+	} else {
+		ac_dfa_teardown_timeout(timeout, index, session, NULL);
+	}
+}
+
+/* */
+void ac_dfa_echo_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param) {
+	struct ac_session_t* session = (struct ac_session_t*)context;
+
+	ac_dfa_deadline_timeout(timeout, index, session, &session->lastecho, AC_MAX_ECHO_INTERVAL, ac_dfa_echo_timeout);
+}
+
+/* */
+void ac_dfa_keepalive_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param) {
+	struct ac_session_t* session = (struct ac_session_t*)context;
+
+	ac_dfa_deadline_timeout(timeout, index, session, &session->lastkeepalive, AC_MAX_DATA_KEEPALIVE_INTERVAL, ac_dfa_keepalive_timeout);
+}
@@ -4,6 +4,7 @@
 #include "capwap_dtls.h"
 #include "capwap_event.h"
 #include "capwap_lock.h"
+#include "capwap_atomic.h"
 #include "ac_soap.h"
 #include "ieee80211.h"
 
@@ -13,6 +14,9 @@ struct ac_packet {
 	char buffer[0];
 };
 
+/* Echo Response template */
+#define AC_ECHO_RESPONSE_TEMPLATE_LENGTH			64
+
 /* */
 struct ac_session_control {
 	union sockaddr_capwap localaddress;
@@ -73,6 +77,12 @@ struct ac_notify_addwlan_t {
 	uint8_t tunnelmode;
 	uint8_t suppressssid;
 	char ssid[CAPWAP_ADD_WLAN_SSID_LENGTH + 1];
+
+	/* Bulk provisioning with IEEE 802.11 Add WLAN already encoded */
+	char idprovisioning[65];
+	unsigned long provisioningindex;
+	unsigned short elementlength;
+	uint8_t element[0];
 };
 
 /* Station Configuration IEEE802.11 add station notification */
@@ -85,6 +95,9 @@ struct ac_notify_station_configuration_ieee8011_add_station {
 	uint16_t capabilities;
 	uint8_t supportedratescount;
 	uint8_t supportedrates[CAPWAP_STATION_RATES_MAXLENGTH];
+
+	/* Retry of a failed batch, sent alone in a Station Configuration Request */
+	int single;
 };
 
 /* Station Configuration IEEE802.11 delete station notification */
@@ -95,6 +108,7 @@ struct ac_notify_station_configuration_ieee8011_delete_station {
 
 /* */
 struct ac_session_t;
+struct ac_batch_request;
 
 /* AC sessions */
 struct ac_session_t {
@@ -102,18 +116,20 @@ struct ac_session_t {
 	pthread_t threadid;
 	struct capwap_list_item* itemlist;					/* My itemlist into g_ac.sessions */
 
-	/* Reference */
-	long count;
+	/* Reference, lookup takes it without sessionlock */
+	capwap_atomic_t count;
 	capwap_event_t changereference;
 
 	/* Soap */
 	struct ac_http_soap_request* soaprequest;
+	struct ac_batch_request* batchrequest;
 
 	/* WLAN Reference */
 	struct ac_wlans* wlans;
 
 	/* */
 	char* wtpid;
+	char* authgroup;							/* Group of WTPs sharing station authorizations */
 	unsigned long state;
 	struct ac_state dfa;
 
@@ -141,10 +157,23 @@ struct ac_session_t {
 	uint8_t localseqnumber;
 	struct capwap_list* requestfragmentpacket;
 	int retransmitcount;
+	struct capwap_rtt rtt;
 
 	uint32_t remotetype;
 	uint8_t remoteseqnumber;
 	struct capwap_list* responsefragmentpacket;
+
+	/* Bulk provisioning waiting response */
+	char idprovisioning[65];
+	unsigned long provisioningindex;
+
+	/* Echo and Keep-Alive fast path, protected by sessionlock */
+	int fastpath;
+	int echoresponselength;
+	char echoresponse[AC_ECHO_RESPONSE_TEMPLATE_LENGTH];
+	struct timeval lastecho;
+	struct timeval lastkeepalive;
+	struct timeval lastcheckwtpsession;
 };
 
 /* Session */
@@ -162,6 +191,11 @@ int ac_has_sessionid(struct capwap_sessionid_element* sessionid);
 struct ac_session_t* ac_search_session_from_wtpid(const char* wtpid);
 int ac_has_wtpid(const char* wtpid);
 
+/* */
+int ac_session_recv_echo_request(struct ac_session_t* session, void* buffer, int length, int plainbuffer);
+int ac_session_recv_keepalive(struct ac_session_t* session);
+void ac_session_echo_complete(struct ac_session_t* session);
+
 /* */
 char* ac_get_printable_wtpid(struct capwap_wtpboarddata_element* wtpboarddata);
 
@@ -191,8 +225,15 @@ int ac_msgqueue_close_allsessions(void);
 int ac_dtls_setup(struct ac_session_t* session);
 
 /* */
+void ac_session_get_rtt(struct ac_session_t* session, struct capwap_rtt* rtt);
+
+/* */
+void ac_dfa_retransmition_start(struct ac_session_t* session);
+void ac_dfa_retransmition_complete(struct ac_session_t* session);
 void ac_dfa_retransmition_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param);
 void ac_dfa_teardown_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param);
+void ac_dfa_echo_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param);
+void ac_dfa_keepalive_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param);
 
 /* */
 void ac_dfa_state_join(struct ac_session_t* session, struct capwap_parsed_packet* packet);
@@ -2,15 +2,6 @@
 #include "ac_soap.h"
 #include "capwap_socket.h"
 
-/* */
-#define SOAP_PROTOCOL_CONNECT_TIMEOUT		10000
-
-/* */
-#define HTTP_RESPONSE_STATUS_CODE			0
-#define HTTP_RESPONSE_HEADER				1
-#define HTTP_RESPONSE_BODY					2
-#define HTTP_RESPONSE_ERROR					3
-
 /* */
 static const char l_encodeblock[] = 
 	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
@@ -21,52 +12,92 @@ static const char l_decodeblock[] =
 	"\x00\x00\x00\x00\x00\x00\x1b\x1c\x1d\x1e\x1f\x20\x21\x22\x23\x24"
 	"\x25\x26\x27\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f\x30\x31\x32\x33\x34";
 
-/* */
-xmlNodePtr ac_xml_get_children(xmlNodePtr parent) {
-	xmlNodePtr children;
-
-	ASSERT(parent != NULL);
+/* State of SAX parser of SOAP response */
+struct ac_soap_xml_parser {
+	xmlParserCtxtPtr context;
+	struct ac_http_soap_request* httprequest;
+	struct ac_soap_response* response;
+	char* tagmethod;
 
 	/* */
-	children = parent->xmlChildrenNode;
-	while ((children != NULL) && (children->type != XML_ELEMENT_NODE)) {
-		children = children->next;
-	}
-
-	return children;
-}
+	int depth;
+	int body;
+	int inbody;
+	int inmethod;
+	int found;
+	int error;
+
+	/* Text of element being retrieved */
+	char** value;
+	char* text;
+	int valuelength;
+	int textsize;
+};
+
+/* Fixed parts of XML SOAP Request */
+static const char l_soapenvelopebegin[] =
+	"<SOAP-ENV:Envelope xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+	"xmlns:SOAP-ENC=\"http://schemas.xmlsoap.org/soap/encoding/\" SOAP-ENV:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\" "
+	"xmlns:SOAP-ENV=\"" SOAP_ENVELOPE_NAMESPACE "\" xmlns:tns=\"";
+static const char l_soapenvelopebody[] = "\"><SOAP-ENV:Header/><SOAP-ENV:Body><tns:";
+static const char l_soapenvelopeend[] = "</SOAP-ENV:Body></SOAP-ENV:Envelope>";
+
+/* Escape XML text, without buffer return only the length of escaped text */
+static int ac_soapclient_xml_string(const char* value, char* buffer) {
+	int length = 0;
+
+	for (; *value; value++) {
+		const char* entity;
+
+		switch (*value) {
+			case '&': {
+				entity = "&amp;";
+				break;
+			}
 
-/* */
-xmlNodePtr ac_xml_get_next(xmlNodePtr element) {
-	xmlNodePtr node;
+			case '<': {
+				entity = "&lt;";
+				break;
+			}
 
-	ASSERT(element != NULL);
+			case '>': {
+				entity = "&gt;";
+				break;
+			}
 
-	node = element->next;
-	while ((node != NULL) && (node->type != XML_ELEMENT_NODE)) {
-		node = node->next;
-	}
+			case '"': {
+				entity = "&quot;";
+				break;
+			}
 
-	return node;
-}
+			case '\r': {
+				entity = "&#13;";
+				break;
+			}
 
-xmlNodePtr ac_xml_search_child(xmlNodePtr parent, char* prefix, char* name) {
-	xmlNodePtr children;
+			default: {
+				if (buffer) {
+					buffer[length] = *value;
+				}
 
-	ASSERT(parent != NULL);
-	ASSERT(name != NULL);
+				length++;
+				continue;
+			}
+		}
 
-	children = ac_xml_get_children(parent);
-	while (children != NULL) {
-		if (!xmlStrcmp(children->name, BAD_CAST name) && (!prefix || !xmlStrcmp(children->ns->prefix, BAD_CAST prefix))) {
-			break;
+		if (buffer) {
+			strcpy(&buffer[length], entity);
 		}
 
-		/* */
-		children = ac_xml_get_next(children);
+		length += strlen(entity);
 	}
 
-	return children;
+	return length;
+}
+
+/* Compare element of SOAP envelope */
+static int ac_soapclient_xml_is_envelope(const xmlChar* localname, const xmlChar* urinamespace, const char* name) {
+	return (urinamespace && !xmlStrcmp(urinamespace, BAD_CAST SOAP_ENVELOPE_NAMESPACE) && !xmlStrcmp(localname, BAD_CAST name));
 }
 
 /* */
@@ -171,10 +202,155 @@ static int ac_soapclient_parsing_url(struct ac_http_soap_server* server, const c
 	return 1;
 }
 
+/* */
+static long ac_soapclient_get_elapsed(struct timeval* last) {
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return ((now.tv_sec - last->tv_sec) * 1000) + ((now.tv_usec - last->tv_usec) / 1000);
+}
+
+/* */
+static void ac_soapclient_close_connection(int sock, struct capwap_socket_ssl* sslsock) {
+	if (sslsock) {
+		capwap_socket_ssl_shutdown(sslsock, SOAP_PROTOCOL_CLOSE_TIMEOUT);
+		capwap_socket_ssl_close(sslsock);
+		capwap_free(sslsock);
+	}
+
+	if (sock >= 0) {
+		capwap_socket_close(sock);
+	}
+}
+
+/* Idle connection is stale if the server closed it or sent unsolicited data */
+static int ac_soapclient_is_stale_connection(int sock) {
+	struct pollfd fds;
+
+	memset(&fds, 0, sizeof(struct pollfd));
+	fds.fd = sock;
+	fds.events = POLLIN;
+
+	return ((poll(&fds, 1, 0) != 0) ? 1 : 0);
+}
+
+/* Retrieve an idle connection from pool */
+int ac_soapclient_pool_get(struct ac_http_soap_request* httprequest) {
+	int result = 0;
+	struct ac_http_soap_connection connection;
+	struct ac_http_soap_pool* pool = &httprequest->server->pool;
+
+	capwap_lock_enter(&pool->lock);
+
+	while (pool->idlecount > 0) {
+		memcpy(&connection, &pool->idle[--pool->idlecount], sizeof(struct ac_http_soap_connection));
+
+		/* */
+		if ((ac_soapclient_get_elapsed(&connection.lastused) < pool->idletimeout) && !ac_soapclient_is_stale_connection(connection.sock)) {
+			httprequest->sock = connection.sock;
+			httprequest->sslsock = connection.sslsock;
+			httprequest->pooled = 1;
+			httprequest->reused = 1;
+			pool->reused++;
+			result = 1;
+			break;
+		}
+
+		/* Drop expired connection */
+		pool->opened--;
+		pool->expired++;
+		capwap_lock_exit(&pool->lock);
+		ac_soapclient_close_connection(connection.sock, connection.sslsock);
+		capwap_lock_enter(&pool->lock);
+	}
+
+	capwap_lock_exit(&pool->lock);
+	return result;
+}
+
+/* Return connection to pool or close it */
+void ac_soapclient_pool_put(struct ac_http_soap_request* httprequest, int reuse) {
+	struct ac_http_soap_connection* connection;
+	struct ac_http_soap_pool* pool = &httprequest->server->pool;
+
+	if (httprequest->sock < 0) {
+		return;
+	}
+
+	/* */
+	if (httprequest->pooled) {
+		capwap_lock_enter(&pool->lock);
+
+		if (reuse && (pool->idlecount < pool->maxconnections)) {
+			connection = &pool->idle[pool->idlecount++];
+			connection->sock = httprequest->sock;
+			connection->sslsock = httprequest->sslsock;
+			gettimeofday(&connection->lastused, NULL);
+
+			capwap_lock_exit(&pool->lock);
+
+			/* */
+			httprequest->sock = -1;
+			httprequest->sslsock = NULL;
+			httprequest->pooled = 0;
+			return;
+		}
+
+		pool->opened--;
+		pool->discarded++;
+		capwap_lock_exit(&pool->lock);
+	}
+
+	/* */
+	ac_soapclient_close_connection(httprequest->sock, httprequest->sslsock);
+	httprequest->sock = -1;
+	httprequest->sslsock = NULL;
+	httprequest->pooled = 0;
+}
+
+/* Account a new connection */
+void ac_soapclient_pool_add(struct ac_http_soap_request* httprequest) {
+	struct ac_http_soap_pool* pool = &httprequest->server->pool;
+
+	/* Connections over the max-per-host limit are closed after the response */
+	capwap_lock_enter(&pool->lock);
+
+	pool->created++;
+	if (pool->opened < pool->maxconnections) {
+		pool->opened++;
+		httprequest->pooled = 1;
+	}
+
+	capwap_lock_exit(&pool->lock);
+}
+
+/* Idle connections are no longer valid */
+void ac_soapclient_pool_retry(struct ac_http_soap_server* server) {
+	capwap_lock_enter(&server->pool.lock);
+	server->pool.retried++;
+	capwap_lock_exit(&server->pool.lock);
+
+	ac_soapclient_flush_server(server);
+}
+
 /* */
 static int ac_soapclient_connect(struct ac_http_soap_request* httprequest) {
 	int result = 0;
 
+	ASSERT(httprequest->sock < 0);
+
+	/* Reuse a persistent connection */
+	httprequest->reused = 0;
+	if (ac_soapclient_pool_get(httprequest)) {
+		return 1;
+	}
+
+	/* Create socket */
+	httprequest->sock = socket(httprequest->server->address.ss.ss_family, SOCK_STREAM, 0);
+	if (httprequest->sock < 0) {
+		return 0;
+	}
+
 	if (httprequest->server->protocol == SOAP_HTTP_PROTOCOL) {
 		result = capwap_socket_connect(httprequest->sock, &httprequest->server->address, SOAP_PROTOCOL_CONNECT_TIMEOUT);
 	} else if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
@@ -188,11 +364,19 @@ static int ac_soapclient_connect(struct ac_http_soap_request* httprequest) {
 		}
 	}
 
-	return result;
+	if (!result) {
+		ac_soapclient_close_connection(httprequest->sock, httprequest->sslsock);
+		httprequest->sock = -1;
+		httprequest->sslsock = NULL;
+		return 0;
+	}
+
+	ac_soapclient_pool_add(httprequest);
+	return 1;
 }
 
 /* */
-static int ac_soapclient_send_http(struct ac_http_soap_request* httprequest, char* soapaction, char* body, int length) {
+char* ac_soapclient_build_http(struct ac_http_soap_request* httprequest, char* soapaction, char* body, int length, int* httplength) {
 	time_t ts;
 	struct tm stm;
 	char datetime[32];
@@ -206,213 +390,538 @@ static int ac_soapclient_send_http(struct ac_http_soap_request* httprequest, cha
 	strftime(datetime, 32, "%a, %d %b %Y %T %z", &stm);
 
 	/* Calculate header length */
-	headerlength = 150 + length + strlen(httprequest->server->path) + strlen(httprequest->server->host) + strlen(datetime) + strlen((soapaction ? soapaction : ""));
+	headerlength = 160 + length + strlen(httprequest->server->path) + strlen(httprequest->server->host) + strlen(datetime) + strlen((soapaction ? soapaction : ""));
 	buffer = capwap_alloc(headerlength);
 
 	/* HTTP headers */
-	result = snprintf(buffer, headerlength,
-		"POST %s HTTP/1.1\r\n"
-		"Host: %s\r\n"
-		"Date: %s\r\n"
-		"Content-Length: %d\r\n"
-		"Content-Type: text/xml\r\n"
-		"Connection: Close\r\n"
-		"SoapAction: %s\r\n"
-		"Expect: 100-continue\r\n"
-		"\r\n"
-		"%s",
-		httprequest->server->path,
-		httprequest->server->host,
-		datetime,
-		length,
-		(soapaction ? soapaction : ""),
-		body
-	);
-
-	/* Send headers */
-	if (result < 0) {
-		result = 0;
+	if (httprequest->server->transport == SOAP_TRANSPORT_JSON) {
+		result = snprintf(buffer, headerlength,
+			"POST %s HTTP/1.1\r\n"
+			"Host: %s\r\n"
+			"Date: %s\r\n"
+			"Content-Length: %d\r\n"
+			"Content-Type: application/json\r\n"
+			"Connection: %s\r\n"
+			"Expect: 100-continue\r\n"
+			"\r\n"
+			"%s",
+			httprequest->server->path,
+			httprequest->server->host,
+			datetime,
+			length,
+			(httprequest->pooled ? "Keep-Alive" : "Close"),
+			body
+		);
 	} else {
-		int sendlength = -1;
+		result = snprintf(buffer, headerlength,
+			"POST %s HTTP/1.1\r\n"
+			"Host: %s\r\n"
+			"Date: %s\r\n"
+			"Content-Length: %d\r\n"
+			"Content-Type: text/xml\r\n"
+			"Connection: %s\r\n"
+			"SoapAction: %s\r\n"
+			"Expect: 100-continue\r\n"
+			"\r\n"
+			"%s",
+			httprequest->server->path,
+			httprequest->server->host,
+			datetime,
+			length,
+			(httprequest->pooled ? "Keep-Alive" : "Close"),
+			(soapaction ? soapaction : ""),
+			body
+		);
+	}
 
-		/* Send packet */
-		if (httprequest->server->protocol == SOAP_HTTP_PROTOCOL) {
-			sendlength = capwap_socket_send(httprequest->sock, buffer, result, httprequest->requesttimeout);
-		} else if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
-			sendlength = capwap_socket_crypto_send(httprequest->sslsock, buffer, result, httprequest->requesttimeout);
-		}
+	if ((result < 0) || (result >= headerlength)) {
+		capwap_free(buffer);
+		return NULL;
+	}
+
+	*httplength = result;
+	return buffer;
+}
+
+/* */
+static int ac_soapclient_send_http(struct ac_http_soap_request* httprequest, char* soapaction, char* body, int length) {
+	int result = 0;
+	int httplength;
+	int sendlength = -1;
+	char* buffer;
+
+	/* */
+	buffer = ac_soapclient_build_http(httprequest, soapaction, body, length, &httplength);
+	if (!buffer) {
+		return 0;
+	}
 
-		/* Check result */
-		result = ((sendlength == result) ? 1 : 0);
+	/* Send packet */
+	if (httprequest->server->protocol == SOAP_HTTP_PROTOCOL) {
+		sendlength = capwap_socket_send(httprequest->sock, buffer, httplength, httprequest->requesttimeout);
+	} else if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
+		sendlength = capwap_socket_crypto_send(httprequest->sslsock, buffer, httplength, httprequest->requesttimeout);
 	}
 
+	/* Check result */
+	result = ((sendlength == httplength) ? 1 : 0);
+
 	/* */
 	capwap_free(buffer);
 	return result;
 }
 
+/* Fill receive buffer from socket */
+static int ac_soapclient_http_fill(struct ac_http_soap_request* httprequest) {
+	int result = -1;
+
+	if (httprequest->server->protocol == SOAP_HTTP_PROTOCOL) {
+		result = capwap_socket_recv(httprequest->sock, httprequest->readbuffer, SOAP_HTTP_READ_BUFFER_LENGTH, httprequest->responsetimeout);
+	} else if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
+		result = capwap_socket_crypto_recv(httprequest->sslsock, httprequest->readbuffer, SOAP_HTTP_READ_BUFFER_LENGTH, httprequest->responsetimeout);
+	}
+
+	if (result <= 0) {
+		return -1;			/* Connection error or closed */
+	}
+
+	/* */
+	httprequest->readoffset = 0;
+	httprequest->readlength = result;
+	httprequest->receivedlength += result;
+	return result;
+}
+
+/* Read data through receive buffer */
+static int ac_soapclient_http_read(struct ac_http_soap_request* httprequest, char* buffer, int length) {
+	int result = -1;
+
+	if (httprequest->readoffset == httprequest->readlength) {
+		if (length >= SOAP_HTTP_READ_BUFFER_LENGTH) {
+			/* Large read bypass the receive buffer */
+			if (httprequest->server->protocol == SOAP_HTTP_PROTOCOL) {
+				result = capwap_socket_recv(httprequest->sock, buffer, length, httprequest->responsetimeout);
+			} else if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
+				result = capwap_socket_crypto_recv(httprequest->sslsock, buffer, length, httprequest->responsetimeout);
+			}
+
+			if (result <= 0) {
+				return -1;
+			}
+
+			httprequest->receivedlength += result;
+			return result;
+		} else if (ac_soapclient_http_fill(httprequest) < 0) {
+			return -1;
+		}
+	}
+
+	/* */
+	result = httprequest->readlength - httprequest->readoffset;
+	if (result > length) {
+		result = length;
+	}
+
+	memcpy(buffer, &httprequest->readbuffer[httprequest->readoffset], result);
+	httprequest->readoffset += result;
+
+	return result;
+}
+
 /* */
 static int ac_soapclient_http_readline(struct ac_http_soap_request* httprequest, char* buffer, int length) {
-	int result = -1;
+	char* endline;
+	int linelength;
 	int bufferpos = 0;
 
 	for (;;) {
-		/* Receive packet into temporaly buffer */
-		if (httprequest->server->protocol == SOAP_HTTP_PROTOCOL) {
-			if (capwap_socket_recv(httprequest->sock, &buffer[bufferpos], 1, httprequest->responsetimeout) != 1) {
-				break;			/* Connection error */
-			}
-		} else if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
-			if (capwap_socket_crypto_recv(httprequest->sslsock, &buffer[bufferpos], 1, httprequest->responsetimeout) != 1) {
+		if (httprequest->readoffset == httprequest->readlength) {
+			if (ac_soapclient_http_fill(httprequest) < 0) {
 				break;			/* Connection error */
 			}
 		}
 
-		/* Update buffer size */
-		bufferpos += 1;
-		if (bufferpos >= length) {
+		/* Search line */
+		endline = memchr(&httprequest->readbuffer[httprequest->readoffset], '\n', httprequest->readlength - httprequest->readoffset);
+		linelength = (endline ? ((int)(endline - &httprequest->readbuffer[httprequest->readoffset]) + 1) : (httprequest->readlength - httprequest->readoffset));
+		if ((bufferpos + linelength) >= length) {
 			break;			/* Buffer overflow */
 		}
 
-		/* Search line */
-		if ((bufferpos > 1) && (buffer[bufferpos - 2] == '\r') && (buffer[bufferpos - 1] == '\n')) {
-			result = bufferpos - 2;
-			buffer[result] = 0;
-			break;
+		/* */
+		memcpy(&buffer[bufferpos], &httprequest->readbuffer[httprequest->readoffset], linelength);
+		httprequest->readoffset += linelength;
+		bufferpos += linelength;
+
+		if (endline) {
+			if ((bufferpos < 2) || (buffer[bufferpos - 2] != '\r')) {
+				break;			/* Invalid line terminator */
+			}
+
+			bufferpos -= 2;
+			buffer[bufferpos] = 0;
+			return bufferpos;
 		}
 	}
 
-	return result;
+	return -1;
 }
 
 /* */
-static int ac_soapclient_xml_io_read(void* ctx, char* buffer, int len) {
-	int result = -1;
-	char respbuffer[8192];
-	int respbufferlength = 0;
-	struct ac_http_soap_request* httprequest = (struct ac_http_soap_request*)ctx;
+static int ac_soapclient_http_readchunk(struct ac_http_soap_request* httprequest) {
+	char* endptr;
+	char chunkline[256];
+	int chunklinelength;
+
+	/* Chunk data is followed by CRLF */
+	if (httprequest->chunkdata) {
+		if (ac_soapclient_http_readline(httprequest, chunkline, sizeof(chunkline))) {
+			return -1;
+		}
 
-	while ((httprequest->httpstate == HTTP_RESPONSE_STATUS_CODE) || (httprequest->httpstate == HTTP_RESPONSE_HEADER)) {
-		/* Receive packet into temporaly buffer */
-		respbufferlength = ac_soapclient_http_readline(httprequest, respbuffer, sizeof(respbuffer));
-		if (respbufferlength == -1) {
+		httprequest->chunkdata = 0;
+	}
+
+	/* Retrieve chunk size, ignore chunk extensions */
+	chunklinelength = ac_soapclient_http_readline(httprequest, chunkline, sizeof(chunkline));
+	if (chunklinelength <= 0) {
+		return -1;
+	}
+
+	httprequest->chunklength = (int)strtol(chunkline, &endptr, 16);
+	if ((endptr == chunkline) || (httprequest->chunklength < 0) || ((*endptr != 0) && (*endptr != ';') && (*endptr != ' '))) {
+		return -1;
+	}
+
+	/* Last chunk, discard trailer */
+	if (!httprequest->chunklength) {
+		do {
+			chunklinelength = ac_soapclient_http_readline(httprequest, chunkline, sizeof(chunkline));
+		} while (chunklinelength > 0);
+
+		return ((chunklinelength < 0) ? -1 : 0);
+	}
+
+	httprequest->chunkdata = 1;
+	return httprequest->chunklength;
+}
+
+/* Parse status line or header line of HTTP response */
+void ac_soapclient_http_parse_line(struct ac_http_soap_request* httprequest, char* line, int length) {
+	if (httprequest->httpstate == HTTP_RESPONSE_STATUS_CODE) {
+		int temp;
+		int descpos;
+
+		/* Parse response code */
+		temp = sscanf(line, "HTTP/1.1 %d %n", &httprequest->responsecode, &descpos);
+		if (temp != 1) {
 			httprequest->httpstate = HTTP_RESPONSE_ERROR;
-		} else if (httprequest->httpstate == HTTP_RESPONSE_STATUS_CODE) {
-			int temp;
-			int descpos;
+			return;
+		}
+
+		/* Parsing headers */
+		httprequest->httpstate = HTTP_RESPONSE_HEADER;
+	} else if (httprequest->httpstate == HTTP_RESPONSE_HEADER) {
+		char* value;
 
-			/* Parse response code */
-			temp = sscanf(respbuffer, "HTTP/1.1 %d %n", &httprequest->responsecode, &descpos);
-			if (temp != 1) {
+		if (!length) {
+			if (httprequest->responsecode == HTTP_RESULT_CONTINUE) {
+				if (!httprequest->contentlength && !httprequest->chunked) {
+					httprequest->httpstate = HTTP_RESPONSE_STATUS_CODE;
+				} else {
+					httprequest->httpstate = HTTP_RESPONSE_ERROR;
+				}
+			} else if ((httprequest->contentxml || httprequest->contentjson || httprequest->contentstream) && (httprequest->chunked || (httprequest->contentlength > 0))) {
+				httprequest->httpstate = HTTP_RESPONSE_BODY;		/* Retrieve body */
+			} else {
 				httprequest->httpstate = HTTP_RESPONSE_ERROR;
-				break;
 			}
+		} else {
+			/* Separate key from value */
+			value = strchr(line, ':');
+			if (!value) {
+				httprequest->httpstate = HTTP_RESPONSE_ERROR;
+			} else {
+				*value = 0;
+				value++;
+				while (*value == ' ') {
+					value++;
+				}
 
-			/* Parsing headers */
-			httprequest->httpstate = HTTP_RESPONSE_HEADER;
-		} else if (httprequest->httpstate == HTTP_RESPONSE_HEADER) {
-			char* value;
-
-			if (!respbufferlength) {
-				if (httprequest->responsecode == HTTP_RESULT_CONTINUE) {
+				/* */
+				if (!strcasecmp(line, "Content-Length")) {
+					httprequest->contentlength = atoi(value);
 					if (!httprequest->contentlength) {
-						httprequest->httpstate = HTTP_RESPONSE_STATUS_CODE;
+						httprequest->httpstate = HTTP_RESPONSE_ERROR;
+					}
+				} else if (!strcasecmp(line, "Transfer-Encoding")) {
+					if (!strcasecmp(value, "chunked")) {
+						httprequest->chunked = 1;
 					} else {
 						httprequest->httpstate = HTTP_RESPONSE_ERROR;
 					}
-				} else if (httprequest->contentxml && (httprequest->contentlength > 0)) {
-					httprequest->httpstate = HTTP_RESPONSE_BODY;		/* Retrieve body */
-				} else {
-					httprequest->httpstate = HTTP_RESPONSE_ERROR;
-				}
-			} else {
-				/* Separate key from value */
-				value = strchr(respbuffer, ':');
-				if (!value) {
-					httprequest->httpstate = HTTP_RESPONSE_ERROR;
-				} else {
-					*value = 0;
-					value++;
-					while (*value == ' ') {
-						value++;
+				} else if (!strcasecmp(line, "Connection")) {
+					if (!strcasecmp(value, "close")) {
+						httprequest->keepalive = 0;
+					}
+				} else if (!strcasecmp(line, "Content-Type")) {
+					char* param;
+
+					/* Remove param from value */
+					param = strchr(value, ';');
+					if (param) {
+						*param = 0;
 					}
 
-					/* */
-					if (!strcmp(respbuffer, "Content-Length")) {
-						httprequest->contentlength = atoi(value);
-						if (!httprequest->contentlength) {
-							httprequest->httpstate = HTTP_RESPONSE_ERROR;
-						}
-					} else if (!strcmp(respbuffer, "Content-Type")) {
-						char* param;
-
-						/* Remove param from value */
-						param = strchr(value, ';');
-						if (param) {
-							*param = 0;
-						}
-
-						if (!strcmp(value, "text/xml")) {
-							httprequest->contentxml = 1;
-						} else {
-							httprequest->httpstate = HTTP_RESPONSE_ERROR;
-						}
+					if (!strcmp(value, "text/xml")) {
+						httprequest->contentxml = 1;
+					} else if (!strcmp(value, "application/json")) {
+						httprequest->contentjson = 1;
+					} else if (!strcmp(value, "application/x-ndjson")) {
+						httprequest->contentstream = 1;
+					} else {
+						httprequest->httpstate = HTTP_RESPONSE_ERROR;
 					}
 				}
 			}
 		}
 	}
+}
 
-	if (httprequest->httpstate == HTTP_RESPONSE_BODY) {
-		if (!httprequest->contentlength) {
-			return 0;
+/* */
+static void ac_soapclient_http_read_header(struct ac_http_soap_request* httprequest) {
+	char respbuffer[8192];
+	int respbufferlength = 0;
+
+	while ((httprequest->httpstate == HTTP_RESPONSE_STATUS_CODE) || (httprequest->httpstate == HTTP_RESPONSE_HEADER)) {
+		/* Receive packet into temporaly buffer */
+		respbufferlength = ac_soapclient_http_readline(httprequest, respbuffer, sizeof(respbuffer));
+		if (respbufferlength == -1) {
+			httprequest->httpstate = HTTP_RESPONSE_ERROR;
+		} else {
+			ac_soapclient_http_parse_line(httprequest, respbuffer, respbufferlength);
 		}
+	}
+}
 
-		/* Receive body directly into XML buffer */
-		if (httprequest->server->protocol == SOAP_HTTP_PROTOCOL) {
-			result = capwap_socket_recv(httprequest->sock, buffer, len, httprequest->responsetimeout);
-		} else if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
-			result = capwap_socket_crypto_recv(httprequest->sslsock, buffer, len, httprequest->responsetimeout);
+/* */
+static int ac_soapclient_http_read_body(struct ac_http_soap_request* httprequest, char* buffer, int len) {
+	int result = -1;
+
+	if (httprequest->httpstate == HTTP_RESPONSE_BODY) {
+		int bodylength;
+
+		if (httprequest->chunked) {
+			/* Chunked transfer-encoding */
+			if (!httprequest->chunklength) {
+				bodylength = ac_soapclient_http_readchunk(httprequest);
+				if (bodylength < 0) {
+					httprequest->httpstate = HTTP_RESPONSE_ERROR;
+					return -1;
+				} else if (!bodylength) {
+					httprequest->httpstate = HTTP_RESPONSE_COMPLETE;
+					return 0;
+				}
+			}
+
+			bodylength = httprequest->chunklength;
+		} else {
+			bodylength = httprequest->contentlength;
 		}
 
+		/* Receive body directly into XML buffer */
+		result = ac_soapclient_http_read(httprequest, buffer, ((len < bodylength) ? len : bodylength));
 		if (result > 0) {
-			httprequest->contentlength -= result;
+			if (httprequest->chunked) {
+				httprequest->chunklength -= result;
+			} else {
+				httprequest->contentlength -= result;
+				if (!httprequest->contentlength) {
+					httprequest->httpstate = HTTP_RESPONSE_COMPLETE;
+				}
+			}
+		} else {
+			httprequest->httpstate = HTTP_RESPONSE_ERROR;
 		}
+	} else if (httprequest->httpstate == HTTP_RESPONSE_COMPLETE) {
+		result = 0;
 	}
 
 	return result;
 }
 
-/* */
-static int ac_soapclient_xml_io_close(void *ctx) {
-	struct ac_http_soap_request* httprequest = (struct ac_http_soap_request*)ctx;
+/* SAX parser of SOAP response, only return or fault elements are retrieved.
+   Walk Envelope/Body/<method>Response/return or Envelope/Body/Fault/faultcode|faultstring
+   and ignore every other subtree */
+static void ac_soapclient_xml_start_element(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* urinamespace, int nb_namespaces, const xmlChar** namespaces, int nb_attributes, int nb_defaulted, const xmlChar** attributes) {
+	struct ac_soap_xml_parser* parser = (struct ac_soap_xml_parser*)ctx;
+	struct ac_soap_response* response = parser->response;
+
+	if (!parser->depth) {
+		/* HTTP header was received before the body */
+		response->responsecode = parser->httprequest->responsecode;
+		if (!ac_soapclient_xml_is_envelope(localname, urinamespace, "Envelope")) {
+			parser->error = 1;
+			xmlStopParser(parser->context);
+		}
+	} else if (parser->depth == 1) {
+		if (ac_soapclient_xml_is_envelope(localname, urinamespace, "Body")) {
+			parser->body = 1;
+			parser->inbody = 1;
+		}
+	} else if ((parser->depth == 2) && parser->inbody) {
+		if (response->responsecode == HTTP_RESULT_OK) {
+			parser->inmethod = !xmlStrcmp(localname, BAD_CAST parser->tagmethod);
+		} else {
+			parser->inmethod = ac_soapclient_xml_is_envelope(localname, urinamespace, "Fault");
+		}
 
-	if ((httprequest->httpstate != HTTP_RESPONSE_BODY) || httprequest->contentlength) {
-		return -1;
+		parser->found = (parser->found || parser->inmethod);
+	} else if ((parser->depth == 3) && parser->inmethod) {
+		parser->value = NULL;
+		if (response->responsecode == HTTP_RESULT_OK) {
+			if (!xmlStrcmp(localname, BAD_CAST "return")) {
+				parser->value = &response->responsereturn;
+			}
+		} else if (!xmlStrcmp(localname, BAD_CAST "faultcode")) {
+			parser->value = &response->faultcode;
+		} else if (!xmlStrcmp(localname, BAD_CAST "faultstring")) {
+			parser->value = &response->faultstring;
+		}
+
+		/* Retrieve only the first element */
+		if (parser->value && *parser->value) {
+			parser->value = NULL;
+		}
+
+		parser->valuelength = 0;
 	}
 
-	return 0;
+	parser->depth++;
 }
 
 /* */
-static void ac_soapclient_parse_error(void* ctxt, const char* msg, ...) {
+static void ac_soapclient_xml_end_element(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* urinamespace) {
+	struct ac_soap_xml_parser* parser = (struct ac_soap_xml_parser*)ctx;
+
+	parser->depth--;
+	if (parser->depth == 3) {
+		if (parser->value) {
+			*parser->value = (char*)capwap_alloc(parser->valuelength + 1);
+			memcpy(*parser->value, parser->text, parser->valuelength);
+			(*parser->value)[parser->valuelength] = 0;
+			parser->value = NULL;
+		}
+	} else if (parser->depth == 2) {
+		parser->inmethod = 0;
+	} else if (parser->depth == 1) {
+		parser->inbody = 0;
+	}
 }
 
 /* */
-void ac_soapclient_init(void) {
-	xmlInitParser();
-	xmlSetGenericErrorFunc(NULL, ac_soapclient_parse_error);
-	xmlThrDefSetGenericErrorFunc(NULL, ac_soapclient_parse_error);
-}
+static void ac_soapclient_xml_characters(void* ctx, const xmlChar* ch, int len) {
+	struct ac_soap_xml_parser* parser = (struct ac_soap_xml_parser*)ctx;
 
-/* */
-void ac_soapclient_free(void) {
-	xmlCleanupParser();
-}
+	if (!parser->value) {
+		return;
+	}
 
-/* */
-struct ac_http_soap_server* ac_soapclient_create_server(const char* url) {
-	struct ac_http_soap_server* server;
+	/* Text of element can be received in more pieces */
+	if ((parser->valuelength + len) > parser->textsize) {
+		char* text;
+
+		parser->textsize = (parser->valuelength + len) * 2;
+		text = (char*)capwap_alloc(parser->textsize);
+		if (parser->text) {
+			memcpy(text, parser->text, parser->valuelength);
+			capwap_free(parser->text);
+		}
+
+		parser->text = text;
+	}
+
+	memcpy(&parser->text[parser->valuelength], ch, len);
+	parser->valuelength += len;
+}
+
+/* */
+static int ac_soapclient_xml_parser_init(struct ac_soap_xml_parser* parser, struct ac_http_soap_request* httprequest) {
+	xmlSAXHandler handler;
+
+	/* */
+	memset(parser, 0, sizeof(struct ac_soap_xml_parser));
+	parser->httprequest = httprequest;
+	parser->response = (struct ac_soap_response*)capwap_alloc(sizeof(struct ac_soap_response));
+	memset(parser->response, 0, sizeof(struct ac_soap_response));
+
+	/* */
+	parser->tagmethod = capwap_alloc(strlen(httprequest->request->method) + 9);
+	sprintf(parser->tagmethod, "%sResponse", httprequest->request->method);
+
+	/* */
+	memset(&handler, 0, sizeof(xmlSAXHandler));
+	handler.initialized = XML_SAX2_MAGIC;
+	handler.startElementNs = ac_soapclient_xml_start_element;
+	handler.endElementNs = ac_soapclient_xml_end_element;
+	handler.characters = ac_soapclient_xml_characters;
+	handler.cdataBlock = ac_soapclient_xml_characters;
+
+	parser->context = xmlCreatePushParserCtxt(&handler, (void*)parser, NULL, 0, NULL);
+	if (!parser->context) {
+		capwap_free(parser->tagmethod);
+		ac_soapclient_free_response(parser->response);
+		return 0;
+	}
+
+	xmlCtxtUseOptions(parser->context, XML_PARSE_NONET | XML_PARSE_NODICT);
+	return 1;
+}
+
+/* */
+static struct ac_soap_response* ac_soapclient_xml_parser_complete(struct ac_soap_xml_parser* parser, int received) {
+	struct ac_soap_response* response = parser->response;
+
+	/* Terminate the document */
+	if (received && !parser->error) {
+		received = !xmlParseChunk(parser->context, NULL, 0, 1) && parser->context->wellFormed;
+	}
+
+	/* */
+	xmlFreeParserCtxt(parser->context);
+	capwap_free(parser->tagmethod);
+	if (parser->text) {
+		capwap_free(parser->text);
+	}
+
+	/* Check response */
+	if (!received || parser->error || !parser->body || !parser->found || ((response->responsecode != HTTP_RESULT_OK) && (!response->faultcode || !response->faultstring))) {
+		ac_soapclient_free_response(response);
+		return NULL;
+	}
+
+	return response;
+}
+
+/* */
+static void ac_soapclient_parse_error(void* ctxt, const char* msg, ...) {
+}
+
+/* */
+void ac_soapclient_init(void) {
+	xmlInitParser();
+	xmlSetGenericErrorFunc(NULL, ac_soapclient_parse_error);
+	xmlThrDefSetGenericErrorFunc(NULL, ac_soapclient_parse_error);
+}
+
+/* */
+void ac_soapclient_free(void) {
+	xmlCleanupParser();
+}
+
+/* */
+struct ac_http_soap_server* ac_soapclient_create_server(const char* url) {
+	struct ac_http_soap_server* server;
 
 	ASSERT(url != NULL);
 
@@ -420,6 +929,10 @@ struct ac_http_soap_server* ac_soapclient_create_server(const char* url) {
 	server = (struct ac_http_soap_server*)capwap_alloc(sizeof(struct ac_http_soap_server));
 	memset(server, 0, sizeof(struct ac_http_soap_server));
 
+	/* */
+	capwap_lock_init(&server->pool.lock);
+	ac_soapclient_keepalive_server(server, SOAP_KEEPALIVE_MAX_CONNECTIONS, SOAP_KEEPALIVE_IDLE_TIMEOUT);
+
 	/* */
 	if (!ac_soapclient_parsing_url(server, url)) {
 		ac_soapclient_free_server(server);
@@ -429,10 +942,72 @@ struct ac_http_soap_server* ac_soapclient_create_server(const char* url) {
 	return server;
 }
 
+/* */
+void ac_soapclient_keepalive_server(struct ac_http_soap_server* server, int maxconnections, int idletimeout) {
+	ASSERT(server != NULL);
+	ASSERT(maxconnections >= 0);
+	ASSERT(idletimeout > 0);
+
+	/* Pool parameters can only be changed before the first request */
+	ASSERT(!server->pool.opened);
+
+	if (server->pool.idle) {
+		capwap_free(server->pool.idle);
+		server->pool.idle = NULL;
+	}
+
+	/* A zero limit disables keep-alive */
+	server->pool.maxconnections = maxconnections;
+	server->pool.idletimeout = idletimeout;
+	if (maxconnections > 0) {
+		server->pool.idle = (struct ac_http_soap_connection*)capwap_alloc(sizeof(struct ac_http_soap_connection) * maxconnections);
+	}
+}
+
+/* */
+void ac_soapclient_flush_server(struct ac_http_soap_server* server) {
+	struct ac_http_soap_connection connection;
+
+	ASSERT(server != NULL);
+
+	capwap_lock_enter(&server->pool.lock);
+
+	while (server->pool.idlecount > 0) {
+		memcpy(&connection, &server->pool.idle[--server->pool.idlecount], sizeof(struct ac_http_soap_connection));
+		server->pool.opened--;
+
+		/* */
+		capwap_lock_exit(&server->pool.lock);
+		ac_soapclient_close_connection(connection.sock, connection.sslsock);
+		capwap_lock_enter(&server->pool.lock);
+	}
+
+	capwap_lock_exit(&server->pool.lock);
+}
+
+/* */
+void ac_soapclient_log_server(struct ac_http_soap_server* server) {
+	ASSERT(server != NULL);
+
+	capwap_lock_enter(&server->pool.lock);
+	capwap_logging_info("Backend %s connections: %d open, %d idle, %lu created, %lu reused, %lu retried, %lu expired, %lu discarded",
+		server->host, server->pool.opened, server->pool.idlecount, server->pool.created, server->pool.reused,
+		server->pool.retried, server->pool.expired, server->pool.discarded);
+	capwap_lock_exit(&server->pool.lock);
+}
+
 /* */
 void ac_soapclient_free_server(struct ac_http_soap_server* server) {
 	ASSERT(server != NULL);
 
+	/* Close persistent connections */
+	if (server->pool.idle) {
+		ac_soapclient_flush_server(server);
+		capwap_free(server->pool.idle);
+	}
+
+	capwap_lock_destroy(&server->pool.lock);
+
 	if (server->host) {
 		capwap_free(server->host);
 	}
@@ -450,7 +1025,6 @@ void ac_soapclient_free_server(struct ac_http_soap_server* server) {
 
 /* */
 struct ac_soap_request* ac_soapclient_create_request(char* method, char* urinamespace) {
-	char* tagMethod;
 	struct ac_soap_request* request;
 
 	ASSERT(method != NULL);
@@ -460,100 +1034,235 @@ struct ac_soap_request* ac_soapclient_create_request(char* method, char* uriname
 	request = (struct ac_soap_request*)capwap_alloc(sizeof(struct ac_soap_request));
 	memset(request, 0, sizeof(struct ac_soap_request));
 
-	/* Build XML SOAP Request */
-	request->xmlDocument = xmlNewDoc(BAD_CAST "1.0");
-	request->xmlRoot = xmlNewNode(NULL, BAD_CAST "SOAP-ENV:Envelope");
-	xmlNewProp(request->xmlRoot, BAD_CAST "xmlns:xsd", BAD_CAST "http://www.w3.org/2001/XMLSchema");
-	xmlNewProp(request->xmlRoot, BAD_CAST "xmlns:xsi", BAD_CAST "http://www.w3.org/2001/XMLSchema-instance");
-	xmlNewProp(request->xmlRoot, BAD_CAST "xmlns:SOAP-ENC", BAD_CAST "http://schemas.xmlsoap.org/soap/encoding/");
-	xmlNewProp(request->xmlRoot, BAD_CAST "SOAP-ENV:encodingStyle", BAD_CAST "http://schemas.xmlsoap.org/soap/encoding/");
-	xmlNewProp(request->xmlRoot, BAD_CAST "xmlns:SOAP-ENV", BAD_CAST "http://schemas.xmlsoap.org/soap/envelope/");
-	xmlNewProp(request->xmlRoot, BAD_CAST "xmlns:tns", BAD_CAST urinamespace);
-	xmlDocSetRootElement(request->xmlDocument, request->xmlRoot);
-
-	xmlNewChild(request->xmlRoot, NULL, BAD_CAST "SOAP-ENV:Header", NULL);
-	request->xmlBody = xmlNewChild(request->xmlRoot, NULL, BAD_CAST "SOAP-ENV:Body", NULL);
-
 	/* */
 	request->method = capwap_duplicate_string(method);
-
-	/* Create request */
-	tagMethod = capwap_alloc(strlen(method) + 5);
-	sprintf(tagMethod, "tns:%s", method);
-	request->xmlRequest = xmlNewChild(request->xmlBody, NULL, BAD_CAST tagMethod, NULL);
-	capwap_free(tagMethod);
+	request->urinamespace = capwap_duplicate_string(urinamespace);
+	request->params = capwap_array_create(sizeof(struct ac_soap_param), 0, 0);
 
 	return request;
 }
 
 /* */
 void ac_soapclient_free_request(struct ac_soap_request* request)  {
+	unsigned long i;
+
 	ASSERT(request != NULL);
 
-	if (request->xmlDocument) {
-		xmlFreeDoc(request->xmlDocument);
-	}
+	for (i = 0; i < request->params->count; i++) {
+		struct ac_soap_param* param = (struct ac_soap_param*)capwap_array_get_item_pointer(request->params, i);
+
+		if (param->type) {
+			capwap_free(param->type);
+		}
 
-	if (request->method) {
-		capwap_free(request->method);
+		capwap_free(param->name);
+		capwap_free(param->value);
 	}
 
+	capwap_array_free(request->params);
+	capwap_free(request->urinamespace);
+	capwap_free(request->method);
 	capwap_free(request);
 }
 
 /* */
 int ac_soapclient_add_param(struct ac_soap_request* request, const char* type, const char* name, const char* value) {
-	xmlNodePtr xmlParam;
+	struct ac_soap_param* param;
 
 	ASSERT(request != NULL);
 	ASSERT(name != NULL);
 	ASSERT(value != NULL);
 
 	/* */
-	xmlParam = xmlNewTextChild(request->xmlRequest, NULL, BAD_CAST name, BAD_CAST value);
-	if (!xmlParam) {
-		return 0;
+	param = (struct ac_soap_param*)capwap_array_get_item_pointer(request->params, request->params->count);
+	param->type = (type ? capwap_duplicate_string(type) : NULL);
+	param->name = capwap_duplicate_string(name);
+	param->value = capwap_duplicate_string(value);
+
+	return 1;
+}
+
+/* Build XML SOAP Request from template, JSON document is base64 encoded */
+static char* ac_soapclient_get_xml_request(struct ac_soap_request* request, int* length) {
+	int pos;
+	unsigned long i;
+	char* result;
+	int methodlength = strlen(request->method);
+
+	/* Retrieve length of request */
+	*length = (sizeof(l_soapenvelopebegin) - 1) + ac_soapclient_xml_string(request->urinamespace, NULL) + (sizeof(l_soapenvelopebody) - 1) + (methodlength * 2) + 8 + (sizeof(l_soapenvelopeend) - 1);
+	for (i = 0; i < request->params->count; i++) {
+		struct ac_soap_param* param = (struct ac_soap_param*)capwap_array_get_item_pointer(request->params, i);
+
+		*length += (strlen(param->name) * 2) + 5 + (param->type ? (strlen(param->type) + 12) : 0);
+		if (param->type && !strcmp(param->type, "xs:base64Binary")) {
+			*length += AC_BASE64_ENCODE_LENGTH(strlen(param->value));
+		} else {
+			*length += ac_soapclient_xml_string(param->value, NULL);
+		}
 	}
 
-	if (type) {
-		if (!xmlNewProp(xmlParam, BAD_CAST "xsi:type", BAD_CAST type)) {
-			return 0;
+	/* */
+	result = capwap_alloc(*length + 1);
+	memcpy(result, l_soapenvelopebegin, sizeof(l_soapenvelopebegin) - 1);
+	pos = sizeof(l_soapenvelopebegin) - 1;
+	pos += ac_soapclient_xml_string(request->urinamespace, &result[pos]);
+	memcpy(&result[pos], l_soapenvelopebody, sizeof(l_soapenvelopebody) - 1);
+	pos += sizeof(l_soapenvelopebody) - 1;
+	pos += sprintf(&result[pos], "%s>", request->method);
+
+	/* Add params */
+	for (i = 0; i < request->params->count; i++) {
+		struct ac_soap_param* param = (struct ac_soap_param*)capwap_array_get_item_pointer(request->params, i);
+
+		if (param->type) {
+			pos += sprintf(&result[pos], "<%s xsi:type=\"%s\">", param->name, param->type);
+		} else {
+			pos += sprintf(&result[pos], "<%s>", param->name);
+		}
+
+		if (param->type && !strcmp(param->type, "xs:base64Binary")) {
+			pos += ac_base64_binary_encode(param->value, strlen(param->value), &result[pos]);
+		} else {
+			pos += ac_soapclient_xml_string(param->value, &result[pos]);
 		}
+
+		pos += sprintf(&result[pos], "</%s>", param->name);
 	}
 
-	return 1;
+	/* */
+	pos += sprintf(&result[pos], "</tns:%s>", request->method);
+	memcpy(&result[pos], l_soapenvelopeend, sizeof(l_soapenvelopeend));
+	pos += sizeof(l_soapenvelopeend) - 1;
+
+	ASSERT(pos <= *length);
+	*length = pos;
+	return result;
 }
 
-/* */
-char* ac_soapclient_get_request(struct ac_soap_request* request) {
+/* Escape JSON string, without buffer return only the length of escaped string */
+static int ac_soapclient_json_string(const char* value, char* buffer) {
+	int length = 0;
+	static const char hexdigit[] = "0123456789abcdef";
+
+	if (buffer) {
+		buffer[length] = '"';
+	}
+
+	length++;
+	for (; *value; value++) {
+		unsigned char c = (unsigned char)*value;
+
+		if ((c == '"') || (c == '\\')) {
+			if (buffer) {
+				buffer[length] = '\\';
+				buffer[length + 1] = c;
+			}
+
+			length += 2;
+		} else if (c < 0x20) {
+			if (buffer) {
+				sprintf(&buffer[length], "\\u00%c%c", hexdigit[c >> 4], hexdigit[c & 0x0f]);
+			}
+
+			length += 6;
+		} else {
+			if (buffer) {
+				buffer[length] = c;
+			}
+
+			length++;
+		}
+	}
+
+	if (buffer) {
+		buffer[length] = '"';
+	}
+
+	return length + 1;
+}
+
+/* Numeric, boolean and JSON params are inserted without quote */
+static int ac_soapclient_json_is_verbatim(struct ac_soap_param* param) {
+	if (!param->type || !*param->value) {
+		return 0;
+	}
+
+	return (!strcmp(param->type, "xs:base64Binary") || !strcmp(param->type, "xs:int") || !strcmp(param->type, "xs:long") || !strcmp(param->type, "xs:boolean"));
+}
+
+/* Build JSON Request
+	{
+		Method: [string],
+		Params: {
+			<name>: [value]
+		}
+	}
+*/
+static char* ac_soapclient_get_json_request(struct ac_soap_request* request, int* length) {
+	int pos;
+	unsigned long i;
 	char* result;
-	size_t length;
-	xmlBufferPtr buffer;
 
-	ASSERT(request != NULL);
-	ASSERT(request->xmlDocument != NULL);
+	/* Retrieve length of request */
+	*length = 23 + ac_soapclient_json_string(request->method, NULL);
+	for (i = 0; i < request->params->count; i++) {
+		struct ac_soap_param* param = (struct ac_soap_param*)capwap_array_get_item_pointer(request->params, i);
+
+		*length += 2 + ac_soapclient_json_string(param->name, NULL);
+		*length += (ac_soapclient_json_is_verbatim(param) ? strlen(param->value) : ac_soapclient_json_string(param->value, NULL));
+	}
 
 	/* */
-	buffer = xmlBufferCreate();
-	length = xmlNodeDump(buffer, request->xmlDocument, request->xmlRoot, 1, 0);
+	result = capwap_alloc(*length + 1);
+	pos = sprintf(result, "{\"Method\":");
+	pos += ac_soapclient_json_string(request->method, &result[pos]);
+	pos += sprintf(&result[pos], ",\"Params\":{");
+
+	for (i = 0; i < request->params->count; i++) {
+		struct ac_soap_param* param = (struct ac_soap_param*)capwap_array_get_item_pointer(request->params, i);
+
+		if (i > 0) {
+			result[pos++] = ',';
+		}
 
-	/* Clone XML document string */
-	result = capwap_alloc(length + 1);
-	memcpy(result, (char*)xmlBufferContent(buffer), length);
-	result[length] = 0;
+		pos += ac_soapclient_json_string(param->name, &result[pos]);
+		result[pos++] = ':';
+		if (ac_soapclient_json_is_verbatim(param)) {
+			strcpy(&result[pos], param->value);
+			pos += strlen(param->value);
+		} else {
+			pos += ac_soapclient_json_string(param->value, &result[pos]);
+		}
+	}
 
 	/* */
-	xmlBufferFree(buffer);
+	result[pos++] = '}';
+	result[pos++] = '}';
+	result[pos] = 0;
+
+	ASSERT(pos <= *length);
+	*length = pos;
 	return result;
 }
 
+/* */
+char* ac_soapclient_get_request(struct ac_soap_request* request, int transport, int* length) {
+	ASSERT(request != NULL);
+	ASSERT(length != NULL);
+
+	if (transport == SOAP_TRANSPORT_JSON) {
+		return ac_soapclient_get_json_request(request, length);
+	}
+
+	return ac_soapclient_get_xml_request(request, length);
+}
+
 /* */
 struct ac_http_soap_request* ac_soapclient_prepare_request(struct ac_soap_request* request, struct ac_http_soap_server* server) {
 	struct ac_http_soap_request* httprequest;
 
 	ASSERT(request != NULL);
-	ASSERT(request->xmlDocument != NULL);
-	ASSERT(request->xmlRoot != NULL);
 	ASSERT(server != NULL);
 
 	/* */
@@ -566,12 +1275,8 @@ struct ac_http_soap_request* ac_soapclient_prepare_request(struct ac_soap_reques
 	httprequest->requesttimeout = SOAP_PROTOCOL_REQUEST_TIMEOUT;
 	httprequest->responsetimeout = SOAP_PROTOCOL_RESPONSE_TIMEOUT;
 
-	/* Create socket */
-	httprequest->sock = socket(httprequest->server->address.ss.ss_family, SOCK_STREAM, 0);
-	if (httprequest->sock < 0) {
-		ac_soapclient_close_request(httprequest, 0);
-		return NULL;
-	}
+	/* Socket is retrieved from keep-alive pool when the request is sent */
+	httprequest->sock = -1;
 
 	return httprequest;
 }
@@ -579,41 +1284,70 @@ struct ac_http_soap_request* ac_soapclient_prepare_request(struct ac_soap_reques
 /* */
 int ac_soapclient_send_request(struct ac_http_soap_request* httprequest, char* soapaction) {
 	char* buffer;
-	size_t length;
-	xmlBufferPtr xmlBuffer;
+	int length;
+	int result = 0;
 
 	ASSERT(httprequest != NULL);
 
-	/* Retrieve XML SOAP Request */
-	xmlBuffer = xmlBufferCreate();
-	length = xmlNodeDump(xmlBuffer, httprequest->request->xmlDocument, httprequest->request->xmlRoot, 1, 0);
-	if (!length) {
+	/* Retrieve Request */
+	buffer = ac_soapclient_get_request(httprequest->request, httprequest->server->transport, &length);
+	if (!buffer) {
 		return 0;
 	}
 
-	buffer = (char*)xmlBufferContent(xmlBuffer);
+	/* Save SOAP action for retransmission on stale connection */
+	if (httprequest->soapaction != soapaction) {
+		if (httprequest->soapaction) {
+			capwap_free(httprequest->soapaction);
+		}
 
-	/* Connect to remote host */
-	if (!ac_soapclient_connect(httprequest)) {
-		xmlBufferFree(xmlBuffer);
-		return 0;
+		httprequest->soapaction = capwap_duplicate_string((soapaction ? soapaction : ""));
 	}
 
-	/* Send HTTP Header */
-	if (!ac_soapclient_send_http(httprequest, soapaction, buffer, (int)length)) {
-		xmlBufferFree(xmlBuffer);
-		return 0;
+	/* */
+	while (!httprequest->shutdown) {
+		if (httprequest->sock >= 0) {
+			ac_soapclient_pool_put(httprequest, 0);
+		}
+
+		/* Connect to remote host */
+		if (!ac_soapclient_connect(httprequest)) {
+			break;
+		}
+
+		/* Send HTTP Header */
+		httprequest->keepalive = 1;
+		httprequest->receivedlength = 0;
+		httprequest->readoffset = 0;
+		httprequest->readlength = 0;
+		if (ac_soapclient_send_http(httprequest, httprequest->soapaction, buffer, length)) {
+			result = 1;
+			break;
+		} else if (!httprequest->reused) {
+			break;
+		}
+
+		/* Persistent connection was closed by server, retry with a new connection */
+		ac_soapclient_pool_retry(httprequest->server);
 	}
 
-	/* Sent SOAP Request */
-	xmlBufferFree(xmlBuffer);
-	return 1;
+	/* Sent Request */
+	capwap_free(buffer);
+	return result;
 }
 
 /* */
 void ac_soapclient_shutdown_request(struct ac_http_soap_request* httprequest) {
 	ASSERT(httprequest != NULL);
 
+	httprequest->shutdown = 1;
+
+	/* Connection is owned by event loop */
+	if (httprequest->async) {
+		ac_soapclient_async_wakeup();
+		return;
+	}
+
 	if (httprequest->sslsock) {
 		capwap_socket_ssl_shutdown(httprequest->sslsock, SOAP_PROTOCOL_CLOSE_TIMEOUT);
 	}
@@ -632,19 +1366,105 @@ void ac_soapclient_close_request(struct ac_http_soap_request* httprequest, int c
 		ac_soapclient_free_request(httprequest->request);
 	}
 
+	/* Keep connection only if the whole response was consumed */
+	ac_soapclient_pool_put(httprequest, (!httprequest->shutdown && httprequest->keepalive && (httprequest->httpstate == HTTP_RESPONSE_COMPLETE) && (httprequest->readoffset == httprequest->readlength)));
+
 	/* */
-	if (httprequest->sslsock) {
-		capwap_socket_ssl_shutdown(httprequest->sslsock, SOAP_PROTOCOL_CLOSE_TIMEOUT);
-		capwap_socket_ssl_close(httprequest->sslsock);
-		capwap_free(httprequest->sslsock);
+	if (httprequest->soapaction) {
+		capwap_free(httprequest->soapaction);
 	}
 
-	/* Close socket */
-	if (httprequest->sock >= 0) {
-		capwap_socket_close(httprequest->sock);
+	capwap_free(httprequest);
+}
+
+/* Maximum time of request in ms, from connection to whole response */
+long ac_soapclient_get_timeout(struct ac_http_soap_request* httprequest) {
+	ASSERT(httprequest != NULL);
+
+	if (httprequest->deadline > 0) {
+		return httprequest->deadline;
 	}
 
-	capwap_free(httprequest);
+	return SOAP_PROTOCOL_CONNECT_TIMEOUT + httprequest->requesttimeout + httprequest->responsetimeout;
+}
+
+/* */
+void ac_soapclient_reset_response(struct ac_http_soap_request* httprequest) {
+	httprequest->httpstate = HTTP_RESPONSE_STATUS_CODE;
+	httprequest->responsecode = 0;
+	httprequest->contentlength = 0;
+	httprequest->contentxml = 0;
+	httprequest->contentjson = 0;
+	httprequest->contentstream = 0;
+	httprequest->chunked = 0;
+	httprequest->chunkdata = 0;
+	httprequest->chunklength = 0;
+}
+
+/* Receive whole HTTP body of JSON response */
+static struct ac_soap_response* ac_soapclient_read_json_response(struct ac_http_soap_request* httprequest) {
+	int result;
+	int length = 0;
+	int size = SOAP_HTTP_READ_BUFFER_LENGTH;
+	char* body = (char*)capwap_alloc(size);
+	struct ac_soap_response* response = NULL;
+
+	for (;;) {
+		if (length == size) {
+			char* buffer = (char*)capwap_alloc(size * 2);
+
+			memcpy(buffer, body, length);
+			capwap_free(body);
+			body = buffer;
+			size *= 2;
+		}
+
+		/* */
+		ac_soapclient_http_read_header(httprequest);
+		result = ac_soapclient_http_read_body(httprequest, &body[length], size - length);
+		if (result <= 0) {
+			break;
+		}
+
+		length += result;
+	}
+
+	if (!result && httprequest->contentjson) {
+		response = ac_soapclient_parse_json_document(httprequest, body, length);
+	}
+
+	capwap_free(body);
+	return response;
+}
+
+/* */
+static struct ac_soap_response* ac_soapclient_read_response(struct ac_http_soap_request* httprequest) {
+	int result;
+	char buffer[SOAP_HTTP_READ_BUFFER_LENGTH];
+	struct ac_soap_xml_parser parser;
+
+	ac_soapclient_reset_response(httprequest);
+	if (httprequest->server->transport == SOAP_TRANSPORT_JSON) {
+		return ac_soapclient_read_json_response(httprequest);
+	}
+
+	/* Parsing HTTP response while it is received */
+	if (!ac_soapclient_xml_parser_init(&parser, httprequest)) {
+		return NULL;
+	}
+
+	for (;;) {
+		ac_soapclient_http_read_header(httprequest);
+		result = ac_soapclient_http_read_body(httprequest, buffer, sizeof(buffer));
+		if (result <= 0) {
+			break;
+		} else if (xmlParseChunk(parser.context, buffer, result, 0)) {
+			result = -1;
+			break;
+		}
+	}
+
+	return ac_soapclient_xml_parser_complete(&parser, (!result && httprequest->contentxml));
 }
 
 /* */
@@ -655,64 +1475,87 @@ struct ac_soap_response* ac_soapclient_recv_response(struct ac_http_soap_request
 	ASSERT(httprequest->sock >= 0);
 
 	/* */
-	response = (struct ac_soap_response*)capwap_alloc(sizeof(struct ac_soap_response));
-	memset(response, 0, sizeof(struct ac_soap_response));
+	response = ac_soapclient_read_response(httprequest);
+	if (!response && httprequest->reused && !httprequest->receivedlength && !httprequest->shutdown) {
+		/* Persistent connection was closed by server before any response, resend request */
+		ac_soapclient_pool_put(httprequest, 0);
+		ac_soapclient_pool_retry(httprequest->server);
+		if (ac_soapclient_send_request(httprequest, httprequest->soapaction)) {
+			response = ac_soapclient_read_response(httprequest);
+		}
+	}
 
-	/* Receive HTTP response into XML callback */
-	httprequest->httpstate = HTTP_RESPONSE_STATUS_CODE;
-	response->xmlDocument = xmlReadIO(ac_soapclient_xml_io_read, ac_soapclient_xml_io_close, (void*)httprequest, "", NULL, 0);
-	if (!response->xmlDocument) {
-		ac_soapclient_free_response(response);
-		return NULL;
+	return response;
+}
+
+/* Receive the body of a streamed response as it arrives */
+int ac_soapclient_recv_stream(struct ac_http_soap_request* httprequest, char* buffer, int length) {
+	ASSERT(httprequest != NULL);
+	ASSERT(httprequest->sock >= 0);
+	ASSERT(buffer != NULL);
+	ASSERT(length > 0);
+
+	/* */
+	ac_soapclient_http_read_header(httprequest);
+	if ((httprequest->httpstate == HTTP_RESPONSE_BODY) && ((httprequest->responsecode != HTTP_RESULT_OK) || !httprequest->contentstream)) {
+		return SOAP_STREAM_UNSUPPORTED;
 	}
 
-	/* Parsing response */
-	response->responsecode = httprequest->responsecode;
-	response->xmlRoot = xmlDocGetRootElement(response->xmlDocument);
-	if (!response->xmlRoot) {
-		ac_soapclient_free_response(response);
+	return ac_soapclient_http_read_body(httprequest, buffer, length);
+}
+
+/* */
+struct ac_soap_response* ac_soapclient_parse_xml_document(struct ac_http_soap_request* httprequest, const char* body, int length) {
+	struct ac_soap_xml_parser parser;
+
+	ASSERT(httprequest != NULL);
+	ASSERT(body != NULL);
+
+	/* */
+	if (!ac_soapclient_xml_parser_init(&parser, httprequest)) {
 		return NULL;
 	}
 
-	/* Retrieve Body */
-	response->xmlBody = ac_xml_search_child(response->xmlRoot, "SOAP-ENV", "Body");
-	if (!response->xmlBody) {
+	return ac_soapclient_xml_parser_complete(&parser, !xmlParseChunk(parser.context, body, length, 0));
+}
+
+/* Parsing JSON response
+	{
+		Return: [value],
+		Fault: {
+			Code: [string],
+			String: [string]
+		}
+	}
+*/
+struct ac_soap_response* ac_soapclient_parse_json_document(struct ac_http_soap_request* httprequest, const char* body, int length) {
+	struct json_tokener* tokener;
+	struct ac_soap_response* response;
+
+	ASSERT(httprequest != NULL);
+	ASSERT(body != NULL);
+
+	/* */
+	response = (struct ac_soap_response*)capwap_alloc(sizeof(struct ac_soap_response));
+	memset(response, 0, sizeof(struct ac_soap_response));
+	response->responsecode = httprequest->responsecode;
+
+	/* */
+	tokener = json_tokener_new();
+	response->jsonRoot = json_tokener_parse_ex(tokener, body, length);
+	json_tokener_free(tokener);
+
+	if (!response->jsonRoot || (json_object_get_type(response->jsonRoot) != json_type_object)) {
 		ac_soapclient_free_response(response);
 		return NULL;
 	}
 
 	/* Retrieve response */
 	if (response->responsecode == HTTP_RESULT_OK) {
-		char* tagMethod = capwap_alloc(strlen(httprequest->request->method) + 9);
-		sprintf(tagMethod, "%sResponse", httprequest->request->method);
-		response->xmlResponse = ac_xml_search_child(response->xmlBody, NULL, tagMethod);
-		capwap_free(tagMethod);
-
-		if (!response->xmlResponse) {
-			ac_soapclient_free_response(response);
-			return NULL;
-		}
-
-		/* Retrieve optional return response */
-		response->xmlResponseReturn = ac_xml_search_child(response->xmlResponse, NULL, "return");
+		response->jsonResponseReturn = compat_json_object_object_get(response->jsonRoot, "Return");
 	} else {
-		/* Retrieve Fault */
-		response->xmlFault = ac_xml_search_child(response->xmlBody, "SOAP-ENV", "Fault");
-		if (!response->xmlFault) {
-			ac_soapclient_free_response(response);
-			return NULL;
-		}
-
-		/* Retrieve FaultCode */
-		response->xmlFaultCode = ac_xml_search_child(response->xmlFault, NULL, "faultcode");
-		if (!response->xmlFaultCode) {
-			ac_soapclient_free_response(response);
-			return NULL;
-		}
-
-		/* Retrieve FaultString */
-		response->xmlFaultString = ac_xml_search_child(response->xmlFault, NULL, "faultstring");
-		if (!response->xmlFaultString) {
+		response->jsonFault = compat_json_object_object_get(response->jsonRoot, "Fault");
+		if (!response->jsonFault || (json_object_get_type(response->jsonFault) != json_type_object)) {
 			ac_soapclient_free_response(response);
 			return NULL;
 		}
@@ -725,32 +1568,34 @@ struct ac_soap_response* ac_soapclient_recv_response(struct ac_http_soap_request
 struct json_object* ac_soapclient_parse_json_response(struct ac_soap_response* response) {
 	int length;
 	char* json;
-	xmlChar* xmlResult;
 	struct json_object* jsonroot;
 
 	ASSERT(response != NULL);
 
 	/* */
-	if ((response->responsecode != HTTP_RESULT_OK) || !response->xmlResponseReturn) {
+	if (response->responsecode != HTTP_RESULT_OK) {
 		return NULL;
-	}
+	} else if (response->jsonResponseReturn) {
+		enum json_type type = json_object_get_type(response->jsonResponseReturn);
 
-	/* Decode base64 result */
-	xmlResult = xmlNodeGetContent(response->xmlResponseReturn);
-	if (!xmlResult) {
+		/* JSON transport return the document without encoding */
+		if ((type != json_type_object) && (type != json_type_array)) {
+			return NULL;
+		}
+
+		return json_object_get(response->jsonResponseReturn);
+	} else if (!response->responsereturn) {
 		return NULL;
 	}
 
-	length = xmlStrlen(xmlResult);
+	/* Decode base64 result */
+	length = strlen(response->responsereturn);
 	if (!length) {
-		xmlFree(xmlResult);
 		return NULL;
 	}
 
 	json = (char*)capwap_alloc(AC_BASE64_DECODE_LENGTH(length));
-	ac_base64_string_decode((const char*)xmlResult, json);
-
-	xmlFree(xmlResult);
+	ac_base64_string_decode(response->responsereturn, json);
 
 	/* Parsing JSON result */
 	jsonroot = json_tokener_parse(json);
@@ -759,12 +1604,88 @@ struct json_object* ac_soapclient_parse_json_response(struct ac_soap_response* r
 	return jsonroot;
 }
 
+/* Retrieve plain value of response */
+char* ac_soapclient_get_string_response(struct ac_soap_response* response) {
+	char* result = NULL;
+
+	ASSERT(response != NULL);
+
+	/* */
+	if (response->responsecode != HTTP_RESULT_OK) {
+		return NULL;
+	} else if (response->jsonResponseReturn) {
+		enum json_type type = json_object_get_type(response->jsonResponseReturn);
+
+		if ((type != json_type_object) && (type != json_type_array)) {
+			result = capwap_duplicate_string(json_object_get_string(response->jsonResponseReturn));
+		}
+	} else if (response->responsereturn) {
+		result = capwap_duplicate_string(response->responsereturn);
+	}
+
+	return result;
+}
+
+/* Response without HTTP transport, the value is the content of return or fault element */
+struct ac_soap_response* ac_soapclient_create_response(int responsecode, const char* value) {
+	struct ac_soap_response* response;
+
+	/* */
+	response = (struct ac_soap_response*)capwap_alloc(sizeof(struct ac_soap_response));
+	memset(response, 0, sizeof(struct ac_soap_response));
+
+	response->responsecode = responsecode;
+	if (value) {
+		if (responsecode == HTTP_RESULT_OK) {
+			response->responsereturn = capwap_duplicate_string(value);
+		} else {
+			response->faultstring = capwap_duplicate_string(value);
+		}
+	}
+
+	return response;
+}
+
+/* Response without HTTP transport, the value is the JSON return */
+struct ac_soap_response* ac_soapclient_create_json_response(int responsecode, struct json_object* value) {
+	struct ac_soap_response* response;
+
+	/* */
+	response = (struct ac_soap_response*)capwap_alloc(sizeof(struct ac_soap_response));
+	memset(response, 0, sizeof(struct ac_soap_response));
+
+	response->responsecode = responsecode;
+	response->jsonRoot = json_object_new_object();
+	if (value) {
+		json_object_object_add(response->jsonRoot, ((responsecode == HTTP_RESULT_OK) ? "Return" : "Fault"), json_object_get(value));
+		if (responsecode == HTTP_RESULT_OK) {
+			response->jsonResponseReturn = value;
+		} else {
+			response->jsonFault = value;
+		}
+	}
+
+	return response;
+}
+
 /* */
 void ac_soapclient_free_response(struct ac_soap_response* response) {
 	ASSERT(response != NULL);
 
-	if (response->xmlDocument) {
-		xmlFreeDoc(response->xmlDocument);
+	if (response->responsereturn) {
+		capwap_free(response->responsereturn);
+	}
+
+	if (response->faultcode) {
+		capwap_free(response->faultcode);
+	}
+
+	if (response->faultstring) {
+		capwap_free(response->faultstring);
+	}
+
+	if (response->jsonRoot) {
+		json_object_put(response->jsonRoot);
 	}
 
 	capwap_free(response);
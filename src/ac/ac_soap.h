@@ -1,7 +1,6 @@
 #ifndef __AC_SOAP_HEADER__
 #define __AC_SOAP_HEADER__
 
-#include <libxml/tree.h>
 #include <libxml/parser.h>
 
 /* */
@@ -11,16 +10,69 @@
 #define SOAP_HTTP_PORT					80
 #define SOAP_HTTPS_PORT					443
 
+#define SOAP_ENVELOPE_NAMESPACE			"http://schemas.xmlsoap.org/soap/envelope/"
+
+#define SOAP_TRANSPORT_XML				0
+#define SOAP_TRANSPORT_JSON				1
+
 #define HTTP_RESULT_CONTINUE			100
 #define HTTP_RESULT_OK					200
+#define HTTP_RESULT_INTERNAL_SERVER_ERROR	500
 
+#define HTTP_RESPONSE_STATUS_CODE			0
+#define HTTP_RESPONSE_HEADER				1
+#define HTTP_RESPONSE_BODY					2
+#define HTTP_RESPONSE_ERROR					3
+#define HTTP_RESPONSE_COMPLETE				4
+
+#define SOAP_PROTOCOL_CONNECT_TIMEOUT		10000
 #define SOAP_PROTOCOL_REQUEST_TIMEOUT		10000
 #define SOAP_PROTOCOL_RESPONSE_TIMEOUT		10000
 #define SOAP_PROTOCOL_CLOSE_TIMEOUT			10000
 
+#ifndef SOAP_HTTP_READ_BUFFER_LENGTH
+#define SOAP_HTTP_READ_BUFFER_LENGTH		4096
+#endif
+
+#define SOAP_STREAM_ERROR					-1
+#define SOAP_STREAM_UNSUPPORTED				-2
+
+#define SOAP_ASYNC_MAX_INFLIGHT				64
+
+#define SOAP_KEEPALIVE_MAX_CONNECTIONS		8
+#define SOAP_KEEPALIVE_IDLE_TIMEOUT			30000
+
+/* Persistent HTTP connection */
+struct ac_http_soap_connection {
+	int sock;
+	struct capwap_socket_ssl* sslsock;
+	struct timeval lastused;
+};
+
+/* Keep-alive connection pool */
+struct ac_http_soap_pool {
+	capwap_lock_t lock;
+
+	int maxconnections;
+	int idletimeout;
+
+	/* Open connections, idle connections are stored in LIFO order */
+	int opened;
+	int idlecount;
+	struct ac_http_soap_connection* idle;
+
+	/* Statistics */
+	unsigned long created;
+	unsigned long reused;
+	unsigned long retried;
+	unsigned long expired;
+	unsigned long discarded;
+};
+
 /* */
 struct ac_http_soap_server {
 	int protocol;
+	int transport;
 	union sockaddr_capwap address;
 
 	char* host;
@@ -28,16 +80,23 @@ struct ac_http_soap_server {
 
 	/* SSL/TLS context */
 	void* sslcontext;
+
+	/* Keep-alive */
+	struct ac_http_soap_pool pool;
 };
 
-/* */
-struct ac_soap_request {
-	xmlDocPtr xmlDocument;
-	xmlNodePtr xmlRoot;
-	xmlNodePtr xmlBody;
-	xmlNodePtr xmlRequest;
+/* Param of request, the value of xs:base64Binary param is a JSON document */
+struct ac_soap_param {
+	char* type;
+	char* name;
+	char* value;
+};
 
+/* Request is encoded by the transport of server when it is sent */
+struct ac_soap_request {
 	char* method;
+	char* urinamespace;
+	struct capwap_array* params;
 };
 
 /* */
@@ -49,31 +108,53 @@ struct ac_http_soap_request {
 	int requesttimeout;
 	int responsetimeout;
 
+	/* Whole time of request in ms, 0 uses the protocol timeouts */
+	long deadline;
+
 	/* SSL info */
 	struct capwap_socket_ssl* sslsock;
 
+	/* Connection info */
+	int async;
+	int pooled;
+	int reused;
+	int shutdown;
+	int keepalive;
+	char* soapaction;
+
 	/* Information for SOAP Response */
 	int httpstate;
 	int responsecode;
 	int contentlength;
 	int contentxml;
+	int contentjson;
+	int contentstream;
+	int chunked;
+	int chunkdata;
+	int chunklength;
+	int receivedlength;
+
+	/* Receive buffer */
+	int readoffset;
+	int readlength;
+	char readbuffer[SOAP_HTTP_READ_BUFFER_LENGTH];
 };
 
 /* */
 struct ac_soap_response {
 	int responsecode;
-	xmlDocPtr xmlDocument;
-	xmlNodePtr xmlRoot;
-	xmlNodePtr xmlBody;
 
-	/* Valid response */
-	xmlNodePtr xmlResponse;
-	xmlNodePtr xmlResponseReturn;
+	/* Valid response, content of return element */
+	char* responsereturn;
 
 	/* Fault response */
-	xmlNodePtr xmlFault;
-	xmlNodePtr xmlFaultCode;
-	xmlNodePtr xmlFaultString;
+	char* faultcode;
+	char* faultstring;
+
+	/* JSON transport */
+	struct json_object* jsonRoot;
+	struct json_object* jsonResponseReturn;
+	struct json_object* jsonFault;
 };
 
 /* */
@@ -83,24 +164,56 @@ void ac_soapclient_free(void);
 /* */
 struct ac_http_soap_server* ac_soapclient_create_server(const char* url);
 void ac_soapclient_free_server(struct ac_http_soap_server* server);
+void ac_soapclient_keepalive_server(struct ac_http_soap_server* server, int maxconnections, int idletimeout);
+void ac_soapclient_flush_server(struct ac_http_soap_server* server);
+void ac_soapclient_log_server(struct ac_http_soap_server* server);
 
 /* Request */
 struct ac_soap_request* ac_soapclient_create_request(char* method, char* urinamespace);
 int ac_soapclient_add_param(struct ac_soap_request* request, const char* type, const char* name, const char* value);
-char* ac_soapclient_get_request(struct ac_soap_request* request);
+char* ac_soapclient_get_request(struct ac_soap_request* request, int transport, int* length);
 void ac_soapclient_free_request(struct ac_soap_request* request);
 
 /* Transport Request */
 struct ac_http_soap_request* ac_soapclient_prepare_request(struct ac_soap_request* request, struct ac_http_soap_server* server);
 int ac_soapclient_send_request(struct ac_http_soap_request* httprequest, char* soapaction);
 struct ac_soap_response* ac_soapclient_recv_response(struct ac_http_soap_request* httprequest);
+int ac_soapclient_recv_stream(struct ac_http_soap_request* httprequest, char* buffer, int length);
 
 struct json_object* ac_soapclient_parse_json_response(struct ac_soap_response* response);
+char* ac_soapclient_get_string_response(struct ac_soap_response* response);
 
 void ac_soapclient_shutdown_request(struct ac_http_soap_request* httprequest);
 void ac_soapclient_close_request(struct ac_http_soap_request* httprequest, int closerequest);
+long ac_soapclient_get_timeout(struct ac_http_soap_request* httprequest);
+
+/* HTTP transport */
+char* ac_soapclient_build_http(struct ac_http_soap_request* httprequest, char* soapaction, char* body, int length, int* httplength);
+void ac_soapclient_http_parse_line(struct ac_http_soap_request* httprequest, char* line, int length);
+void ac_soapclient_reset_response(struct ac_http_soap_request* httprequest);
+struct ac_soap_response* ac_soapclient_parse_xml_document(struct ac_http_soap_request* httprequest, const char* body, int length);
+struct ac_soap_response* ac_soapclient_parse_json_document(struct ac_http_soap_request* httprequest, const char* body, int length);
+
+/* Keep-alive pool */
+int ac_soapclient_pool_get(struct ac_http_soap_request* httprequest);
+void ac_soapclient_pool_put(struct ac_http_soap_request* httprequest, int reuse);
+void ac_soapclient_pool_add(struct ac_http_soap_request* httprequest);
+void ac_soapclient_pool_retry(struct ac_http_soap_server* server);
+
+/* Asynchronous transport, the callback is invoked from the event loop thread
+   and take ownership of response. The request must be closed by the owner */
+typedef void (*ac_soapclient_async_callback)(struct ac_http_soap_request* httprequest, struct ac_soap_response* response, void* param);
+
+int ac_soapclient_async_start(void);
+void ac_soapclient_async_stop(void);
+void ac_soapclient_async_wakeup(void);
+
+int ac_soapclient_async_submit(struct ac_http_soap_request* httprequest, char* soapaction, long timeout, ac_soapclient_async_callback callback, void* param);
+struct ac_soap_response* ac_soapclient_async_execute(struct ac_http_soap_request* httprequest, char* soapaction);
 
 /* Response */
+struct ac_soap_response* ac_soapclient_create_response(int responsecode, const char* value);
+struct ac_soap_response* ac_soapclient_create_json_response(int responsecode, struct json_object* value);
 void ac_soapclient_free_response(struct ac_soap_response* response);
 
 /* Base64 */
@@ -0,0 +1,778 @@
+#include "ac.h"
+#include "ac_soap.h"
+#include "capwap_socket.h"
+
+/* */
+#define SOAP_ASYNC_LINE_LENGTH				8192
+#define SOAP_ASYNC_BODY_LENGTH				4096
+#define SOAP_ASYNC_MAX_TIMEOUT				1000
+
+/* */
+#define SOAP_ASYNC_STATE_QUEUED				0
+#define SOAP_ASYNC_STATE_CONNECT			1
+#define SOAP_ASYNC_STATE_HANDSHAKE			2
+#define SOAP_ASYNC_STATE_SEND				3
+#define SOAP_ASYNC_STATE_RECV				4
+
+/* */
+#define SOAP_ASYNC_CHUNK_SIZE				0
+#define SOAP_ASYNC_CHUNK_DATA				1
+#define SOAP_ASYNC_CHUNK_DATAEND			2
+#define SOAP_ASYNC_CHUNK_TRAILER			3
+
+/* */
+struct ac_soap_async_request {
+	struct ac_http_soap_request* httprequest;
+	int state;
+	short events;
+
+	/* HTTP request */
+	char* soapaction;
+	char* sendbuffer;
+	int sendlength;
+	int sendoffset;
+
+	/* HTTP response */
+	char line[SOAP_ASYNC_LINE_LENGTH];
+	int linelength;
+	int chunkstate;
+	char* body;
+	int bodylength;
+	int bodysize;
+
+	/* */
+	struct timeval deadline;
+	ac_soapclient_async_callback callback;
+	void* param;
+};
+
+/* */
+struct ac_soap_async_t {
+	pthread_t threadid;
+	int running;
+	int endthread;
+	int wakeup[2];
+
+	capwap_lock_t lock;
+	struct capwap_list* pending;
+	struct capwap_list* active;
+
+	/* Statistics */
+	unsigned long completed;
+	unsigned long failed;
+	unsigned long expired;
+};
+
+static struct ac_soap_async_t g_ac_soap_async;
+
+/* */
+struct ac_soap_async_wait {
+	capwap_event_t event;
+	struct ac_soap_response* response;
+};
+
+/* */
+static long ac_soapclient_async_remaining(struct timeval* deadline, struct timeval* now) {
+	return ((deadline->tv_sec - now->tv_sec) * 1000) + ((deadline->tv_usec - now->tv_usec) / 1000);
+}
+
+/* */
+static void ac_soapclient_async_free(struct ac_soap_async_request* asyncrequest) {
+	if (asyncrequest->soapaction) {
+		capwap_free(asyncrequest->soapaction);
+	}
+
+	if (asyncrequest->sendbuffer) {
+		capwap_free(asyncrequest->sendbuffer);
+	}
+
+	if (asyncrequest->body) {
+		capwap_free(asyncrequest->body);
+	}
+}
+
+/* Deliver result to owner of request */
+static void ac_soapclient_async_complete(struct ac_soap_async_request* asyncrequest, struct ac_soap_response* response) {
+	struct ac_http_soap_request* httprequest = asyncrequest->httprequest;
+
+	/* Connection is returned to pool only with a complete response */
+	if (!response) {
+		httprequest->httpstate = HTTP_RESPONSE_ERROR;
+	}
+
+	httprequest->readoffset = 0;
+	httprequest->readlength = 0;
+	httprequest->async = 0;
+
+	/* */
+	asyncrequest->callback(httprequest, response, asyncrequest->param);
+	ac_soapclient_async_free(asyncrequest);
+}
+
+/* */
+static void ac_soapclient_async_fail(struct ac_soap_async_request* asyncrequest) {
+	g_ac_soap_async.failed++;
+	ac_soapclient_async_complete(asyncrequest, NULL);
+}
+
+/* Build HTTP request for the current connection */
+static int ac_soapclient_async_prepare_send(struct ac_soap_async_request* asyncrequest) {
+	int length;
+	char* buffer;
+	struct ac_http_soap_request* httprequest = asyncrequest->httprequest;
+
+	/* Keep-Alive header depends on connection */
+	if (asyncrequest->sendbuffer) {
+		capwap_free(asyncrequest->sendbuffer);
+		asyncrequest->sendbuffer = NULL;
+	}
+
+	/* Retrieve Request */
+	buffer = ac_soapclient_get_request(httprequest->request, httprequest->server->transport, &length);
+	if (buffer) {
+		asyncrequest->sendbuffer = ac_soapclient_build_http(httprequest, asyncrequest->soapaction, buffer, length, &asyncrequest->sendlength);
+		capwap_free(buffer);
+	}
+
+	if (!asyncrequest->sendbuffer) {
+		return 0;
+	}
+
+	/* */
+	asyncrequest->sendoffset = 0;
+	asyncrequest->state = SOAP_ASYNC_STATE_SEND;
+	asyncrequest->events = POLLOUT;
+
+	/* */
+	asyncrequest->linelength = 0;
+	asyncrequest->bodylength = 0;
+	asyncrequest->chunkstate = SOAP_ASYNC_CHUNK_SIZE;
+	httprequest->keepalive = 1;
+	httprequest->receivedlength = 0;
+	ac_soapclient_reset_response(httprequest);
+
+	return 1;
+}
+
+/* Start TLS handshake or send request */
+static int ac_soapclient_async_connected(struct ac_soap_async_request* asyncrequest) {
+	struct ac_http_soap_request* httprequest = asyncrequest->httprequest;
+
+	if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
+		httprequest->sslsock = capwap_socket_ssl_create(httprequest->sock, httprequest->server->sslcontext);
+		if (!httprequest->sslsock) {
+			return 0;
+		}
+
+		asyncrequest->state = SOAP_ASYNC_STATE_HANDSHAKE;
+		asyncrequest->events = POLLOUT;
+		return 1;
+	}
+
+	return ac_soapclient_async_prepare_send(asyncrequest);
+}
+
+/* Retrieve a persistent connection or start a new one */
+static int ac_soapclient_async_connect(struct ac_soap_async_request* asyncrequest) {
+	int result;
+	struct ac_http_soap_request* httprequest = asyncrequest->httprequest;
+
+	ASSERT(httprequest->sock < 0);
+
+	/* */
+	httprequest->reused = 0;
+	if (ac_soapclient_pool_get(httprequest)) {
+		return ac_soapclient_async_prepare_send(asyncrequest);
+	}
+
+	/* Create socket */
+	httprequest->sock = socket(httprequest->server->address.ss.ss_family, SOCK_STREAM, 0);
+	if (httprequest->sock < 0) {
+		return 0;
+	}
+
+	/* */
+	result = capwap_socket_connect_async(httprequest->sock, &httprequest->server->address);
+	if (result == CAPWAP_SOCKET_ERROR) {
+		return 0;
+	}
+
+	/* */
+	ac_soapclient_pool_add(httprequest);
+	if (result == CAPWAP_SOCKET_WANT_WRITE) {
+		asyncrequest->state = SOAP_ASYNC_STATE_CONNECT;
+		asyncrequest->events = POLLOUT;
+		return 1;
+	}
+
+	return ac_soapclient_async_connected(asyncrequest);
+}
+
+/* Persistent connection was closed by server, retry once with a new connection */
+static int ac_soapclient_async_retry(struct ac_soap_async_request* asyncrequest) {
+	struct ac_http_soap_request* httprequest = asyncrequest->httprequest;
+
+	if (!httprequest->reused || httprequest->receivedlength || httprequest->shutdown) {
+		return 0;
+	}
+
+	ac_soapclient_pool_put(httprequest, 0);
+	ac_soapclient_pool_retry(httprequest->server);
+
+	return ac_soapclient_async_connect(asyncrequest);
+}
+
+/* Accumulate a line of HTTP response, return 1 when the line is complete */
+static int ac_soapclient_async_readline(struct ac_soap_async_request* asyncrequest, char** data, int* length) {
+	char* endline;
+	int linelength;
+
+	/* */
+	endline = memchr(*data, '\n', *length);
+	linelength = (endline ? ((int)(endline - *data) + 1) : *length);
+	if ((asyncrequest->linelength + linelength) >= SOAP_ASYNC_LINE_LENGTH) {
+		return -1;
+	}
+
+	memcpy(&asyncrequest->line[asyncrequest->linelength], *data, linelength);
+	asyncrequest->linelength += linelength;
+	*data += linelength;
+	*length -= linelength;
+
+	if (!endline) {
+		return 0;
+	} else if ((asyncrequest->linelength < 2) || (asyncrequest->line[asyncrequest->linelength - 2] != '\r')) {
+		return -1;
+	}
+
+	/* Remove CRLF */
+	asyncrequest->linelength -= 2;
+	asyncrequest->line[asyncrequest->linelength] = 0;
+	return 1;
+}
+
+/* */
+static void ac_soapclient_async_append_body(struct ac_soap_async_request* asyncrequest, char* data, int length) {
+	char* body;
+
+	if ((asyncrequest->bodylength + length) >= asyncrequest->bodysize) {
+		asyncrequest->bodysize = asyncrequest->bodylength + length + SOAP_ASYNC_BODY_LENGTH;
+		body = (char*)capwap_alloc(asyncrequest->bodysize);
+		if (asyncrequest->body) {
+			memcpy(body, asyncrequest->body, asyncrequest->bodylength);
+			capwap_free(asyncrequest->body);
+		}
+
+		asyncrequest->body = body;
+	}
+
+	memcpy(&asyncrequest->body[asyncrequest->bodylength], data, length);
+	asyncrequest->bodylength += length;
+}
+
+/* Push received data into HTTP parser, return 1 when the response is complete */
+static int ac_soapclient_async_parse(struct ac_soap_async_request* asyncrequest, char* data, int length) {
+	int result;
+	int bodylength;
+	char* endptr;
+	struct ac_http_soap_request* httprequest = asyncrequest->httprequest;
+
+	while (length > 0) {
+		if ((httprequest->httpstate == HTTP_RESPONSE_STATUS_CODE) || (httprequest->httpstate == HTTP_RESPONSE_HEADER)) {
+			result = ac_soapclient_async_readline(asyncrequest, &data, &length);
+			if (result <= 0) {
+				return result;
+			}
+
+			/* */
+			ac_soapclient_http_parse_line(httprequest, asyncrequest->line, asyncrequest->linelength);
+			asyncrequest->linelength = 0;
+			if (httprequest->httpstate == HTTP_RESPONSE_ERROR) {
+				return -1;
+			} else if ((httprequest->httpstate == HTTP_RESPONSE_BODY) && !httprequest->chunked) {
+				asyncrequest->bodysize = httprequest->contentlength + 1;
+				asyncrequest->body = (char*)capwap_alloc(asyncrequest->bodysize);
+			}
+		} else if (httprequest->httpstate != HTTP_RESPONSE_BODY) {
+			return -1;
+		} else if (!httprequest->chunked) {
+			bodylength = ((length < httprequest->contentlength) ? length : httprequest->contentlength);
+			ac_soapclient_async_append_body(asyncrequest, data, bodylength);
+			httprequest->contentlength -= bodylength;
+			data += bodylength;
+			length -= bodylength;
+
+			if (!httprequest->contentlength) {
+				httprequest->httpstate = HTTP_RESPONSE_COMPLETE;
+			}
+		} else if (asyncrequest->chunkstate == SOAP_ASYNC_CHUNK_DATA) {
+			bodylength = ((length < httprequest->chunklength) ? length : httprequest->chunklength);
+			ac_soapclient_async_append_body(asyncrequest, data, bodylength);
+			httprequest->chunklength -= bodylength;
+			data += bodylength;
+			length -= bodylength;
+
+			if (!httprequest->chunklength) {
+				asyncrequest->chunkstate = SOAP_ASYNC_CHUNK_DATAEND;
+			}
+		} else {
+			result = ac_soapclient_async_readline(asyncrequest, &data, &length);
+			if (result <= 0) {
+				return result;
+			}
+
+			/* */
+			if (asyncrequest->chunkstate == SOAP_ASYNC_CHUNK_SIZE) {
+				/* Retrieve chunk size, ignore chunk extensions */
+				httprequest->chunklength = (int)strtol(asyncrequest->line, &endptr, 16);
+				if ((endptr == asyncrequest->line) || (httprequest->chunklength < 0) || ((*endptr != 0) && (*endptr != ';') && (*endptr != ' '))) {
+					return -1;
+				}
+
+				asyncrequest->chunkstate = (httprequest->chunklength ? SOAP_ASYNC_CHUNK_DATA : SOAP_ASYNC_CHUNK_TRAILER);
+			} else if (asyncrequest->chunkstate == SOAP_ASYNC_CHUNK_DATAEND) {
+				if (asyncrequest->linelength) {
+					return -1;
+				}
+
+				asyncrequest->chunkstate = SOAP_ASYNC_CHUNK_SIZE;
+			} else if (!asyncrequest->linelength) {
+				/* Last chunk, discard trailer */
+				httprequest->httpstate = HTTP_RESPONSE_COMPLETE;
+			}
+
+			asyncrequest->linelength = 0;
+		}
+
+		/* */
+		if (httprequest->httpstate == HTTP_RESPONSE_COMPLETE) {
+			if (length > 0) {
+				httprequest->keepalive = 0;		/* Unexpected data after response */
+			}
+
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Build SOAP response from HTTP body */
+static void ac_soapclient_async_response(struct ac_soap_async_request* asyncrequest) {
+	struct ac_soap_response* response = NULL;
+	struct ac_http_soap_request* httprequest = asyncrequest->httprequest;
+
+	if (httprequest->server->transport == SOAP_TRANSPORT_JSON) {
+		if (httprequest->contentjson && asyncrequest->body) {
+			response = ac_soapclient_parse_json_document(httprequest, asyncrequest->body, asyncrequest->bodylength);
+		}
+	} else if (asyncrequest->body) {
+		response = ac_soapclient_parse_xml_document(httprequest, asyncrequest->body, asyncrequest->bodylength);
+	}
+
+	if (!response) {
+		ac_soapclient_async_fail(asyncrequest);
+		return;
+	}
+
+	/* */
+	g_ac_soap_async.completed++;
+	ac_soapclient_async_complete(asyncrequest, response);
+}
+
+/* Drive request state machine, return 0 when the request is terminated */
+static int ac_soapclient_async_process(struct ac_soap_async_request* asyncrequest, short revents) {
+	int result;
+	struct ac_http_soap_request* httprequest = asyncrequest->httprequest;
+
+	if (asyncrequest->state == SOAP_ASYNC_STATE_CONNECT) {
+		if (capwap_socket_connect_result(httprequest->sock) < 0) {
+			ac_soapclient_async_fail(asyncrequest);
+			return 0;
+		}
+
+		if (!ac_soapclient_async_connected(asyncrequest)) {
+			ac_soapclient_async_fail(asyncrequest);
+			return 0;
+		}
+
+		return 1;
+	} else if (asyncrequest->state == SOAP_ASYNC_STATE_HANDSHAKE) {
+		result = capwap_socket_ssl_connect_async(httprequest->sslsock);
+		if (result == CAPWAP_SOCKET_WANT_READ) {
+			asyncrequest->events = POLLIN;
+		} else if (result == CAPWAP_SOCKET_WANT_WRITE) {
+			asyncrequest->events = POLLOUT;
+		} else if ((result < 0) || !ac_soapclient_async_prepare_send(asyncrequest)) {
+			ac_soapclient_async_fail(asyncrequest);
+			return 0;
+		}
+
+		return 1;
+	} else if (asyncrequest->state == SOAP_ASYNC_STATE_SEND) {
+		while (asyncrequest->sendoffset < asyncrequest->sendlength) {
+			if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
+				result = capwap_socket_crypto_send_async(httprequest->sslsock, &asyncrequest->sendbuffer[asyncrequest->sendoffset], asyncrequest->sendlength - asyncrequest->sendoffset);
+			} else {
+				result = capwap_socket_send_async(httprequest->sock, &asyncrequest->sendbuffer[asyncrequest->sendoffset], asyncrequest->sendlength - asyncrequest->sendoffset);
+			}
+
+			if ((result == CAPWAP_SOCKET_WANT_READ) || (result == CAPWAP_SOCKET_WANT_WRITE)) {
+				asyncrequest->events = ((result == CAPWAP_SOCKET_WANT_READ) ? POLLIN : POLLOUT);
+				return 1;
+			} else if (result <= 0) {
+				if (!ac_soapclient_async_retry(asyncrequest)) {
+					ac_soapclient_async_fail(asyncrequest);
+					return 0;
+				}
+
+				return 1;
+			}
+
+			asyncrequest->sendoffset += result;
+		}
+
+		/* Wait response */
+		asyncrequest->state = SOAP_ASYNC_STATE_RECV;
+		asyncrequest->events = POLLIN;
+		return 1;
+	} else if (asyncrequest->state == SOAP_ASYNC_STATE_RECV) {
+		for (;;) {
+			if (httprequest->server->protocol == SOAP_HTTPS_PROTOCOL) {
+				result = capwap_socket_crypto_recv_async(httprequest->sslsock, httprequest->readbuffer, SOAP_HTTP_READ_BUFFER_LENGTH);
+			} else {
+				result = capwap_socket_recv_async(httprequest->sock, httprequest->readbuffer, SOAP_HTTP_READ_BUFFER_LENGTH);
+			}
+
+			if ((result == CAPWAP_SOCKET_WANT_READ) || (result == CAPWAP_SOCKET_WANT_WRITE)) {
+				asyncrequest->events = ((result == CAPWAP_SOCKET_WANT_READ) ? POLLIN : POLLOUT);
+				return 1;
+			} else if (result <= 0) {
+				/* Connection closed or error */
+				if (!ac_soapclient_async_retry(asyncrequest)) {
+					ac_soapclient_async_fail(asyncrequest);
+					return 0;
+				}
+
+				return 1;
+			}
+
+			/* */
+			httprequest->receivedlength += result;
+			result = ac_soapclient_async_parse(asyncrequest, httprequest->readbuffer, result);
+			if (result < 0) {
+				ac_soapclient_async_fail(asyncrequest);
+				return 0;
+			} else if (result > 0) {
+				ac_soapclient_async_response(asyncrequest);
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+/* */
+static void ac_soapclient_async_terminate_list(struct capwap_list* list) {
+	struct capwap_list_item* item;
+
+	while (list->first) {
+		item = capwap_itemlist_remove_head(list);
+		ac_soapclient_async_fail((struct ac_soap_async_request*)item->item);
+		capwap_itemlist_free(item);
+	}
+}
+
+/* */
+static void* ac_soapclient_async_thread(void* param) {
+	int i;
+	int count;
+	long timeout;
+	long remaining;
+	char dummy[64];
+	struct timeval now;
+	struct pollfd* fds;
+	struct capwap_list_item* item;
+	struct capwap_list_item* next;
+	struct ac_soap_async_request* asyncrequest;
+
+	capwap_logging_debug("SOAP async client start");
+
+	/* */
+	fds = (struct pollfd*)capwap_alloc(sizeof(struct pollfd) * (SOAP_ASYNC_MAX_INFLIGHT + 1));
+
+	/* */
+	while (!g_ac_soap_async.endthread) {
+		gettimeofday(&now, NULL);
+
+		/* Expire queued request */
+		capwap_lock_enter(&g_ac_soap_async.lock);
+
+		item = g_ac_soap_async.pending->first;
+		while (item) {
+			next = item->next;
+			asyncrequest = (struct ac_soap_async_request*)item->item;
+			if (asyncrequest->httprequest->shutdown || (ac_soapclient_async_remaining(&asyncrequest->deadline, &now) <= 0)) {
+				capwap_itemlist_remove(g_ac_soap_async.pending, item);
+				capwap_lock_exit(&g_ac_soap_async.lock);
+
+				/* */
+				g_ac_soap_async.expired++;
+				ac_soapclient_async_fail(asyncrequest);
+				capwap_itemlist_free(item);
+
+				capwap_lock_enter(&g_ac_soap_async.lock);
+				item = g_ac_soap_async.pending->first;
+			} else {
+				item = next;
+			}
+		}
+
+		/* Start queued request respecting in-flight limit */
+		while (g_ac_soap_async.pending->first && (g_ac_soap_async.active->count < SOAP_ASYNC_MAX_INFLIGHT)) {
+			item = capwap_itemlist_remove_head(g_ac_soap_async.pending);
+			capwap_lock_exit(&g_ac_soap_async.lock);
+
+			/* */
+			asyncrequest = (struct ac_soap_async_request*)item->item;
+			if (ac_soapclient_async_connect(asyncrequest)) {
+				capwap_itemlist_insert_after(g_ac_soap_async.active, NULL, item);
+			} else {
+				ac_soapclient_async_fail(asyncrequest);
+				capwap_itemlist_free(item);
+			}
+
+			capwap_lock_enter(&g_ac_soap_async.lock);
+		}
+
+		capwap_lock_exit(&g_ac_soap_async.lock);
+
+		/* Build poll list and nearest deadline */
+		count = 1;
+		timeout = SOAP_ASYNC_MAX_TIMEOUT;
+		fds[0].fd = g_ac_soap_async.wakeup[0];
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+
+		for (item = g_ac_soap_async.active->first; item; item = item->next) {
+			asyncrequest = (struct ac_soap_async_request*)item->item;
+			fds[count].fd = asyncrequest->httprequest->sock;
+			fds[count].events = asyncrequest->events;
+			fds[count].revents = 0;
+			count++;
+
+			/* */
+			remaining = ac_soapclient_async_remaining(&asyncrequest->deadline, &now);
+			if (remaining < timeout) {
+				timeout = ((remaining > 0) ? remaining : 0);
+			}
+		}
+
+		/* */
+		if ((poll(fds, count, timeout) < 0) && (errno != EINTR)) {
+			capwap_logging_error("SOAP async client poll error: %d", errno);
+			break;
+		}
+
+		/* Flush wakeup notification */
+		if (fds[0].revents & POLLIN) {
+			while (read(g_ac_soap_async.wakeup[0], dummy, sizeof(dummy)) > 0);
+		}
+
+		/* Process active request */
+		gettimeofday(&now, NULL);
+
+		i = 1;
+		item = g_ac_soap_async.active->first;
+		while (item) {
+			next = item->next;
+			asyncrequest = (struct ac_soap_async_request*)item->item;
+
+			/* */
+			if (asyncrequest->httprequest->shutdown) {
+				capwap_itemlist_remove(g_ac_soap_async.active, item);
+				ac_soapclient_async_fail(asyncrequest);
+				capwap_itemlist_free(item);
+			} else if (fds[i].revents) {
+				if (!ac_soapclient_async_process(asyncrequest, fds[i].revents)) {
+					capwap_itemlist_remove(g_ac_soap_async.active, item);
+					capwap_itemlist_free(item);
+				}
+			} else if (ac_soapclient_async_remaining(&asyncrequest->deadline, &now) <= 0) {
+				capwap_itemlist_remove(g_ac_soap_async.active, item);
+				g_ac_soap_async.expired++;
+				ac_soapclient_async_fail(asyncrequest);
+				capwap_itemlist_free(item);
+			}
+
+			/* */
+			item = next;
+			i++;
+		}
+	}
+
+	/* Terminate all request */
+	ac_soapclient_async_terminate_list(g_ac_soap_async.active);
+
+	capwap_lock_enter(&g_ac_soap_async.lock);
+	g_ac_soap_async.running = 0;
+	capwap_lock_exit(&g_ac_soap_async.lock);
+
+	ac_soapclient_async_terminate_list(g_ac_soap_async.pending);
+
+	/* */
+	capwap_free(fds);
+	capwap_logging_debug("SOAP async client stop: %lu completed, %lu failed, %lu expired", g_ac_soap_async.completed, g_ac_soap_async.failed, g_ac_soap_async.expired);
+
+	/* Thread exit */
+	pthread_exit(NULL);
+	return NULL;
+}
+
+/* */
+void ac_soapclient_async_wakeup(void) {
+	char dummy = 0;
+
+	if (g_ac_soap_async.running) {
+		if (write(g_ac_soap_async.wakeup[1], &dummy, 1) < 0) {
+			/* Pipe already signaled */
+		}
+	}
+}
+
+/* */
+int ac_soapclient_async_submit(struct ac_http_soap_request* httprequest, char* soapaction, long timeout, ac_soapclient_async_callback callback, void* param) {
+	struct capwap_list_item* item;
+	struct ac_soap_async_request* asyncrequest;
+
+	ASSERT(httprequest != NULL);
+	ASSERT(httprequest->sock < 0);
+	ASSERT(timeout > 0);
+	ASSERT(callback != NULL);
+
+	/* */
+	item = capwap_itemlist_create(sizeof(struct ac_soap_async_request));
+	asyncrequest = (struct ac_soap_async_request*)item->item;
+	memset(asyncrequest, 0, sizeof(struct ac_soap_async_request));
+
+	asyncrequest->httprequest = httprequest;
+	asyncrequest->state = SOAP_ASYNC_STATE_QUEUED;
+	asyncrequest->soapaction = capwap_duplicate_string((soapaction ? soapaction : ""));
+	asyncrequest->callback = callback;
+	asyncrequest->param = param;
+
+	/* */
+	gettimeofday(&asyncrequest->deadline, NULL);
+	asyncrequest->deadline.tv_sec += timeout / 1000;
+	asyncrequest->deadline.tv_usec += (timeout % 1000) * 1000;
+	if (asyncrequest->deadline.tv_usec >= 1000000) {
+		asyncrequest->deadline.tv_sec++;
+		asyncrequest->deadline.tv_usec -= 1000000;
+	}
+
+	/* */
+	capwap_lock_enter(&g_ac_soap_async.lock);
+
+	if (!g_ac_soap_async.running || g_ac_soap_async.endthread) {
+		capwap_lock_exit(&g_ac_soap_async.lock);
+		ac_soapclient_async_free(asyncrequest);
+		capwap_itemlist_free(item);
+		return 0;
+	}
+
+	httprequest->async = 1;
+	capwap_itemlist_insert_after(g_ac_soap_async.pending, NULL, item);
+
+	capwap_lock_exit(&g_ac_soap_async.lock);
+
+	/* */
+	ac_soapclient_async_wakeup();
+	return 1;
+}
+
+/* */
+static void ac_soapclient_async_execute_callback(struct ac_http_soap_request* httprequest, struct ac_soap_response* response, void* param) {
+	struct ac_soap_async_wait* wait = (struct ac_soap_async_wait*)param;
+
+	wait->response = response;
+	capwap_event_signal(&wait->event);
+}
+
+/* Blocking wrapper for synchronous caller */
+struct ac_soap_response* ac_soapclient_async_execute(struct ac_http_soap_request* httprequest, char* soapaction) {
+	long timeout;
+	struct ac_soap_async_wait wait;
+
+	ASSERT(httprequest != NULL);
+
+	/* */
+	memset(&wait, 0, sizeof(struct ac_soap_async_wait));
+	capwap_event_init(&wait.event);
+
+	/* */
+	timeout = ac_soapclient_get_timeout(httprequest);
+	if (ac_soapclient_async_submit(httprequest, soapaction, timeout, ac_soapclient_async_execute_callback, (void*)&wait)) {
+		capwap_event_wait(&wait.event);
+	} else if (ac_soapclient_send_request(httprequest, soapaction)) {
+		/* Event loop is not running */
+		wait.response = ac_soapclient_recv_response(httprequest);
+	}
+
+	capwap_event_destroy(&wait.event);
+	return wait.response;
+}
+
+/* */
+int ac_soapclient_async_start(void) {
+	int i;
+	int result;
+
+	memset(&g_ac_soap_async, 0, sizeof(struct ac_soap_async_t));
+
+	/* Wakeup notification of event loop */
+	if (pipe(g_ac_soap_async.wakeup)) {
+		capwap_logging_debug("Unable create SOAP async client pipe");
+		return 0;
+	}
+
+	for (i = 0; i < 2; i++) {
+		fcntl(g_ac_soap_async.wakeup[i], F_SETFL, fcntl(g_ac_soap_async.wakeup[i], F_GETFL, 0) | O_NONBLOCK);
+	}
+
+	/* Init */
+	capwap_lock_init(&g_ac_soap_async.lock);
+	g_ac_soap_async.pending = capwap_list_create();
+	g_ac_soap_async.active = capwap_list_create();
+	g_ac_soap_async.running = 1;
+
+	/* Create thread */
+	result = pthread_create(&g_ac_soap_async.threadid, NULL, ac_soapclient_async_thread, NULL);
+	if (result) {
+		capwap_logging_debug("Unable create SOAP async client thread");
+		g_ac_soap_async.running = 0;
+		return 0;
+	}
+
+	return 1;
+}
+
+/* */
+void ac_soapclient_async_stop(void) {
+	void* dummy;
+
+	if (g_ac_soap_async.running) {
+		g_ac_soap_async.endthread = 1;
+		ac_soapclient_async_wakeup();
+
+		/* Wait close thread */
+		pthread_join(g_ac_soap_async.threadid, &dummy);
+	}
+
+	/* */
+	capwap_lock_destroy(&g_ac_soap_async.lock);
+	capwap_list_free(g_ac_soap_async.pending);
+	capwap_list_free(g_ac_soap_async.active);
+	close(g_ac_soap_async.wakeup[0]);
+	close(g_ac_soap_async.wakeup[1]);
+}
@@ -412,7 +412,7 @@ void ac_stations_delete_station(struct ac_session_t* session, struct ac_station*
 }
 
 /* */
-void ac_stations_authorize_station(struct ac_session_t* session, struct ac_station* station) {
+static void ac_stations_send_authorize_station(struct ac_session_t* session, struct ac_station* station, int single) {
 	struct ac_notify_station_configuration_ieee8011_add_station notify;
 
 	ASSERT(session != NULL);
@@ -429,11 +429,22 @@ void ac_stations_authorize_station(struct ac_session_t* session, struct ac_stati
 		notify.capabilities = station->capability;
 		notify.supportedratescount = station->supportedratescount;
 		memcpy(notify.supportedrates, station->supportedrates, station->supportedratescount);
+		notify.single = single;
 
 		ac_session_send_action(session, AC_SESSION_ACTION_STATION_CONFIGURATION_IEEE80211_ADD_STATION, 0, &notify, sizeof(struct ac_notify_station_configuration_ieee8011_add_station));
 	}
 }
 
+/* */
+void ac_stations_authorize_station(struct ac_session_t* session, struct ac_station* station) {
+	ac_stations_send_authorize_station(session, station, 0);
+}
+
+/* Authorize again a station of a failed Station Configuration Request with more stations */
+void ac_stations_retry_authorize_station(struct ac_session_t* session, struct ac_station* station) {
+	ac_stations_send_authorize_station(session, station, 1);
+}
+
 /* */
 void ac_stations_deauthorize_station(struct ac_session_t* session, struct ac_station* station) {
 	int responselength;
@@ -120,6 +120,7 @@ struct ac_station* ac_stations_create_station(struct ac_session_t* session, uint
 struct ac_station* ac_stations_get_station(struct ac_session_t* session, uint8_t radioid, const uint8_t* bssid, const uint8_t* address);
 void ac_stations_delete_station(struct ac_session_t* session, struct ac_station* station);
 void ac_stations_authorize_station(struct ac_session_t* session, struct ac_station* station);
+void ac_stations_retry_authorize_station(struct ac_session_t* session, struct ac_station* station);
 void ac_stations_deauthorize_station(struct ac_session_t* session, struct ac_station* station);
 
 /* */
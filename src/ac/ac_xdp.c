@@ -0,0 +1,406 @@
+#include "ac.h"
+#include <net/if.h>
+#include <limits.h>
+#include <linux/if_link.h>
+#include <bpf/libbpf.h>
+#include <bpf/bpf.h>
+#include "ac_xdp.h"
+#include "smartcapwap_xdp.h"
+
+/* Data channel session of XDP program */
+struct ac_xdp_session {
+	struct capwap_sessionid_element sessionid;
+
+	uint32_t id;
+	int haskey;
+	struct smartcapwap_xdp_session_key key;
+};
+
+/* */
+struct ac_xdp_t {
+	int ifindex;
+	uint32_t xdpflags;
+	struct bpf_object* object;
+
+	/* Uplink and its bridge */
+	uint32_t uplinkifindex;
+	char uplinkmaster[IFNAMSIZ];
+
+	/* Maps */
+	int sessionsfd;
+	int stationsfd;
+	int interfacesfd;
+
+	/* */
+	capwap_lock_t lock;
+	struct capwap_hash* sessions;
+	uint32_t nextid;
+};
+
+static struct ac_xdp_t g_xdp = { .ifindex = -1 };
+
+/* */
+static unsigned long ac_xdp_item_gethash(const void* key, unsigned long hashsize) {
+	int i;
+	unsigned long hash = 0;
+	const struct capwap_sessionid_element* sessionid = (const struct capwap_sessionid_element*)key;
+
+	for (i = 0; i < 16; i++) {
+		hash = (hash * 31) + sessionid->id[i];
+	}
+
+	return (hash % hashsize);
+}
+
+/* */
+static const void* ac_xdp_item_getkey(const void* data) {
+	return (const void*)&((struct ac_xdp_session*)data)->sessionid;
+}
+
+/* */
+static int ac_xdp_item_cmp(const void* key1, const void* key2) {
+	return memcmp(key1, key2, sizeof(struct capwap_sessionid_element));
+}
+
+/* */
+static void ac_xdp_item_free(void* data) {
+	capwap_free(data);
+}
+
+/* */
+static int ac_xdp_get_session_key(struct sockaddr_storage* sockaddr, struct smartcapwap_xdp_session_key* key) {
+	memset(key, 0, sizeof(struct smartcapwap_xdp_session_key));
+
+	if (sockaddr->ss_family == AF_INET) {
+		struct sockaddr_in* sin = (struct sockaddr_in*)sockaddr;
+
+		key->family = SMARTCAPWAP_XDP_FAMILY_IPV4;
+		key->port = sin->sin_port;
+		memcpy(key->addr, &sin->sin_addr, sizeof(struct in_addr));
+	} else if (sockaddr->ss_family == AF_INET6) {
+		struct sockaddr_in6* sin6 = (struct sockaddr_in6*)sockaddr;
+
+		/* The IPv4 packets received by IPv6 socket */
+		key->port = sin6->sin6_port;
+		if (IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr)) {
+			key->family = SMARTCAPWAP_XDP_FAMILY_IPV4;
+			memcpy(key->addr, &sin6->sin6_addr.s6_addr[12], sizeof(struct in_addr));
+		} else {
+			key->family = SMARTCAPWAP_XDP_FAMILY_IPV6;
+			memcpy(key->addr, &sin6->sin6_addr, sizeof(struct in6_addr));
+		}
+	} else {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Bridge of interface */
+static int ac_xdp_get_master(const char* ifname, char* master) {
+	int length;
+	char* name;
+	char path[PATH_MAX];
+	char link[PATH_MAX];
+
+	snprintf(path, sizeof(path), "/sys/class/net/%s/master", ifname);
+	length = readlink(path, link, sizeof(link) - 1);
+	if (length <= 0) {
+		return -1;
+	}
+
+	link[length] = 0;
+	name = strrchr(link, '/');
+	name = (name ? name + 1 : link);
+	if (strlen(name) > (IFNAMSIZ - 1)) {
+		return -1;
+	}
+
+	strcpy(master, name);
+	return 0;
+}
+
+/* The capwap interface of station is bridged with uplink, or into uplink when it is the bridge */
+static int ac_xdp_is_uplink_bridged(int ifindex) {
+	char ifname[IFNAMSIZ];
+	char master[IFNAMSIZ];
+
+	if (!if_indextoname(ifindex, ifname) || ac_xdp_get_master(ifname, master)) {
+		return 0;
+	}
+
+	return (!strcmp(master, g_ac.xdp.uplink) || (g_xdp.uplinkmaster[0] && !strcmp(master, g_xdp.uplinkmaster)));
+}
+
+/* Remove the stations of a session */
+static void ac_xdp_purge_stations(uint32_t id) {
+	int next;
+	struct smartcapwap_xdp_station station;
+	struct smartcapwap_xdp_station_key key;
+	struct smartcapwap_xdp_station_key nextkey;
+
+	next = !bpf_map_get_next_key(g_xdp.stationsfd, NULL, &nextkey);
+	while (next) {
+		memcpy(&key, &nextkey, sizeof(struct smartcapwap_xdp_station_key));
+		next = !bpf_map_get_next_key(g_xdp.stationsfd, &key, &nextkey);
+
+		if (!bpf_map_lookup_elem(g_xdp.stationsfd, &key, &station) && (station.session == id)) {
+			bpf_map_delete_elem(g_xdp.stationsfd, &key);
+		}
+	}
+}
+
+/* */
+int ac_xdp_init(unsigned short dataport) {
+	int mapfd;
+	uint32_t index = 0;
+	struct bpf_program* program;
+	struct smartcapwap_xdp_config config;
+	const char* object = (g_ac.xdp.object ? g_ac.xdp.object : AC_XDP_DEFAULT_OBJECT);
+
+	/* Disabled */
+	if (!g_ac.xdp.interface[0]) {
+		return 0;
+	}
+
+	/* The decapsulated packets are sent to uplink bridged with capwap interface of station,
+	   a redirect into capwap interface is a new transmission to WTP */
+	g_xdp.ifindex = if_nametoindex(g_ac.xdp.interface);
+	g_xdp.uplinkifindex = if_nametoindex(g_ac.xdp.uplink);
+	if (!g_xdp.ifindex || !g_xdp.uplinkifindex) {
+		capwap_logging_warning("Unable to found XDP interface %s or uplink %s", g_ac.xdp.interface, g_ac.xdp.uplink);
+		g_xdp.ifindex = -1;
+		return -1;
+	}
+
+	if (ac_xdp_get_master(g_ac.xdp.uplink, g_xdp.uplinkmaster)) {
+		g_xdp.uplinkmaster[0] = 0;
+	}
+
+	/* Load program */
+	g_xdp.object = bpf_object__open_file(object, NULL);
+	if (!g_xdp.object) {
+		capwap_logging_warning("Unable to open XDP program %s: %d", object, errno);
+		g_xdp.ifindex = -1;
+		return -1;
+	}
+
+	if (bpf_object__load(g_xdp.object)) {
+		capwap_logging_warning("Unable to load XDP program %s: %d", object, errno);
+		g_xdp.ifindex = -1;
+		ac_xdp_free();
+		return -1;
+	}
+
+	/* */
+	program = bpf_object__find_program_by_name(g_xdp.object, SMARTCAPWAP_XDP_PROGRAM);
+	g_xdp.sessionsfd = bpf_object__find_map_fd_by_name(g_xdp.object, SMARTCAPWAP_XDP_MAP_SESSIONS);
+	g_xdp.stationsfd = bpf_object__find_map_fd_by_name(g_xdp.object, SMARTCAPWAP_XDP_MAP_STATIONS);
+	g_xdp.interfacesfd = bpf_object__find_map_fd_by_name(g_xdp.object, SMARTCAPWAP_XDP_MAP_INTERFACES);
+	if (!program || (g_xdp.sessionsfd < 0) || (g_xdp.stationsfd < 0) || (g_xdp.interfacesfd < 0)) {
+		capwap_logging_warning("Invalid XDP program %s", object);
+		g_xdp.ifindex = -1;
+		ac_xdp_free();
+		return -1;
+	}
+
+	/* Data channel port */
+	memset(&config, 0, sizeof(struct smartcapwap_xdp_config));
+	config.dataport = dataport;
+
+	mapfd = bpf_object__find_map_fd_by_name(g_xdp.object, SMARTCAPWAP_XDP_MAP_CONFIG);
+	if ((mapfd < 0) || bpf_map_update_elem(mapfd, &index, &config, BPF_ANY)) {
+		capwap_logging_warning("Unable to configure XDP program");
+		g_xdp.ifindex = -1;
+		ac_xdp_free();
+		return -1;
+	}
+
+	/* Generic mode is available on any interface, also veth without offload */
+	g_xdp.xdpflags = XDP_FLAGS_UPDATE_IF_NOEXIST | (g_ac.xdp.generic ? XDP_FLAGS_SKB_MODE : XDP_FLAGS_DRV_MODE);
+	if (bpf_xdp_attach(g_xdp.ifindex, bpf_program__fd(program), g_xdp.xdpflags, NULL)) {
+		capwap_logging_warning("Unable to attach XDP program to %s: %d", g_ac.xdp.interface, errno);
+		g_xdp.ifindex = -1;
+		ac_xdp_free();
+		return -1;
+	}
+
+	/* */
+	capwap_lock_init(&g_xdp.lock);
+	g_xdp.sessions = capwap_hash_create(AC_XDP_HASH_SIZE);
+	g_xdp.sessions->item_gethash = ac_xdp_item_gethash;
+	g_xdp.sessions->item_getkey = ac_xdp_item_getkey;
+	g_xdp.sessions->item_cmp = ac_xdp_item_cmp;
+	g_xdp.sessions->item_free = ac_xdp_item_free;
+
+	capwap_logging_info("XDP data channel fast path attached to %s, uplink %s", g_ac.xdp.interface, g_ac.xdp.uplink);
+	return 0;
+}
+
+/* */
+void ac_xdp_free(void) {
+	if (g_xdp.ifindex > 0) {
+		bpf_xdp_detach(g_xdp.ifindex, g_xdp.xdpflags, NULL);
+		g_xdp.ifindex = -1;
+	}
+
+	if (g_xdp.sessions) {
+		capwap_hash_free(g_xdp.sessions);
+		g_xdp.sessions = NULL;
+		capwap_lock_destroy(&g_xdp.lock);
+	}
+
+	if (g_xdp.object) {
+		bpf_object__close(g_xdp.object);
+		g_xdp.object = NULL;
+	}
+}
+
+/* */
+void ac_xdp_new_session(struct capwap_sessionid_element* sessionid) {
+	struct ac_xdp_session* xdpsession;
+
+	ASSERT(sessionid != NULL);
+
+	if (!g_xdp.sessions) {
+		return;
+	}
+
+	/* The address of WTP is known with the first keep-alive */
+	capwap_lock_enter(&g_xdp.lock);
+
+	if (!capwap_hash_search(g_xdp.sessions, sessionid)) {
+		xdpsession = (struct ac_xdp_session*)capwap_alloc(sizeof(struct ac_xdp_session));
+		memset(xdpsession, 0, sizeof(struct ac_xdp_session));
+		memcpy(&xdpsession->sessionid, sessionid, sizeof(struct capwap_sessionid_element));
+		xdpsession->id = ++g_xdp.nextid;
+
+		capwap_hash_add(g_xdp.sessions, xdpsession);
+	}
+
+	capwap_lock_exit(&g_xdp.lock);
+}
+
+/* */
+void ac_xdp_delete_session(struct capwap_sessionid_element* sessionid) {
+	struct ac_xdp_session* xdpsession;
+
+	ASSERT(sessionid != NULL);
+
+	if (!g_xdp.sessions) {
+		return;
+	}
+
+	/* */
+	capwap_lock_enter(&g_xdp.lock);
+
+	xdpsession = (struct ac_xdp_session*)capwap_hash_search(g_xdp.sessions, sessionid);
+	if (xdpsession) {
+		if (xdpsession->haskey) {
+			bpf_map_delete_elem(g_xdp.sessionsfd, &xdpsession->key);
+		}
+
+		ac_xdp_purge_stations(xdpsession->id);
+		capwap_hash_delete(g_xdp.sessions, sessionid);
+	}
+
+	capwap_lock_exit(&g_xdp.lock);
+}
+
+/* */
+void ac_xdp_update_session(struct capwap_sessionid_element* sessionid, struct sockaddr_storage* sockaddr) {
+	struct ac_xdp_session* xdpsession;
+	struct smartcapwap_xdp_session value;
+	struct smartcapwap_xdp_session_key key;
+
+	ASSERT(sessionid != NULL);
+	ASSERT(sockaddr != NULL);
+
+	if (!g_xdp.sessions || ac_xdp_get_session_key(sockaddr, &key)) {
+		return;
+	}
+
+	/* */
+	capwap_lock_enter(&g_xdp.lock);
+
+	xdpsession = (struct ac_xdp_session*)capwap_hash_search(g_xdp.sessions, sessionid);
+	if (xdpsession && (!xdpsession->haskey || memcmp(&xdpsession->key, &key, sizeof(struct smartcapwap_xdp_session_key)))) {
+		/* Address of WTP is changed */
+		if (xdpsession->haskey) {
+			bpf_map_delete_elem(g_xdp.sessionsfd, &xdpsession->key);
+			xdpsession->haskey = 0;
+		}
+
+		value.id = xdpsession->id;
+		if (!bpf_map_update_elem(g_xdp.sessionsfd, &key, &value, BPF_ANY)) {
+			memcpy(&xdpsession->key, &key, sizeof(struct smartcapwap_xdp_session_key));
+			xdpsession->haskey = 1;
+		} else {
+			capwap_logging_warning("Unable to add data channel session into XDP program: %d", errno);
+		}
+	}
+
+	capwap_lock_exit(&g_xdp.lock);
+}
+
+/* */
+void ac_xdp_authorize_station(struct capwap_sessionid_element* sessionid, const uint8_t* macaddress, int ifindex, uint16_t vlan) {
+	uint32_t interface;
+	struct ac_xdp_session* xdpsession;
+	struct smartcapwap_xdp_station value;
+	struct smartcapwap_xdp_station_key key;
+
+	ASSERT(sessionid != NULL);
+	ASSERT(macaddress != NULL);
+
+	if (!g_xdp.sessions) {
+		return;
+	}
+
+	/* The packets of station with VLAN are tagged by kernel module, the packets of capwap
+	   interface not bridged with uplink are forwarded by kernel module */
+	memset(&key, 0, sizeof(struct smartcapwap_xdp_station_key));
+	memcpy(key.addr, macaddress, MACADDRESS_EUI48_LENGTH);
+	if ((vlan > 0) || !ac_xdp_is_uplink_bridged(ifindex)) {
+		bpf_map_delete_elem(g_xdp.stationsfd, &key);
+		return;
+	}
+
+	/* The interfaces removed are deleted from map by kernel */
+	interface = (uint32_t)ifindex;
+	if (bpf_map_update_elem(g_xdp.interfacesfd, &interface, &g_xdp.uplinkifindex, BPF_ANY)) {
+		capwap_logging_warning("Unable to add interface into XDP program: %d", errno);
+		bpf_map_delete_elem(g_xdp.stationsfd, &key);
+		return;
+	}
+
+	/* */
+	capwap_lock_enter(&g_xdp.lock);
+
+	xdpsession = (struct ac_xdp_session*)capwap_hash_search(g_xdp.sessions, sessionid);
+	if (xdpsession) {
+		value.session = xdpsession->id;
+		value.ifindex = interface;
+		if (bpf_map_update_elem(g_xdp.stationsfd, &key, &value, BPF_ANY)) {
+			capwap_logging_warning("Unable to add station into XDP program: %d", errno);
+		}
+	}
+
+	capwap_lock_exit(&g_xdp.lock);
+}
+
+/* */
+void ac_xdp_deauthorize_station(const uint8_t* macaddress) {
+	struct smartcapwap_xdp_station_key key;
+
+	ASSERT(macaddress != NULL);
+
+	if (!g_xdp.sessions) {
+		return;
+	}
+
+	/* */
+	memset(&key, 0, sizeof(struct smartcapwap_xdp_station_key));
+	memcpy(key.addr, macaddress, MACADDRESS_EUI48_LENGTH);
+	bpf_map_delete_elem(g_xdp.stationsfd, &key);
+}
@@ -0,0 +1,38 @@
+#ifndef __AC_XDP_HEADER__
+#define __AC_XDP_HEADER__
+
+/* */
+#ifndef AC_XDP_DEFAULT_OBJECT
+#define AC_XDP_DEFAULT_OBJECT				"/usr/local/lib/smartcapwap/smartcapwap_xdp.o"
+#endif
+/* One bucket for each session of program map, defined into smartcapwap_xdp.h */
+#define AC_XDP_HASH_SIZE					SMARTCAPWAP_XDP_MAX_SESSIONS
+
+/* XDP fast path of data channel, the packets not handled by program are received by kernel module */
+#ifdef ENABLE_XDP
+int ac_xdp_init(unsigned short dataport);
+void ac_xdp_free(void);
+
+/* */
+void ac_xdp_new_session(struct capwap_sessionid_element* sessionid);
+void ac_xdp_delete_session(struct capwap_sessionid_element* sessionid);
+void ac_xdp_update_session(struct capwap_sessionid_element* sessionid, struct sockaddr_storage* sockaddr);
+
+/* */
+void ac_xdp_authorize_station(struct capwap_sessionid_element* sessionid, const uint8_t* macaddress, int ifindex, uint16_t vlan);
+void ac_xdp_deauthorize_station(const uint8_t* macaddress);
+#else
+static inline int ac_xdp_init(unsigned short dataport) { return 0; }
+static inline void ac_xdp_free(void) { }
+
+/* */
+static inline void ac_xdp_new_session(struct capwap_sessionid_element* sessionid) { }
+static inline void ac_xdp_delete_session(struct capwap_sessionid_element* sessionid) { }
+static inline void ac_xdp_update_session(struct capwap_sessionid_element* sessionid, struct sockaddr_storage* sockaddr) { }
+
+/* */
+static inline void ac_xdp_authorize_station(struct capwap_sessionid_element* sessionid, const uint8_t* macaddress, int ifindex, uint16_t vlan) { }
+static inline void ac_xdp_deauthorize_station(const uint8_t* macaddress) { }
+#endif
+
+#endif /* __AC_XDP_HEADER__ */
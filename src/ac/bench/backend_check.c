@@ -0,0 +1,325 @@
+#include "ac.h"
+#include "ac_soap.h"
+#include "ac_backend.h"
+#include <unistd.h>
+
+/* Round trips of Backend Server methods with the JSON or XML SOAP transport of ac_soap.c, against
+   webservice/jsonbackend.py that answers both. Every call is encoded as the AC does and the
+   response is decoded and checked: joinBackend, authorizeWTPSession, joinWTPSession,
+   authorizeStation, streamBackendEvent and waitBackendEvent with the events queued by the
+   POST /event of server, ackBackendEvent and leaveBackend */
+
+/* */
+#define BENCH_DEFAULT_URL					"http://127.0.0.1:8080/backend"
+#define BENCH_WTPID							"backend_check"
+#define BENCH_STREAM_LINE_LENGTH			65536
+
+/* */
+static int bench_failed;
+
+/* */
+static void bench_result(const char* method, int success, const char* detail) {
+	printf("%s: %s%s%s\n", method, (success ? "ok" : "FAIL"), (detail ? ", " : ""), (detail ? detail : ""));
+	if (!success) {
+		bench_failed++;
+	}
+}
+
+/* POST of JSON document to path of webservice/jsonbackend.py, outside of Backend protocol */
+static int bench_post(struct ac_http_soap_server* server, const char* path, const char* body) {
+	int sock;
+	int length;
+	int result = 0;
+	char buffer[1024];
+
+	length = snprintf(buffer, sizeof(buffer), "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n%s", path, server->host, (int)strlen(body), body);
+
+	sock = socket(server->address.ss.ss_family, SOCK_STREAM, 0);
+	if (sock >= 0) {
+		if (!connect(sock, &server->address.sa, sizeof(server->address)) && (send(sock, buffer, length, 0) == length)) {
+			length = recv(sock, buffer, sizeof(buffer) - 1, 0);
+			if (length > 0) {
+				buffer[length] = 0;
+				result = (strstr(buffer, " 200 ") ? 1 : 0);
+			}
+		}
+
+		close(sock);
+	}
+
+	return result;
+}
+
+/* Send request and receive response as ac_backend.c without the asynchronous event loop */
+static struct ac_soap_response* bench_execute(struct ac_http_soap_server* server, struct ac_soap_request* request) {
+	struct ac_soap_response* response = NULL;
+	struct ac_http_soap_request* httprequest;
+
+	httprequest = ac_soapclient_prepare_request(request, server);
+	if (ac_soapclient_send_request(httprequest, "")) {
+		response = ac_soapclient_recv_response(httprequest);
+	}
+
+	ac_soapclient_close_request(httprequest, 1);
+	return response;
+}
+
+/* Call with a JSON object as return value */
+static struct json_object* bench_execute_json(struct ac_http_soap_server* server, struct ac_soap_request* request) {
+	struct json_object* jsonroot = NULL;
+	struct ac_soap_response* response;
+
+	response = bench_execute(server, request);
+	if (response) {
+		jsonroot = ac_soapclient_parse_json_response(response);
+		ac_soapclient_free_response(response);
+	}
+
+	return jsonroot;
+}
+
+/* Call with a plain value or without return value */
+static int bench_execute_string(struct ac_http_soap_server* server, struct ac_soap_request* request, char** value) {
+	int result = 0;
+	struct ac_soap_response* response;
+
+	response = bench_execute(server, request);
+	if (response) {
+		result = (response->responsecode == HTTP_RESULT_OK);
+		if (value) {
+			*value = ac_soapclient_get_string_response(response);
+		}
+
+		ac_soapclient_free_response(response);
+	}
+
+	return result;
+}
+
+/* Call answered with a fault of both transports */
+static int bench_execute_fault(struct ac_http_soap_server* server, struct ac_soap_request* request) {
+	int result = 0;
+	struct ac_soap_response* response;
+
+	response = bench_execute(server, request);
+	if (response) {
+		result = ((response->responsecode != HTTP_RESULT_OK) && (response->faultstring || response->jsonFault));
+		ac_soapclient_free_response(response);
+	}
+
+	return result;
+}
+
+/* Check Action and WTPId of event */
+static int bench_check_event(struct json_object* jsonevent, unsigned long* sequence) {
+	struct json_object* jsonaction;
+	struct json_object* jsonparams;
+	struct json_object* jsonwtpid;
+	struct json_object* jsonsequence;
+
+	if (!jsonevent || (json_object_get_type(jsonevent) != json_type_object)) {
+		return 0;
+	}
+
+	jsonaction = compat_json_object_object_get(jsonevent, "Action");
+	jsonparams = compat_json_object_object_get(jsonevent, "Params");
+	jsonwtpid = (jsonparams ? compat_json_object_object_get(jsonparams, "WTPId") : NULL);
+	if (!jsonaction || strcmp(json_object_get_string(jsonaction), "CloseWTPSession") || !jsonwtpid || strcmp(json_object_get_string(jsonwtpid), BENCH_WTPID)) {
+		return 0;
+	}
+
+	if (sequence) {
+		jsonsequence = compat_json_object_object_get(jsonevent, "Sequence");
+		if (!jsonsequence) {
+			return 0;
+		}
+
+		*sequence = (unsigned long)json_object_get_int64(jsonsequence);
+	}
+
+	return 1;
+}
+
+/* First event of stream, as ac_backend_soap_streamevent */
+static int bench_stream_event(struct ac_http_soap_server* server, char* idsession, unsigned long* sequence) {
+	int length;
+	int received = 0;
+	int result = 0;
+	char buffer[BENCH_STREAM_LINE_LENGTH];
+	char* endline = NULL;
+	struct json_object* jsonevent;
+	struct ac_soap_request* request;
+	struct ac_http_soap_request* httprequest;
+
+	request = ac_soapclient_create_request("streamBackendEvent", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idsession", idsession);
+	ac_soapclient_add_param(request, "xs:long", "sequence", "0");
+
+	httprequest = ac_soapclient_prepare_request(request, server);
+	if (ac_soapclient_send_request(httprequest, "")) {
+		ac_soapclient_reset_response(httprequest);
+
+		while (!endline && (received < (sizeof(buffer) - 1))) {
+			length = ac_soapclient_recv_stream(httprequest, &buffer[received], sizeof(buffer) - received - 1);
+			if (length <= 0) {
+				break;
+			}
+
+			received += length;
+			buffer[received] = 0;
+			endline = strchr(buffer, '\n');
+		}
+
+		if (endline) {
+			*endline = 0;
+			jsonevent = json_tokener_parse(buffer);
+			result = bench_check_event(jsonevent, sequence);
+			if (jsonevent) {
+				json_object_put(jsonevent);
+			}
+		}
+	}
+
+	ac_soapclient_close_request(httprequest, 1);
+	return result;
+}
+
+/* */
+static void bench_usage(const char* name) {
+	fprintf(stderr, "Usage: %s [-x] [url]\n", name);
+	fprintf(stderr, "  -x   XML SOAP transport instead of JSON transport\n");
+	fprintf(stderr, "  url  Backend Server (default %s)\n", BENCH_DEFAULT_URL);
+}
+
+/* */
+int main(int argc, char** argv) {
+	int opt;
+	int success;
+	char buffer[64];
+	char* value = NULL;
+	char* idsession = NULL;
+	unsigned long sequence = 0;
+	int transport = SOAP_TRANSPORT_JSON;
+	const char* url = BENCH_DEFAULT_URL;
+	struct json_object* jsonroot;
+	struct ac_soap_request* request;
+	struct ac_http_soap_server* server;
+
+	while ((opt = getopt(argc, argv, "xh")) != -1) {
+		switch (opt) {
+			case 'x': {
+				transport = SOAP_TRANSPORT_XML;
+				break;
+			}
+
+			default: {
+				bench_usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+
+	if (optind < argc) {
+		url = argv[optind];
+	}
+
+	/* */
+	capwap_logging_init();
+	ac_soapclient_init();
+
+	server = ac_soapclient_create_server(url);
+	if (!server) {
+		fprintf(stderr, "Invalid Backend Server url %s\n", url);
+		return 1;
+	}
+
+	server->transport = transport;
+	printf("transport: %s, url: %s\n", ((transport == SOAP_TRANSPORT_JSON) ? "json" : "xml"), url);
+
+	/* Session of AC */
+	request = ac_soapclient_create_request("joinBackend", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idac", BENCH_WTPID);
+	ac_soapclient_add_param(request, "xs:string", "version", PACKAGE_VERSION);
+	ac_soapclient_add_param(request, "xs:boolean", "forcereset", "true");
+	bench_execute_string(server, request, &idsession);
+	bench_result("joinBackend", (idsession && *idsession), idsession);
+	if (!idsession) {
+		return 1;
+	}
+
+	/* Plain boolean return value */
+	request = ac_soapclient_create_request("authorizeWTPSession", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idsession", idsession);
+	ac_soapclient_add_param(request, "xs:string", "idwtp", BENCH_WTPID);
+	success = bench_execute_string(server, request, &value);
+	bench_result("authorizeWTPSession", (success && value && !strcmp(value, "true")), value);
+	if (value) {
+		capwap_free(value);
+	}
+
+	/* JSON param and JSON return value */
+	request = ac_soapclient_create_request("joinWTPSession", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idsession", idsession);
+	ac_soapclient_add_param(request, "xs:string", "idwtp", BENCH_WTPID);
+	ac_soapclient_add_param(request, "xs:base64Binary", "join", "{\"Binding\":{\"Type\":1},\"WTPName\":{\"Name\":\"backend & check <1>\"},\"CachedProfiles\":[]}");
+	jsonroot = bench_execute_json(server, request);
+	bench_result("joinWTPSession", (jsonroot && (json_object_get_type(jsonroot) == json_type_object)), NULL);
+	if (jsonroot) {
+		json_object_put(jsonroot);
+	}
+
+	request = ac_soapclient_create_request("authorizeStation", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idsession", idsession);
+	ac_soapclient_add_param(request, "xs:string", "idwtp", BENCH_WTPID);
+	ac_soapclient_add_param(request, "xs:base64Binary", "station", "{ \"RadioID\": 1, \"WLANID\": 1, \"Station\": \"02:00:00:00:00:01\" }");
+	jsonroot = bench_execute_json(server, request);
+	bench_result("authorizeStation", (jsonroot && (json_object_get_type(jsonroot) == json_type_object)), NULL);
+	if (jsonroot) {
+		json_object_put(jsonroot);
+	}
+
+	/* Event delivered by stream */
+	success = bench_post(server, "/event", "{\"Action\":\"CloseWTPSession\",\"Params\":{\"WTPId\":\"" BENCH_WTPID "\"}}");
+	bench_result("streamBackendEvent", (success && bench_stream_event(server, idsession, &sequence)), NULL);
+
+	sprintf(buffer, "%lu", sequence);
+	request = ac_soapclient_create_request("ackBackendEvent", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idsession", idsession);
+	ac_soapclient_add_param(request, "xs:long", "sequence", buffer);
+	bench_result("ackBackendEvent", bench_execute_string(server, request, NULL), NULL);
+
+	/* Event delivered by long polling, the acknowledged event is not returned again */
+	success = bench_post(server, "/event", "{\"Action\":\"CloseWTPSession\",\"Params\":{\"WTPId\":\"" BENCH_WTPID "\"}}");
+	if (success) {
+		request = ac_soapclient_create_request("waitBackendEvent", SOAP_NAMESPACE_URI);
+		ac_soapclient_add_param(request, "xs:string", "idsession", idsession);
+		jsonroot = bench_execute_json(server, request);
+		success = (jsonroot && (json_object_get_type(jsonroot) == json_type_array) && (json_object_array_length(jsonroot) == 1) && bench_check_event(json_object_array_get_idx(jsonroot, 0), NULL));
+		if (jsonroot) {
+			json_object_put(jsonroot);
+		}
+	}
+
+	bench_result("waitBackendEvent", success, NULL);
+
+	/* Fault of invalid session */
+	request = ac_soapclient_create_request("authorizeStation", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idsession", "invalid");
+	ac_soapclient_add_param(request, "xs:string", "idwtp", BENCH_WTPID);
+	ac_soapclient_add_param(request, "xs:base64Binary", "station", "{}");
+	bench_result("fault", bench_execute_fault(server, request), NULL);
+
+	request = ac_soapclient_create_request("leaveBackend", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idsession", idsession);
+	bench_result("leaveBackend", bench_execute_string(server, request, NULL), NULL);
+
+	printf("result: %s\n", (bench_failed ? "FAIL" : "PASS"));
+
+	/* */
+	capwap_free(idsession);
+	ac_soapclient_free_server(server);
+	ac_soapclient_free();
+	capwap_logging_close();
+
+	return (bench_failed ? 1 : 0);
+}
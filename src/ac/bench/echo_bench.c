@@ -0,0 +1,340 @@
+#include "ac.h"
+#include "capwap_dfa.h"
+#include "ac_session.h"
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+/* Answer plain Echo Request of a RUN session with the template fast path of ac_session.c
+   and with the DFA path of session thread used before. Like the AC, the DFA path hand off
+   every packet to the session thread and wait it, the checkWTPSession call to Backend Server
+   that the DFA path make for every Echo Request is not included. The responses are sent to
+   a bound UDP socket on loopback that is never read */
+
+/* */
+#define BENCH_DEFAULT_ECHOES				100000
+
+/* */
+struct bench_session {
+	struct capwap_dtls dtls;
+	capwap_lock_t sessionlock;
+
+	/* Fast path */
+	int fastpath;
+	int echoresponselength;
+	char echoresponse[AC_ECHO_RESPONSE_TEMPLATE_LENGTH];
+	struct timeval lastecho;
+	struct timeval lastcheckwtpsession;
+
+	/* Session thread */
+	int running;
+	pthread_t threadid;
+	struct capwap_list* packets;
+	capwap_event_t waitpacket;
+	capwap_event_t waitcomplete;
+	struct capwap_list* responsefragmentpacket;
+	unsigned short fragmentid;
+	unsigned long answered;
+};
+
+/* */
+static uint64_t bench_nsec(clockid_t clock) {
+	struct timespec now;
+
+	clock_gettime(clock, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+/* */
+static long bench_get_elapsed(struct timeval* last) {
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return ((now.tv_sec - last->tv_sec) * 1000) + ((now.tv_usec - last->tv_usec) / 1000);
+}
+
+/* First fragment of control message without message elements */
+static int bench_build_message(unsigned long type, char* buffer, int length) {
+	int result = 0;
+	struct capwap_list* fragmentlist;
+	struct capwap_header_data capwapheader;
+	struct capwap_packet_txmng* txmngpacket;
+	struct capwap_fragment_packet_item* fragmentpacket;
+
+	capwap_header_init(&capwapheader, CAPWAP_RADIOID_NONE, CAPWAP_WIRELESS_BINDING_IEEE80211);
+	txmngpacket = capwap_packet_txmng_create_ctrl_message(&capwapheader, type, 0, CAPWAP_MTU_DEFAULT);
+
+	fragmentlist = capwap_list_create();
+	capwap_packet_txmng_get_fragment_packets(txmngpacket, fragmentlist, 0);
+	capwap_packet_txmng_free(txmngpacket);
+
+	fragmentpacket = (struct capwap_fragment_packet_item*)fragmentlist->first->item;
+	if ((fragmentlist->count == 1) && (fragmentpacket->offset <= length)) {
+		memcpy(buffer, fragmentpacket->buffer, fragmentpacket->offset);
+		result = fragmentpacket->offset;
+	}
+
+	capwap_list_free(fragmentlist);
+	return result;
+}
+
+/* Same checks of ac_session_recv_echo_request */
+static int bench_fastpath_echo_request(struct bench_session* session, void* buffer, int length) {
+	int headerlength;
+	int responselength;
+	struct capwap_header* header;
+	struct capwap_control_message* ctrlmsg;
+	char response[AC_ECHO_RESPONSE_TEMPLATE_LENGTH];
+
+	if ((length <= sizeof(struct capwap_preamble)) || (capwap_sanity_check(CAPWAP_UNDEF_STATE, buffer, length, 0) != CAPWAP_PLAIN_PACKET)) {
+		return 0;
+	}
+
+	header = (struct capwap_header*)buffer;
+	headerlength = GET_HLEN_HEADER(header) * 4;
+	if (IS_FLAG_F_HEADER(header) || IS_FLAG_T_HEADER(header) || (length != (headerlength + sizeof(struct capwap_control_message)))) {
+		return 0;
+	}
+
+	ctrlmsg = (struct capwap_control_message*)((char*)buffer + headerlength);
+	if ((ntohl(ctrlmsg->type) != CAPWAP_ECHO_REQUEST) || (ntohs(ctrlmsg->length) != CAPWAP_CONTROL_MESSAGE_MIN_LENGTH) || ctrlmsg->flags) {
+		return 0;
+	}
+
+	/* */
+	capwap_lock_enter(&session->sessionlock);
+
+	if (!session->fastpath || (GET_WBID_HEADER(header) != CAPWAP_WIRELESS_BINDING_IEEE80211) || (bench_get_elapsed(&session->lastcheckwtpsession) >= AC_ECHO_CHECK_SESSION_INTERVAL)) {
+		capwap_lock_exit(&session->sessionlock);
+		return 0;
+	}
+
+	responselength = session->echoresponselength;
+	memcpy(response, session->echoresponse, responselength);
+	gettimeofday(&session->lastecho, NULL);
+
+	capwap_lock_exit(&session->sessionlock);
+
+	/* */
+	header = (struct capwap_header*)response;
+	((struct capwap_control_message*)(response + GET_HLEN_HEADER(header) * 4))->seq = ctrlmsg->seq;
+
+	if (capwap_crypt_sendto(&session->dtls, response, responselength) <= 0) {
+		return 0;
+	}
+
+	return 1;
+}
+
+/* Same steps of ac_session_run and receive_echo_request, without the Backend Server */
+static void bench_dfa_echo_request(struct bench_session* session, void* buffer, int length) {
+	struct capwap_parsed_packet packet;
+	struct capwap_header_data capwapheader;
+	struct capwap_packet_txmng* txmngpacket;
+	struct capwap_packet_rxmng* rxmngpacket;
+
+	if (capwap_sanity_check(CAPWAP_UNDEF_STATE, buffer, length, 0) != CAPWAP_PLAIN_PACKET) {
+		return;
+	}
+
+	rxmngpacket = capwap_packet_rxmng_create_message();
+	if ((capwap_packet_rxmng_add_recv_packet(rxmngpacket, buffer, length) == CAPWAP_RECEIVE_COMPLETE_PACKET) && (capwap_check_message_type(rxmngpacket) == VALID_MESSAGE_TYPE)) {
+		if (capwap_parsing_packet(rxmngpacket, &packet) == PARSING_COMPLETE) {
+			if (!capwap_validate_parsed_packet(&packet, NULL) && (rxmngpacket->ctrlmsg.type == CAPWAP_ECHO_REQUEST)) {
+				capwap_header_init(&capwapheader, CAPWAP_RADIOID_NONE, GET_WBID_HEADER(rxmngpacket->header));
+				txmngpacket = capwap_packet_txmng_create_ctrl_message(&capwapheader, CAPWAP_ECHO_RESPONSE, rxmngpacket->ctrlmsg.seq, CAPWAP_MTU_DEFAULT);
+
+				capwap_list_flush(session->responsefragmentpacket);
+				capwap_packet_txmng_get_fragment_packets(txmngpacket, session->responsefragmentpacket, session->fragmentid);
+				if (session->responsefragmentpacket->count > 1) {
+					session->fragmentid++;
+				}
+
+				capwap_packet_txmng_free(txmngpacket);
+
+				if (capwap_crypt_sendto_fragmentpacket(&session->dtls, session->responsefragmentpacket)) {
+					session->answered++;
+				}
+			}
+
+			capwap_free_parsed_packet(&packet);
+		}
+	}
+
+	capwap_packet_rxmng_free(rxmngpacket);
+}
+
+/* Session thread */
+static void* bench_session_thread(void* param) {
+	struct capwap_list_item* itempacket;
+	struct bench_session* session = (struct bench_session*)param;
+
+	for (;;) {
+		capwap_lock_enter(&session->sessionlock);
+
+		if (!session->running) {
+			capwap_lock_exit(&session->sessionlock);
+			break;
+		} else if (!session->packets->count) {
+			capwap_lock_exit(&session->sessionlock);
+			capwap_event_wait(&session->waitpacket);
+			continue;
+		}
+
+		itempacket = capwap_itemlist_remove_head(session->packets);
+		capwap_lock_exit(&session->sessionlock);
+
+		/* */
+		bench_dfa_echo_request(session, ((struct ac_packet*)itempacket->item)->buffer, itempacket->itemsize - sizeof(struct ac_packet));
+		capwap_itemlist_free(itempacket);
+		capwap_event_signal(&session->waitcomplete);
+	}
+
+	return NULL;
+}
+
+/* Same of ac_session_add_packet */
+static void bench_add_packet(struct bench_session* session, char* buffer, int size) {
+	struct capwap_list_item* item;
+	struct ac_packet* packet;
+
+	item = capwap_itemlist_create(sizeof(struct ac_packet) + size);
+	packet = (struct ac_packet*)item->item;
+	packet->plainbuffer = 1;
+	memcpy(packet->buffer, buffer, size);
+
+	capwap_lock_enter(&session->sessionlock);
+	capwap_itemlist_insert_after(session->packets, NULL, item);
+	capwap_event_signal(&session->waitpacket);
+	capwap_lock_exit(&session->sessionlock);
+}
+
+/* */
+static void bench_report(const char* name, int echoes, unsigned long answered, uint64_t cputime, uint64_t walltime) {
+	printf("%s: %lu/%d answered, cpu %.2f us/echo, wall %.2f us/echo\n", name, answered, echoes, (double)cputime / echoes / 1000.0, (double)walltime / echoes / 1000.0);
+}
+
+/* */
+static void bench_usage(const char* name) {
+	fprintf(stderr, "Usage: %s [-n echoes]\n", name);
+	fprintf(stderr, "  -n echoes  Echo Request answered by every path (default %d)\n", BENCH_DEFAULT_ECHOES);
+}
+
+/* */
+int main(int argc, char** argv) {
+	int i;
+	int opt;
+	int length;
+	int sinksock;
+	socklen_t addrlength;
+	uint64_t cpustart;
+	uint64_t wallstart;
+	unsigned long answered = 0;
+	int echoes = BENCH_DEFAULT_ECHOES;
+	char request[AC_ECHO_RESPONSE_TEMPLATE_LENGTH];
+	struct capwap_header* header;
+	struct bench_session session;
+
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+			case 'n': {
+				echoes = atoi(optarg);
+				break;
+			}
+
+			default: {
+				bench_usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+
+	if (echoes <= 0) {
+		bench_usage(argv[0]);
+		return 1;
+	}
+
+	/* */
+	capwap_logging_init();
+	memset(&session, 0, sizeof(struct bench_session));
+	capwap_lock_init(&session.sessionlock);
+	capwap_event_init(&session.waitpacket);
+	capwap_event_init(&session.waitcomplete);
+	session.packets = capwap_list_create();
+	session.responsefragmentpacket = capwap_list_create();
+
+	/* WTP is a bound socket never read */
+	sinksock = socket(AF_INET, SOCK_DGRAM, 0);
+	session.dtls.sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if ((sinksock < 0) || (session.dtls.sock < 0)) {
+		fprintf(stderr, "Unable to create sockets\n");
+		return 1;
+	}
+
+	session.dtls.peeraddr.sin.sin_family = AF_INET;
+	session.dtls.peeraddr.sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addrlength = sizeof(struct sockaddr_in);
+	if (bind(sinksock, &session.dtls.peeraddr.sa, addrlength) || getsockname(sinksock, &session.dtls.peeraddr.sa, &addrlength)) {
+		fprintf(stderr, "Unable to bind WTP socket\n");
+		return 1;
+	}
+
+	/* Echo Request and template of Echo Response */
+	length = bench_build_message(CAPWAP_ECHO_REQUEST, request, sizeof(request));
+	session.echoresponselength = bench_build_message(CAPWAP_ECHO_RESPONSE, session.echoresponse, sizeof(session.echoresponse));
+	if (!length || !session.echoresponselength) {
+		fprintf(stderr, "Unable to build Echo messages\n");
+		return 1;
+	}
+
+	header = (struct capwap_header*)request;
+	session.fastpath = 1;
+	gettimeofday(&session.lastcheckwtpsession, NULL);
+
+	/* Fast path into receive thread */
+	cpustart = bench_nsec(CLOCK_PROCESS_CPUTIME_ID);
+	wallstart = bench_nsec(CLOCK_MONOTONIC);
+	for (i = 0; i < echoes; i++) {
+		((struct capwap_control_message*)(request + GET_HLEN_HEADER(header) * 4))->seq = (uint8_t)i;
+		if (bench_fastpath_echo_request(&session, request, length)) {
+			answered++;
+		}
+	}
+
+	bench_report("fast path", echoes, answered, bench_nsec(CLOCK_PROCESS_CPUTIME_ID) - cpustart, bench_nsec(CLOCK_MONOTONIC) - wallstart);
+
+	/* DFA path into session thread, every packet wake the thread */
+	session.running = 1;
+	if (pthread_create(&session.threadid, NULL, bench_session_thread, &session)) {
+		fprintf(stderr, "Unable to create session thread\n");
+		return 1;
+	}
+
+	cpustart = bench_nsec(CLOCK_PROCESS_CPUTIME_ID);
+	wallstart = bench_nsec(CLOCK_MONOTONIC);
+	for (i = 0; i < echoes; i++) {
+		((struct capwap_control_message*)(request + GET_HLEN_HEADER(header) * 4))->seq = (uint8_t)i;
+		bench_add_packet(&session, request, length);
+		capwap_event_wait(&session.waitcomplete);
+	}
+
+	bench_report("dfa path", echoes, session.answered, bench_nsec(CLOCK_PROCESS_CPUTIME_ID) - cpustart, bench_nsec(CLOCK_MONOTONIC) - wallstart);
+
+	/* */
+	capwap_lock_enter(&session.sessionlock);
+	session.running = 0;
+	capwap_event_signal(&session.waitpacket);
+	capwap_lock_exit(&session.sessionlock);
+	pthread_join(session.threadid, NULL);
+
+	close(session.dtls.sock);
+	close(sinksock);
+	capwap_list_free(session.responsefragmentpacket);
+	capwap_list_free(session.packets);
+	capwap_event_destroy(&session.waitcomplete);
+	capwap_event_destroy(&session.waitpacket);
+	capwap_lock_destroy(&session.sessionlock);
+	capwap_logging_close();
+
+	return (((answered != echoes) || (session.answered != echoes)) ? 1 : 0);
+}
@@ -0,0 +1,446 @@
+#include "ac.h"
+#include "ac_soap.h"
+#include "ac_backend.h"
+#include "ac_health.h"
+#include <time.h>
+#include <unistd.h>
+
+/* Circuit breaker of ac_health.c against two Backend Servers, like webservice/jsonbackend.py,
+   with the latency injected by POST /delay of server. The authorizeStation calls are executed
+   as ac_backend_execute and the rejoin of Backend Management Thread is replaced by the change
+   of active Backend Server. The phases are:
+     healthy   calls to the first Backend Server
+     slow      the first Backend Server answers after the slow delay until the circuit opens
+     failover  calls to the second Backend Server
+     fix       the first Backend Server is fixed until the probes close the circuit
+     hung      the second Backend Server answers after the hung delay until the circuit opens */
+
+/* */
+#define BENCH_DEFAULT_CALLS					200
+#define BENCH_DEFAULT_SLOW_DELAY			700
+#define BENCH_DEFAULT_HUNG_DELAY			5000
+#define BENCH_DEFAULT_WINDOW				20
+#define BENCH_DEFAULT_SLOW_LATENCY			500
+#define BENCH_DEFAULT_OPEN_TIME				1000
+#define BENCH_DEFAULT_PROBE_INTERVAL		50
+
+#define BENCH_MAX_CALLS_TO_OPEN				1000
+#define BENCH_CLOSE_TIMEOUT					30000
+
+/* */
+struct ac_t g_ac;
+
+static int bench_activebackend;
+static unsigned long bench_failovers;
+
+/* */
+struct bench_result {
+	int calls;
+	int failed;
+	int slow;
+	uint64_t* latency;
+};
+
+/* */
+static uint64_t bench_nsec(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+/* */
+static int bench_compare_latency(const void* a, const void* b) {
+	uint64_t first = *(const uint64_t*)a;
+	uint64_t second = *(const uint64_t*)b;
+
+	return ((first < second) ? -1 : ((first > second) ? 1 : 0));
+}
+
+/* */
+static struct ac_http_soap_server* bench_get_server(int index) {
+	return *(struct ac_http_soap_server**)capwap_array_get_item_pointer(g_ac.availablebackends, index);
+}
+
+/* Called by ac_health_record when a circuit opens, same choice of ac_backend_change_server */
+void ac_backend_failover(void) {
+	unsigned long i;
+	unsigned long count = g_ac.availablebackends->count;
+
+	if (ac_health_isavailable(bench_get_server(bench_activebackend))) {
+		return;
+	}
+
+	for (i = 1; i < count; i++) {
+		int index = (int)((bench_activebackend + i) % count);
+
+		if (ac_health_isavailable(bench_get_server(index))) {
+			bench_activebackend = index;
+			bench_failovers++;
+			return;
+		}
+	}
+}
+
+/* Change the latency of Backend Server with POST /delay of webservice/jsonbackend.py */
+static int bench_set_delay(struct ac_http_soap_server* server, int delay) {
+	int sock;
+	int length;
+	int result = 0;
+	char body[64];
+	char buffer[512];
+
+	snprintf(body, sizeof(body), "{\"Delay\":%d}", delay);
+	length = snprintf(buffer, sizeof(buffer), "POST /delay HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n%s", server->host, (int)strlen(body), body);
+
+	sock = socket(server->address.ss.ss_family, SOCK_STREAM, 0);
+	if (sock >= 0) {
+		if (!connect(sock, &server->address.sa, sizeof(server->address)) && (send(sock, buffer, length, 0) == length)) {
+			length = recv(sock, buffer, sizeof(buffer) - 1, 0);
+			if (length > 0) {
+				buffer[length] = 0;
+				result = (strstr(buffer, " 200 ") ? 1 : 0);
+			}
+		}
+
+		close(sock);
+	}
+
+	return result;
+}
+
+/* Request and health record of ac_backend.c */
+struct ac_soap_response* ac_backend_execute(struct ac_http_soap_request* soaprequest) {
+	struct timeval start;
+	struct ac_soap_response* response;
+
+	soaprequest->deadline = ac_health_get_deadline(soaprequest->request->method);
+
+	gettimeofday(&start, NULL);
+	response = ac_soapclient_async_execute(soaprequest, "");
+	ac_health_record(soaprequest->server, soaprequest->request->method, &start, (response ? 1 : 0));
+
+	return response;
+}
+
+/* Same param of ac_session_action_authorizestation_request, the request is rejected while the circuit is open */
+static int bench_authorizestation(struct ac_http_soap_server* server, const char* idsession, int index, uint64_t* latency) {
+	int result = 0;
+	char station[128];
+	uint64_t start;
+	struct ac_soap_request* request;
+	struct ac_http_soap_request* soaprequest;
+	struct ac_soap_response* response;
+
+	snprintf(station, sizeof(station), "{ \"RadioID\": 1, \"WLANID\": 1, \"Station\": \"02:00:00:00:%02X:%02X\" }", (index >> 8) & 0xff, index & 0xff);
+
+	request = ac_soapclient_create_request("authorizeStation", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idsession", (char*)idsession);
+	ac_soapclient_add_param(request, "xs:string", "idwtp", "health_bench");
+	ac_soapclient_add_param(request, "xs:base64Binary", "station", station);
+
+	*latency = 0;
+	soaprequest = ac_soapclient_prepare_request(request, server);
+	if (!soaprequest) {
+		ac_soapclient_free_request(request);
+		return 0;
+	}
+
+	/* */
+	start = bench_nsec();
+	response = ac_backend_execute(soaprequest);
+	*latency = bench_nsec() - start;
+
+	if (response) {
+		result = (response->responsecode == HTTP_RESULT_OK);
+		ac_soapclient_free_response(response);
+	}
+
+	ac_soapclient_close_request(soaprequest, 1);
+	return result;
+}
+
+/* */
+static char* bench_join(struct ac_http_soap_server* server) {
+	char* idsession = NULL;
+	struct ac_soap_request* request;
+	struct ac_http_soap_request* soaprequest;
+	struct ac_soap_response* response;
+
+	request = ac_soapclient_create_request("joinBackend", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idac", g_ac.backendacid);
+	ac_soapclient_add_param(request, "xs:string", "version", PACKAGE_VERSION);
+	ac_soapclient_add_param(request, "xs:boolean", "forcereset", "false");
+
+	soaprequest = ac_soapclient_prepare_request(request, server);
+	if (!soaprequest) {
+		ac_soapclient_free_request(request);
+		return NULL;
+	}
+
+	response = ac_soapclient_async_execute(soaprequest, "");
+	if (response) {
+		idsession = ac_soapclient_get_string_response(response);
+		ac_soapclient_free_response(response);
+	}
+
+	ac_soapclient_close_request(soaprequest, 1);
+	return idsession;
+}
+
+/* Calls to active Backend Server, until count or the circuit of Backend Server opens */
+static void bench_calls(struct bench_result* result, char** idsessions, int index, int count, int untilopen) {
+	int i;
+	uint64_t latency;
+	struct ac_http_soap_server* server = bench_get_server(index);
+
+	memset(result, 0, sizeof(struct bench_result));
+	result->latency = (uint64_t*)capwap_alloc(sizeof(uint64_t) * count);
+
+	for (i = 0; i < count; i++) {
+		if (untilopen && !ac_health_isavailable(server)) {
+			break;
+		}
+
+		if (!bench_authorizestation(server, idsessions[index], i, &latency)) {
+			result->failed++;
+		}
+
+		if ((latency / 1000000) >= (uint64_t)g_ac.health.slowlatency) {
+			result->slow++;
+		}
+
+		result->latency[result->calls++] = latency;
+	}
+
+	qsort(result->latency, result->calls, sizeof(uint64_t), bench_compare_latency);
+}
+
+/* */
+static void bench_print(const char* phase, struct bench_result* result, int index) {
+	int calls = result->calls;
+
+	printf("%s: %d calls to backend %d, %d failed, %d slow", phase, calls, index, result->failed, result->slow);
+	if (calls) {
+		printf(", p50 %.1f us, p99 %.1f us, p999 %.1f us, max %.1f us", (double)result->latency[calls / 2] / 1000.0, (double)result->latency[(calls * 99) / 100] / 1000.0,
+			(double)result->latency[(calls * 999) / 1000] / 1000.0, (double)result->latency[calls - 1] / 1000.0);
+	}
+
+	printf("\n");
+	capwap_free(result->latency);
+}
+
+/* Calls until the circuit opens, then the active Backend Server must be changed */
+static int bench_open(const char* phase, char** idsessions, int index, int delay) {
+	uint64_t start;
+	struct bench_result result;
+
+	if (!bench_set_delay(bench_get_server(index), delay)) {
+		fprintf(stderr, "Unable to set delay of backend %d\n", index);
+		return 0;
+	}
+
+	start = bench_nsec();
+	bench_calls(&result, idsessions, index, BENCH_MAX_CALLS_TO_OPEN, 1);
+	printf("%s: backend %d delay %d ms, circuit %s after %d calls (%d failed, %d slow) in %.2f s, max latency %.2f s, active backend %d\n", phase, index, delay,
+		(ac_health_isavailable(bench_get_server(index)) ? "closed" : "opened"), result.calls, result.failed, result.slow, (double)(bench_nsec() - start) / 1000000000.0,
+		(result.calls ? (double)result.latency[result.calls - 1] / 1000000000.0 : 0.0), bench_activebackend);
+
+	capwap_free(result.latency);
+	return ((bench_activebackend != index) ? 1 : 0);
+}
+
+/* Fix the Backend Server and wait that the probes close the circuit */
+static int bench_close(const char* phase, int index) {
+	uint64_t start;
+	uint64_t elapsed;
+
+	if (!bench_set_delay(bench_get_server(index), 0)) {
+		fprintf(stderr, "Unable to set delay of backend %d\n", index);
+		return 0;
+	}
+
+	start = bench_nsec();
+	do {
+		usleep(1000);
+		elapsed = bench_nsec() - start;
+	} while (!ac_health_isavailable(bench_get_server(index)) && ((elapsed / 1000000) < BENCH_CLOSE_TIMEOUT));
+
+	if (!ac_health_isavailable(bench_get_server(index))) {
+		printf("%s: backend %d delay 0 ms, circuit still open after %.2f s\n", phase, index, (double)elapsed / 1000000000.0);
+		return 0;
+	}
+
+	printf("%s: backend %d delay 0 ms, circuit closed after %.2f s with %lu probes, open time %ld ms, probe interval %ld ms\n", phase, index, (double)elapsed / 1000000000.0,
+		g_ac.health.probesuccess, g_ac.health.opentime, g_ac.health.probeinterval);
+	return 1;
+}
+
+/* */
+static void bench_usage(const char* name) {
+	fprintf(stderr, "Usage: %s [-n calls] [-s delay] [-H delay] [-w window] [-l latency] [-o time] [-p interval] [-x] url url\n", name);
+	fprintf(stderr, "  -n calls     calls of healthy and failover phases (default %d)\n", BENCH_DEFAULT_CALLS);
+	fprintf(stderr, "  -s delay     latency of slow Backend Server in ms (default %d)\n", BENCH_DEFAULT_SLOW_DELAY);
+	fprintf(stderr, "  -H delay     latency of hung Backend Server in ms (default %d)\n", BENCH_DEFAULT_HUNG_DELAY);
+	fprintf(stderr, "  -w window    calls into circuit breaker window (default %d)\n", BENCH_DEFAULT_WINDOW);
+	fprintf(stderr, "  -l latency   latency of slow call in ms (default %d)\n", BENCH_DEFAULT_SLOW_LATENCY);
+	fprintf(stderr, "  -o time      open time of circuit in ms (default %d)\n", BENCH_DEFAULT_OPEN_TIME);
+	fprintf(stderr, "  -p interval  probe interval in ms (default %d)\n", BENCH_DEFAULT_PROBE_INTERVAL);
+	fprintf(stderr, "  -x           XML SOAP transport instead of JSON transport\n");
+}
+
+/* */
+int main(int argc, char** argv) {
+	int i;
+	int opt;
+	int result = 0;
+	int transport = SOAP_TRANSPORT_JSON;
+	int calls = BENCH_DEFAULT_CALLS;
+	int slowdelay = BENCH_DEFAULT_SLOW_DELAY;
+	int hungdelay = BENCH_DEFAULT_HUNG_DELAY;
+	char* idsessions[2] = { NULL, NULL };
+	struct bench_result phase;
+	struct ac_http_soap_server* server;
+
+	/* Configuration of ac.c, with short times of circuit breaker */
+	memset(&g_ac, 0, sizeof(struct ac_t));
+	g_ac.backendacid = "health_bench";
+	g_ac.health.sessiondeadline = AC_HEALTH_SESSION_DEADLINE;
+	g_ac.health.stationdeadline = AC_HEALTH_STATION_DEADLINE;
+	g_ac.health.eventdeadline = AC_HEALTH_EVENT_DEADLINE;
+	g_ac.health.controldeadline = AC_HEALTH_CONTROL_DEADLINE;
+	g_ac.health.window = BENCH_DEFAULT_WINDOW;
+	g_ac.health.minimumcalls = AC_HEALTH_MINIMUM_CALLS;
+	g_ac.health.errorrate = AC_HEALTH_ERROR_RATE;
+	g_ac.health.slowrate = AC_HEALTH_SLOW_RATE;
+	g_ac.health.slowlatency = BENCH_DEFAULT_SLOW_LATENCY;
+	g_ac.health.opentime = BENCH_DEFAULT_OPEN_TIME;
+	g_ac.health.probeinterval = BENCH_DEFAULT_PROBE_INTERVAL;
+	g_ac.health.probesuccess = AC_HEALTH_PROBE_SUCCESS;
+	g_ac.health.keeprunning = 1;
+	g_ac.health.datachannel = -1;
+
+	while ((opt = getopt(argc, argv, "n:s:H:w:l:o:p:xh")) != -1) {
+		switch (opt) {
+			case 'n': {
+				calls = atoi(optarg);
+				break;
+			}
+
+			case 's': {
+				slowdelay = atoi(optarg);
+				break;
+			}
+
+			case 'H': {
+				hungdelay = atoi(optarg);
+				break;
+			}
+
+			case 'w': {
+				g_ac.health.window = (unsigned long)atoi(optarg);
+				break;
+			}
+
+			case 'l': {
+				g_ac.health.slowlatency = atol(optarg);
+				break;
+			}
+
+			case 'o': {
+				g_ac.health.opentime = atol(optarg);
+				break;
+			}
+
+			case 'p': {
+				g_ac.health.probeinterval = atol(optarg);
+				break;
+			}
+
+			case 'x': {
+				transport = SOAP_TRANSPORT_XML;
+				break;
+			}
+
+			default: {
+				bench_usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+
+	if ((calls <= 0) || !g_ac.health.window || (g_ac.health.window > AC_HEALTH_MAX_WINDOW) || (g_ac.health.probeinterval <= 0) || ((argc - optind) != 2)) {
+		bench_usage(argv[0]);
+		return 1;
+	}
+
+	/* */
+	capwap_logging_init();
+	ac_soapclient_init();
+	ac_soapclient_async_start();
+
+	g_ac.availablebackends = capwap_array_create(sizeof(struct ac_http_soap_server*), 0, 0);
+	for (i = 0; i < 2; i++) {
+		server = ac_soapclient_create_server(argv[optind + i]);
+		if (!server) {
+			fprintf(stderr, "Invalid Backend Server url %s\n", argv[optind + i]);
+			return 1;
+		}
+
+		server->transport = transport;
+		ac_soapclient_keepalive_server(server, SOAP_KEEPALIVE_MAX_CONNECTIONS, SOAP_KEEPALIVE_IDLE_TIMEOUT);
+		*(struct ac_http_soap_server**)capwap_array_get_item_pointer(g_ac.availablebackends, i) = server;
+
+		/* The Backend Servers of previous run can be slow */
+		idsessions[i] = (bench_set_delay(server, 0) ? bench_join(server) : NULL);
+		if (!idsessions[i]) {
+			fprintf(stderr, "Unable to join Backend Server %s\n", argv[optind + i]);
+			return 1;
+		}
+	}
+
+	ac_health_start();
+
+	printf("transport: %s, window: %lu, slow latency: %ld ms, station deadline: %ld ms, error rate: %d%%, slow rate: %d%%\n", ((transport == SOAP_TRANSPORT_JSON) ? "json" : "xml"),
+		g_ac.health.window, g_ac.health.slowlatency, g_ac.health.stationdeadline, g_ac.health.errorrate, g_ac.health.slowrate);
+
+	/* */
+	bench_calls(&phase, idsessions, 0, calls, 0);
+	bench_print("healthy", &phase, 0);
+
+	if (!bench_open("slow", idsessions, 0, slowdelay)) {
+		result = 1;
+	} else {
+		bench_calls(&phase, idsessions, bench_activebackend, calls, 0);
+		bench_print("failover", &phase, bench_activebackend);
+
+		if (!bench_close("fix", 0) || !bench_open("hung", idsessions, 1, hungdelay)) {
+			result = 1;
+		}
+	}
+
+	printf("failovers: %lu, result: %s\n", bench_failovers, (result ? "FAIL" : "PASS"));
+
+	/* */
+	for (i = 0; i < 2; i++) {
+		bench_set_delay(bench_get_server(i), 0);
+	}
+
+	ac_health_stop();
+	ac_health_free();
+	ac_soapclient_async_stop();
+
+	for (i = 0; i < 2; i++) {
+		if (idsessions[i]) {
+			capwap_free(idsessions[i]);
+		}
+
+		ac_soapclient_free_server(bench_get_server(i));
+	}
+
+	capwap_array_free(g_ac.availablebackends);
+	ac_soapclient_free();
+	capwap_logging_close();
+
+	return result;
+}
@@ -0,0 +1,299 @@
+#include "ac.h"
+#include "ac_soap.h"
+#include "ac_backend.h"
+#include <time.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Execute authorizeStation calls against a Backend Server, like webservice/jsonbackend.py,
+   with the synchronous transport of ac_soap.c. The socket functions are wrapped by linker
+   for count the system calls of every call */
+
+/* */
+#define BENCH_DEFAULT_CALLS					1000
+#define BENCH_DEFAULT_URL					"http://127.0.0.1:8080/backend"
+
+/* Wrapped system calls */
+#define BENCH_SYSCALL_SOCKET				0
+#define BENCH_SYSCALL_CONNECT				1
+#define BENCH_SYSCALL_GETSOCKOPT			2
+#define BENCH_SYSCALL_FCNTL					3
+#define BENCH_SYSCALL_POLL					4
+#define BENCH_SYSCALL_SEND					5
+#define BENCH_SYSCALL_RECV					6
+#define BENCH_SYSCALL_SHUTDOWN				7
+#define BENCH_SYSCALL_CLOSE					8
+#define BENCH_SYSCALL_COUNT					9
+
+static const char* bench_syscall_names[BENCH_SYSCALL_COUNT] = { "socket", "connect", "getsockopt", "fcntl", "poll", "send", "recv", "shutdown", "close" };
+static unsigned long bench_syscalls[BENCH_SYSCALL_COUNT];
+
+/* */
+int __real_socket(int domain, int type, int protocol);
+int __real_connect(int sock, const struct sockaddr* address, socklen_t length);
+int __real_getsockopt(int sock, int level, int name, void* value, socklen_t* length);
+int __real_fcntl(int fd, int cmd, ...);
+int __real_poll(struct pollfd* fds, nfds_t nfds, int timeout);
+ssize_t __real_send(int sock, const void* buffer, size_t length, int flags);
+ssize_t __real_recv(int sock, void* buffer, size_t length, int flags);
+int __real_shutdown(int sock, int how);
+int __real_close(int fd);
+
+/* */
+int __wrap_socket(int domain, int type, int protocol) {
+	bench_syscalls[BENCH_SYSCALL_SOCKET]++;
+	return __real_socket(domain, type, protocol);
+}
+
+/* */
+int __wrap_connect(int sock, const struct sockaddr* address, socklen_t length) {
+	bench_syscalls[BENCH_SYSCALL_CONNECT]++;
+	return __real_connect(sock, address, length);
+}
+
+/* */
+int __wrap_getsockopt(int sock, int level, int name, void* value, socklen_t* length) {
+	bench_syscalls[BENCH_SYSCALL_GETSOCKOPT]++;
+	return __real_getsockopt(sock, level, name, value, length);
+}
+
+/* The F_GETFL and F_SETFL commands only are used by capwap_socket.c */
+int __wrap_fcntl(int fd, int cmd, ...) {
+	long arg;
+	va_list args;
+
+	va_start(args, cmd);
+	arg = va_arg(args, long);
+	va_end(args);
+
+	bench_syscalls[BENCH_SYSCALL_FCNTL]++;
+	return __real_fcntl(fd, cmd, arg);
+}
+
+/* */
+int __wrap_poll(struct pollfd* fds, nfds_t nfds, int timeout) {
+	bench_syscalls[BENCH_SYSCALL_POLL]++;
+	return __real_poll(fds, nfds, timeout);
+}
+
+/* */
+ssize_t __wrap_send(int sock, const void* buffer, size_t length, int flags) {
+	bench_syscalls[BENCH_SYSCALL_SEND]++;
+	return __real_send(sock, buffer, length, flags);
+}
+
+/* */
+ssize_t __wrap_recv(int sock, void* buffer, size_t length, int flags) {
+	bench_syscalls[BENCH_SYSCALL_RECV]++;
+	return __real_recv(sock, buffer, length, flags);
+}
+
+/* */
+int __wrap_shutdown(int sock, int how) {
+	bench_syscalls[BENCH_SYSCALL_SHUTDOWN]++;
+	return __real_shutdown(sock, how);
+}
+
+/* */
+int __wrap_close(int fd) {
+	bench_syscalls[BENCH_SYSCALL_CLOSE]++;
+	return __real_close(fd);
+}
+
+/* */
+static uint64_t bench_nsec(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+/* */
+static int bench_compare_latency(const void* a, const void* b) {
+	uint64_t first = *(const uint64_t*)a;
+	uint64_t second = *(const uint64_t*)b;
+
+	return ((first < second) ? -1 : ((first > second) ? 1 : 0));
+}
+
+/* Send request and receive response as ac_backend.c without the asynchronous event loop */
+static struct ac_soap_response* bench_execute(struct ac_http_soap_server* server, struct ac_soap_request* request) {
+	struct ac_soap_response* response = NULL;
+	struct ac_http_soap_request* httprequest;
+
+	httprequest = ac_soapclient_prepare_request(request, server);
+	if (ac_soapclient_send_request(httprequest, "")) {
+		response = ac_soapclient_recv_response(httprequest);
+	}
+
+	ac_soapclient_close_request(httprequest, 1);
+	return response;
+}
+
+/* */
+static char* bench_join(struct ac_http_soap_server* server) {
+	char* idsession = NULL;
+	struct ac_soap_request* request;
+	struct ac_soap_response* response;
+
+	request = ac_soapclient_create_request("joinBackend", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idac", "soap_bench");
+	ac_soapclient_add_param(request, "xs:string", "version", PACKAGE_VERSION);
+	ac_soapclient_add_param(request, "xs:boolean", "forcereset", "false");
+
+	response = bench_execute(server, request);
+	if (response) {
+		idsession = ac_soapclient_get_string_response(response);
+		ac_soapclient_free_response(response);
+	}
+
+	return idsession;
+}
+
+/* Same param of ac_session_action_authorizestation_request */
+static int bench_authorizestation(struct ac_http_soap_server* server, char* idsession, int index) {
+	int result = 0;
+	char station[128];
+	struct ac_soap_request* request;
+	struct ac_soap_response* response;
+
+	snprintf(station, sizeof(station), "{ \"RadioID\": 1, \"WLANID\": 1, \"Station\": \"02:00:00:00:%02X:%02X\" }", (index >> 8) & 0xff, index & 0xff);
+
+	request = ac_soapclient_create_request("authorizeStation", SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(request, "xs:string", "idsession", idsession);
+	ac_soapclient_add_param(request, "xs:string", "idwtp", "soap_bench");
+	ac_soapclient_add_param(request, "xs:base64Binary", "station", station);
+
+	response = bench_execute(server, request);
+	if (response) {
+		result = (response->responsecode == HTTP_RESULT_OK);
+		ac_soapclient_free_response(response);
+	}
+
+	return result;
+}
+
+/* */
+static void bench_usage(const char* name) {
+	fprintf(stderr, "Usage: %s [-n calls] [-k connections] [-x] [url]\n", name);
+	fprintf(stderr, "  -n calls        number of authorizeStation calls (default %d)\n", BENCH_DEFAULT_CALLS);
+	fprintf(stderr, "  -k connections  keep-alive connections, 0 disables keep-alive (default %d)\n", SOAP_KEEPALIVE_MAX_CONNECTIONS);
+	fprintf(stderr, "  -x              XML SOAP transport instead of JSON transport\n");
+	fprintf(stderr, "  url             Backend Server (default %s)\n", BENCH_DEFAULT_URL);
+}
+
+/* */
+int main(int argc, char** argv) {
+	int i;
+	int opt;
+	int failed = 0;
+	int transport = SOAP_TRANSPORT_JSON;
+	int calls = BENCH_DEFAULT_CALLS;
+	int connections = SOAP_KEEPALIVE_MAX_CONNECTIONS;
+	char* idsession;
+	uint64_t start;
+	uint64_t* latency;
+	uint64_t totaltime = 0;
+	unsigned long totalsyscalls = 0;
+	const char* url = BENCH_DEFAULT_URL;
+	struct ac_http_soap_server* server;
+
+	while ((opt = getopt(argc, argv, "n:k:xh")) != -1) {
+		switch (opt) {
+			case 'n': {
+				calls = atoi(optarg);
+				break;
+			}
+
+			case 'k': {
+				connections = atoi(optarg);
+				break;
+			}
+
+			case 'x': {
+				transport = SOAP_TRANSPORT_XML;
+				break;
+			}
+
+			default: {
+				bench_usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+
+	if ((calls <= 0) || (connections < 0)) {
+		bench_usage(argv[0]);
+		return 1;
+	} else if (optind < argc) {
+		url = argv[optind];
+	}
+
+	/* */
+	capwap_logging_init();
+	ac_soapclient_init();
+
+	server = ac_soapclient_create_server(url);
+	if (!server) {
+		fprintf(stderr, "Invalid Backend Server url %s\n", url);
+		return 1;
+	}
+
+	server->transport = transport;
+	ac_soapclient_keepalive_server(server, connections, SOAP_KEEPALIVE_IDLE_TIMEOUT);
+
+	/* */
+	idsession = bench_join(server);
+	if (!idsession) {
+		fprintf(stderr, "Unable to join Backend Server %s\n", url);
+		return 1;
+	}
+
+	/* The first call open the keep-alive connection and it is not measured */
+	if (!bench_authorizestation(server, idsession, 0)) {
+		fprintf(stderr, "Unable to authorize station with Backend Server %s\n", url);
+		return 1;
+	}
+
+	latency = (uint64_t*)malloc(sizeof(uint64_t) * calls);
+	if (!latency) {
+		return 1;
+	}
+
+	memset(bench_syscalls, 0, sizeof(bench_syscalls));
+	for (i = 0; i < calls; i++) {
+		start = bench_nsec();
+		if (!bench_authorizestation(server, idsession, i + 1)) {
+			failed++;
+		}
+
+		latency[i] = bench_nsec() - start;
+		totaltime += latency[i];
+	}
+
+	/* */
+	qsort(latency, calls, sizeof(uint64_t), bench_compare_latency);
+
+	printf("calls: %d, failed: %d, transport: %s, read buffer: %d bytes, keep-alive connections: %d\n", calls, failed, ((transport == SOAP_TRANSPORT_JSON) ? "json" : "xml"), SOAP_HTTP_READ_BUFFER_LENGTH, connections);
+	printf("connections: %lu created, %lu reused, %lu retried\n", server->pool.created, server->pool.reused, server->pool.retried);
+	for (i = 0; i < BENCH_SYSCALL_COUNT; i++) {
+		if (bench_syscalls[i]) {
+			printf("%s: %.2f/call\n", bench_syscall_names[i], (double)bench_syscalls[i] / calls);
+			totalsyscalls += bench_syscalls[i];
+		}
+	}
+
+	printf("syscalls: %.2f/call\n", (double)totalsyscalls / calls);
+	printf("latency: mean %.1f us, p50 %.1f us, p99 %.1f us\n", (double)totaltime / calls / 1000.0, (double)latency[calls / 2] / 1000.0, (double)latency[(calls * 99) / 100] / 1000.0);
+
+	/* */
+	free(latency);
+	capwap_free(idsession);
+	ac_soapclient_free_server(server);
+	ac_soapclient_free();
+	capwap_logging_close();
+
+	return (failed ? 1 : 0);
+}
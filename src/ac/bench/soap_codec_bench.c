@@ -0,0 +1,439 @@
+#include "ac.h"
+#include "ac_soap.h"
+#include "ac_backend.h"
+#include <time.h>
+#include <unistd.h>
+#include <libxml/tree.h>
+
+/* Encode the requests and decode the responses of joinWTPSession and authorizeStation with
+   the XML SOAP codec of ac_soap.c, the template request and the SAX2 response parser. The
+   libxml2 DOM codec replaced by them is kept into the benchmark as reference */
+
+/* */
+#define BENCH_DEFAULT_ITERATIONS			10000
+#define BENCH_DEFAULT_RUNS					5
+
+/* Fixed parts of XML SOAP Response */
+#define BENCH_RESPONSE_FORMAT																								\
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"																			\
+	"<SOAP-ENV:Envelope xmlns:SOAP-ENV=\"" SOAP_ENVELOPE_NAMESPACE "\" xmlns:SOAP-ENC=\"http://schemas.xmlsoap.org/soap/encoding/\" "	\
+	"xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" "				\
+	"xmlns:tns=\"" SOAP_NAMESPACE_URI "\"><SOAP-ENV:Header/><SOAP-ENV:Body "												\
+	"SOAP-ENV:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\"><tns:%sResponse>"								\
+	"<return xsi:type=\"xsd:base64Binary\">%s</return></tns:%sResponse></SOAP-ENV:Body></SOAP-ENV:Envelope>\n"
+
+/* Param of joinWTPSession, see ac_dfa_join.c */
+static const char bench_join_param[] =
+	"{\"Binding\":{\"Type\":1},\"LocationData\":{\"Location\":\"Building 1, Floor 2, Room 204\"},"
+	"\"WTPBoardData\":{\"VendorIdentifier\":0,\"BoardDataSubElement\":[{\"BoardDataType\":0,\"BoardDataValue\":\"c21hcnRjYXB3YXAtd3Rw\"},"
+	"{\"BoardDataType\":1,\"BoardDataValue\":\"MDAwMDAwMDAwMDAx\"},{\"BoardDataType\":4,\"BoardDataValue\":\"AgAAAAAB\"}]},"
+	"\"WTPDescriptor\":{\"MaxRadios\":2,\"RadiosInUse\":2,\"EncryptionSubElement\":[{\"WBID\":1,\"EncryptionCapabilities\":0}],"
+	"\"DescriptorSubElement\":[{\"DescriptorVendorIdentifier\":0,\"DescriptorType\":0,\"DescriptorData\":\"1.0\"},"
+	"{\"DescriptorVendorIdentifier\":0,\"DescriptorType\":1,\"DescriptorData\":\"1.0\"},"
+	"{\"DescriptorVendorIdentifier\":0,\"DescriptorType\":2,\"DescriptorData\":\"1.0\"}]},"
+	"\"WTPName\":{\"Name\":\"wtp-building1-floor2-room204\"},"
+	"\"WTPFrameTunnelMode\":{\"NativeFrameTunnel\":true,\"FrameTunnelMode8023\":true,\"LocalBridge\":false},"
+	"\"WTPMACType\":{\"Type\":1},\"ECNSupport\":{\"Mode\":0},\"CAPWAPLocalIPv4Address\":{\"Address\":\"192.168.1.204\"},"
+	"\"WTPRebootStatistics\":{\"RebootCount\":3,\"ACInitiatedCount\":1,\"LinkFailureCount\":0,\"SWFailureCount\":0,"
+	"\"HWFailureCount\":0,\"OtherFailureCount\":0,\"UnknownFailureCount\":2},"
+	"\"WTPRadio\":[{\"RadioID\":1,\"IEEE80211WTPRadioInformation\":{\"Mode\":14}},{\"RadioID\":2,\"IEEE80211WTPRadioInformation\":{\"Mode\":9}}],"
+	"\"CachedProfiles\":[{\"Key\":\"default\",\"Version\":3}]}";
+
+/* Return of joinWTPSession, see ac_dfa_join.c and ac_80211_json.c */
+static const char bench_join_result[] =
+	"{\"AuthorizationGroup\":\"default\",\"ACIPv4List\":[\"192.168.1.1\",\"192.168.1.2\"],"
+	"\"WTPRadio\":[{\"RadioID\":1,"
+	"\"IEEE80211Antenna\":{\"Diversity\":false,\"Combiner\":3,\"AntennaSelection\":[1,2]},"
+	"\"IEEE80211DirectSequenceControl\":{\"CurrentChan\":6,\"CurrentCCA\":1,\"EnergyDetectThreshold\":-82},"
+	"\"IEEE80211MACOperation\":{\"RTSThreshold\":2347,\"ShortRetry\":7,\"LongRetry\":4,\"FragmentationThreshold\":2346,\"TxMSDULifetime\":512,\"RxMSDULifetime\":512},"
+	"\"IEEE80211MultiDomainCapability\":{\"FirstChannel\":1,\"NumberChannels\":13,\"MaxTxPowerLevel\":20},"
+	"\"IEEE80211Rateset\":[2,4,11,22,12,18,24,36,48,72,96,108],"
+	"\"IEEE80211SupportedRates\":[2,4,11,22,12,18,24,36,48,72,96,108],"
+	"\"IEEE80211TxPower\":{\"CurrentTxPower\":20},"
+	"\"IEEE80211TXPowerLevel\":[20,17,14,11,8],"
+	"\"IEEE80211WTPRadioConfiguration\":{\"ShortPreamble\":1,\"NumBSSIDs\":8,\"DTIMPeriod\":1,\"BSSID\":\"02:00:00:00:01:00\",\"BeaconPeriod\":100,\"CountryString\":\"IT \"}},"
+	"{\"RadioID\":2,"
+	"\"IEEE80211Antenna\":{\"Diversity\":false,\"Combiner\":3,\"AntennaSelection\":[1,2]},"
+	"\"IEEE80211OFDMControl\":{\"CurrentChan\":36,\"BandSupport\":15,\"TIThreshold\":-82},"
+	"\"IEEE80211MACOperation\":{\"RTSThreshold\":2347,\"ShortRetry\":7,\"LongRetry\":4,\"FragmentationThreshold\":2346,\"TxMSDULifetime\":512,\"RxMSDULifetime\":512},"
+	"\"IEEE80211MultiDomainCapability\":{\"FirstChannel\":36,\"NumberChannels\":4,\"MaxTxPowerLevel\":23},"
+	"\"IEEE80211Rateset\":[12,18,24,36,48,72,96,108],"
+	"\"IEEE80211SupportedRates\":[12,18,24,36,48,72,96,108],"
+	"\"IEEE80211TxPower\":{\"CurrentTxPower\":23},"
+	"\"IEEE80211TXPowerLevel\":[23,20,17,14,11],"
+	"\"IEEE80211WTPRadioConfiguration\":{\"ShortPreamble\":1,\"NumBSSIDs\":8,\"DTIMPeriod\":1,\"BSSID\":\"02:00:00:00:02:00\",\"BeaconPeriod\":100,\"CountryString\":\"IT \"}}],"
+	"\"Profile\":{\"Key\":\"default\",\"Version\":3}}";
+
+/* Param of authorizeStation, see ac_session_action_authorizestation_request */
+static const char bench_station_param[] =
+	"{\"RadioID\":1,\"WLANID\":1,\"Station\":\"02:00:00:00:10:01\"}";
+
+/* Return of authorizeStation, see ac_session_action_authorizestation_response */
+static const char bench_station_result[] =
+	"{\"DataChannelInterface\":{\"Index\":1,\"VLAN\":100},\"CacheTTL\":300,"
+	"\"IEEE80211Station\":{\"RadioID\":1,\"WLANID\":1,\"Address\":\"02:00:00:00:10:01\",\"Capability\":1057,\"AssociationID\":1,"
+	"\"SupportedRates\":[2,4,11,22,12,18,24,36,48,72,96,108]},\"IEEE80211StationQoS\":{\"Priority\":0}}";
+
+/* */
+struct bench_payload {
+	char* method;
+	char* name;
+	const char* param;
+	const char* result;
+
+	/* */
+	struct ac_soap_request* request;
+	char* response;
+	int responselength;
+};
+
+/* */
+static struct bench_payload bench_payloads[] = {
+	{ "joinWTPSession", "join", bench_join_param, bench_join_result },
+	{ "authorizeStation", "station", bench_station_param, bench_station_result },
+};
+
+#define BENCH_PAYLOADS_COUNT				(sizeof(bench_payloads) / sizeof(bench_payloads[0]))
+
+/* */
+static uint64_t bench_nsec(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+/* */
+static int bench_compare_time(const void* a, const void* b) {
+	uint64_t first = *(const uint64_t*)a;
+	uint64_t second = *(const uint64_t*)b;
+
+	return ((first < second) ? -1 : ((first > second) ? 1 : 0));
+}
+
+/* */
+static xmlNodePtr bench_dom_search_child(xmlNodePtr parent, char* prefix, char* name) {
+	xmlNodePtr children;
+
+	for (children = parent->xmlChildrenNode; children; children = children->next) {
+		if ((children->type == XML_ELEMENT_NODE) && !xmlStrcmp(children->name, BAD_CAST name) && (!prefix || (children->ns && !xmlStrcmp(children->ns->prefix, BAD_CAST prefix)))) {
+			break;
+		}
+	}
+
+	return children;
+}
+
+/* Build XML SOAP Request as libxml2 document */
+static char* bench_dom_get_request(struct ac_soap_request* request, int* length) {
+	unsigned long i;
+	char* result = NULL;
+	char* tagMethod;
+	xmlDocPtr xmlDocument;
+	xmlNodePtr xmlRoot;
+	xmlNodePtr xmlBody;
+	xmlNodePtr xmlRequest;
+	xmlBufferPtr buffer;
+
+	/* */
+	xmlDocument = xmlNewDoc(BAD_CAST "1.0");
+	xmlRoot = xmlNewNode(NULL, BAD_CAST "SOAP-ENV:Envelope");
+	xmlNewProp(xmlRoot, BAD_CAST "xmlns:xsd", BAD_CAST "http://www.w3.org/2001/XMLSchema");
+	xmlNewProp(xmlRoot, BAD_CAST "xmlns:xsi", BAD_CAST "http://www.w3.org/2001/XMLSchema-instance");
+	xmlNewProp(xmlRoot, BAD_CAST "xmlns:SOAP-ENC", BAD_CAST "http://schemas.xmlsoap.org/soap/encoding/");
+	xmlNewProp(xmlRoot, BAD_CAST "SOAP-ENV:encodingStyle", BAD_CAST "http://schemas.xmlsoap.org/soap/encoding/");
+	xmlNewProp(xmlRoot, BAD_CAST "xmlns:SOAP-ENV", BAD_CAST SOAP_ENVELOPE_NAMESPACE);
+	xmlNewProp(xmlRoot, BAD_CAST "xmlns:tns", BAD_CAST request->urinamespace);
+	xmlDocSetRootElement(xmlDocument, xmlRoot);
+
+	xmlNewChild(xmlRoot, NULL, BAD_CAST "SOAP-ENV:Header", NULL);
+	xmlBody = xmlNewChild(xmlRoot, NULL, BAD_CAST "SOAP-ENV:Body", NULL);
+
+	/* Create request */
+	tagMethod = capwap_alloc(strlen(request->method) + 5);
+	sprintf(tagMethod, "tns:%s", request->method);
+	xmlRequest = xmlNewChild(xmlBody, NULL, BAD_CAST tagMethod, NULL);
+	capwap_free(tagMethod);
+
+	/* Add params, JSON document is base64 encoded */
+	for (i = 0; i < request->params->count; i++) {
+		xmlNodePtr xmlParam;
+		struct ac_soap_param* param = (struct ac_soap_param*)capwap_array_get_item_pointer(request->params, i);
+
+		if (param->type && !strcmp(param->type, "xs:base64Binary")) {
+			char* base64value = capwap_alloc(AC_BASE64_ENCODE_LENGTH(strlen(param->value)));
+
+			ac_base64_string_encode(param->value, base64value);
+			xmlParam = xmlNewTextChild(xmlRequest, NULL, BAD_CAST param->name, BAD_CAST base64value);
+			capwap_free(base64value);
+		} else {
+			xmlParam = xmlNewTextChild(xmlRequest, NULL, BAD_CAST param->name, BAD_CAST param->value);
+		}
+
+		if (!xmlParam || (param->type && !xmlNewProp(xmlParam, BAD_CAST "xsi:type", BAD_CAST param->type))) {
+			xmlFreeDoc(xmlDocument);
+			return NULL;
+		}
+	}
+
+	/* Clone XML document string */
+	buffer = xmlBufferCreate();
+	*length = xmlNodeDump(buffer, xmlDocument, xmlRoot, 1, 0);
+	if (*length > 0) {
+		result = capwap_alloc(*length + 1);
+		memcpy(result, (char*)xmlBufferContent(buffer), *length);
+		result[*length] = 0;
+	}
+
+	/* */
+	xmlBufferFree(buffer);
+	xmlFreeDoc(xmlDocument);
+	return result;
+}
+
+/* Parsing XML SOAP Response as libxml2 document and decode the JSON return */
+static struct json_object* bench_dom_parse_response(struct ac_soap_request* request, const char* body, int length) {
+	int jsonlength;
+	char* json;
+	char* tagMethod;
+	xmlChar* xmlResult;
+	xmlDocPtr xmlDocument;
+	xmlNodePtr xmlNode;
+	struct json_object* jsonroot = NULL;
+
+	xmlDocument = xmlReadMemory(body, length, "", NULL, 0);
+	if (!xmlDocument) {
+		return NULL;
+	}
+
+	/* Retrieve Body and return */
+	xmlNode = xmlDocGetRootElement(xmlDocument);
+	if (xmlNode) {
+		xmlNode = bench_dom_search_child(xmlNode, "SOAP-ENV", "Body");
+	}
+
+	if (xmlNode) {
+		tagMethod = capwap_alloc(strlen(request->method) + 9);
+		sprintf(tagMethod, "%sResponse", request->method);
+		xmlNode = bench_dom_search_child(xmlNode, NULL, tagMethod);
+		capwap_free(tagMethod);
+	}
+
+	if (xmlNode) {
+		xmlNode = bench_dom_search_child(xmlNode, NULL, "return");
+	}
+
+	/* Decode base64 result */
+	xmlResult = (xmlNode ? xmlNodeGetContent(xmlNode) : NULL);
+	if (xmlResult) {
+		jsonlength = xmlStrlen(xmlResult);
+		if (jsonlength) {
+			json = (char*)capwap_alloc(AC_BASE64_DECODE_LENGTH(jsonlength));
+			ac_base64_string_decode((const char*)xmlResult, json);
+			jsonroot = json_tokener_parse(json);
+			capwap_free(json);
+		}
+
+		xmlFree(xmlResult);
+	}
+
+	xmlFreeDoc(xmlDocument);
+	return jsonroot;
+}
+
+/* Parsing XML SOAP Response with ac_soap.c and decode the JSON return */
+static struct json_object* bench_sax_parse_response(struct ac_http_soap_request* httprequest, const char* body, int length) {
+	struct json_object* jsonroot = NULL;
+	struct ac_soap_response* response;
+
+	response = ac_soapclient_parse_xml_document(httprequest, body, length);
+	if (response) {
+		jsonroot = ac_soapclient_parse_json_response(response);
+		ac_soapclient_free_response(response);
+	}
+
+	return jsonroot;
+}
+
+/* */
+static void bench_init_payload(struct bench_payload* payload) {
+	char* base64result;
+
+	/* Same params of request sent by ac_backend.c */
+	payload->request = ac_soapclient_create_request(payload->method, SOAP_NAMESPACE_URI);
+	ac_soapclient_add_param(payload->request, "xs:string", "idsession", "3f2a8c1d9e6b47a5b0c4d2e8f1a7b3c6");
+	ac_soapclient_add_param(payload->request, "xs:string", "idwtp", "02:00:00:00:00:01");
+	ac_soapclient_add_param(payload->request, "xs:base64Binary", payload->name, payload->param);
+
+	/* */
+	base64result = (char*)capwap_alloc(AC_BASE64_ENCODE_LENGTH(strlen(payload->result)));
+	ac_base64_string_encode(payload->result, base64result);
+
+	payload->responselength = snprintf(NULL, 0, BENCH_RESPONSE_FORMAT, payload->method, base64result, payload->method);
+	payload->response = (char*)capwap_alloc(payload->responselength + 1);
+	sprintf(payload->response, BENCH_RESPONSE_FORMAT, payload->method, base64result, payload->method);
+
+	capwap_free(base64result);
+}
+
+/* Both codec must return the same document */
+static int bench_check_payload(struct bench_payload* payload, struct ac_http_soap_request* httprequest) {
+	int result = 0;
+	struct json_object* jsondom = bench_dom_parse_response(payload->request, payload->response, payload->responselength);
+	struct json_object* jsonsax = bench_sax_parse_response(httprequest, payload->response, payload->responselength);
+
+	if (jsondom && jsonsax && !strcmp(json_object_to_json_string(jsondom), json_object_to_json_string(jsonsax))) {
+		result = 1;
+	}
+
+	if (jsondom) {
+		json_object_put(jsondom);
+	}
+
+	if (jsonsax) {
+		json_object_put(jsonsax);
+	}
+
+	return result;
+}
+
+/* Median time of a single operation in ns */
+static double bench_median(uint64_t* times, int runs, int iterations) {
+	qsort(times, runs, sizeof(uint64_t), bench_compare_time);
+	return (double)times[runs / 2] / iterations;
+}
+
+/* */
+static void bench_usage(const char* name) {
+	fprintf(stderr, "Usage: %s [-n iterations] [-r runs]\n", name);
+	fprintf(stderr, "  -n iterations  operations of every run (default %d)\n", BENCH_DEFAULT_ITERATIONS);
+	fprintf(stderr, "  -r runs        runs, the median is reported (default %d)\n", BENCH_DEFAULT_RUNS);
+}
+
+/* */
+int main(int argc, char** argv) {
+	int i;
+	int j;
+	int opt;
+	int run;
+	int length;
+	char* buffer;
+	uint64_t start;
+	uint64_t* times[4];
+	struct json_object* jsonroot;
+	struct ac_http_soap_request httprequest;
+	int iterations = BENCH_DEFAULT_ITERATIONS;
+	int runs = BENCH_DEFAULT_RUNS;
+
+	while ((opt = getopt(argc, argv, "n:r:h")) != -1) {
+		switch (opt) {
+			case 'n': {
+				iterations = atoi(optarg);
+				break;
+			}
+
+			case 'r': {
+				runs = atoi(optarg);
+				break;
+			}
+
+			default: {
+				bench_usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+
+	if ((iterations <= 0) || (runs <= 0)) {
+		bench_usage(argv[0]);
+		return 1;
+	}
+
+	/* */
+	capwap_logging_init();
+	ac_soapclient_init();
+
+	for (i = 0; i < 4; i++) {
+		times[i] = (uint64_t*)malloc(sizeof(uint64_t) * runs);
+		if (!times[i]) {
+			return 1;
+		}
+	}
+
+	for (i = 0; i < BENCH_PAYLOADS_COUNT; i++) {
+		struct bench_payload* payload = &bench_payloads[i];
+
+		bench_init_payload(payload);
+
+		/* HTTP response was received */
+		memset(&httprequest, 0, sizeof(struct ac_http_soap_request));
+		httprequest.request = payload->request;
+		httprequest.responsecode = HTTP_RESULT_OK;
+
+		if (!bench_check_payload(payload, &httprequest)) {
+			fprintf(stderr, "Mismatch of %s response\n", payload->method);
+			return 1;
+		}
+
+		/* */
+		for (run = 0; run < runs; run++) {
+			/* Encode with DOM */
+			start = bench_nsec();
+			for (j = 0; j < iterations; j++) {
+				buffer = bench_dom_get_request(payload->request, &length);
+				capwap_free(buffer);
+			}
+
+			times[0][run] = bench_nsec() - start;
+
+			/* Encode with template */
+			start = bench_nsec();
+			for (j = 0; j < iterations; j++) {
+				buffer = ac_soapclient_get_request(payload->request, SOAP_TRANSPORT_XML, &length);
+				capwap_free(buffer);
+			}
+
+			times[1][run] = bench_nsec() - start;
+
+			/* Decode with DOM */
+			start = bench_nsec();
+			for (j = 0; j < iterations; j++) {
+				jsonroot = bench_dom_parse_response(payload->request, payload->response, payload->responselength);
+				json_object_put(jsonroot);
+			}
+
+			times[2][run] = bench_nsec() - start;
+
+			/* Decode with SAX */
+			start = bench_nsec();
+			for (j = 0; j < iterations; j++) {
+				jsonroot = bench_sax_parse_response(&httprequest, payload->response, payload->responselength);
+				json_object_put(jsonroot);
+			}
+
+			times[3][run] = bench_nsec() - start;
+		}
+
+		/* */
+		buffer = ac_soapclient_get_request(payload->request, SOAP_TRANSPORT_XML, &length);
+		capwap_free(buffer);
+
+		printf("%s: request %d bytes, response %d bytes\n", payload->method, length, payload->responselength);
+		printf("  encode: dom %.2f us, template %.2f us\n", bench_median(times[0], runs, iterations) / 1000.0, bench_median(times[1], runs, iterations) / 1000.0);
+		printf("  decode: dom %.2f us, sax %.2f us\n", bench_median(times[2], runs, iterations) / 1000.0, bench_median(times[3], runs, iterations) / 1000.0);
+
+		/* */
+		ac_soapclient_free_request(payload->request);
+		capwap_free(payload->response);
+	}
+
+	/* */
+	for (i = 0; i < 4; i++) {
+		free(times[i]);
+	}
+
+	ac_soapclient_free();
+	capwap_logging_close();
+
+	return 0;
+}
@@ -1,8 +1,13 @@
 #include "config.h"
+#include <linux/version.h>
 #include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/jhash.h>
+#include <linux/random.h>
 #include <linux/if_ether.h>
 #include <linux/etherdevice.h>
 #include <linux/ieee80211.h>
+#include <net/udp_tunnel.h>
 #include "socket.h"
 #include "capwap.h"
 #include "nlsmartcapwap.h"
@@ -17,90 +22,171 @@ static unsigned char sc_rfc1042_header[] = { 0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00
 /* Bridge-Tunnel header (for EtherTypes ETH_P_AARP and ETH_P_IPX) */
 static unsigned char sc_bridge_tunnel_header[] = { 0xaa, 0xaa, 0x03, 0x00, 0x00, 0xf8 };
 
+/* Fragment queues of all sessions */
+struct sc_capwap_fragment_bucket {
+	spinlock_t lock;
+	struct hlist_head chain;
+};
+
+static struct sc_capwap_fragment_bucket sc_fragment_hash[CAPWAP_FRAGMENT_HASH_SIZE];
+static uint32_t sc_fragment_rnd;
+
+/* LRU of fragment queues in order of creation, nested into lock of bucket */
+static DEFINE_SPINLOCK(sc_fragment_lru_lock);
+static LIST_HEAD(sc_fragment_lru_list);
+
 /* */
-static void sc_capwap_fragment_free(struct sc_capwap_fragment* fragment) {
-	TRACEKMOD("### sc_capwap_fragment_free\n");
+static atomic_t sc_fragment_mem = ATOMIC_INIT(0);
+static atomic_t sc_fragment_timeouts = ATOMIC_INIT(0);
+static atomic_t sc_fragment_evictions = ATOMIC_INIT(0);
 
-	/* */
-	list_del(&fragment->lru_list);
-	fragment->flags = 0;
+/* Memory limits of fragments, when exceeded the high threshold the oldest queues are evicted up to low threshold */
+static int sc_capwap_fragment_high_thresh = CAPWAP_FRAGMENT_HIGH_THRESH;
+module_param_named(fragment_high_thresh, sc_capwap_fragment_high_thresh, int, 0644);
+MODULE_PARM_DESC(fragment_high_thresh, "Maximum memory used to reassemble data packets");
+
+static int sc_capwap_fragment_low_thresh = CAPWAP_FRAGMENT_LOW_THRESH;
+module_param_named(fragment_low_thresh, sc_capwap_fragment_low_thresh, int, 0644);
+MODULE_PARM_DESC(fragment_low_thresh, "Memory used to reassemble data packets after an eviction");
+
+static int sc_capwap_fragment_session_thresh = CAPWAP_FRAGMENT_SESSION_THRESH;
+module_param_named(fragment_session_thresh, sc_capwap_fragment_session_thresh, int, 0644);
+MODULE_PARM_DESC(fragment_session_thresh, "Maximum memory used to reassemble data packets of a session");
+
+/* */
+static uint32_t sc_capwap_fragment_hash(struct sc_capwap_session* session, uint16_t fragmentid) {
+	TRACEKMOD("### sc_capwap_fragment_hash\n");
+
+	return jhash_3words((uint32_t)(unsigned long)session, (uint32_t)((uint64_t)(unsigned long)session >> 32), fragmentid, sc_fragment_rnd) & (CAPWAP_FRAGMENT_HASH_SIZE - 1);
+}
+
+/* */
+static void sc_capwap_fragment_put(struct sc_capwap_fragment* fragment) {
+	TRACEKMOD("### sc_capwap_fragment_put\n");
+
+	if (atomic_dec_and_test(&fragment->refcnt)) {
+		/* Free socket buffer */
+		while (fragment->fragments) {
+			struct sk_buff* next = fragment->fragments->next;
+
+			kfree_skb(fragment->fragments);
+			fragment->fragments = next;
+		}
+
+		kfree(fragment);
+	}
+}
+
+/* Remove fragment queue from hash and LRU, require lock of bucket */
+static void sc_capwap_fragment_kill(struct sc_capwap_fragment* fragment) {
+	TRACEKMOD("### sc_capwap_fragment_kill\n");
 
-	/* Free socket buffer */
-	while (fragment->fragments) {
-		struct sk_buff* next = fragment->fragments->next;
+	if (!(fragment->flags & CAPWAP_FRAGMENT_COMPLETE)) {
+		fragment->flags |= CAPWAP_FRAGMENT_COMPLETE;
+		hlist_del(&fragment->hash_list);
 
-		kfree_skb(fragment->fragments);
-		fragment->fragments = next;
+		spin_lock(&sc_fragment_lru_lock);
+		list_del(&fragment->lru_list);
+		spin_unlock(&sc_fragment_lru_lock);
+
+		/* */
+		atomic_sub(fragment->truesize, &fragment->session->fragments.mem);
+		atomic_sub(fragment->truesize, &sc_fragment_mem);
+
+		/* Release reference of hash */
+		sc_capwap_fragment_put(fragment);
 	}
 }
 
 /* */
-static void sc_capwap_defrag_evictor(struct sc_capwap_session* session, ktime_t now) {
+static void sc_capwap_fragment_evictor(ktime_t now) {
+	int timeout;
 	ktime_t delta;
 	struct sc_capwap_fragment* fragment;
-	struct list_head* list = &session->fragments.lru_list;
+	struct sc_capwap_fragment_bucket* bucket;
+	int force = (atomic_read(&sc_fragment_mem) > sc_capwap_fragment_high_thresh);
 
-	TRACEKMOD("### sc_capwap_defrag_evictor\n");
+	TRACEKMOD("### sc_capwap_fragment_evictor\n");
 
-	/* Light check without lock */
-	if (!list_empty(list)) {
-		spin_lock(&session->fragments.lock);
+	for (;;) {
+		spin_lock_bh(&sc_fragment_lru_lock);
 
-		/* Remove last old fragment */
-		if (!list_empty(list)) {
-			fragment = list_first_entry(list, struct sc_capwap_fragment, lru_list);
-			delta = ktime_sub(now, fragment->tstamp);
-			if ((delta.tv64 < -NSEC_PER_SEC) || (delta.tv64 > NSEC_PER_SEC)) {
-				TRACEKMOD("*** Expired fragment %hu (%llu %llu)\n", fragment->fragmentid, now.tv64, fragment->tstamp.tv64);
-				sc_capwap_fragment_free(fragment);
-			}
+		/* Oldest fragment queue */
+		fragment = list_first_entry_or_null(&sc_fragment_lru_list, struct sc_capwap_fragment, lru_list);
+		if (!fragment) {
+			spin_unlock_bh(&sc_fragment_lru_lock);
+			break;
 		}
 
-		spin_unlock(&session->fragments.lock);
+		/* */
+		delta = ktime_sub(now, fragment->tstamp);
+		timeout = ((delta.tv64 < -CAPWAP_FRAGMENT_TIMEOUT) || (delta.tv64 > CAPWAP_FRAGMENT_TIMEOUT));
+		if (!timeout && (!force || (atomic_read(&sc_fragment_mem) <= sc_capwap_fragment_low_thresh))) {
+			spin_unlock_bh(&sc_fragment_lru_lock);
+			break;
+		}
+
+		atomic_inc(&fragment->refcnt);
+		spin_unlock_bh(&sc_fragment_lru_lock);
+
+		/* */
+		bucket = &sc_fragment_hash[fragment->hash];
+		spin_lock_bh(&bucket->lock);
+
+		if (!(fragment->flags & CAPWAP_FRAGMENT_COMPLETE)) {
+			TRACEKMOD("*** %s fragment %hu\n", (timeout ? "Expired" : "Evicted"), fragment->fragmentid);
+			atomic_inc(timeout ? &sc_fragment_timeouts : &sc_fragment_evictions);
+			sc_capwap_fragment_kill(fragment);
+		}
+
+		spin_unlock_bh(&bucket->lock);
+		sc_capwap_fragment_put(fragment);
 	}
 }
 
 /* */
 static struct sk_buff* sc_capwap_reasm(struct sc_capwap_fragment* fragment) {
-	int len;
-	int offset;
-	struct sk_buff* skb;
+	struct sk_buff* skb = fragment->fragments;
 	struct sk_buff* skbfrag;
 	struct sc_capwap_header* header;
 
 	TRACEKMOD("### sc_capwap_reasm\n");
 
-	/* */
-	skbfrag = fragment->fragments;
-	len = GET_HLEN_HEADER((struct sc_capwap_header*)skbfrag->data) * 4;
-
-	/* Create new packet */
-	skb = alloc_skb(len + fragment->totallength, GFP_KERNEL);
-	if (!skb) {
+	/* The first fragment is the head of reassembled packet and its capwap header is changed */
+	if (skb_unclone(skb, GFP_ATOMIC)) {
 		return NULL;
 	}
 
-	/* The first capwap header is header of reassembled packet without fragment field */
-	header = (struct sc_capwap_header*)skb_put(skb, len);
-	memcpy(header, skbfrag->data, len);
-
-	SET_FLAG_F_HEADER(header, 0);
-	SET_FLAG_L_HEADER(header, 0);
-	header->frag_id = (__be16)0;
-	header->frag_off = (__be16)0;
+	/* Chain the body of other fragments without copy */
+	skbfrag = skb->next;
+	skb->next = NULL;
+	skb_shinfo(skb)->frag_list = skbfrag;
 
-	/* Copy body */
 	while (skbfrag) {
-		offset = GET_HLEN_HEADER((struct sc_capwap_header*)skbfrag->data) * 4;
-		len = skbfrag->len - offset;
+		skb_pull(skbfrag, GET_HLEN_HEADER((struct sc_capwap_header*)skbfrag->data) * 4);
 
-		TRACEKMOD("*** Append fragment size %d\n", len);
+		TRACEKMOD("*** Append fragment size %d\n", skbfrag->len);
 
 		/* */
-		memcpy(skb_put(skb, len), skbfrag->data + offset, len);
+		skb->len += skbfrag->len;
+		skb->data_len += skbfrag->len;
+		skb->truesize += skbfrag->truesize;
 		skbfrag = skbfrag->next;
 	}
 
+	fragment->fragments = NULL;
+	fragment->lastfragment = NULL;
+
+	/* Capwap header without fragment field */
+	header = (struct sc_capwap_header*)skb->data;
+	SET_FLAG_F_HEADER(header, 0);
+	SET_FLAG_L_HEADER(header, 0);
+	header->frag_id = (__be16)0;
+	header->frag_off = (__be16)0;
+
+	/* The checksum of data channel does not cover the reassembled packet */
+	skb->ip_summed = CHECKSUM_NONE;
+
 	TRACEKMOD("*** Assemblate capwap data packet with total size %d\n", skb->len);
 
 	return skb;
@@ -113,6 +199,7 @@ static struct sk_buff* sc_capwap_defrag(struct sc_capwap_session* session, struc
 	struct sk_buff* prev;
 	struct sk_buff* next;
 	struct sc_capwap_fragment* fragment;
+	struct sc_capwap_fragment_bucket* bucket;
 	struct sc_skb_capwap_cb* cb;
 	struct sk_buff* skb_defrag = NULL;
 	struct sc_capwap_header* header = (struct sc_capwap_header*)skb->data;
@@ -134,26 +221,54 @@ static struct sk_buff* sc_capwap_defrag(struct sc_capwap_session* session, struc
 	cb->frag_offset = be16_to_cpu(header->frag_off);
 	cb->frag_length = skb->len - headersize;
 
+	/* The fragment is owned by reassembled packet */
+	skb_orphan(skb);
+
+	/* Cleaning old fragments */
+	if (!skb->tstamp.tv64) {
+		skb->tstamp = ktime_get();
+	}
+
+	sc_capwap_fragment_evictor(skb->tstamp);
+
 	/* */
-	spin_lock(&session->fragments.lock);
+	bucket = &sc_fragment_hash[sc_capwap_fragment_hash(session, frag_id)];
+	spin_lock_bh(&bucket->lock);
 	TRACEKMOD("*** Fragment info: id %hu offset %hu length %hu\n", frag_id, cb->frag_offset, cb->frag_length);
 
 	/* Get fragment */
-	fragment = &session->fragments.queues[frag_id % CAPWAP_FRAGMENT_QUEUE];
-	if ((fragment->flags & CAPWAP_FRAGMENT_ENABLE) && (fragment->fragmentid != frag_id)) {
-		TRACEKMOD("*** Unable defrag, queue fragment busy\n");
-		goto error2;	/* Queue fragment busy*/
+	hlist_for_each_entry(fragment, &bucket->chain, hash_list) {
+		if ((fragment->session == session) && (fragment->fragmentid == frag_id)) {
+			break;
+		}
 	}
 
 	/* Init fragment */
-	if (!(fragment->flags & CAPWAP_FRAGMENT_ENABLE)) {
-		fragment->flags = CAPWAP_FRAGMENT_ENABLE;
+	if (!fragment) {
+		fragment = (struct sc_capwap_fragment*)kzalloc(sizeof(struct sc_capwap_fragment), GFP_ATOMIC);
+		if (!fragment) {
+			TRACEKMOD("*** Unable defrag, no memory for fragment queue\n");
+			goto error2;
+		}
+
+		atomic_set(&fragment->refcnt, 1);
+		fragment->hash = bucket - sc_fragment_hash;
+		fragment->session = session;
 		fragment->fragmentid = frag_id;
-		fragment->fragments = NULL;
-		fragment->lastfragment = NULL;
-		fragment->recvlength = 0;
-		fragment->totallength = 0;
-		list_add_tail(&fragment->lru_list, &session->fragments.lru_list);
+		fragment->tstamp = skb->tstamp;
+		hlist_add_head(&fragment->hash_list, &bucket->chain);
+
+		spin_lock(&sc_fragment_lru_lock);
+		list_add_tail(&fragment->lru_list, &sc_fragment_lru_list);
+		spin_unlock(&sc_fragment_lru_lock);
+	}
+
+	/* Memory limit of session */
+	if ((atomic_read(&session->fragments.mem) + skb->truesize) > sc_capwap_fragment_session_thresh) {
+		TRACEKMOD("*** Unable defrag, memory limit of session\n");
+		atomic_inc(&sc_fragment_evictions);
+		sc_capwap_fragment_kill(fragment);
+		goto error2;
 	}
 
 	/* Search fragment position */
@@ -164,7 +279,7 @@ static struct sk_buff* sc_capwap_defrag(struct sc_capwap_session* session, struc
 		if ((CAPWAP_SKB_CB(prev)->frag_offset + CAPWAP_SKB_CB(prev)->frag_length) <= cb->frag_offset) {
 			next = NULL;
 		} else {
-			sc_capwap_fragment_free(fragment);
+			sc_capwap_fragment_kill(fragment);
 			TRACEKMOD("*** Unable defrag, overlap error\n");
 			goto error2;	/* Overlap error */
 		}
@@ -180,7 +295,7 @@ static struct sk_buff* sc_capwap_defrag(struct sc_capwap_session* session, struc
 				if ((cb->frag_offset + cb->frag_length) <= next_cb->frag_offset) {
 					break;
 				} else {
-					sc_capwap_fragment_free(fragment);
+					sc_capwap_fragment_kill(fragment);
 					TRACEKMOD("*** Unable defrag, overlap error\n");
 					goto error2;	/* Overlap error */
 				}
@@ -204,6 +319,10 @@ static struct sk_buff* sc_capwap_defrag(struct sc_capwap_session* session, struc
 	}
 
 	/* Update size */
+	fragment->truesize += skb->truesize;
+	atomic_add(skb->truesize, &session->fragments.mem);
+	atomic_add(skb->truesize, &sc_fragment_mem);
+
 	fragment->recvlength += cb->frag_length;
 	if (IS_FLAG_L_HEADER(header)) {
 		fragment->totallength = cb->frag_offset + cb->frag_length;
@@ -215,24 +334,15 @@ static struct sk_buff* sc_capwap_defrag(struct sc_capwap_session* session, struc
 		skb_defrag = sc_capwap_reasm(fragment);
 
 		/* Free fragment complete */
-		sc_capwap_fragment_free(fragment);
-	} else {
-		/* Update timeout */
-		fragment->tstamp = skb->tstamp;
-		TRACEKMOD("*** Fragment id %hu expire at %llu\n", frag_id, fragment->tstamp.tv64);
-
-		/* Set LRU timeout */
-		if (!list_is_last(&fragment->lru_list, &session->fragments.lru_list)) {
-			list_move_tail(&fragment->lru_list, &session->fragments.lru_list);
-		}
+		sc_capwap_fragment_kill(fragment);
 	}
 
-	spin_unlock(&session->fragments.lock);
+	spin_unlock_bh(&bucket->lock);
 
 	return skb_defrag;
 
 error2:
-	spin_unlock(&session->fragments.lock);
+	spin_unlock_bh(&bucket->lock);
 
 error:
 	kfree_skb(skb);
@@ -403,23 +513,54 @@ void sc_capwap_initsession(struct sc_capwap_session* session) {
 
 	/* Defragment packets */
 	memset(&session->fragments, 0, sizeof(struct sc_capwap_fragment_queue));
-	INIT_LIST_HEAD(&session->fragments.lru_list);
-	spin_lock_init(&session->fragments.lock);
+	atomic_set(&session->fragments.mem, 0);
 }
 
 /* */
 void sc_capwap_freesession(struct sc_capwap_session* session) {
-	struct sc_capwap_fragment* temp;
+	unsigned long i;
+	struct hlist_node* temp;
 	struct sc_capwap_fragment* fragment;
 
 	TRACEKMOD("### sc_capwap_freesession\n");
 
-	/* Free socket buffers */
-	list_for_each_entry_safe(fragment, temp, &session->fragments.lru_list, lru_list) {
-		sc_capwap_fragment_free(fragment);
+	/* Free fragment queues of session */
+	for (i = 0; (i < CAPWAP_FRAGMENT_HASH_SIZE) && atomic_read(&session->fragments.mem); i++) {
+		spin_lock_bh(&sc_fragment_hash[i].lock);
+
+		hlist_for_each_entry_safe(fragment, temp, &sc_fragment_hash[i].chain, hash_list) {
+			if (fragment->session == session) {
+				sc_capwap_fragment_kill(fragment);
+			}
+		}
+
+		spin_unlock_bh(&sc_fragment_hash[i].lock);
 	}
 }
 
+/* */
+void sc_capwap_fragment_init(void) {
+	unsigned long i;
+
+	TRACEKMOD("### sc_capwap_fragment_init\n");
+
+	for (i = 0; i < CAPWAP_FRAGMENT_HASH_SIZE; i++) {
+		spin_lock_init(&sc_fragment_hash[i].lock);
+		INIT_HLIST_HEAD(&sc_fragment_hash[i].chain);
+	}
+
+	get_random_bytes(&sc_fragment_rnd, sizeof(uint32_t));
+}
+
+/* */
+void sc_capwap_fragment_stats(struct sc_capwap_fragment_stats* stats) {
+	TRACEKMOD("### sc_capwap_fragment_stats\n");
+
+	stats->memory = atomic_read(&sc_fragment_mem);
+	stats->timeouts = atomic_read(&sc_fragment_timeouts);
+	stats->evictions = atomic_read(&sc_fragment_evictions);
+}
+
 /* */
 uint16_t sc_capwap_newfragmentid(struct sc_capwap_session* session) {
 	uint16_t fragmentid;
@@ -491,8 +632,8 @@ int sc_capwap_parsingpacket(struct sc_capwap_session* session, const union capwa
 
 	TRACEKMOD("### sc_capwap_parsingpacket\n");
 
-	/* Linearize socket buffer */
-	if (skb_linearize(skb)) {
+	/* Linearize socket buffer, the aggregated packet by GRO requires only linear headers */
+	if (skb_is_gso(skb) ? !pskb_may_pull(skb, sizeof(struct sc_capwap_header) + ETH_HLEN) : skb_linearize(skb)) {
 		TRACEKMOD("*** Unable to linearize packet\n");
 		return -EINVAL;
 	}
@@ -573,20 +714,19 @@ int sc_capwap_parsingpacket(struct sc_capwap_session* session, const union capwa
 			headersize -= msglength;
 		}
 	} else if (session) {
-		if (!skb->tstamp.tv64) {
-			skb->tstamp = ktime_get();
-		}
-
-		/* Cleaning old fragments */
-		sc_capwap_defrag_evictor(session, skb->tstamp);
-
-		/* */
 		if (IS_FLAG_F_HEADER(header)) {
 			skb = sc_capwap_defrag(session, skb);
 			if (!skb) {
 				return 0;
 			}
 
+			/* The body of reassembled packet is into frag_list, pull only the headers */
+			header = (struct sc_capwap_header*)skb->data;
+			if (!pskb_may_pull(skb, min_t(unsigned int, skb->len, GET_HLEN_HEADER(header) * 4 + CAPWAP_FRAGMENT_PULL_LENGTH))) {
+				kfree_skb(skb);
+				return 0;
+			}
+
 			/* Get new header info */
 			header = (struct sc_capwap_header*)skb->data;
 		}
@@ -611,37 +751,146 @@ int sc_capwap_parsingpacket(struct sc_capwap_session* session, const union capwa
 }
 
 /* */
+static int sc_capwap_setheader(struct sc_capwap_header* header, uint8_t radioid, uint8_t binding, uint32_t flags, struct sc_capwap_radio_addr* radioaddr, int radioaddrlength, struct sc_capwap_wireless_information* winfo, int winfolength) {
+	int size = sizeof(struct sc_capwap_header);
+	uint8_t* headeroption = (uint8_t*)header + sizeof(struct sc_capwap_header);
+
+	memset(header, 0, sizeof(struct sc_capwap_header));
+	SET_VERSION_HEADER(header, CAPWAP_PROTOCOL_VERSION);
+	SET_TYPE_HEADER(header, CAPWAP_PREAMBLE_HEADER);
+	SET_WBID_HEADER(header, binding);
+	SET_RID_HEADER(header, radioid);
+	SET_FLAG_T_HEADER(header, ((flags & NLSMARTCAPWAP_FLAGS_TUNNEL_8023) ? 0 : 1));
+
+	if (radioaddr) {
+		SET_FLAG_M_HEADER(header, 1);
+		memcpy(headeroption, radioaddr, radioaddrlength);
+		headeroption += radioaddrlength;
+		size += radioaddrlength;
+	}
+
+	if (winfo) {
+		SET_FLAG_W_HEADER(header, 1);
+		memcpy(headeroption, winfo, winfolength);
+		headeroption += winfolength;
+		size += winfolength;
+	}
+
+	SET_HLEN_HEADER(header, size / 4);
+	return size;
+}
+
+/* Send the packet with CAPWAP header in headroom, without copy of payload */
+static int sc_capwap_forwardskb(struct sc_capwap_session* session, uint8_t radioid, uint8_t binding, struct sk_buff* skb, uint32_t flags, struct sc_capwap_radio_addr* radioaddr, int radioaddrlength, struct sc_capwap_wireless_information* winfo, int winfolength) {
+	int err;
+	struct sc_capwap_header* header;
+	int reserve = sizeof(struct sc_capwap_header) + radioaddrlength + winfolength;
+
+	TRACEKMOD("### sc_capwap_forwardskb\n");
+
+	/* Copy only the header of cloned packet or without headroom */
+	if (skb_cow_head(skb, reserve + SOCKET_SKB_HEADROOM)) {
+		TRACEKMOD("*** Unable to expand headroom\n");
+		kfree_skb(skb);
+		return -ENOMEM;
+	}
+
+	/* The GSO packet is segmented by device or stack after the UDP/IP encapsulation */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,6,0)
+	err = udp_tunnel_handle_offloads(skb, true);
+	if (err) {
+		kfree_skb(skb);
+		return err;
+	}
+#else
+	skb = udp_tunnel_handle_offloads(skb, true);
+	if (IS_ERR(skb)) {
+		return PTR_ERR(skb);
+	}
+#endif
+
+	header = (struct sc_capwap_header*)skb_push(skb, reserve);
+	sc_capwap_setheader(header, radioid, binding, flags, radioaddr, radioaddrlength, winfo, winfolength);
+
+	/* */
+	err = sc_socket_send_skb(SOCKET_UDP, skb, &session->peeraddr);
+	TRACEKMOD("*** Send packet result: %d\n", err);
+	return ((err < 0) ? err : 0);
+}
+
+/* */
+static int sc_capwap_forwardgso(struct sc_capwap_session* session, uint8_t radioid, uint8_t binding, struct sk_buff* skb, uint32_t flags, struct sc_capwap_radio_addr* radioaddr, int radioaddrlength, struct sc_capwap_wireless_information* winfo, int winfolength) {
+	int err = 0;
+	struct sk_buff* next;
+	struct sk_buff* segs;
+	int reserve = sizeof(struct sc_capwap_header) + radioaddrlength + winfolength;
+
+	TRACEKMOD("### sc_capwap_forwardgso\n");
+
+	/* The segments replicate the CAPWAP header and every one must be into MTU */
+	if ((session->peeraddr.ss.ss_family == AF_INET) && ((reserve + skb_network_offset(skb) + skb_gso_network_seglen(skb)) <= session->mtu)) {
+		return sc_capwap_forwardskb(session, radioid, binding, skb, flags, radioaddr, radioaddrlength, winfo, winfolength);
+	}
+
+	/* Software segmentation */
+	segs = skb_gso_segment(skb, 0);
+	kfree_skb(skb);
+
+	if (IS_ERR_OR_NULL(segs)) {
+		TRACEKMOD("*** Unable to segment GSO packet\n");
+		return (segs ? PTR_ERR(segs) : -EINVAL);
+	}
+
+	while (segs) {
+		next = segs->next;
+		segs->next = NULL;
+
+		if (!err) {
+			err = sc_capwap_forwarddata(session, radioid, binding, segs, flags, radioaddr, radioaddrlength, winfo, winfolength);
+		} else {
+			kfree_skb(segs);
+		}
+
+		segs = next;
+	}
+
+	return err;
+}
+
+/* The packet is always consumed */
 int sc_capwap_forwarddata(struct sc_capwap_session* session, uint8_t radioid, uint8_t binding, struct sk_buff* skb, uint32_t flags, struct sc_capwap_radio_addr* radioaddr, int radioaddrlength, struct sc_capwap_wireless_information* winfo, int winfolength) {
 	int err;
 	int size;
 	int length;
 	int reserve;
-	int headroom;
 	int requestfragment;
 	__be16 fragmentid = 0;
 	int fragmentoffset = 0;
 	struct sc_capwap_header* header;
-	struct sk_buff* clone = NULL;
 	int packetlength = skb->len;
 
 	TRACEKMOD("### sc_capwap_forwarddata\n");
 
-	/* Check headroom */
-	headroom = skb_headroom(skb);
-	reserve = sizeof(struct sc_capwap_header) + radioaddrlength + winfolength;
-	if (skb_is_nonlinear(skb) || (headroom < reserve)) {
-		TRACEKMOD("*** Copy socket buffer and expand headroom of: %d\n", (reserve - headroom));
-		clone = skb_copy_expand(skb, max(headroom, reserve), skb_tailroom(skb), GFP_KERNEL);
-		if (!clone) {
-			TRACEKMOD("*** Unable to copy socket buffer\n");
-			return -ENOMEM;
-		}
-
-		skb = clone;
+	/* GSO packet is sent as one packet for all segments */
+	if (skb_is_gso(skb)) {
+		return sc_capwap_forwardgso(session, radioid, binding, skb, flags, radioaddr, radioaddrlength, winfo, winfolength);
 	}
 
 	/* Check MTU */
+	reserve = sizeof(struct sc_capwap_header) + radioaddrlength + winfolength;
 	requestfragment = (((packetlength + reserve) > session->mtu) ? 1 : 0);
+	if (!requestfragment && (session->peeraddr.ss.ss_family == AF_INET)) {
+		return sc_capwap_forwardskb(session, radioid, binding, skb, flags, radioaddr, radioaddrlength, winfo, winfolength);
+	}
+
+	/* The fragment headers are written into the body of packet, the data must be linear and not shared */
+	if (skb_linearize(skb) || skb_cow_head(skb, reserve) || ((skb->ip_summed == CHECKSUM_PARTIAL) && skb_checksum_help(skb))) {
+		TRACEKMOD("*** Unable to linearize socket buffer\n");
+		kfree_skb(skb);
+		return -ENOMEM;
+	}
+
+	/* */
 	if (requestfragment) {
 		fragmentid = cpu_to_be16(sc_capwap_newfragmentid(session));
 	}
@@ -649,33 +898,11 @@ int sc_capwap_forwarddata(struct sc_capwap_session* session, uint8_t radioid, ui
 	/* */
 	header = (struct sc_capwap_header*)skb_push(skb, sizeof(struct sc_capwap_header) + radioaddrlength + winfolength);
 	while (packetlength > 0) {
-		memset(header, 0, sizeof(struct sc_capwap_header));
-		SET_VERSION_HEADER(header, CAPWAP_PROTOCOL_VERSION);
-		SET_TYPE_HEADER(header, CAPWAP_PREAMBLE_HEADER);
-		SET_WBID_HEADER(header, binding);
-		SET_RID_HEADER(header, radioid);
-		SET_FLAG_T_HEADER(header, ((flags & NLSMARTCAPWAP_FLAGS_TUNNEL_8023) ? 0 : 1));
-
+		/* The options are only into first fragment */
 		if (!fragmentoffset) {
-			uint8_t* headeroption = (uint8_t*)header + sizeof(struct sc_capwap_header);
-
-			if (radioaddr) {
-				SET_FLAG_M_HEADER(header, 1);
-				memcpy(headeroption, radioaddr, radioaddrlength);
-				headeroption += radioaddrlength;
-			}
-
-			if (winfo) {
-				SET_FLAG_W_HEADER(header, 1);
-				memcpy(headeroption, winfo, winfolength);
-				headeroption += winfolength;
-			}
-
-			size = sizeof(struct sc_capwap_header) + radioaddrlength + winfolength;
-			SET_HLEN_HEADER(header, size / 4);
+			size = sc_capwap_setheader(header, radioid, binding, flags, radioaddr, radioaddrlength, winfo, winfolength);
 		} else {
-			size = sizeof(struct sc_capwap_header);
-			SET_HLEN_HEADER(header, size / 4);
+			size = sc_capwap_setheader(header, radioid, binding, flags, NULL, 0, NULL, 0);
 		}
 
 		/* Calculate body size */
@@ -712,10 +939,7 @@ int sc_capwap_forwarddata(struct sc_capwap_session* session, uint8_t radioid, ui
 		packetlength -= length;
 	}
 
-	if (clone) {
-		kfree_skb(clone);
-	}
-
+	kfree_skb(skb);
 	return (!packetlength ? 0 : -EIO);
 }
 
@@ -11,12 +11,18 @@
 #define IEEE80211_MTU				7981
 
 /* */
-#define CAPWAP_FRAGMENT_QUEUE		16
+#define CAPWAP_FRAGMENT_HASH_SIZE			1024
+#define CAPWAP_FRAGMENT_TIMEOUT				NSEC_PER_SEC
+#define CAPWAP_FRAGMENT_HIGH_THRESH			(4 * 1024 * 1024)
+#define CAPWAP_FRAGMENT_LOW_THRESH			(3 * 1024 * 1024)
+#define CAPWAP_FRAGMENT_SESSION_THRESH		(256 * 1024)
+
+/* Linear headers of reassembled packet: IEEE 802.11 header (4 address, QoS and HT) with LLC/SNAP */
+#define CAPWAP_FRAGMENT_PULL_LENGTH			(36 + 8)
 
 /* */
-#define CAPWAP_FRAGMENT_ENABLE		0x0001
-#define CAPWAP_FRAGMENT_LRUQUEUE	0x0002
-#define CAPWAP_FRAGMENT_LAST		0x0004
+#define CAPWAP_FRAGMENT_LAST		0x0001
+#define CAPWAP_FRAGMENT_COMPLETE	0x0002
 
 /* */
 #define SKB_CAPWAP_FLAG_FROM_DATA_CHANNEL			0x0001
@@ -54,25 +60,34 @@ struct sc_skb_capwap_cb {
 
 /* */
 struct sc_capwap_fragment {
+	struct hlist_node hash_list;
 	struct list_head lru_list;
+	atomic_t refcnt;
+	uint32_t hash;
+
+	struct sc_capwap_session* session;
+	uint16_t fragmentid;
 
 	uint8_t flags;
 	ktime_t tstamp;
 
-	uint16_t fragmentid;
-
 	struct sk_buff* fragments;
 	struct sk_buff* lastfragment;
 	int recvlength;
 	int totallength;
+	int truesize;
 };
 
 /* */
 struct sc_capwap_fragment_queue {
-	spinlock_t lock;
+	atomic_t mem;
+};
 
-	struct list_head lru_list;
-	struct sc_capwap_fragment queues[CAPWAP_FRAGMENT_QUEUE];
+/* */
+struct sc_capwap_fragment_stats {
+	uint32_t memory;
+	uint32_t timeouts;
+	uint32_t evictions;
 };
 
 /* */
@@ -104,6 +119,9 @@ void sc_capwap_initsession(struct sc_capwap_session* session);
 void sc_capwap_freesession(struct sc_capwap_session* session);
 uint16_t sc_capwap_newfragmentid(struct sc_capwap_session* session);
 
+void sc_capwap_fragment_init(void);
+void sc_capwap_fragment_stats(struct sc_capwap_fragment_stats* stats);
+
 int sc_capwap_8023_to_80211(struct sk_buff* skb, const uint8_t* bssid);
 int sc_capwap_80211_to_8023(struct sk_buff* skb);
 
@@ -1,6 +1,7 @@
 #include "config.h"
+#include <linux/version.h>
 #include <linux/module.h>
-#include <linux/hash.h>
+#include <linux/jhash.h>
 #include <linux/slab.h>
 #include <linux/kthread.h>
 #include <linux/if_ether.h>
@@ -8,6 +9,11 @@
 #include <linux/etherdevice.h>
 #include <linux/smp.h>
 #include <linux/lockdep.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+#include <linux/rhashtable.h>
+#else
+#include <linux/hash.h>
+#endif
 #include <net/ipv6.h>
 #include <net/cfg80211.h>
 #include "socket.h"
@@ -18,8 +24,10 @@
 #include "station.h"
 
 /* */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,1,0)
 #define SESSION_HASH_SIZE_SHIFT				16
 #define SESSION_HASH_SIZE					(1 << SESSION_HASH_SIZE_SHIFT)
+#endif
 #define MAX_WORKER_THREAD					32
 
 /* */
@@ -29,15 +37,95 @@ static DEFINE_MUTEX(sc_session_update_mutex);
 static struct list_head sc_session_setup_list;
 static struct list_head sc_session_running_list;
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+static struct rhashtable sc_session_hash_ipaddr;
+static struct rhashtable sc_session_hash_sessionid;
+#else
 static struct sc_capwap_session_priv* __rcu sc_session_hash_ipaddr[SESSION_HASH_SIZE];
 static struct sc_capwap_session_priv* __rcu sc_session_hash_sessionid[SESSION_HASH_SIZE];
+#endif
 
 /* Threads */
-static DEFINE_SPINLOCK(sc_session_threads_lock);
-static uint32_t sc_session_threads_pos;
 static uint32_t sc_session_threads_count;
 static struct sc_capwap_workthread sc_session_threads[MAX_WORKER_THREAD];
 
+/* Data packets processed in softirq context, the threads receive only the packets that can sleep */
+static bool sc_capwap_runtocompletion;
+module_param_named(runtocompletion, sc_capwap_runtocompletion, bool, 0644);
+MODULE_PARM_DESC(runtocompletion, "Process the data packets to completion in softirq context");
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+/* Hash with jhash over address and port of peer */
+static uint32_t sc_capwap_hash_ipaddr(const void* data, uint32_t len, uint32_t seed) {
+	const union capwap_addr* peeraddr = (const union capwap_addr*)data;
+
+	TRACEKMOD("### sc_capwap_hash_ipaddr\n");
+
+	if (peeraddr->ss.ss_family == AF_INET) {
+		return jhash_2words(peeraddr->sin.sin_addr.s_addr, peeraddr->sin.sin_port, seed);
+	}
+
+	return jhash_3words(jhash2(peeraddr->sin6.sin6_addr.s6_addr32, 4, seed), peeraddr->sin6.sin6_port, peeraddr->ss.ss_family, seed);
+}
+
+/* */
+static int sc_capwap_compare_ipaddr(struct rhashtable_compare_arg* arg, const void* obj) {
+	const struct sc_capwap_session_priv* sessionpriv = (const struct sc_capwap_session_priv*)obj;
+
+	TRACEKMOD("### sc_capwap_compare_ipaddr\n");
+
+	return sc_addr_compare((const union capwap_addr*)arg->key, &sessionpriv->session.peeraddr);
+}
+
+/* */
+static const struct rhashtable_params sc_session_hash_ipaddr_params = {
+	.head_offset = offsetof(struct sc_capwap_session_priv, node_ipaddr),
+	.key_offset = offsetof(struct sc_capwap_session_priv, session.peeraddr),
+	.key_len = sizeof(union capwap_addr),
+	.hashfn = sc_capwap_hash_ipaddr,
+	.obj_cmpfn = sc_capwap_compare_ipaddr,
+	.automatic_shrinking = true,
+};
+
+/* Hash with jhash over all bytes of session id */
+static const struct rhashtable_params sc_session_hash_sessionid_params = {
+	.head_offset = offsetof(struct sc_capwap_session_priv, node_sessionid),
+	.key_offset = offsetof(struct sc_capwap_session_priv, session.sessionid),
+	.key_len = sizeof(struct sc_capwap_sessionid_element),
+	.hashfn = jhash,
+	.automatic_shrinking = true,
+};
+
+/* */
+static int sc_capwap_addhash(struct sc_capwap_session_priv* sessionpriv) {
+	int err;
+
+	TRACEKMOD("### sc_capwap_addhash\n");
+
+	err = rhashtable_insert_fast(&sc_session_hash_ipaddr, &sessionpriv->node_ipaddr, sc_session_hash_ipaddr_params);
+	if (err) {
+		TRACEKMOD("*** Unable to add session into address hash table\n");
+		return err;
+	}
+
+	err = rhashtable_insert_fast(&sc_session_hash_sessionid, &sessionpriv->node_sessionid, sc_session_hash_sessionid_params);
+	if (err) {
+		TRACEKMOD("*** Unable to add session into session id hash table\n");
+		rhashtable_remove_fast(&sc_session_hash_ipaddr, &sessionpriv->node_ipaddr, sc_session_hash_ipaddr_params);
+		return err;
+	}
+
+	return 0;
+}
+
+/* */
+static void sc_capwap_removehash(struct sc_capwap_session_priv* sessionpriv) {
+	TRACEKMOD("### sc_capwap_removehash\n");
+
+	rhashtable_remove_fast(&sc_session_hash_ipaddr, &sessionpriv->node_ipaddr, sc_session_hash_ipaddr_params);
+	rhashtable_remove_fast(&sc_session_hash_sessionid, &sessionpriv->node_sessionid, sc_session_hash_sessionid_params);
+}
+#else
 /* */
 static uint32_t sc_capwap_hash_ipaddr(const union capwap_addr* peeraddr) {
 	TRACEKMOD("### sc_capwap_hash_ipaddr\n");
@@ -49,13 +137,75 @@ static uint32_t sc_capwap_hash_ipaddr(const union capwap_addr* peeraddr) {
 static uint32_t sc_capwap_hash_sessionid(const struct sc_capwap_sessionid_element* sessionid) {
 	TRACEKMOD("### sc_capwap_hash_sessionid\n");
 
-	return ((sessionid->id32[0] ^ sessionid->id32[1] ^ sessionid->id32[2] ^ sessionid->id32[3]) % SESSION_HASH_SIZE);
+	return (jhash(sessionid, sizeof(struct sc_capwap_sessionid_element), 0) % SESSION_HASH_SIZE);
 }
 
 /* */
-static void sc_capwap_closesession(struct sc_capwap_session_priv* sessionpriv) {
+static int sc_capwap_addhash(struct sc_capwap_session_priv* sessionpriv) {
+	uint32_t hash;
+
+	TRACEKMOD("### sc_capwap_addhash\n");
+
+	/* IP Address */
+	hash = sc_capwap_hash_ipaddr(&sessionpriv->session.peeraddr);
+	sessionpriv->next_ipaddr = rcu_dereference_protected(sc_session_hash_ipaddr[hash], sc_capwap_update_lock_is_locked());
+	rcu_assign_pointer(sc_session_hash_ipaddr[hash], sessionpriv);
+
+	/* Session ID */
+	hash = sc_capwap_hash_sessionid(&sessionpriv->session.sessionid);
+	sessionpriv->next_sessionid = rcu_dereference_protected(sc_session_hash_sessionid[hash], sc_capwap_update_lock_is_locked());
+	rcu_assign_pointer(sc_session_hash_sessionid[hash], sessionpriv);
+
+	return 0;
+}
+
+/* */
+static void sc_capwap_removehash(struct sc_capwap_session_priv* sessionpriv) {
 	uint32_t hash;
 	struct sc_capwap_session_priv* search;
+
+	TRACEKMOD("### sc_capwap_removehash\n");
+
+	/* IP Address */
+	hash = sc_capwap_hash_ipaddr(&sessionpriv->session.peeraddr);
+	search = rcu_dereference_protected(sc_session_hash_ipaddr[hash], sc_capwap_update_lock_is_locked());
+
+	if (search) {
+		if (search == sessionpriv) {
+			rcu_assign_pointer(sc_session_hash_ipaddr[hash], sessionpriv->next_ipaddr);
+		} else {
+			while (rcu_access_pointer(search->next_ipaddr) && (rcu_access_pointer(search->next_ipaddr) != sessionpriv)) {
+				search = rcu_dereference_protected(search->next_ipaddr, sc_capwap_update_lock_is_locked());
+			}
+
+			if (rcu_access_pointer(search->next_ipaddr)) {
+				rcu_assign_pointer(search->next_ipaddr, sessionpriv->next_ipaddr);
+			}
+		}
+	}
+
+	/* Session ID */
+	hash = sc_capwap_hash_sessionid(&sessionpriv->session.sessionid);
+	search = rcu_dereference_protected(sc_session_hash_sessionid[hash], sc_capwap_update_lock_is_locked());
+
+	if (search) {
+		if (search == sessionpriv) {
+			rcu_assign_pointer(sc_session_hash_sessionid[hash], sessionpriv->next_sessionid);
+		} else {
+			while (rcu_access_pointer(search->next_sessionid) && (rcu_access_pointer(search->next_sessionid) != sessionpriv)) {
+				search = rcu_dereference_protected(search->next_sessionid, sc_capwap_update_lock_is_locked());
+			}
+
+			if (rcu_access_pointer(search->next_sessionid)) {
+				rcu_assign_pointer(search->next_sessionid, sessionpriv->next_sessionid);
+			}
+		}
+	}
+}
+#endif
+
+/* */
+static void sc_capwap_closesession(struct sc_capwap_session_priv* sessionpriv) {
 	struct sc_capwap_station* temp;
 	struct sc_capwap_station* station;
 
@@ -78,41 +228,7 @@ static void sc_capwap_closesession(struct sc_capwap_session_priv* sessionpriv) {
 
 	/* Remove session from list reference */
 	if (sessionpriv->session.peeraddr.ss.ss_family != AF_UNSPEC) {
-		/* IP Address */
-		hash = sc_capwap_hash_ipaddr(&sessionpriv->session.peeraddr);
-		search = rcu_dereference_protected(sc_session_hash_ipaddr[hash], sc_capwap_update_lock_is_locked());
-
-		if (search) {
-			if (search == sessionpriv) {
-				rcu_assign_pointer(sc_session_hash_ipaddr[hash], sessionpriv->next_ipaddr);
-			} else {
-				while (rcu_access_pointer(search->next_ipaddr) && (rcu_access_pointer(search->next_ipaddr) != sessionpriv)) {
-					search = rcu_dereference_protected(search->next_ipaddr, sc_capwap_update_lock_is_locked());
-				}
-
-				if (rcu_access_pointer(search->next_ipaddr)) {
-					rcu_assign_pointer(search->next_ipaddr, sessionpriv->next_ipaddr);
-				}
-			}
-		}
-
-		/* Session ID */
-		hash = sc_capwap_hash_sessionid(&sessionpriv->session.sessionid);
-		search = rcu_dereference_protected(sc_session_hash_sessionid[hash], sc_capwap_update_lock_is_locked());
-
-		if (search) {
-			if (search == sessionpriv) {
-				rcu_assign_pointer(sc_session_hash_sessionid[hash], sessionpriv->next_sessionid);
-			} else {
-				while (rcu_access_pointer(search->next_sessionid) && (rcu_access_pointer(search->next_sessionid) != sessionpriv)) {
-					search = rcu_dereference_protected(search->next_sessionid, sc_capwap_update_lock_is_locked());
-				}
-
-				if (rcu_access_pointer(search->next_sessionid)) {
-					rcu_assign_pointer(search->next_sessionid, sessionpriv->next_sessionid);
-				}
-			}
-		}
+		sc_capwap_removehash(sessionpriv);
 	}
 
 	/* */
@@ -150,11 +266,15 @@ static void sc_capwap_closesessions(void) {
 
 /* */
 static struct sc_capwap_session_priv* sc_capwap_getsession_ipaddr(const union capwap_addr* sockaddr) {
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,1,0)
 	struct sc_capwap_session_priv* sessionpriv;
+#endif
 
 	TRACEKMOD("### sc_capwap_getsession_ipaddr\n");
 
-	/* */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	return rhashtable_lookup_fast(&sc_session_hash_ipaddr, sockaddr, sc_session_hash_ipaddr_params);
+#else
 	sessionpriv = rcu_dereference_check(sc_session_hash_ipaddr[sc_capwap_hash_ipaddr(sockaddr)], sc_capwap_update_lock_is_locked());
 	while (sessionpriv) {
 		if (!sc_addr_compare(sockaddr, &sessionpriv->session.peeraddr)) {
@@ -166,15 +286,20 @@ static struct sc_capwap_session_priv* sc_capwap_getsession_ipaddr(const union ca
 	}
 
 	return sessionpriv;
+#endif
 }
 
 /* */
 static struct sc_capwap_session_priv* sc_capwap_getsession_sessionid(const struct sc_capwap_sessionid_element* sessionid) {
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,1,0)
 	struct sc_capwap_session_priv* sessionpriv;
+#endif
 
 	TRACEKMOD("### sc_capwap_getsession_sessionid\n");
 
-	/* */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	return rhashtable_lookup_fast(&sc_session_hash_sessionid, sessionid, sc_session_hash_sessionid_params);
+#else
 	sessionpriv = rcu_dereference_check(sc_session_hash_sessionid[sc_capwap_hash_sessionid(sessionid)], sc_capwap_update_lock_is_locked());
 	while (sessionpriv) {
 		if (!memcmp(&sessionpriv->session.sessionid, sessionid, sizeof(struct sc_capwap_sessionid_element))) {
@@ -186,6 +311,7 @@ static struct sc_capwap_session_priv* sc_capwap_getsession_sessionid(const struc
 	}
 
 	return sessionpriv;
+#endif
 }
 
 /* */
@@ -256,7 +382,7 @@ static int sc_capwap_restrictbroadcastpacket(struct sk_buff* skb, int is80211) {
 	return 0;
 }
 
-/* */
+/* The packet is always consumed */
 static int sc_capwap_sendpacket_wtp(struct sc_capwap_session_priv* sessionpriv, uint8_t radioid, uint8_t wlanid, struct sk_buff* skb, int is80211) {
 	uint32_t flags = 0;
 	struct sc_capwap_radio_addr* radioaddr = NULL;
@@ -267,6 +393,7 @@ static int sc_capwap_sendpacket_wtp(struct sc_capwap_session_priv* sessionpriv,
 
 	/* */
 	if (!wlan->used) {
+		kfree_skb(skb);
 		return -EINVAL;
 	}
 
@@ -289,19 +416,13 @@ static void sc_capwap_sendbroadcastpacket_wtp(struct sc_netdev_priv* netpriv, ui
 	struct sc_capwap_connection* connection;
 	struct sc_capwap_wireless_information* winfo;
 	uint8_t buffer[CAPWAP_WINFO_DESTWLAN_LENGTH_PADDED];
-	int headroom = sizeof(struct sc_capwap_header) + CAPWAP_WINFO_DESTWLAN_LENGTH_PADDED;
 
 	TRACEKMOD("### sc_capwap_sendbroadcastpacket_wtp\n");
 
-	/* */
-	if (headroom < skb_headroom(skb)) {
-		headroom = skb_headroom(skb);
-	}
-
-	/* Send packet for every connection */
+	/* Send packet for every connection, the clones share the payload and have own CAPWAP header */
 	list_for_each_entry_rcu(connection, &netpriv->list_connections, list_dev) {
 		if ((connection->vlan == vlan) && (connection->sessionpriv != ignore)) {
-			clone = skb_copy_expand(skb, headroom, skb_tailroom(skb), GFP_KERNEL);
+			clone = skb_clone(skb, GFP_ATOMIC);
 			if (!clone) {
 				break;
 			}
@@ -309,13 +430,13 @@ static void sc_capwap_sendbroadcastpacket_wtp(struct sc_netdev_priv* netpriv, ui
 			/* Forward packet */
 			winfo = sc_capwap_setwinfo_destwlans(buffer, CAPWAP_WINFO_DESTWLAN_LENGTH_PADDED, connection->wlanidmask);
 			sc_capwap_forwarddata(&connection->sessionpriv->session, connection->radioid, connection->sessionpriv->binding, clone, NLSMARTCAPWAP_FLAGS_TUNNEL_8023, NULL, 0, winfo, CAPWAP_WINFO_DESTWLAN_LENGTH_PADDED);
-			kfree_skb(clone);
 		}
 	}
 }
 
 /* */
 static void sc_capwap_sendpacket_iface(struct sc_capwap_station* station, struct sk_buff* skb) {
+	unsigned int length;
 	struct sc_netdev_priv* devpriv = rcu_dereference(station->devpriv);
 
 	TRACEKMOD("### sc_capwap_sendpacket_iface\n");
@@ -326,9 +447,7 @@ static void sc_capwap_sendpacket_iface(struct sc_capwap_station* station, struct
 			skb = vlan_insert_tag(skb, htons(ETH_P_8021Q), station->vlan & VLAN_VID_MASK);
 			if (!skb) {
 				/* Unable add VLAN id */
-				spin_lock(&devpriv->lock);
-				devpriv->dev->stats.rx_dropped++;
-				spin_unlock(&devpriv->lock);
+				sc_iface_stats_rxdropped(devpriv);
 				return;
 			}
 		}
@@ -337,22 +456,22 @@ static void sc_capwap_sendpacket_iface(struct sc_capwap_station* station, struct
 		skb_reset_mac_header(skb);
 		skb->protocol = eth_type_trans(skb, devpriv->dev);
 
-		/* Send packet */
-		netif_rx_ni(skb);
-		TRACEKMOD("*** Send packet with size %d to interface %s\n", skb->len, devpriv->dev->name);
+		/* Send packet, in softirq the packets of same NAPI poll are aggregated by GRO */
+		length = skb->len;
+		if (in_softirq()) {
+			gro_cells_receive(&devpriv->gro_cells, skb);
+		} else {
+			netif_rx_ni(skb);
+		}
+
+		TRACEKMOD("*** Send packet with size %d to interface %s\n", length, devpriv->dev->name);
 
 		/* Update stats */
-		spin_lock(&devpriv->lock);
-		devpriv->dev->stats.rx_packets++;
-		devpriv->dev->stats.rx_bytes += skb->len;
-		spin_unlock(&devpriv->lock);
+		sc_iface_stats_rx(devpriv, length);
 	} else {
 		/* Drop packet */
 		kfree_skb(skb);
-
-		spin_lock(&devpriv->lock);
-		devpriv->dev->stats.rx_dropped++;
-		spin_unlock(&devpriv->lock);
+		sc_iface_stats_rxdropped(devpriv);
 	}
 }
 
@@ -376,6 +495,8 @@ static int sc_capwap_thread_recvpacket(struct sk_buff* skb) {
 			if (sc_capwap_forwarddata(&sessionpriv->session, cb->radioid, cb->binding, skb, 0, NULL, 0, NULL, 0)) {
 				TRACEKMOD("*** Unable send packet from sc_netlink_send_data function\n");
 			}
+
+			ret = 0;
 		} else {
 			TRACEKMOD("*** Unable to find session\n");
 		}
@@ -434,6 +555,7 @@ static int sc_capwap_thread_recvpacket(struct sk_buff* skb) {
 			station = sc_stations_search(eh->h_dest);
 			if (station && (station->vlan == vlan)) {
 				sc_capwap_sendpacket_wtp(rcu_dereference(station->sessionpriv), station->radioid, station->wlanid, skb, 0);
+				ret = 0;
 			} else {
 				TRACEKMOD("*** Unable to found station from macaddress\n");
 				ret = -EINVAL;
@@ -446,6 +568,31 @@ static int sc_capwap_thread_recvpacket(struct sk_buff* skb) {
 	return ret;
 }
 
+/* Flow of packet: WTP data channel, WTP session or station */
+static uint32_t sc_capwap_thread_hash(struct sk_buff* skb) {
+	struct sc_skb_capwap_cb* cb = CAPWAP_SKB_CB(skb);
+
+	TRACEKMOD("### sc_capwap_thread_hash\n");
+
+	if (cb->flags & SKB_CAPWAP_FLAG_FROM_DATA_CHANNEL) {
+		union capwap_addr peeraddr;
+
+		if (!sc_socket_getpeeraddr(skb, &peeraddr)) {
+			if (peeraddr.ss.ss_family == AF_INET) {
+				return jhash_2words(peeraddr.sin.sin_addr.s_addr, peeraddr.sin.sin_port, 0);
+			}
+
+			return jhash_2words(ipv6_addr_hash(&peeraddr.sin6.sin6_addr), peeraddr.sin6.sin6_port, 0);
+		}
+	} else if (cb->flags & SKB_CAPWAP_FLAG_FROM_USER_SPACE) {
+		return jhash2(cb->sessionid.id32, 4, 0);
+	} else if (cb->flags & SKB_CAPWAP_FLAG_FROM_AC_TAP) {
+		return jhash(eth_hdr(skb)->h_dest, ETH_ALEN, 0);
+	}
+
+	return 0;
+}
+
 /* */
 static int sc_capwap_thread(void* data) {
 	struct sk_buff* skb;
@@ -473,6 +620,11 @@ static int sc_capwap_thread(void* data) {
 			TRACEKMOD("*** Free packet\n");
 			kfree_skb(skb);
 		}
+
+		/* Deliver the management frames of burst */
+		if (skb_queue_empty(&thread->queue)) {
+			sc_netlink_notify_flush();
+		}
 	}
 
 	/* Purge queue */
@@ -592,13 +744,30 @@ int sc_capwap_init(void) {
 	memset(&sc_localaddr, 0, sizeof(union capwap_addr));
 	INIT_LIST_HEAD(&sc_session_setup_list);
 	INIT_LIST_HEAD(&sc_session_running_list);
+	sc_capwap_fragment_init();
 
 	/* */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	err = rhashtable_init(&sc_session_hash_ipaddr, &sc_session_hash_ipaddr_params);
+	if (err) {
+		return err;
+	}
+
+	err = rhashtable_init(&sc_session_hash_sessionid, &sc_session_hash_sessionid_params);
+	if (err) {
+		goto error_ipaddr;
+	}
+#else
 	memset(sc_session_hash_ipaddr, 0, sizeof(struct sc_capwap_session_priv*) * SESSION_HASH_SIZE);
 	memset(sc_session_hash_sessionid, 0, sizeof(struct sc_capwap_session_priv*) * SESSION_HASH_SIZE);
+#endif
+
+	err = sc_stations_init();
+	if (err) {
+		goto error_sessionid;
+	}
 
 	/* Create threads */
-	sc_session_threads_pos = 0;
 	sc_session_threads_count = 0;
 	for_each_online_cpu(cpu) {
 		memset(&sc_session_threads[sc_session_threads_count], 0, sizeof(struct sc_capwap_workthread));
@@ -642,6 +811,15 @@ error:
 		}
 	}
 
+	sc_stations_close();
+
+error_sessionid:
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	rhashtable_destroy(&sc_session_hash_sessionid);
+
+error_ipaddr:
+	rhashtable_destroy(&sc_session_hash_ipaddr);
+#endif
 	return err;
 }
 
@@ -660,6 +838,117 @@ void sc_capwap_close(void) {
 	for (i = 0; i < sc_session_threads_count; i++) {
 		kthread_stop(sc_session_threads[i].thread);
 	}
+
+	/* */
+	sc_stations_close();
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	rhashtable_destroy(&sc_session_hash_sessionid);
+	rhashtable_destroy(&sc_session_hash_ipaddr);
+#endif
+}
+
+/* */
+void sc_capwap_hashstats_chain(struct sc_capwap_hashstats* stats, uint32_t chain) {
+	stats->maxchain = max(stats->maxchain, chain);
+	stats->chains[min_t(uint32_t, chain, NLSMARTCAPWAP_HASH_CHAINS_COUNT - 1)]++;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+/* */
+void sc_capwap_hashstats(struct rhashtable* ht, struct sc_capwap_hashstats* stats) {
+	unsigned int i;
+	uint32_t chain;
+	struct rhash_head* pos;
+	const struct bucket_table* tbl;
+
+	TRACEKMOD("### sc_capwap_hashstats\n");
+
+	memset(stats, 0, sizeof(struct sc_capwap_hashstats));
+
+	/* Walk the current bucket table, a table of a resize in progress is ignored */
+	rcu_read_lock();
+
+	tbl = rht_dereference_rcu(ht->tbl, ht);
+	stats->elements = atomic_read(&ht->nelems);
+	stats->buckets = tbl->size;
+	for (i = 0; i < tbl->size; i++) {
+		chain = 0;
+		rht_for_each_rcu(pos, tbl, i) {
+			chain++;
+		}
+
+		/* */
+		sc_capwap_hashstats_chain(stats, chain);
+	}
+
+	rcu_read_unlock();
+}
+#else
+/* */
+static void sc_capwap_hashstats_sessions(struct sc_capwap_session_priv* __rcu* hash, bool ipaddr, struct sc_capwap_hashstats* stats) {
+	unsigned long i;
+	uint32_t chain;
+	struct sc_capwap_session_priv* sessionpriv;
+
+	TRACEKMOD("### sc_capwap_hashstats_sessions\n");
+
+	memset(stats, 0, sizeof(struct sc_capwap_hashstats));
+
+	/* */
+	rcu_read_lock();
+
+	stats->buckets = SESSION_HASH_SIZE;
+	for (i = 0; i < SESSION_HASH_SIZE; i++) {
+		chain = 0;
+		sessionpriv = rcu_dereference(hash[i]);
+		while (sessionpriv) {
+			chain++;
+			sessionpriv = (ipaddr ? rcu_dereference(sessionpriv->next_ipaddr) : rcu_dereference(sessionpriv->next_sessionid));
+		}
+
+		/* */
+		stats->elements += chain;
+		sc_capwap_hashstats_chain(stats, chain);
+	}
+
+	rcu_read_unlock();
+}
+#endif
+
+/* */
+int sc_capwap_gethashstats(uint8_t table, struct sc_capwap_hashstats* stats) {
+	TRACEKMOD("### sc_capwap_gethashstats\n");
+
+	switch (table) {
+		case NLSMARTCAPWAP_HASH_STATIONS: {
+			sc_stations_hashstats(stats);
+			break;
+		}
+
+		case NLSMARTCAPWAP_HASH_SESSIONS_ADDRESS: {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+			sc_capwap_hashstats(&sc_session_hash_ipaddr, stats);
+#else
+			sc_capwap_hashstats_sessions(sc_session_hash_ipaddr, true, stats);
+#endif
+			break;
+		}
+
+		case NLSMARTCAPWAP_HASH_SESSIONS_ID: {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+			sc_capwap_hashstats(&sc_session_hash_sessionid, stats);
+#else
+			sc_capwap_hashstats_sessions(sc_session_hash_sessionid, false, stats);
+#endif
+			break;
+		}
+
+		default: {
+			return -EINVAL;
+		}
+	}
+
+	return 0;
 }
 
 /* */
@@ -751,16 +1040,98 @@ int sc_capwap_removewlan(const struct sc_capwap_sessionid_element* sessionid, ui
 	return err;
 }
 
+/* Plain data packet of running session from station to interface, processed without sleep */
+static int sc_capwap_softirq_recvpacket(struct sk_buff* skb) {
+	int ret = -EAGAIN;
+	uint8_t* body;
+	uint8_t* srcaddress;
+	uint8_t* dstaddress;
+	union capwap_addr peeraddr;
+	struct sc_capwap_header* header;
+	struct sc_capwap_station* srcstation;
+	struct sc_capwap_session_priv* sessionpriv;
+
+	TRACEKMOD("### sc_capwap_softirq_recvpacket\n");
+
+	/* */
+	if (sc_socket_getpeeraddr(skb, &peeraddr) || (skb->len < (sizeof(struct udphdr) + sizeof(struct sc_capwap_header) + ETH_HLEN))) {
+		return -EAGAIN;
+	} else if (skb_is_gso(skb) ? !pskb_may_pull(skb, sizeof(struct udphdr) + sizeof(struct sc_capwap_header) + ETH_HLEN) : skb_linearize(skb)) {
+		return -EAGAIN;
+	}
+
+	/* Keep-alive and fragments are processed by threads */
+	header = (struct sc_capwap_header*)(skb->data + sizeof(struct udphdr));
+	if ((GET_VERSION_HEADER(header) != CAPWAP_PROTOCOL_VERSION) || (GET_TYPE_HEADER(header) != CAPWAP_PREAMBLE_HEADER) || IS_FLAG_K_HEADER(header) || IS_FLAG_F_HEADER(header)) {
+		return -EAGAIN;
+	}
+
+	/* */
+	body = ((uint8_t*)header) + GET_HLEN_HEADER(header) * 4;
+	if (!IS_FLAG_T_HEADER(header)) {
+		if ((body + sizeof(struct ethhdr)) > skb_tail_pointer(skb)) {
+			return -EAGAIN;
+		}
+
+		srcaddress = (uint8_t*)((struct ethhdr*)body)->h_source;
+		dstaddress = (uint8_t*)((struct ethhdr*)body)->h_dest;
+	} else if (GET_WBID_HEADER(header) == CAPWAP_WIRELESS_BINDING_IEEE80211) {
+		struct ieee80211_hdr* hdr = (struct ieee80211_hdr*)body;
+
+		if (((body + sizeof(struct ieee80211_hdr)) > skb_tail_pointer(skb)) || !ieee80211_is_data_present(hdr->frame_control)) {
+			return -EAGAIN;
+		}
+
+		srcaddress = ieee80211_get_SA(hdr);
+		dstaddress = ieee80211_get_DA(hdr);
+	} else {
+		return -EAGAIN;
+	}
+
+	/* Packets to other WTPs are sent with socket by threads */
+	if (is_multicast_ether_addr(dstaddress)) {
+		return -EAGAIN;
+	}
+
+	/* */
+	rcu_read_lock();
+
+	sessionpriv = sc_capwap_getsession_ipaddr(&peeraddr);
+	srcstation = sc_stations_search(srcaddress);
+	if (sessionpriv && srcstation && !sc_stations_search(dstaddress)) {
+		struct sc_capwap_session_priv* srcsessionpriv = rcu_dereference(srcstation->sessionpriv);
+		struct sc_capwap_wlan* wlan = &srcsessionpriv->wlans[srcstation->radioid - 1][srcstation->wlanid - 1];
+
+		if (wlan->used && (wlan->tunnelmode != CAPWAP_ADD_WLAN_TUNNELMODE_LOCAL)) {
+			skb_pull(skb, sizeof(struct udphdr));
+			if (sc_capwap_parsingpacket(&sessionpriv->session, &peeraddr, skb)) {
+				kfree_skb(skb);
+			}
+
+			ret = 0;
+		}
+	}
+
+	rcu_read_unlock();
+
+	return ret;
+}
+
 /* */
 void sc_capwap_recvpacket(struct sk_buff* skb) {
 	uint32_t pos;
 
 	TRACEKMOD("### sc_capwap_recvpacket\n");
 
-	spin_lock(&sc_session_threads_lock);
-	sc_session_threads_pos = ((sc_session_threads_pos + 1) % sc_session_threads_count);
-	pos = sc_session_threads_pos;
-	spin_unlock(&sc_session_threads_lock);
+	/* Run to completion */
+	if (sc_capwap_runtocompletion && (CAPWAP_SKB_CB(skb)->flags & SKB_CAPWAP_FLAG_FROM_DATA_CHANNEL)) {
+		if (!sc_capwap_softirq_recvpacket(skb)) {
+			return;
+		}
+	}
+
+	/* The packets of same flow are always processed by the same thread */
+	pos = sc_capwap_thread_hash(skb) % sc_session_threads_count;
 
 	TRACEKMOD("*** Add packet (flags 0x%04x size %d) to thread: %u\n", (int)CAPWAP_SKB_CB(skb)->flags, (int)skb->len, pos);
 
@@ -771,7 +1142,6 @@ void sc_capwap_recvpacket(struct sk_buff* skb) {
 
 /* */
 struct sc_capwap_session* sc_capwap_recvunknownkeepalive(const union capwap_addr* sockaddr, const struct sc_capwap_sessionid_element* sessionid) {
-	uint32_t hash;
 	struct sc_capwap_session_priv* search;
 	struct sc_capwap_session_priv* sessionpriv = NULL;
 
@@ -809,17 +1179,19 @@ struct sc_capwap_session* sc_capwap_recvunknownkeepalive(const union capwap_addr
 
 	/* */
 	memcpy(&sessionpriv->session.peeraddr, sockaddr, sizeof(union capwap_addr));
-	list_add_rcu(&sessionpriv->list, &sc_session_running_list);
+	if (sc_capwap_addhash(sessionpriv)) {
+		goto error;
+	}
 
-	/* */
-	hash = sc_capwap_hash_ipaddr(sockaddr);
-	sessionpriv->next_ipaddr = rcu_dereference_protected(sc_session_hash_ipaddr[hash], sc_capwap_update_lock_is_locked());
-	rcu_assign_pointer(sc_session_hash_ipaddr[hash], sessionpriv);
+	list_add_rcu(&sessionpriv->list, &sc_session_running_list);
+	goto done;
 
-	/* */
-	hash = sc_capwap_hash_sessionid(sessionid);
-	sessionpriv->next_sessionid = rcu_dereference_protected(sc_session_hash_sessionid[hash], sc_capwap_update_lock_is_locked());
-	rcu_assign_pointer(sc_session_hash_sessionid[hash], sessionpriv);
+error:
+	/* Restore setup session */
+	synchronize_net();
+	sessionpriv->session.peeraddr.ss.ss_family = AF_UNSPEC;
+	list_add_rcu(&sessionpriv->list, &sc_session_setup_list);
+	sessionpriv = NULL;
 
 done:
 	rcu_read_lock();
@@ -861,6 +1233,15 @@ void sc_capwap_parsingdatapacket(struct sc_capwap_session* session, struct sk_bu
 
 	/* Body packet */
 	skb_pull(skb, GET_HLEN_HEADER(header) * 4);
+
+	/* The packet aggregated by GRO becomes a GSO packet of 802.3 frames */
+	if (skb_is_gso(skb)) {
+		skb_shinfo(skb)->gso_type &= ~(SKB_GSO_UDP_TUNNEL | SKB_GSO_UDP_TUNNEL_CSUM);
+		skb->encapsulation = 0;
+		skb_reset_mac_header(skb);
+		skb_set_network_header(skb, ETH_HLEN);
+		skb_set_transport_header(skb, skb_checksum_start_offset(skb));
+	}
 	srcaddress = (is80211 ? ieee80211_get_SA((struct ieee80211_hdr*)skb->data) : (uint8_t*)((struct ethhdr*)skb->data)->h_source);
 	dstaddress = (is80211 ? ieee80211_get_DA((struct ieee80211_hdr*)skb->data) : (uint8_t*)((struct ethhdr*)skb->data)->h_dest);
 
@@ -889,12 +1270,12 @@ void sc_capwap_parsingdatapacket(struct sc_capwap_session* session, struct sk_bu
 					/* Search destination station */
 					dststation = sc_stations_search(dstaddress);
 					if (dststation) {
-						/* Forward packet */
-						if (!srcsessionpriv->isolation && (srcsessionpriv != rcu_access_pointer(dststation->sessionpriv))) {
+						/* Forward packet, the socket can not be used in softirq by station connected after the check of sc_capwap_softirq_recvpacket */
+						if (!in_softirq() && !srcsessionpriv->isolation && (srcsessionpriv != rcu_access_pointer(dststation->sessionpriv))) {
 							sc_capwap_sendpacket_wtp(rcu_dereference(dststation->sessionpriv), dststation->radioid, dststation->wlanid, skb, is80211);
+						} else {
+							kfree_skb(skb);
 						}
-
-						kfree_skb(skb);
 					} else {
 						if (is80211) {
 							sc_capwap_80211_to_8023(skb);
@@ -922,8 +1303,11 @@ void sc_capwap_parsingdatapacket(struct sc_capwap_session* session, struct sk_bu
 void sc_capwap_parsingmgmtpacket(struct sc_capwap_session* session, struct sk_buff* skb) {
 	TRACEKMOD("### sc_capwap_parsingmgmtpacket\n");
 
-	/* Send packet with capwap header into userspace */
-	sc_netlink_notify_recv_data(&session->sessionid, skb->data, skb->len);
+	/* Send packet with capwap header into userspace, a reassembled packet is not linear */
+	if (!skb_linearize(skb)) {
+		sc_netlink_notify_recv_batchdata(&session->sessionid, skb->data, skb->len);
+	}
+
 	kfree_skb(skb);
 }
 
@@ -977,17 +1361,18 @@ int sc_capwap_authstation(const struct sc_capwap_sessionid_element* sessionid, c
 					station->vlan = vlan;
 					station->radioid = radioid;
 					station->wlanid = wlanid;
-
-					/* Assign interface */
 					rcu_assign_pointer(station->devpriv, devpriv);
-					list_add(&station->list_dev, &devpriv->list_stations);
-
-					/* Assign session */
 					rcu_assign_pointer(station->sessionpriv, sessionpriv);
-					list_add(&station->list_session, &sessionpriv->list_stations);
 
 					/* Add station */
-					sc_stations_add(station);
+					err = sc_stations_add(station);
+					if (!err) {
+						list_add(&station->list_dev, &devpriv->list_stations);
+						list_add(&station->list_session, &sessionpriv->list_stations);
+					} else {
+						kfree(station);
+						station = NULL;
+					}
 				} else {
 					TRACEKMOD("*** Unable to create station\n");
 					err = -ENOMEM;
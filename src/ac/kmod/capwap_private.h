@@ -1,6 +1,12 @@
 #ifndef __KMOD_CAPWAP_PRIVATE_HEADER__
 #define __KMOD_CAPWAP_PRIVATE_HEADER__
 
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+#include <linux/rhashtable.h>
+#endif
+#include "nlsmartcapwap.h"
+
 /* */
 struct sc_capwap_wlan {
 	int used;
@@ -15,8 +21,13 @@ struct sc_capwap_session_priv {
 	struct sc_capwap_session session;
 
 	struct list_head list;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	struct rhash_head node_ipaddr;
+	struct rhash_head node_sessionid;
+#else
 	struct sc_capwap_session_priv* __rcu next_ipaddr;
 	struct sc_capwap_session_priv* __rcu next_sessionid;
+#endif
 
 	struct list_head list_stations;
 	struct list_head list_connections;
@@ -35,10 +46,25 @@ struct sc_capwap_workthread {
 	wait_queue_head_t waitevent;
 };
 
+/* Chain length of a hash table */
+struct sc_capwap_hashstats {
+	uint32_t elements;
+	uint32_t buckets;
+	uint32_t maxchain;
+	uint32_t chains[NLSMARTCAPWAP_HASH_CHAINS_COUNT];
+};
+
 /* */
 int sc_capwap_init(void);
 void sc_capwap_close(void);
 
+/* */
+void sc_capwap_hashstats_chain(struct sc_capwap_hashstats* stats, uint32_t chain);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+void sc_capwap_hashstats(struct rhashtable* ht, struct sc_capwap_hashstats* stats);
+#endif
+int sc_capwap_gethashstats(uint8_t table, struct sc_capwap_hashstats* stats);
+
 /* */
 void sc_capwap_update_lock(void);
 void sc_capwap_update_unlock(void);
@@ -15,6 +15,43 @@
 static LIST_HEAD(sc_iface_list);
 static struct sc_netdev_priv* __rcu sc_iface_hash[CAPWAP_IFACE_COUNT];
 
+/* */
+static int sc_iface_netdev_init(struct net_device* dev) {
+	int err;
+	struct sc_netdev_priv* priv = (struct sc_netdev_priv*)netdev_priv(dev);
+
+	TRACEKMOD("### sc_iface_netdev_init\n");
+
+	/* Stats */
+	dev->tstats = netdev_alloc_pcpu_stats(struct pcpu_sw_netstats);
+	if (!dev->tstats) {
+		return -ENOMEM;
+	}
+
+	priv->dropstats = netdev_alloc_pcpu_stats(struct sc_netdev_dropstats);
+	if (!priv->dropstats) {
+		err = -ENOMEM;
+		goto error;
+	}
+
+	/* */
+	err = gro_cells_init(&priv->gro_cells, dev);
+	if (err) {
+		goto error2;
+	}
+
+	return 0;
+
+error2:
+	free_percpu(priv->dropstats);
+	priv->dropstats = NULL;
+
+error:
+	free_percpu(dev->tstats);
+	dev->tstats = NULL;
+	return err;
+}
+
 /* */
 static void sc_iface_netdev_uninit(struct net_device* dev) {
 	struct sc_netdev_priv* search;
@@ -77,6 +114,11 @@ static void sc_iface_netdev_uninit(struct net_device* dev) {
 	}
 
 	sc_capwap_update_unlock();
+
+	/* */
+	gro_cells_destroy(&priv->gro_cells);
+	free_percpu(priv->dropstats);
+	free_percpu(dev->tstats);
 }
 
 /* */
@@ -97,6 +139,8 @@ static int sc_iface_netdev_stop(struct net_device* dev) {
 
 /* */
 static int sc_iface_netdev_tx(struct sk_buff* skb, struct net_device* dev) {
+	struct pcpu_sw_netstats* stats;
+	struct sc_netdev_dropstats* dropstats;
 	struct sc_netdev_priv* priv = (struct sc_netdev_priv*)netdev_priv(dev);
 
 	TRACEKMOD("### sc_iface_netdev_tx %d\n", smp_processor_id());
@@ -107,11 +151,12 @@ static int sc_iface_netdev_tx(struct sk_buff* skb, struct net_device* dev) {
 			goto drop;
 		}
 
-		/* */
-		spin_lock(&priv->lock);
-		dev->stats.tx_packets++;
-		dev->stats.tx_bytes += skb->len;
-		spin_unlock(&priv->lock);
+		/* Transmit runs with bottom half disabled */
+		stats = this_cpu_ptr(dev->tstats);
+		u64_stats_update_begin(&stats->syncp);
+		stats->tx_packets++;
+		stats->tx_bytes += skb->len;
+		u64_stats_update_end(&stats->syncp);
 
 		/* */
 		CAPWAP_SKB_CB(skb)->flags = SKB_CAPWAP_FLAG_FROM_AC_TAP;
@@ -127,13 +172,54 @@ drop:
 	kfree_skb(skb);
 
 	/* */
-	spin_lock(&priv->lock);
-	dev->stats.rx_dropped++;
-	spin_unlock(&priv->lock);
+	dropstats = this_cpu_ptr(priv->dropstats);
+	u64_stats_update_begin(&dropstats->syncp);
+	dropstats->tx_dropped++;
+	u64_stats_update_end(&dropstats->syncp);
 
 	return 0;
 }
 
+/* */
+static struct rtnl_link_stats64* sc_iface_netdev_get_stats64(struct net_device* dev, struct rtnl_link_stats64* storage) {
+	int cpu;
+	unsigned int start;
+	u64 rx_packets, rx_bytes, tx_packets, tx_bytes;
+	u64 rx_dropped, tx_dropped;
+	struct sc_netdev_priv* priv = (struct sc_netdev_priv*)netdev_priv(dev);
+
+	TRACEKMOD("### sc_iface_netdev_get_stats64\n");
+
+	for_each_possible_cpu(cpu) {
+		const struct pcpu_sw_netstats* stats = per_cpu_ptr(dev->tstats, cpu);
+		const struct sc_netdev_dropstats* dropstats = per_cpu_ptr(priv->dropstats, cpu);
+
+		do {
+			start = u64_stats_fetch_begin_irq(&stats->syncp);
+			rx_packets = stats->rx_packets;
+			rx_bytes = stats->rx_bytes;
+			tx_packets = stats->tx_packets;
+			tx_bytes = stats->tx_bytes;
+		} while (u64_stats_fetch_retry_irq(&stats->syncp, start));
+
+		do {
+			start = u64_stats_fetch_begin_irq(&dropstats->syncp);
+			rx_dropped = dropstats->rx_dropped;
+			tx_dropped = dropstats->tx_dropped;
+		} while (u64_stats_fetch_retry_irq(&dropstats->syncp, start));
+
+		/* */
+		storage->rx_packets += rx_packets;
+		storage->rx_bytes += rx_bytes;
+		storage->tx_packets += tx_packets;
+		storage->tx_bytes += tx_bytes;
+		storage->rx_dropped += rx_dropped;
+		storage->tx_dropped += tx_dropped;
+	}
+
+	return storage;
+}
+
 /* */
 static int sc_iface_netdev_change_mtu(struct net_device* dev, int new_mtu) {
 	TRACEKMOD("### sc_iface_netdev_change_mtu\n");
@@ -151,17 +237,18 @@ static void sc_iface_netdev_setup(struct net_device* dev) {
 	/* */
 	memset(devpriv, 0, sizeof(struct sc_netdev_priv));
 	devpriv->dev = dev;
-	spin_lock_init(&devpriv->lock);
 	INIT_LIST_HEAD(&devpriv->list_stations);
 	INIT_LIST_HEAD(&devpriv->list_connections);
 }
 
 /* */
 static const struct net_device_ops capwap_netdev_ops = {
+	.ndo_init = sc_iface_netdev_init,
 	.ndo_uninit = sc_iface_netdev_uninit,
 	.ndo_open = sc_iface_netdev_open,
 	.ndo_stop = sc_iface_netdev_stop,
 	.ndo_start_xmit = sc_iface_netdev_tx,
+	.ndo_get_stats64 = sc_iface_netdev_get_stats64,
 	.ndo_change_mtu = sc_iface_netdev_change_mtu,
 };
 
@@ -188,8 +275,9 @@ int sc_iface_create(const char* ifname, uint16_t mtu) {
 	eth_hw_addr_random(dev);
 
 	dev->mtu = mtu;
+	dev->needed_headroom = CAPWAP_HEADER_MAX_LENGTH + SOCKET_SKB_HEADROOM;
 
-	dev->hw_features = NETIF_F_HW_CSUM;
+	dev->hw_features = NETIF_F_HW_CSUM | NETIF_F_SG | NETIF_F_GSO_SOFTWARE;
 	dev->features = dev->hw_features;
 
 	/* */
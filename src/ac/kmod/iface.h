@@ -1,12 +1,24 @@
 #ifndef __KMOD_AC_IFACE_HEADER__
 #define __KMOD_AC_IFACE_HEADER__
 
+#include <linux/netdevice.h>
+#include <linux/u64_stats_sync.h>
+#include <net/gro_cells.h>
+
+/* Packets dropped by kmod */
+struct sc_netdev_dropstats {
+	u64 rx_dropped;
+	u64 tx_dropped;
+	struct u64_stats_sync syncp;
+};
+
 /* */
 struct sc_netdev_priv {
 	struct list_head list;
 	struct net_device* dev;
 
-	spinlock_t lock;
+	struct sc_netdev_dropstats __percpu* dropstats;
+	struct gro_cells gro_cells;
 
 	struct list_head list_stations;
 	struct list_head list_connections;
@@ -24,4 +36,29 @@ struct sc_netdev_priv* sc_iface_search(uint32_t ifindex);
 /* */
 void sc_iface_closeall(void);
 
+/* Per cpu stats, the writers of same cpu are serialized with bottom half disabled */
+static inline void sc_iface_stats_rx(struct sc_netdev_priv* devpriv, unsigned int length) {
+	struct pcpu_sw_netstats* stats;
+
+	local_bh_disable();
+	stats = this_cpu_ptr(devpriv->dev->tstats);
+	u64_stats_update_begin(&stats->syncp);
+	stats->rx_packets++;
+	stats->rx_bytes += length;
+	u64_stats_update_end(&stats->syncp);
+	local_bh_enable();
+}
+
+/* */
+static inline void sc_iface_stats_rxdropped(struct sc_netdev_priv* devpriv) {
+	struct sc_netdev_dropstats* stats;
+
+	local_bh_disable();
+	stats = this_cpu_ptr(devpriv->dropstats);
+	u64_stats_update_begin(&stats->syncp);
+	stats->rx_dropped++;
+	u64_stats_update_end(&stats->syncp);
+	local_bh_enable();
+}
+
 #endif /* __KMOD_AC_IFACE_HEADER__ */
@@ -18,6 +18,20 @@
 /* */
 static u32 sc_netlink_usermodeid;
 
+/* Management frames received by a worker thread are aggregated into one message, flushed when the thread is idle */
+struct sc_netlink_batch {
+	spinlock_t lock;
+	struct sk_buff* msg;
+	void* hdr;
+	unsigned int count;
+};
+
+static DEFINE_PER_CPU(struct sc_netlink_batch, sc_netlink_batch);
+
+static unsigned int sc_netlink_mgmtbatch = 32;
+module_param_named(mgmtbatch, sc_netlink_mgmtbatch, uint, 0644);
+MODULE_PARM_DESC(mgmtbatch, "Maximum management frames for netlink message, 0 send a message for each frame");
+
 /* */
 static int sc_netlink_pre_doit(struct genl_ops* ops, struct sk_buff* skb, struct genl_info* info);
 static void sc_netlink_post_doit(struct genl_ops* ops, struct sk_buff* skb, struct genl_info* info);
@@ -388,6 +402,125 @@ static int sc_netlink_delete_iface(struct sk_buff* skb, struct genl_info* info)
 	return sc_iface_delete(nla_get_u32(info->attrs[NLSMARTCAPWAP_ATTR_IFPHY_INDEX]));
 }
 
+/* */
+static int sc_netlink_get_hash_stats(struct sk_buff* skb, struct genl_info* info) {
+	int err;
+	void* hdr;
+	struct sk_buff *msg;
+	struct sc_capwap_hashstats stats;
+
+	TRACEKMOD("### sc_netlink_get_hash_stats\n");
+
+	/* Check Link */
+	if (!sc_netlink_usermodeid) {
+		return -ENOLINK;
+	}
+
+	/* */
+	if (!info->attrs[NLSMARTCAPWAP_ATTR_HASH_TABLE]) {
+		return -EINVAL;
+	}
+
+	/* */
+	err = sc_capwap_gethashstats(nla_get_u8(info->attrs[NLSMARTCAPWAP_ATTR_HASH_TABLE]), &stats);
+	if (err) {
+		return err;
+	}
+
+	/* Send response */
+	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!msg) {
+		return -ENOMEM;
+	}
+
+	hdr = genlmsg_put(msg, info->snd_portid, info->snd_seq, &sc_netlink_family, 0, NLSMARTCAPWAP_CMD_GET_HASH_STATS);
+	if (IS_ERR(hdr)) {
+		err = PTR_ERR(hdr);
+		goto error;
+	}
+
+	if (nla_put_u8(msg, NLSMARTCAPWAP_ATTR_HASH_TABLE, nla_get_u8(info->attrs[NLSMARTCAPWAP_ATTR_HASH_TABLE])) ||
+		nla_put_u32(msg, NLSMARTCAPWAP_ATTR_HASH_ELEMENTS, stats.elements) ||
+		nla_put_u32(msg, NLSMARTCAPWAP_ATTR_HASH_BUCKETS, stats.buckets) ||
+		nla_put_u32(msg, NLSMARTCAPWAP_ATTR_HASH_MAX_CHAIN, stats.maxchain) ||
+		nla_put(msg, NLSMARTCAPWAP_ATTR_HASH_CHAINS, sizeof(stats.chains), stats.chains)) {
+		err = -ENOBUFS;
+		goto error;
+	}
+
+	genlmsg_end(msg, hdr);
+	return genlmsg_reply(msg, info);
+
+error:
+	nlmsg_free(msg);
+	return err;
+}
+
+/* */
+static int sc_netlink_get_fragment_stats(struct sk_buff* skb, struct genl_info* info) {
+	int err;
+	void* hdr;
+	struct sk_buff *msg;
+	struct sc_capwap_fragment_stats stats;
+
+	TRACEKMOD("### sc_netlink_get_fragment_stats\n");
+
+	/* Check Link */
+	if (!sc_netlink_usermodeid) {
+		return -ENOLINK;
+	}
+
+	/* */
+	sc_capwap_fragment_stats(&stats);
+
+	/* Send response */
+	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!msg) {
+		return -ENOMEM;
+	}
+
+	hdr = genlmsg_put(msg, info->snd_portid, info->snd_seq, &sc_netlink_family, 0, NLSMARTCAPWAP_CMD_GET_FRAGMENT_STATS);
+	if (IS_ERR(hdr)) {
+		err = PTR_ERR(hdr);
+		goto error;
+	}
+
+	if (nla_put_u32(msg, NLSMARTCAPWAP_ATTR_FRAGMENT_MEMORY, stats.memory) ||
+		nla_put_u32(msg, NLSMARTCAPWAP_ATTR_FRAGMENT_TIMEOUTS, stats.timeouts) ||
+		nla_put_u32(msg, NLSMARTCAPWAP_ATTR_FRAGMENT_EVICTIONS, stats.evictions)) {
+		err = -ENOBUFS;
+		goto error;
+	}
+
+	genlmsg_end(msg, hdr);
+	return genlmsg_reply(msg, info);
+
+error:
+	nlmsg_free(msg);
+	return err;
+}
+
+/* */
+static void sc_netlink_purge_batch(void) {
+	int cpu;
+
+	TRACEKMOD("### sc_netlink_purge_batch\n");
+
+	for_each_possible_cpu(cpu) {
+		struct sc_netlink_batch* batch = per_cpu_ptr(&sc_netlink_batch, cpu);
+
+		spin_lock_bh(&batch->lock);
+
+		if (batch->msg) {
+			nlmsg_free(batch->msg);
+			batch->msg = NULL;
+			batch->count = 0;
+		}
+
+		spin_unlock_bh(&batch->lock);
+	}
+}
+
 /* */
 static int sc_netlink_notify(struct notifier_block* nb, unsigned long state, void* _notify) {
 	struct netlink_notify* notify = (struct netlink_notify*)_notify;
@@ -396,6 +529,7 @@ static int sc_netlink_notify(struct notifier_block* nb, unsigned long state, voi
 	if ((state == NETLINK_URELEASE) && (sc_netlink_usermodeid == notify->portid)) {
 		/* Close capwap engine */
 		sc_capwap_close();
+		sc_netlink_purge_batch();
 
 		/* Allow unload module */
 		module_put(THIS_MODULE);
@@ -422,6 +556,7 @@ static const struct nla_policy sc_netlink_policy[NLSMARTCAPWAP_ATTR_MAX + 1] = {
 	[NLSMARTCAPWAP_ATTR_MACADDRESS] = { .type = NLA_BINARY, .len = MACADDRESS_EUI48_LENGTH },
 	[NLSMARTCAPWAP_ATTR_BSSID] = { .type = NLA_BINARY, .len = MACADDRESS_EUI48_LENGTH },
 	[NLSMARTCAPWAP_ATTR_VLAN] = { .type = NLA_U16 },
+	[NLSMARTCAPWAP_ATTR_HASH_TABLE] = { .type = NLA_U8 },
 };
 
 /* Netlink Ops */
@@ -498,6 +633,18 @@ static struct genl_ops sc_netlink_ops[] = {
 		.policy = sc_netlink_policy,
 		.flags = GENL_ADMIN_PERM,
 	},
+	{
+		.cmd = NLSMARTCAPWAP_CMD_GET_HASH_STATS,
+		.doit = sc_netlink_get_hash_stats,
+		.policy = sc_netlink_policy,
+		.flags = GENL_ADMIN_PERM,
+	},
+	{
+		.cmd = NLSMARTCAPWAP_CMD_GET_FRAGMENT_STATS,
+		.doit = sc_netlink_get_fragment_stats,
+		.policy = sc_netlink_policy,
+		.flags = GENL_ADMIN_PERM,
+	},
 };
 
 /* Netlink notify */
@@ -525,7 +672,7 @@ int sc_netlink_notify_recv_keepalive(const union capwap_addr* sockaddr, struct s
 	}
 
 	/* */
-	if (nla_put(sk_msg, NLSMARTCAPWAP_ATTR_SESSION_ID, sizeof(struct sc_capwap_sessionid_element), sessionid)) {
+	if (nla_put(sk_msg, NLSMARTCAPWAP_ATTR_SESSION_ID, sizeof(struct sc_capwap_sessionid_element), sessionid) || nla_put(sk_msg, NLSMARTCAPWAP_ATTR_ADDRESS, sizeof(union capwap_addr), sockaddr)) {
 		goto error2;
 	}
 
@@ -576,12 +723,139 @@ error:
 	return -ENOMEM;
 }
 
+/* Require lock of batch */
+static int sc_netlink_send_batch(struct sc_netlink_batch* batch) {
+	struct sk_buff* sk_msg = batch->msg;
+
+	TRACEKMOD("### sc_netlink_send_batch\n");
+
+	if (!sk_msg) {
+		return 0;
+	}
+
+	TRACEKMOD("*** Send %u management frames\n", batch->count);
+
+	/* */
+	batch->msg = NULL;
+	batch->count = 0;
+
+	/* Send message */
+	genlmsg_end(sk_msg, batch->hdr);
+	return genlmsg_unicast(&init_net, sk_msg, sc_netlink_usermodeid);
+}
+
+/* Require lock of batch */
+static int sc_netlink_put_batch(struct sc_netlink_batch* batch, struct sc_capwap_sessionid_element* sessionid, uint8_t* packet, int length) {
+	struct nlattr* item;
+
+	TRACEKMOD("### sc_netlink_put_batch\n");
+
+	/* Alloc message */
+	if (!batch->msg) {
+		batch->msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_ATOMIC);
+		if (!batch->msg) {
+			return -ENOMEM;
+		}
+
+		/* Set command */
+		batch->hdr = genlmsg_put(batch->msg, 0, 0, &sc_netlink_family, 0, NLSMARTCAPWAP_CMD_RECV_DATA_BATCH);
+		if (!batch->hdr) {
+			nlmsg_free(batch->msg);
+			batch->msg = NULL;
+			return -ENOMEM;
+		}
+	}
+
+	/* */
+	item = nla_nest_start(batch->msg, NLSMARTCAPWAP_ATTR_DATA_ITEM);
+	if (!item) {
+		return -EMSGSIZE;
+	}
+
+	if (nla_put(batch->msg, NLSMARTCAPWAP_ATTR_SESSION_ID, sizeof(struct sc_capwap_sessionid_element), sessionid) ||
+		nla_put(batch->msg, NLSMARTCAPWAP_ATTR_DATA_FRAME, length, packet)) {
+		nla_nest_cancel(batch->msg, item);
+		return -EMSGSIZE;
+	}
+
+	nla_nest_end(batch->msg, item);
+	batch->count++;
+
+	return 0;
+}
+
+/* */
+int sc_netlink_notify_recv_batchdata(struct sc_capwap_sessionid_element* sessionid, uint8_t* packet, int length) {
+	int err;
+	struct sc_netlink_batch* batch;
+
+	TRACEKMOD("### sc_netlink_notify_recv_batchdata\n");
+
+	/* Only the worker threads flush the batch */
+	if (!sc_netlink_mgmtbatch || in_softirq()) {
+		return sc_netlink_notify_recv_data(sessionid, packet, length);
+	}
+
+	/* */
+	batch = &get_cpu_var(sc_netlink_batch);
+	spin_lock_bh(&batch->lock);
+
+	err = sc_netlink_put_batch(batch, sessionid, packet, length);
+	if ((err == -EMSGSIZE) && batch->count) {
+		/* Message full */
+		sc_netlink_send_batch(batch);
+		err = sc_netlink_put_batch(batch, sessionid, packet, length);
+	}
+
+	if (!err) {
+		if (batch->count >= sc_netlink_mgmtbatch) {
+			err = sc_netlink_send_batch(batch);
+		}
+	} else if (batch->msg && !batch->count) {
+		nlmsg_free(batch->msg);
+		batch->msg = NULL;
+	}
+
+	spin_unlock_bh(&batch->lock);
+	put_cpu_var(sc_netlink_batch);
+
+	return err;
+}
+
+/* */
+void sc_netlink_notify_flush(void) {
+	struct sc_netlink_batch* batch;
+
+	TRACEKMOD("### sc_netlink_notify_flush\n");
+
+	batch = &get_cpu_var(sc_netlink_batch);
+
+	/* Light check without lock */
+	if (batch->msg) {
+		spin_lock_bh(&batch->lock);
+		sc_netlink_send_batch(batch);
+		spin_unlock_bh(&batch->lock);
+	}
+
+	put_cpu_var(sc_netlink_batch);
+}
+
 /* */
 int sc_netlink_init(void) {
+	int cpu;
 	int ret;
 
 	TRACEKMOD("### sc_netlink_init\n");
 
+	/* */
+	for_each_possible_cpu(cpu) {
+		struct sc_netlink_batch* batch = per_cpu_ptr(&sc_netlink_batch, cpu);
+
+		spin_lock_init(&batch->lock);
+		batch->msg = NULL;
+		batch->count = 0;
+	}
+
 	/* Register netlink family */
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3,12,0)
 	ret = genl_register_family_with_ops(&sc_netlink_family, sc_netlink_ops, sizeof(sc_netlink_ops) / sizeof(sc_netlink_ops[0]));
@@ -608,4 +882,5 @@ void sc_netlink_exit(void) {
 
 	netlink_unregister_notifier(&sc_netlink_notifier);
 	genl_unregister_family(&sc_netlink_family);
+	sc_netlink_purge_batch();
 }
@@ -11,5 +11,7 @@ void sc_netlink_exit(void);
 /* */
 int sc_netlink_notify_recv_keepalive(const union capwap_addr* sockaddr, struct sc_capwap_sessionid_element* sessionid);
 int sc_netlink_notify_recv_data(struct sc_capwap_sessionid_element* sessionid, uint8_t* packet, int length);
+int sc_netlink_notify_recv_batchdata(struct sc_capwap_sessionid_element* sessionid, uint8_t* packet, int length);
+void sc_netlink_notify_flush(void);
 
 #endif /* __KMOD_AC_NETLINKAPP_HEADER__ */
@@ -7,6 +7,14 @@
 /* */
 #define NLSMARTCAPWAP_FLAGS_TUNNEL_8023			0x00000001
 
+/* Hash tables */
+#define NLSMARTCAPWAP_HASH_STATIONS				0
+#define NLSMARTCAPWAP_HASH_SESSIONS_ADDRESS		1
+#define NLSMARTCAPWAP_HASH_SESSIONS_ID			2
+
+/* Buckets with chain length 0..N-2, the last counter is for longer chains */
+#define NLSMARTCAPWAP_HASH_CHAINS_COUNT			8
+
 /* */
 enum sc_netlink_attrs {
 	NLSMARTCAPWAP_ATTR_UNSPEC,
@@ -34,6 +42,18 @@ enum sc_netlink_attrs {
 
 	NLSMARTCAPWAP_ATTR_VLAN,
 
+	NLSMARTCAPWAP_ATTR_HASH_TABLE,
+	NLSMARTCAPWAP_ATTR_HASH_ELEMENTS,
+	NLSMARTCAPWAP_ATTR_HASH_BUCKETS,
+	NLSMARTCAPWAP_ATTR_HASH_MAX_CHAIN,
+	NLSMARTCAPWAP_ATTR_HASH_CHAINS,
+
+	NLSMARTCAPWAP_ATTR_FRAGMENT_MEMORY,
+	NLSMARTCAPWAP_ATTR_FRAGMENT_TIMEOUTS,
+	NLSMARTCAPWAP_ATTR_FRAGMENT_EVICTIONS,
+
+	NLSMARTCAPWAP_ATTR_DATA_ITEM,
+
 	/* Last attribute */
 	__NLSMARTCAPWAP_ATTR_AFTER_LAST,
 	NLSMARTCAPWAP_ATTR_MAX = __NLSMARTCAPWAP_ATTR_AFTER_LAST - 1
@@ -65,6 +85,11 @@ enum sc_netlink_commands {
 	NLSMARTCAPWAP_CMD_AUTH_STATION,
 	NLSMARTCAPWAP_CMD_DEAUTH_STATION,
 
+	NLSMARTCAPWAP_CMD_GET_HASH_STATS,
+	NLSMARTCAPWAP_CMD_GET_FRAGMENT_STATS,
+
+	NLSMARTCAPWAP_CMD_RECV_DATA_BATCH,
+
 	/* Last command */
 	__NLSMARTCAPWAP_CMD_AFTER_LAST,
 	NLSMARTCAPWAP_CMD_MAX = __NLSMARTCAPWAP_CMD_AFTER_LAST - 1
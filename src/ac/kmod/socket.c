@@ -1,4 +1,5 @@
 #include "config.h"
+#include <linux/version.h>
 #include <linux/module.h>
 #include <linux/sched.h>
 #include <linux/socket.h>
@@ -6,9 +7,14 @@
 #include <linux/net.h>
 #include <linux/if_ether.h>
 #include <linux/udp.h>
+#include <linux/netdevice.h>
+#include <linux/etherdevice.h>
 #include <net/ipv6.h>
 #include <net/sock.h>
 #include <net/udp.h>
+#include <net/route.h>
+#include <net/protocol.h>
+#include <net/udp_tunnel.h>
 #include "socket.h"
 #include "capwap.h"
 
@@ -16,6 +22,124 @@
 #define SOCKET_COUNT				2
 static struct socket* sc_sockets[SOCKET_COUNT];
 
+/* GRO of data channel, the udp_offload is removed by 4.7 and the packets are received one by one */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,7,0)
+static int sc_socket_offload_enabled;
+static struct udp_offload sc_socket_offload;
+
+/* Aggregate the plain 802.3 data packets of same session, the inner packets are aggregated by GRO of ethertype */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,0,0)
+static struct sk_buff** sc_socket_gro_receive(struct sk_buff** head, struct sk_buff* skb, struct udp_offload* uoff) {
+#else
+static struct sk_buff** sc_socket_gro_receive(struct sk_buff** head, struct sk_buff* skb) {
+#endif
+	struct sk_buff* p;
+	struct sk_buff** pp = NULL;
+	struct ethhdr* eh;
+	struct ethhdr* eh2;
+	struct sc_capwap_header* header;
+	struct sc_capwap_header* header2;
+	const struct packet_offload* ptype;
+	unsigned int hlen;
+	unsigned int offheader;
+	unsigned int offeth;
+	int flush = 1;
+
+	/* CAPWAP header */
+	offheader = skb_gro_offset(skb);
+	hlen = offheader + sizeof(struct sc_capwap_header);
+	header = (struct sc_capwap_header*)skb_gro_header_fast(skb, offheader);
+	if (skb_gro_header_hard(skb, hlen)) {
+		header = (struct sc_capwap_header*)skb_gro_header_slow(skb, hlen, offheader);
+		if (!header) {
+			goto out;
+		}
+	}
+
+	/* Keep-alive, fragments, 802.11 frames and header with options are processed one by one */
+	if ((GET_VERSION_HEADER(header) != CAPWAP_PROTOCOL_VERSION) || (GET_TYPE_HEADER(header) != CAPWAP_PREAMBLE_HEADER) || IS_FLAG_K_HEADER(header) || IS_FLAG_F_HEADER(header) ||
+		IS_FLAG_T_HEADER(header) || IS_FLAG_M_HEADER(header) || IS_FLAG_W_HEADER(header) || ((GET_HLEN_HEADER(header) * 4) != sizeof(struct sc_capwap_header))) {
+		goto out;
+	}
+
+	skb_gro_pull(skb, sizeof(struct sc_capwap_header));
+	skb_gro_postpull_rcsum(skb, header, sizeof(struct sc_capwap_header));
+
+	/* Ethernet header */
+	offeth = skb_gro_offset(skb);
+	hlen = offeth + sizeof(struct ethhdr);
+	eh = (struct ethhdr*)skb_gro_header_fast(skb, offeth);
+	if (skb_gro_header_hard(skb, hlen)) {
+		eh = (struct ethhdr*)skb_gro_header_slow(skb, hlen, offeth);
+		if (!eh) {
+			goto out;
+		}
+	}
+
+	/* The UDP/IP header of packets are already compared */
+	flush = 0;
+	for (p = *head; p; p = p->next) {
+		if (!NAPI_GRO_CB(p)->same_flow) {
+			continue;
+		}
+
+		header2 = (struct sc_capwap_header*)(p->data + offheader);
+		eh2 = (struct ethhdr*)(p->data + offeth);
+		if (memcmp(header, header2, sizeof(struct sc_capwap_header)) || compare_ether_header(eh, eh2)) {
+			NAPI_GRO_CB(p)->same_flow = 0;
+		}
+	}
+
+	/* */
+	rcu_read_lock();
+
+	ptype = gro_find_receive_by_type(eh->h_proto);
+	if (ptype) {
+		skb_gro_pull(skb, sizeof(struct ethhdr));
+		skb_gro_postpull_rcsum(skb, eh, sizeof(struct ethhdr));
+		pp = ptype->callbacks.gro_receive(head, skb);
+	} else {
+		flush = 1;
+	}
+
+	rcu_read_unlock();
+
+out:
+	NAPI_GRO_CB(skb)->flush |= flush;
+	return pp;
+}
+
+/* */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,0,0)
+static int sc_socket_gro_complete(struct sk_buff* skb, int nhoff, struct udp_offload* uoff) {
+#else
+static int sc_socket_gro_complete(struct sk_buff* skb, int nhoff) {
+#endif
+	int err = -ENOSYS;
+	struct ethhdr* eh;
+	const struct packet_offload* ptype;
+	int offeth = nhoff + sizeof(struct sc_capwap_header);
+
+	/* */
+	udp_tunnel_gro_complete(skb, nhoff);
+	skb_set_inner_mac_header(skb, offeth);
+
+	/* */
+	eh = (struct ethhdr*)(skb->data + offeth);
+
+	rcu_read_lock();
+
+	ptype = gro_find_complete_by_type(eh->h_proto);
+	if (ptype) {
+		err = ptype->callbacks.gro_complete(skb, offeth + sizeof(struct ethhdr));
+	}
+
+	rcu_read_unlock();
+
+	return err;
+}
+#endif
+
 /* */
 int sc_socket_recvpacket(struct sock* sk, struct sk_buff* skb) {
 	TRACEKMOD("### sc_socket_recvpacket\n");
@@ -149,11 +273,50 @@ int sc_socket_send(int type, uint8_t* buffer, int length, union capwap_addr* soc
 	return kernel_sendmsg(sc_sockets[type], &msg, &vec, 1, length);
 }
 
+/* Send socket buffer with CAPWAP header, the segmentation of GSO packet is offloaded to device or stack */
+int sc_socket_send_skb(int type, struct sk_buff* skb, union capwap_addr* sockaddr) {
+	int length = skb->len;
+	struct rtable* rt;
+	struct flowi4 fl4;
+	struct sock* sk = sc_sockets[type]->sk;
+
+	TRACEKMOD("### sc_socket_send_skb\n");
+
+	/* */
+	if (sockaddr->ss.ss_family != AF_INET) {
+		kfree_skb(skb);
+		return -EAFNOSUPPORT;
+	}
+
+	/* */
+	rt = ip_route_output_ports(sock_net(sk), &fl4, sk, sockaddr->sin.sin_addr.s_addr, inet_sk(sk)->inet_saddr, sockaddr->sin.sin_port, inet_sk(sk)->inet_sport, IPPROTO_UDP, 0, 0);
+	if (IS_ERR(rt)) {
+		kfree_skb(skb);
+		return PTR_ERR(rt);
+	}
+
+	/* Push UDP/IP header and send */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,6,0)
+	udp_tunnel_xmit_skb(rt, sk, skb, fl4.saddr, fl4.daddr, 0, ip4_dst_hoplimit(&rt->dst), 0, inet_sk(sk)->inet_sport, sockaddr->sin.sin_port, false, false);
+	return length;
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	return udp_tunnel_xmit_skb(rt, sk, skb, fl4.saddr, fl4.daddr, 0, ip4_dst_hoplimit(&rt->dst), 0, inet_sk(sk)->inet_sport, sockaddr->sin.sin_port, false, false);
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(4,0,0)
+	return udp_tunnel_xmit_skb(rt, skb, fl4.saddr, fl4.daddr, 0, ip4_dst_hoplimit(&rt->dst), 0, inet_sk(sk)->inet_sport, sockaddr->sin.sin_port, false, false);
+#else
+	return udp_tunnel_xmit_skb(sc_sockets[type], rt, skb, fl4.saddr, fl4.daddr, 0, ip4_dst_hoplimit(&rt->dst), 0, inet_sk(sk)->inet_sport, sockaddr->sin.sin_port, false);
+#endif
+}
+
 /* */
 int sc_socket_init(void) {
 	TRACEKMOD("### sc_socket_init\n");
 
 	memset(sc_sockets, 0, sizeof(sc_sockets));
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,7,0)
+	memset(&sc_socket_offload, 0, sizeof(struct udp_offload));
+	sc_socket_offload_enabled = 0;
+#endif
 	return 0;
 }
 
@@ -186,6 +349,16 @@ int sc_socket_bind(union capwap_addr* sockaddr) {
 		udpv6_encap_enable();
 	}
 
+	/* GRO of data channel */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,7,0)
+	sc_socket_offload.port = ((sockaddr->ss.ss_family == AF_INET) ? sockaddr->sin.sin_port : sockaddr->sin6.sin6_port);
+	sc_socket_offload.callbacks.gro_receive = sc_socket_gro_receive;
+	sc_socket_offload.callbacks.gro_complete = sc_socket_gro_complete;
+	if (!udp_add_offload(&sc_socket_offload)) {
+		sc_socket_offload_enabled = 1;
+	}
+#endif
+
 	return 0;
 
 failure:
@@ -197,6 +370,14 @@ failure:
 void sc_socket_close(void) {
 	TRACEKMOD("### sc_socket_close\n");
 
+	/* */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,7,0)
+	if (sc_socket_offload_enabled) {
+		udp_del_offload(&sc_socket_offload);
+		sc_socket_offload_enabled = 0;
+	}
+#endif
+
 	/* Close sockets */
 	if (sc_sockets[SOCKET_UDP]) {
 		kernel_sock_shutdown(sc_sockets[SOCKET_UDP], SHUT_RDWR);
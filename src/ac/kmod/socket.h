@@ -5,11 +5,17 @@
 #include <linux/in.h>
 #include <linux/in6.h>
 #include <linux/skbuff.h>
+#include <linux/netdevice.h>
+#include <linux/ipv6.h>
+#include <linux/udp.h>
 
 /* */
 #define SOCKET_UDP					0
 #define SOCKET_UDPLITE				1
 
+/* Headroom of UDP/IP encapsulation */
+#define SOCKET_SKB_HEADROOM			(LL_MAX_HEADER + sizeof(struct ipv6hdr) + sizeof(struct udphdr))
+
 /* Universal socket address */
 union capwap_addr {
 	struct sockaddr sa;
@@ -25,6 +31,7 @@ void sc_socket_close(void);
 /* */
 int sc_socket_bind(union capwap_addr* sockaddr);
 int sc_socket_send(int type, uint8_t* buffer, int length, union capwap_addr* sockaddr);
+int sc_socket_send_skb(int type, struct sk_buff* skb, union capwap_addr* sockaddr);
 
 /* */
 int sc_socket_getpeeraddr(struct sk_buff* skb, union capwap_addr* peeraddr);
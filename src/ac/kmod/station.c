@@ -1,25 +1,46 @@
 #include "config.h"
+#include <linux/version.h>
 #include <linux/module.h>
 #include <linux/kernel.h>
 #include <linux/slab.h>
 #include <linux/netdevice.h>
+#include <linux/jhash.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+#include <linux/rhashtable.h>
+#endif
 #include "station.h"
 #include "capwap.h"
 #include "iface.h"
 
 /* */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,1,0)
 #define STATION_HASH_SIZE					65536
+#endif
 
 /* */
 static LIST_HEAD(sc_station_list);
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+static struct rhashtable sc_station_hash_addr;
+
+/* Hash with jhash over all bytes of MAC address */
+static const struct rhashtable_params sc_station_hash_addr_params = {
+	.head_offset = offsetof(struct sc_capwap_station, node_addr),
+	.key_offset = offsetof(struct sc_capwap_station, address),
+	.key_len = MACADDRESS_EUI48_LENGTH,
+	.hashfn = jhash,
+	.automatic_shrinking = true,
+};
+#else
 static struct sc_capwap_station* __rcu sc_station_hash_addr[STATION_HASH_SIZE];
 
 /* */
 static uint32_t sc_stations_hash_addr(const uint8_t* macaddress) {
 	TRACEKMOD("### sc_stations_hash_addr\n");
 
-	return (((((uint32_t)macaddress[4] << 8) | (uint32_t)macaddress[5]) ^ ((uint32_t)macaddress[3] << 4)) % STATION_HASH_SIZE);
+	return (jhash(macaddress, MACADDRESS_EUI48_LENGTH, 0) % STATION_HASH_SIZE);
 }
+#endif
 
 /* */
 static struct sc_capwap_connection* sc_stations_searchconnection(struct sc_capwap_station* station) {
@@ -39,26 +60,68 @@ static struct sc_capwap_connection* sc_stations_searchconnection(struct sc_capwa
 }
 
 /* */
-void sc_stations_add(struct sc_capwap_station* station) {
+int sc_stations_init(void) {
+	TRACEKMOD("### sc_stations_init\n");
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	return rhashtable_init(&sc_station_hash_addr, &sc_station_hash_addr_params);
+#else
+	memset(sc_station_hash_addr, 0, sizeof(struct sc_capwap_station*) * STATION_HASH_SIZE);
+	return 0;
+#endif
+}
+
+/* */
+void sc_stations_close(void) {
+	TRACEKMOD("### sc_stations_close\n");
+
+	if (!list_empty(&sc_station_list)) {
+		TRACEKMOD("*** Bug: the list stations is not empty\n");
+	}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	rhashtable_destroy(&sc_station_hash_addr);
+#endif
+}
+
+/* */
+int sc_stations_add(struct sc_capwap_station* station) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	int err;
+#else
 	uint32_t hash;
+#endif
 
 	TRACEKMOD("### sc_stations_add\n");
 
 	/* */
-	list_add_rcu(&station->list, &sc_station_list);
-
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	err = rhashtable_insert_fast(&sc_station_hash_addr, &station->node_addr, sc_station_hash_addr_params);
+	if (err) {
+		TRACEKMOD("*** Unable to add station into hash table: %d\n", err);
+		return err;
+	}
+#else
 	hash = sc_stations_hash_addr(station->address);
 	station->next_addr = rcu_dereference_protected(sc_station_hash_addr[hash], sc_capwap_update_lock_is_locked());
 	rcu_assign_pointer(sc_station_hash_addr[hash], station);
+#endif
+
+	list_add_rcu(&station->list, &sc_station_list);
+	return 0;
 }
 
 /* */
 struct sc_capwap_station* sc_stations_search(const uint8_t* macaddress) {
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,1,0)
 	struct sc_capwap_station* station;
+#endif
 
 	TRACEKMOD("### sc_stations_search\n");
 
-	/* */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	return rhashtable_lookup_fast(&sc_station_hash_addr, macaddress, sc_station_hash_addr_params);
+#else
 	station = rcu_dereference_check(sc_station_hash_addr[sc_stations_hash_addr(macaddress)], sc_capwap_update_lock_is_locked());
 	while (station) {
 		if (!memcmp(&station->address, macaddress, MACADDRESS_EUI48_LENGTH)) {
@@ -70,16 +133,56 @@ struct sc_capwap_station* sc_stations_search(const uint8_t* macaddress) {
 	}
 
 	return station;
+#endif
+}
+
+/* */
+void sc_stations_hashstats(struct sc_capwap_hashstats* stats) {
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,1,0)
+	unsigned long i;
+	uint32_t chain;
+	struct sc_capwap_station* station;
+#endif
+
+	TRACEKMOD("### sc_stations_hashstats\n");
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	sc_capwap_hashstats(&sc_station_hash_addr, stats);
+#else
+	memset(stats, 0, sizeof(struct sc_capwap_hashstats));
+
+	/* */
+	rcu_read_lock();
+
+	stats->buckets = STATION_HASH_SIZE;
+	for (i = 0; i < STATION_HASH_SIZE; i++) {
+		chain = 0;
+		for (station = rcu_dereference(sc_station_hash_addr[i]); station; station = rcu_dereference(station->next_addr)) {
+			chain++;
+		}
+
+		/* */
+		stats->elements += chain;
+		sc_capwap_hashstats_chain(stats, chain);
+	}
+
+	rcu_read_unlock();
+#endif
 }
 
 /* */
 void sc_stations_free(struct sc_capwap_station* station) {
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,1,0)
 	uint32_t hash;
 	struct sc_capwap_station* search;
+#endif
 
 	TRACEKMOD("### sc_stations_free\n");
 
 	/* */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	rhashtable_remove_fast(&sc_station_hash_addr, &station->node_addr, sc_station_hash_addr_params);
+#else
 	hash = sc_stations_hash_addr(station->address);
 	search = rcu_dereference_protected(sc_station_hash_addr[hash], sc_capwap_update_lock_is_locked());
 
@@ -96,8 +199,10 @@ void sc_stations_free(struct sc_capwap_station* station) {
 			}
 		}
 	}
+#endif
 
 	/* */
+	list_del_rcu(&station->list);
 	list_del_rcu(&station->list_dev);
 	list_del_rcu(&station->list_session);
 	synchronize_net();
@@ -1,6 +1,10 @@
 #ifndef __KMOD_AC_STATION_HEADER__
 #define __KMOD_AC_STATION_HEADER__
 
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+#include <linux/rhashtable.h>
+#endif
 #include "capwap_rfc.h"
 
 /* */
@@ -27,7 +31,11 @@ struct sc_capwap_station {
 
 	/* */
 	uint8_t address[MACADDRESS_EUI48_LENGTH];
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0)
+	struct rhash_head node_addr;
+#else
 	struct sc_capwap_station* __rcu next_addr;
+#endif
 
 	/* Session */
 	struct sc_capwap_session_priv* __rcu sessionpriv;
@@ -45,12 +53,20 @@ struct sc_capwap_station {
 };
 
 /* */
-void sc_stations_add(struct sc_capwap_station* station);
+int sc_stations_init(void);
+void sc_stations_close(void);
+
+/* */
+int sc_stations_add(struct sc_capwap_station* station);
 void sc_stations_free(struct sc_capwap_station* station);
 
 /* */
 struct sc_capwap_station* sc_stations_search(const uint8_t* macaddress);
 
+/* */
+struct sc_capwap_hashstats;
+void sc_stations_hashstats(struct sc_capwap_hashstats* stats);
+
 /* */
 int sc_stations_setconnection(struct sc_capwap_station* station);
 void sc_stations_releaseconnection(struct sc_capwap_station* station);
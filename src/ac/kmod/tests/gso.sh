@@ -0,0 +1,117 @@
+#!/bin/bash
+#
+# GSO transmit and GRO receive of AC kernel module data channel
+#
+# The receive runs send IPv4/TCP segments of a flow for every session from
+# the WTP namespace, sctest.py recv counts the packets delivered to capwap
+# interface after GRO: with GRO on the packets are larger than the frames
+# sent. The GRO of capwap interface aggregates the inner TCP segments, the GRO
+# of veth aggregates the CAPWAP datagrams by the udp_offload of module.
+#
+# The transmit runs inject GSO packets of --size bytes to the stations from
+# capwap interface and sctest.py sink counts the datagrams received by the
+# WTPs. With TSO off on capwap interface the stack segments every packet
+# before the module, with TSO on the module encapsulates it once and the
+# segments are cut after the UDP/IP encapsulation.
+#
+# Usage: gso.sh [-s sessions] [-t seconds] [-l size] [-g size] [-G size] smartcapwap.ko
+#   -s sessions  WTP sessions (default 4)
+#   -t seconds   duration of every run (default 10)
+#   -l size      frame size of receive runs (default 1414)
+#   -g size      GSO packet size of transmit runs (default 65000)
+#   -G size      TCP payload of every GSO segment (default 1300)
+#
+# Run as root with ethtool, the module must not be loaded because the script
+# loads and removes it. The veth does GRO only with NAPI, that is on kernels
+# that enable it with the gro feature or with a XDP program attached, the
+# error of ethtool on the veth is ignored. The udp_offload of module is
+# removed with 4.7, on those kernels only the GRO of capwap interface runs.
+
+. "$(dirname "$0")/netns.sh"
+
+SESSIONS=4
+DURATION=10
+SIZE=1414
+GSOSIZE=65000
+SEGMENT=1300
+
+while getopts "s:t:l:g:G:h" opt; do
+	case "${opt}" in
+		s) SESSIONS="${OPTARG}" ;;
+		t) DURATION="${OPTARG}" ;;
+		l) SIZE="${OPTARG}" ;;
+		g) GSOSIZE="${OPTARG}" ;;
+		G) SEGMENT="${OPTARG}" ;;
+		*) sed -n '/^# Usage/,/^#$/p' "$0" >&2; exit 1 ;;
+	esac
+done
+
+shift $((OPTIND - 1))
+[ $# -eq 1 ] || sc_fail "Usage: $0 [options] smartcapwap.ko"
+command -v ethtool > /dev/null || sc_fail "ethtool not found"
+
+sc_setup "$1"
+sc_start_ac "${SESSIONS}" 1
+
+# Usage: receive on|off
+receive() {
+	local senders="$(nproc)"
+	local pids
+	local first
+	local count
+	local i
+
+	[ "${senders}" -le "${SESSIONS}" ] || senders="${SESSIONS}"
+	ethtool -K "${SC_CAPWAP_IF}" gro "$1" || sc_fail "Unable to set GRO of ${SC_CAPWAP_IF}"
+	ethtool -K "${SC_AC_IF}" gro "$1" 2> /dev/null
+
+	${SC_TOOL} recv --tcp --iface "${SC_CAPWAP_IF}" --duration "$((DURATION + 2))" > "${SC_TMP}/recv.log" &
+	pids=($!)
+	sleep 0.5
+
+	for i in $(seq 0 $((senders - 1))); do
+		first=$((SESSIONS * i / senders))
+		count=$((SESSIONS * (i + 1) / senders - first))
+		sc_wtp taskset -c "${i}" ${SC_TOOL} send --tcp --ac "${SC_AC_ADDR}" --first "${first}" --sessions "${count}" --size "${SIZE}" --duration "${DURATION}" > "${SC_TMP}/send.${i}.log" &
+		pids+=($!)
+	done
+
+	wait "${pids[@]}"
+
+	echo "=== receive, GRO $1, frame size: ${SIZE}"
+	awk '{ sent += $2; rate += $6 } END { printf "sent: %d frames, %.0f frames/s\n", sent, rate }' "${SC_TMP}"/send.*.log
+	cat "${SC_TMP}/recv.log"
+	rm -f "${SC_TMP}"/send.*.log
+	echo
+}
+
+# Usage: transmit on|off
+transmit() {
+	local pid
+
+	ethtool -K "${SC_CAPWAP_IF}" tso "$1" || sc_fail "Unable to set TSO of ${SC_CAPWAP_IF}"
+
+	sc_wtp ${SC_TOOL} sink --ac "${SC_AC_ADDR}" --sessions "${SESSIONS}" --duration "$((DURATION + 2))" > "${SC_TMP}/sink.log" &
+	pid=$!
+	sleep 1
+
+	${SC_TOOL} inject --iface "${SC_CAPWAP_IF}" --sessions "${SESSIONS}" --size "${GSOSIZE}" --gso-size "${SEGMENT}" --duration "${DURATION}" > "${SC_TMP}/inject.log"
+	wait "${pid}"
+
+	echo "=== transmit, TSO $1, packet size: ${GSOSIZE}, segment: ${SEGMENT}"
+	cat "${SC_TMP}/inject.log"
+	grep "^received" "${SC_TMP}/sink.log"
+	echo
+}
+
+# */
+echo "module: $1, sessions: ${SESSIONS}, duration: ${DURATION} s"
+echo
+
+for offload in off on; do
+	receive "${offload}"
+done
+
+for offload in off on; do
+	transmit "${offload}"
+done
@@ -0,0 +1,62 @@
+#!/bin/bash
+#
+# Broadcast fan-out of AC kernel module to the WTP sessions
+#
+# sctest.py inject sends ARP requests to the broadcast address from capwap
+# interface, the module sends a clone of every request to all sessions and
+# sctest.py sink receives the datagrams of sessions into the WTP namespace.
+# Every clone shares the payload and has its own CAPWAP header, sink checks
+# that the frame after the CAPWAP header is the same ARP request sent.
+#
+# Usage: multicast.sh [-s sessions] [-n count] [-r rate] [-l size] smartcapwap.ko
+#   -s sessions  WTP sessions (default 1000)
+#   -n count     ARP requests (default 1000)
+#   -r rate      ARP requests/s (default 100)
+#   -l size      frame size, from 62 bytes (default 62)
+#
+# Run as root, the module must not be loaded because the script loads and
+# removes it. The test fails on a modified frame or a session that misses a
+# request. The datagrams/s of sink are the rate of fan-out, raise the rate
+# of requests until sink reports lost frames to find the limit of the module
+# or of sink.
+
+. "$(dirname "$0")/netns.sh"
+
+SESSIONS=1000
+COUNT=1000
+RATE=100
+SIZE=62
+
+while getopts "s:n:r:l:h" opt; do
+	case "${opt}" in
+		s) SESSIONS="${OPTARG}" ;;
+		n) COUNT="${OPTARG}" ;;
+		r) RATE="${OPTARG}" ;;
+		l) SIZE="${OPTARG}" ;;
+		*) sed -n '/^# Usage/,/^#$/p' "$0" >&2; exit 1 ;;
+	esac
+done
+
+shift $((OPTIND - 1))
+[ $# -eq 1 ] || sc_fail "Usage: $0 [options] smartcapwap.ko"
+
+sc_setup "$1"
+sc_start_ac "${SESSIONS}" 1
+
+# The sink activates the sessions with a Keep-Alive and stops about two seconds after the requests
+DURATION=$(((COUNT + RATE - 1) / RATE))
+sc_wtp ${SC_TOOL} sink --verify --ac "${SC_AC_ADDR}" --sessions "${SESSIONS}" --size "${SIZE}" --duration "$((DURATION + 3))" > "${SC_TMP}/sink.log" &
+PID=$!
+sleep 1
+
+${SC_TOOL} inject --broadcast --iface "${SC_CAPWAP_IF}" --size "${SIZE}" --rate "${RATE}" --count "${COUNT}" --duration "$((DURATION + 1))" > "${SC_TMP}/inject.log"
+wait "${PID}"
+
+# */
+echo "module: $1"
+echo "sessions: ${SESSIONS}, requests: ${COUNT}, rate: ${RATE} requests/s, frame size: ${SIZE}"
+cat "${SC_TMP}/inject.log" "${SC_TMP}/sink.log"
+
+SENT="$(awk '/^sent:/ { print $2 }' "${SC_TMP}/inject.log")"
+awk -v sent="${SENT}" '/^verified:/ { gsub(",", ""); ok = (($5 == 0) && ($10 == sent)) } END { exit !ok }' "${SC_TMP}/sink.log" || sc_fail "FAIL: modified frames or sessions with lost requests"
+echo "PASS"
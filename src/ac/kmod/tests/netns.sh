@@ -0,0 +1,109 @@
+#
+# Network namespace of the kernel module tests, sourced by the test scripts
+#
+# The module creates its sockets and capwap interface into the initial network
+# namespace, the AC side of veth pair stays there. The WTPs run into the
+# namespace sc-wtp with the other side of veth pair:
+#
+#   [ init: smartcapwap.ko, sc-ac 10.253.0.1, sctest0 ] <-veth-> [ sc-wtp: sc-wtp 10.253.0.2 ]
+#
+# Any state is removed on exit, also on error and interrupt.
+
+SC_TESTS_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+SC_TOOL="python3 ${SC_TESTS_DIR}/sctest.py"
+
+SC_NETNS="sc-wtp"
+SC_AC_IF="sc-ac"
+SC_WTP_IF="sc-wtp"
+SC_AC_ADDR="10.253.0.1"
+SC_WTP_ADDR="10.253.0.2"
+SC_CAPWAP_IF="sctest0"
+SC_QUEUES="$(nproc)"
+
+SC_AC_PID=""
+SC_TMP=""
+
+# */
+sc_fail() {
+	echo "$*" >&2
+	exit 1
+}
+
+# */
+sc_cleanup() {
+	if [ -n "${SC_AC_PID}" ]; then
+		kill "${SC_AC_PID}" 2>/dev/null
+		wait "${SC_AC_PID}" 2>/dev/null
+		SC_AC_PID=""
+	fi
+
+	# The module is unlocked when the link of sctest.py is closed
+	if grep -qs "^smartcapwap " /proc/modules; then
+		rmmod smartcapwap 2>/dev/null
+	fi
+
+	ip netns del "${SC_NETNS}" 2>/dev/null
+	ip link del "${SC_AC_IF}" 2>/dev/null
+
+	if [ -n "${SC_TMP}" ]; then
+		rm -rf "${SC_TMP}"
+		SC_TMP=""
+	fi
+}
+
+# Usage: sc_setup module.ko [module parameters]
+sc_setup() {
+	local kmod="$1"
+	shift
+
+	[ "$(id -u)" -eq 0 ] || sc_fail "The tests must run as root"
+	[ -f "${kmod}" ] || sc_fail "Kernel module ${kmod} not found"
+	if grep -qs "^smartcapwap " /proc/modules; then
+		sc_fail "Module smartcapwap is already loaded, stop the AC and remove it"
+	fi
+
+	trap sc_cleanup EXIT
+	trap "exit 1" INT TERM
+	SC_TMP="$(mktemp -d)"
+
+	# A queue for every CPU, the senders pinned to different CPUs reach the module from those CPUs
+	ip netns add "${SC_NETNS}" || sc_fail "Unable to create namespace ${SC_NETNS}"
+	ip link add "${SC_AC_IF}" numtxqueues "${SC_QUEUES}" numrxqueues "${SC_QUEUES}" type veth peer name "${SC_WTP_IF}" numtxqueues "${SC_QUEUES}" numrxqueues "${SC_QUEUES}" netns "${SC_NETNS}" || sc_fail "Unable to create veth pair"
+	ip addr add "${SC_AC_ADDR}/24" dev "${SC_AC_IF}"
+	ip link set "${SC_AC_IF}" up
+	ip -n "${SC_NETNS}" addr add "${SC_WTP_ADDR}/24" dev "${SC_WTP_IF}"
+	ip -n "${SC_NETNS}" link set "${SC_WTP_IF}" up
+	ip -n "${SC_NETNS}" link set lo up
+
+	insmod "${kmod}" "$@" || sc_fail "Unable to load ${kmod}"
+}
+
+# Usage: sc_start_ac sessions stations [sctest.py ac options]
+sc_start_ac() {
+	local sessions="$1"
+	local stations="$2"
+	local i
+	shift 2
+
+	${SC_TOOL} ac --iface "${SC_CAPWAP_IF}" --address "${SC_AC_ADDR}" --sessions "${sessions}" --stations "${stations}" "$@" > "${SC_TMP}/ac.log" 2>&1 &
+	SC_AC_PID=$!
+
+	for i in $(seq 1 100); do
+		if grep -q "^ready" "${SC_TMP}/ac.log"; then
+			ip link set "${SC_CAPWAP_IF}" up
+			return 0
+		elif ! kill -0 "${SC_AC_PID}" 2>/dev/null; then
+			cat "${SC_TMP}/ac.log" >&2
+			sc_fail "Unable to configure the kernel module"
+		fi
+
+		sleep 0.1
+	done
+
+	sc_fail "Timeout of kernel module configuration"
+}
+
+# Usage: sc_wtp command [arguments], run into the WTP namespace
+sc_wtp() {
+	ip netns exec "${SC_NETNS}" "$@"
+}
@@ -0,0 +1,50 @@
+#!/bin/bash
+#
+# Run-to-completion in softirq against the worker threads of AC kernel module
+#
+# Every mode is measured twice with throughput.sh: a throughput run with
+# unlimited senders and a latency run with paced senders, where the one-way
+# latency is not dominated by the queues of an overloaded receiver.
+#
+# Usage: runtocompletion.sh [-s sessions] [-t seconds] [-l size] [-r rate] smartcapwap.ko
+#   -s sessions  WTP sessions (default 64)
+#   -t seconds   duration of every run (default 10)
+#   -l size      frame size (default 64)
+#   -r rate      frames/s of every sender into latency run (default 10000)
+#
+# Run as root with more than one CPU, the module must not be loaded.
+
+SESSIONS=64
+DURATION=10
+SIZE=64
+RATE=10000
+
+while getopts "s:t:l:r:h" opt; do
+	case "${opt}" in
+		s) SESSIONS="${OPTARG}" ;;
+		t) DURATION="${OPTARG}" ;;
+		l) SIZE="${OPTARG}" ;;
+		r) RATE="${OPTARG}" ;;
+		*) sed -n '/^# Usage/,/^#$/p' "$0" >&2; exit 1 ;;
+	esac
+done
+
+shift $((OPTIND - 1))
+if [ $# -ne 1 ]; then
+	echo "Usage: $0 [options] smartcapwap.ko" >&2
+	exit 1
+fi
+
+# */
+run() {
+	"$(dirname "$0")/throughput.sh" -s "${SESSIONS}" -t "${DURATION}" -l "${SIZE}" "$@" || exit 1
+}
+
+for mode in 0 1; do
+	echo "=== runtocompletion=${mode}, throughput"
+	run -p "runtocompletion=${mode}" "$1"
+	echo
+	echo "=== runtocompletion=${mode}, latency at ${RATE} frames/s for sender"
+	run -p "runtocompletion=${mode}" -r "${RATE}" "$1"
+	echo
+done
@@ -0,0 +1,583 @@
+#!/usr/bin/env python3
+#
+# Test tool of SmartCAPWAP AC kernel module, without AC and WTP
+#
+# The ac command is the user space of kernel module: it links to the module by
+# generic netlink, creates the capwap interface, binds the data channel and
+# creates the sessions with a IEEE 802.3 tunnel WLAN and the authorized
+# stations. The module sockets and interface live in the initial network
+# namespace, the AC side run there.
+#
+# The send command simulate the WTPs, from the WTP namespace: every session is
+# a UDP socket that activates the session with a Keep-Alive and then sends data
+# frames of its stations. The frames carry
+#   session [u32], sequence [u64], send time [u64, CLOCK_MONOTONIC ns]
+# with the local experimental ethertype 0x88b5.
+#
+# The recv command counts the frames delivered by kernel module to capwap
+# interface: packets/s, lost and reordered frames of every session and the
+# one-way latency, the namespaces share the same monotonic clock.
+#
+# With --tcp the frames are IPv4/TCP segments of a flow for every station,
+# aggregated by GRO of module, and recv reports the packets and bytes seen
+# after GRO.
+#
+# The inject command sends frames to the stations from capwap interface, the
+# TCP frames larger than --gso-size are GSO packets with virtio_net_hdr. The
+# sink command receives the datagrams of sessions into the WTP namespace.
+#
+# With --broadcast inject sends ARP requests to the broadcast address, fanned
+# out by module to every session, with the test payload after the ARP packet.
+# sink --verify checks that the frame after the CAPWAP header of every
+# datagram is the same frame sent and counts the frames of every session.
+#
+# The sessions are numbered from 0, session N is
+#   session id     00..00 5343 0000 <N>
+#   WTP port       --wtp-port + N
+#   stations       02:53:43:<N>:<S>, S from 0 to --stations - 1
+#   TCP flow       10.<N>.<S + 1>:<10000 + S> -> 10.255.255.254:5001
+
+import argparse
+import os
+import select
+import signal
+import socket
+import struct
+import sys
+import time
+
+# Generic netlink
+NETLINK_GENERIC = 16
+GENL_ID_CTRL = 0x10
+CTRL_CMD_GETFAMILY = 3
+CTRL_ATTR_FAMILY_ID = 1
+CTRL_ATTR_FAMILY_NAME = 2
+NLM_F_REQUEST = 0x01
+NLM_F_ACK = 0x04
+NLMSG_ERROR = 0x02
+
+# nlsmartcapwap.h
+NLSMARTCAPWAP_GENL_NAME = "smartcapwap_ac"
+
+NLSMARTCAPWAP_ATTR_SESSION_ID = 2
+NLSMARTCAPWAP_ATTR_RADIOID = 3
+NLSMARTCAPWAP_ATTR_WLANID = 4
+NLSMARTCAPWAP_ATTR_BINDING = 5
+NLSMARTCAPWAP_ATTR_MACMODE = 6
+NLSMARTCAPWAP_ATTR_TUNNELMODE = 7
+NLSMARTCAPWAP_ATTR_ADDRESS = 8
+NLSMARTCAPWAP_ATTR_MTU = 9
+NLSMARTCAPWAP_ATTR_IFPHY_NAME = 11
+NLSMARTCAPWAP_ATTR_IFPHY_INDEX = 12
+NLSMARTCAPWAP_ATTR_MACADDRESS = 13
+
+NLSMARTCAPWAP_CMD_LINK = 1
+NLSMARTCAPWAP_CMD_ADD_IFACE = 2
+NLSMARTCAPWAP_CMD_BIND = 4
+NLSMARTCAPWAP_CMD_NEW_SESSION = 7
+NLSMARTCAPWAP_CMD_ADD_WLAN = 9
+NLSMARTCAPWAP_CMD_AUTH_STATION = 13
+
+# CAPWAP
+CAPWAP_WIRELESS_BINDING_IEEE80211 = 1
+CAPWAP_ELEMENT_SESSIONID = 35
+CAPWAP_ADD_WLAN_MACMODE_SPLIT = 1
+CAPWAP_ADD_WLAN_TUNNELMODE_8023 = 1
+
+# Test frames
+ETH_P_TEST = 0x88b5
+ETH_P_IP = 0x0800
+ETH_P_ARP = 0x0806
+ETH_BROADCAST = b"\xff" * 6
+BROADCAST_SESSION = 0xffffffff
+ETH_P_ALL = 0x0003
+TCP_HEADERS = 14 + 20 + 20
+TCP_SERVER = bytes([ 10, 255, 255, 254 ])
+TEST_PAYLOAD = struct.Struct("!IQQ")
+DEFAULT_GATEWAY = bytes.fromhex("025343ffffff")
+DEFAULT_BSSID = bytes.fromhex("025343fffffe")
+
+# */
+def session_id(index):
+	return struct.pack("!QQ", 0x5343, index)
+
+# */
+def station_address(session, station):
+	return bytes([ 0x02, 0x53, 0x43, (session >> 8) & 0xff, session & 0xff, station & 0xff ])
+
+# CAPWAP header without optional fields, RFC 5415
+def capwap_header(keepalive=False):
+	flags = (2 << 19) | (1 << 14) | (CAPWAP_WIRELESS_BINDING_IEEE80211 << 9)
+	if keepalive:
+		flags |= (1 << 3)
+
+	return struct.pack("!IHH", flags, 0, 0)
+
+# Data channel Keep-Alive with Session ID message element
+def capwap_keepalive(index):
+	element = struct.pack("!HH", CAPWAP_ELEMENT_SESSIONID, 16) + session_id(index)
+	return capwap_header(True) + struct.pack("!H", 2 + len(element)) + element
+
+# IEEE 802.3 data frame of a station
+def ethernet_frame(destination, source, payload, size):
+	frame = destination + source + struct.pack("!H", ETH_P_TEST) + payload
+	return frame + bytes(max(0, size - len(frame)))
+
+# Internet checksum, RFC 1071
+def checksum(data, initial=0):
+	if len(data) & 1:
+		data += b"\0"
+
+	value = initial + sum(struct.unpack("!%dH" % (len(data) // 2), data))
+	while value >> 16:
+		value = (value & 0xffff) + (value >> 16)
+
+	return value
+
+# IEEE 802.3 IPv4/TCP segment of a station flow, the downlink segments have the partial checksum of GSO
+def tcp_frame(destination, source, session, station, sequence, size, downlink=False):
+	address = bytes([ 10, (session >> 8) & 0xff, session & 0xff, (station + 1) & 0xff ])
+	saddr, daddr = ((TCP_SERVER, address) if downlink else (address, TCP_SERVER))
+	sport, dport = ((5001, 10000 + station) if downlink else (10000 + station, 5001))
+	payload = bytes(max(0, size - TCP_HEADERS))
+	ipid = (sequence // max(1, len(payload))) & 0xffff
+
+	ip = struct.pack("!BBHHHBBH4s4s", 0x45, 0, 40 + len(payload), ipid, 0x4000, 64, socket.IPPROTO_TCP, 0, saddr, daddr)
+	ip = ip[:10] + struct.pack("!H", ~checksum(ip) & 0xffff) + ip[12:]
+
+	pseudo = checksum(saddr + daddr + struct.pack("!HH", socket.IPPROTO_TCP, 20 + len(payload)))
+	tcp = struct.pack("!HHIIBBHHH", sport, dport, sequence & 0xffffffff, 0, 5 << 4, 0x10, 65535, 0, 0)
+	if downlink:
+		tcp = tcp[:16] + struct.pack("!H", pseudo) + tcp[18:]
+	else:
+		tcp = tcp[:16] + struct.pack("!H", ~checksum(tcp + payload, pseudo) & 0xffff) + tcp[18:]
+
+	return destination + source + struct.pack("!H", ETH_P_IP) + ip + tcp + payload
+
+# ARP request of gateway to broadcast address, the test payload follows the ARP packet
+def arp_frame(source, sequence, size):
+	arp = struct.pack("!HHBBH6s4s6s4s", 1, ETH_P_IP, 6, 4, 1, source, TCP_SERVER, bytes(6), bytes([ 10, 0, (sequence >> 8) & 0xff, sequence & 0xff ]))
+	frame = ETH_BROADCAST + source + struct.pack("!H", ETH_P_ARP) + arp + TEST_PAYLOAD.pack(BROADCAST_SESSION, sequence, 0)
+	return frame + bytes(max(0, size - len(frame)))
+
+# */
+def sockaddr_storage(address, port):
+	family, _, _, _, sockaddr = socket.getaddrinfo(address, port, 0, socket.SOCK_DGRAM)[0]
+	if family == socket.AF_INET:
+		data = struct.pack("=H", family) + struct.pack("!H", port) + socket.inet_pton(family, sockaddr[0])
+	else:
+		data = struct.pack("=H", family) + struct.pack("!HI", port, 0) + socket.inet_pton(family, sockaddr[0]) + struct.pack("=I", sockaddr[3])
+
+	return data + bytes(128 - len(data))
+
+# Generic netlink socket
+class Genl:
+	def __init__(self):
+		self.sock = socket.socket(socket.AF_NETLINK, socket.SOCK_RAW, NETLINK_GENERIC)
+		self.sock.bind((0, 0))
+		self.seq = 0
+
+	@staticmethod
+	def attr(type, data):
+		length = 4 + len(data)
+		return struct.pack("=HH", length, type) + data + bytes((4 - (length % 4)) % 4)
+
+	@staticmethod
+	def attrs(data):
+		result = {}
+		while len(data) >= 4:
+			length, type = struct.unpack_from("=HH", data)
+			result[type & 0x3fff] = data[4:length]
+			data = data[(length + 3) & ~3:]
+
+		return result
+
+	def request(self, family, command, attrs=b""):
+		self.seq += 1
+		payload = struct.pack("=BBH", command, 1, 0) + attrs
+		self.sock.send(struct.pack("=IHHII", 16 + len(payload), family, NLM_F_REQUEST | NLM_F_ACK, self.seq, 0) + payload)
+
+		reply = {}
+		while True:
+			data = self.sock.recv(65536)
+			while len(data) >= 16:
+				length, type, _, seq, _ = struct.unpack_from("=IHHII", data)
+				if seq == self.seq:
+					if type == NLMSG_ERROR:
+						error = struct.unpack_from("=i", data, 16)[0]
+						if error:
+							raise OSError(-error, "%s command %d" % (os.strerror(-error), command))
+
+						return reply
+
+					reply = self.attrs(data[20:length])
+
+				data = data[(length + 3) & ~3:]
+
+	def family(self, name):
+		reply = self.request(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, self.attr(CTRL_ATTR_FAMILY_NAME, name.encode() + b"\0"))
+		return struct.unpack("=H", reply[CTRL_ATTR_FAMILY_ID][:2])[0]
+
+# User space of kernel module
+def command_ac(args):
+	genl = Genl()
+	family = genl.family(NLSMARTCAPWAP_GENL_NAME)
+
+	genl.request(family, NLSMARTCAPWAP_CMD_LINK)
+	reply = genl.request(family, NLSMARTCAPWAP_CMD_ADD_IFACE, genl.attr(NLSMARTCAPWAP_ATTR_IFPHY_NAME, args.iface.encode() + b"\0") + genl.attr(NLSMARTCAPWAP_ATTR_MTU, struct.pack("=H", args.mtu)))
+	ifindex = struct.unpack("=I", reply[NLSMARTCAPWAP_ATTR_IFPHY_INDEX])[0]
+	genl.request(family, NLSMARTCAPWAP_CMD_BIND, genl.attr(NLSMARTCAPWAP_ATTR_ADDRESS, sockaddr_storage(args.address, args.port)))
+
+	for index in range(args.sessions):
+		sessionid = genl.attr(NLSMARTCAPWAP_ATTR_SESSION_ID, session_id(index))
+		radio = genl.attr(NLSMARTCAPWAP_ATTR_RADIOID, b"\x01") + genl.attr(NLSMARTCAPWAP_ATTR_WLANID, b"\x01")
+
+		genl.request(family, NLSMARTCAPWAP_CMD_NEW_SESSION, sessionid + genl.attr(NLSMARTCAPWAP_ATTR_BINDING, bytes([ CAPWAP_WIRELESS_BINDING_IEEE80211 ])) + genl.attr(NLSMARTCAPWAP_ATTR_MTU, struct.pack("=H", args.mtu)))
+		genl.request(family, NLSMARTCAPWAP_CMD_ADD_WLAN, sessionid + radio + genl.attr(NLSMARTCAPWAP_ATTR_MACADDRESS, DEFAULT_BSSID) + genl.attr(NLSMARTCAPWAP_ATTR_MACMODE, bytes([ CAPWAP_ADD_WLAN_MACMODE_SPLIT ])) + genl.attr(NLSMARTCAPWAP_ATTR_TUNNELMODE, bytes([ CAPWAP_ADD_WLAN_TUNNELMODE_8023 ])))
+		for station in range(args.stations):
+			genl.request(family, NLSMARTCAPWAP_CMD_AUTH_STATION, sessionid + radio + genl.attr(NLSMARTCAPWAP_ATTR_MACADDRESS, station_address(index, station)) + genl.attr(NLSMARTCAPWAP_ATTR_IFPHY_INDEX, struct.pack("=I", ifindex)))
+
+	print("ready %s %d sessions" % (args.iface, args.sessions), flush=True)
+
+	# The link is closed with the socket, drain the notifications of module until terminated
+	signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+	try:
+		while True:
+			genl.sock.recv(65536)
+	except KeyboardInterrupt:
+		pass
+
+# WTPs
+def command_send(args):
+	sockets = []
+	stations = [ [ station_address(index, station) for station in range(args.stations) ] for index in range(args.first, args.first + args.sessions) ]
+	destination = (args.ac, args.port)
+
+	for index in range(args.first, args.first + args.sessions):
+		sock = socket.socket(socket.AF_INET6 if ":" in args.ac else socket.AF_INET, socket.SOCK_DGRAM)
+		sock.bind(("", args.wtp_port + index))
+		sock.connect(destination)
+		sock.send(capwap_keepalive(index))
+		sockets.append(sock)
+
+	time.sleep(0.5)
+
+	# Frames of sessions interleaved, optionally paced to rate frames/s
+	header = capwap_header()
+	sequence = [ 0 ] * args.sessions
+	sent = 0
+	errors = 0
+	start = time.monotonic()
+	deadline = start + args.duration
+	interval = ((1.0 / args.rate) if args.rate else 0)
+	due = start
+
+	while True:
+		now = time.monotonic()
+		if (now >= deadline) or (args.count and (sent >= args.count)):
+			break
+
+		if interval:
+			if now < due:
+				time.sleep(due - now)
+
+			due += interval
+
+		index = sent % args.sessions
+		station = sequence[index] % args.stations
+		if args.tcp:
+			frame = tcp_frame(args.gateway, stations[index][station], args.first + index, station, (sequence[index] // args.stations) * (args.size - TCP_HEADERS), args.size)
+		else:
+			frame = ethernet_frame(args.gateway, stations[index][station], TEST_PAYLOAD.pack(args.first + index, sequence[index], time.monotonic_ns()), args.size)
+
+		try:
+			sockets[index].send(header + frame)
+		except OSError:
+			errors += 1
+
+		sequence[index] += 1
+		sent += 1
+
+	elapsed = time.monotonic() - start
+	print("sent: %d frames, %d errors, %.0f frames/s" % (sent, errors, sent / elapsed), flush=True)
+
+# Packets and bytes of TCP frames delivered to capwap interface, after GRO
+def recv_tcp(args):
+	sock = socket.socket(socket.AF_PACKET, socket.SOCK_RAW, socket.htons(ETH_P_IP))
+	sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 64 * 1024 * 1024)
+	sock.bind((args.iface, ETH_P_IP))
+
+	received = 0
+	length = 0
+	first = None
+	stop = time.monotonic() + args.duration
+
+	signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+	try:
+		while time.monotonic() < stop:
+			if not select.select([ sock ], [], [], 0.2)[0]:
+				continue
+
+			# The length of aggregated packet and not only the captured part
+			length += len(sock.recv(65536, socket.MSG_TRUNC))
+			received += 1
+			finish = time.monotonic()
+			if first is None:
+				first = finish
+	except (KeyboardInterrupt, SystemExit):
+		pass
+
+	stats = sock.getsockopt(263, 6, 8)
+	drops = struct.unpack("=II", stats)[1]
+	elapsed = ((finish - first) if first else 0)
+
+	print("received: %d packets, %d bytes, %.0f bytes/packet, %.1f Mbit/s" % (received, length, (length / received) if received else 0, ((length * 8) / (elapsed * 1000000)) if elapsed else 0))
+	print("receiver drops: %d" % drops)
+	sys.stdout.flush()
+
+# Frames delivered to capwap interface
+def command_recv(args):
+	if args.tcp:
+		return recv_tcp(args)
+
+	sock = socket.socket(socket.AF_PACKET, socket.SOCK_RAW, socket.htons(ETH_P_TEST))
+	sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 64 * 1024 * 1024)
+	sock.bind((args.iface, ETH_P_TEST))
+
+	last = {}
+	received = 0
+	reordered = 0
+	latency = []
+	first = None
+	stop = time.monotonic() + args.duration
+
+	signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+	try:
+		while time.monotonic() < stop:
+			if not select.select([ sock ], [], [], 0.2)[0]:
+				continue
+
+			frame = sock.recv(65536)
+			now = time.monotonic_ns()
+			session, sequence, timestamp = TEST_PAYLOAD.unpack_from(frame, 14)
+
+			received += 1
+			finish = time.monotonic()
+			if first is None:
+				first = finish
+
+			if session in last:
+				if sequence < last[session][0]:
+					reordered += 1
+				else:
+					last[session] = (sequence, last[session][1] + 1)
+			else:
+				last[session] = (sequence, 1)
+
+			if (received % args.sample) == 0:
+				latency.append(now - timestamp)
+	except (KeyboardInterrupt, SystemExit):
+		pass
+
+	# Socket drops are losses of this receiver, not of kernel module
+	stats = sock.getsockopt(263, 6, 8)
+	drops = struct.unpack("=II", stats)[1]
+	elapsed = ((finish - first) if first else 0)
+	lost = sum((sequence + 1 - count) for sequence, count in last.values()) - reordered
+
+	print("received: %d frames, %d sessions, %.0f frames/s" % (received, len(last), (received / elapsed) if elapsed else 0))
+	print("lost: %d, reordered: %d, receiver drops: %d" % (max(0, lost), reordered, drops))
+	if latency:
+		latency.sort()
+		print("latency: p50 %.1f us, p99 %.1f us, max %.1f us" % (latency[len(latency) // 2] / 1000.0, latency[(len(latency) * 99) // 100] / 1000.0, latency[-1] / 1000.0))
+
+	sys.stdout.flush()
+
+# Frames to the stations of sessions from capwap interface
+def command_inject(args):
+	sock = socket.socket(socket.AF_PACKET, socket.SOCK_RAW, 0)
+	sock.setsockopt(263, 15, 1)		# PACKET_VNET_HDR
+	sock.bind((args.iface, 0))
+
+	sequence = 0
+	sent = 0
+	errors = 0
+	length = 0
+	start = time.monotonic()
+	deadline = start + args.duration
+	interval = ((1.0 / args.rate) if args.rate else 0)
+	due = start
+
+	while True:
+		now = time.monotonic()
+		if (now >= deadline) or (args.count and (sent >= args.count)):
+			break
+
+		if interval:
+			if now < due:
+				time.sleep(due - now)
+
+			due += interval
+
+		index = args.first + (sent % args.sessions)
+		station = (sent // args.sessions) % args.stations
+		if args.broadcast:
+			frame = arp_frame(args.gateway, sent, args.size)
+		else:
+			frame = tcp_frame(station_address(index, station), args.gateway, index, station, sequence, args.size, True)
+
+		# virtio_net_hdr: the TCP checksum is completed by stack or device, segments of gso_size
+		if args.broadcast:
+			vnethdr = bytes(10)
+		elif len(frame) > (TCP_HEADERS + args.gso_size):
+			vnethdr = struct.pack("=BBHHHH", 1, 1, TCP_HEADERS, args.gso_size, 14 + 20, 16)
+		else:
+			vnethdr = struct.pack("=BBHHHH", 1, 0, 0, 0, 14 + 20, 16)
+
+		try:
+			sock.send(vnethdr + frame)
+			length += len(frame)
+		except OSError:
+			errors += 1
+
+		if station == (args.stations - 1) and (index == (args.first + args.sessions - 1)):
+			sequence += len(frame) - TCP_HEADERS
+
+		sent += 1
+
+	elapsed = time.monotonic() - start
+	print("sent: %d frames, %d errors, %.1f Mbit/s" % (sent, errors, (length * 8) / (elapsed * 1000000)), flush=True)
+
+# Datagrams of sessions received by WTPs
+def command_sink(args):
+	sockets = {}
+	poll = select.poll()
+	destination = (args.ac, args.port)
+
+	for index in range(args.first, args.first + args.sessions):
+		sock = socket.socket(socket.AF_INET6 if ":" in args.ac else socket.AF_INET, socket.SOCK_DGRAM)
+		sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 * 1024 * 1024)
+		sock.bind(("", args.wtp_port + index))
+		sock.connect(destination)
+		sock.send(capwap_keepalive(index))
+		sockets[sock.fileno()] = sock
+		poll.register(sock, select.POLLIN)
+
+	print("ready %d sessions" % args.sessions, flush=True)
+
+	received = 0
+	length = 0
+	mismatch = 0
+	frames = dict.fromkeys(sockets, 0)
+	expected = {}
+	first = None
+	stop = time.monotonic() + args.duration
+
+	signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+	try:
+		while time.monotonic() < stop:
+			for fd, _ in poll.poll(200):
+				try:
+					data = sockets[fd].recv(65536)
+				except OSError:
+					continue
+
+				# The frame follows the CAPWAP header of HLEN words, the Keep-Alive are not frames
+				if args.verify:
+					flags = struct.unpack_from("!I", data)[0]
+					if flags & (1 << 3):
+						continue
+
+					frame = data[((flags >> 19) & 0x1f) * 4:]
+					if len(frame) >= 62:
+						sequence = TEST_PAYLOAD.unpack_from(frame, 42)[1]
+						if sequence not in expected:
+							expected[sequence] = arp_frame(args.gateway, sequence, args.size)
+
+					if (len(frame) < 62) or (frame != expected[sequence]):
+						mismatch += 1
+					else:
+						frames[fd] += 1
+
+				length += len(data)
+				received += 1
+				finish = time.monotonic()
+				if first is None:
+					first = finish
+	except (KeyboardInterrupt, SystemExit):
+		pass
+
+	elapsed = ((finish - first) if first else 0)
+	print("received: %d datagrams, %d bytes, %.1f Mbit/s, %.0f datagrams/s" % (received, length, ((length * 8) / (elapsed * 1000000)) if elapsed else 0, (received / elapsed) if elapsed else 0))
+	if args.verify:
+		print("verified: %d frames, mismatch: %d, frames of session: min %d, max %d" % (sum(frames.values()), mismatch, min(frames.values()), max(frames.values())))
+
+	sys.stdout.flush()
+
+# */
+def main():
+	parser = argparse.ArgumentParser(description="SmartCAPWAP AC kernel module test tool")
+	commands = parser.add_subparsers(dest="command", required=True)
+
+	ac = commands.add_parser("ac", help="link to kernel module and create the sessions")
+	ac.add_argument("--iface", default="capwap0", help="capwap interface")
+	ac.add_argument("--address", default="0.0.0.0", help="data channel address")
+	ac.add_argument("--port", type=int, default=5247, help="data channel port")
+	ac.add_argument("--mtu", type=int, default=1400, help="session and interface MTU")
+	ac.add_argument("--sessions", type=int, default=1)
+	ac.add_argument("--stations", type=int, default=1, help="stations of every session")
+	ac.set_defaults(handler=command_ac)
+
+	send = commands.add_parser("send", help="send data frames of simulated WTPs")
+	send.add_argument("--ac", required=True, help="AC address")
+	send.add_argument("--port", type=int, default=5247, help="AC data channel port")
+	send.add_argument("--wtp-port", type=int, default=20000, help="UDP port of session 0")
+	send.add_argument("--first", type=int, default=0, help="first session")
+	send.add_argument("--sessions", type=int, default=1)
+	send.add_argument("--stations", type=int, default=1, help="stations of every session")
+	send.add_argument("--gateway", type=lambda value: bytes.fromhex(value.replace(":", "")), default=DEFAULT_GATEWAY, help="destination address of frames")
+	send.add_argument("--size", type=int, default=64, help="frame size")
+	send.add_argument("--tcp", action="store_true", help="IPv4/TCP frames")
+	send.add_argument("--rate", type=float, default=0, help="frames/s, 0 is unlimited")
+	send.add_argument("--count", type=int, default=0, help="frames, 0 is unlimited")
+	send.add_argument("--duration", type=float, default=10)
+	send.set_defaults(handler=command_send)
+
+	recv = commands.add_parser("recv", help="count the frames delivered to capwap interface")
+	recv.add_argument("--iface", default="capwap0", help="capwap interface")
+	recv.add_argument("--duration", type=float, default=10)
+	recv.add_argument("--sample", type=int, default=16, help="latency of one frame every sample")
+	recv.add_argument("--tcp", action="store_true", help="count IPv4/TCP packets and bytes")
+	recv.set_defaults(handler=command_recv)
+
+	inject = commands.add_parser("inject", help="send TCP frames to the stations from capwap interface")
+	inject.add_argument("--iface", default="capwap0", help="capwap interface")
+	inject.add_argument("--first", type=int, default=0, help="first session")
+	inject.add_argument("--sessions", type=int, default=1)
+	inject.add_argument("--stations", type=int, default=1, help="stations of every session")
+	inject.add_argument("--gateway", type=lambda value: bytes.fromhex(value.replace(":", "")), default=DEFAULT_GATEWAY, help="source address of frames")
+	inject.add_argument("--size", type=int, default=65000, help="frame size")
+	inject.add_argument("--broadcast", action="store_true", help="ARP requests to broadcast address")
+	inject.add_argument("--gso-size", type=int, default=1300, help="TCP payload of every segment")
+	inject.add_argument("--rate", type=float, default=0, help="frames/s, 0 is unlimited")
+	inject.add_argument("--count", type=int, default=0, help="frames, 0 is unlimited")
+	inject.add_argument("--duration", type=float, default=10)
+	inject.set_defaults(handler=command_inject)
+
+	sink = commands.add_parser("sink", help="receive the datagrams of simulated WTPs")
+	sink.add_argument("--ac", required=True, help="AC address")
+	sink.add_argument("--port", type=int, default=5247, help="AC data channel port")
+	sink.add_argument("--wtp-port", type=int, default=20000, help="UDP port of session 0")
+	sink.add_argument("--first", type=int, default=0, help="first session")
+	sink.add_argument("--sessions", type=int, default=1)
+	sink.add_argument("--verify", action="store_true", help="check the ARP requests of inject --broadcast")
+	sink.add_argument("--gateway", type=lambda value: bytes.fromhex(value.replace(":", "")), default=DEFAULT_GATEWAY, help="source address of ARP requests")
+	sink.add_argument("--size", type=int, default=62, help="frame size of ARP requests")
+	sink.add_argument("--duration", type=float, default=10)
+	sink.set_defaults(handler=command_sink)
+
+	args = parser.parse_args()
+	args.handler(args)
+
+if __name__ == "__main__":
+	main()
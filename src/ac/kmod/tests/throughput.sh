@@ -0,0 +1,76 @@
+#!/bin/bash
+#
+# Receive throughput and reordering of AC kernel module data channel
+#
+# The WTP sessions are simulated by sctest.py send processes into the WTP
+# namespace, every process is pinned to its CPU and sends the interleaved
+# frames of its sessions to the module by the veth pair. sctest.py recv counts
+# the frames delivered to capwap interface: frames/s, lost and reordered
+# frames of the sessions and one-way latency.
+#
+# Usage: throughput.sh [-s sessions] [-j senders] [-t seconds] [-l size] [-r rate] [-p params] smartcapwap.ko
+#   -s sessions  WTP sessions (default 64)
+#   -j senders   sender processes, one for CPU (default CPUs count)
+#   -t seconds   duration (default 10)
+#   -l size      frame size (default 64)
+#   -r rate      frames/s of every sender, 0 is unlimited (default 0)
+#   -p params    module parameters, e.g. "runtocompletion=1"
+#
+# Run as root with more than one CPU, the module must not be loaded because
+# the script loads and removes it. Compare two builds of module with the same
+# options, e.g. the round-robin dispatch of worker threads against the flow
+# dispatch:
+#   ./throughput.sh -s 64 before/smartcapwap.ko
+#   ./throughput.sh -s 64 after/smartcapwap.ko
+#
+# A Python sender reaches some hundred thousand frames/s, use as many senders
+# as CPUs to load the module. The receiver drops are losses of sctest.py recv
+# and not of the module, lower the rate when they are not zero.
+
+. "$(dirname "$0")/netns.sh"
+
+SESSIONS=64
+SENDERS="$(nproc)"
+DURATION=10
+SIZE=64
+RATE=0
+PARAMS=""
+
+while getopts "s:j:t:l:r:p:h" opt; do
+	case "${opt}" in
+		s) SESSIONS="${OPTARG}" ;;
+		j) SENDERS="${OPTARG}" ;;
+		t) DURATION="${OPTARG}" ;;
+		l) SIZE="${OPTARG}" ;;
+		r) RATE="${OPTARG}" ;;
+		p) PARAMS="${OPTARG}" ;;
+		*) sed -n '/^# Usage/,/^#$/p' "$0" >&2; exit 1 ;;
+	esac
+done
+
+shift $((OPTIND - 1))
+[ $# -eq 1 ] || sc_fail "Usage: $0 [options] smartcapwap.ko"
+[ "${SENDERS}" -le "${SESSIONS}" ] || SENDERS="${SESSIONS}"
+
+sc_setup "$1" ${PARAMS}
+sc_start_ac "${SESSIONS}" 1
+
+# The receiver stops about one second after senders
+${SC_TOOL} recv --iface "${SC_CAPWAP_IF}" --duration "$((DURATION + 2))" > "${SC_TMP}/recv.log" &
+PIDS=($!)
+sleep 0.5
+
+for i in $(seq 0 $((SENDERS - 1))); do
+	first=$((SESSIONS * i / SENDERS))
+	count=$((SESSIONS * (i + 1) / SENDERS - first))
+	sc_wtp taskset -c "$((i % $(nproc)))" ${SC_TOOL} send --ac "${SC_AC_ADDR}" --first "${first}" --sessions "${count}" --size "${SIZE}" --rate "${RATE}" --duration "${DURATION}" > "${SC_TMP}/send.${i}.log" &
+	PIDS+=($!)
+done
+
+wait "${PIDS[@]}"
+
+# */
+echo "module: $1 ${PARAMS}"
+echo "sessions: ${SESSIONS}, senders: ${SENDERS}, frame size: ${SIZE}, duration: ${DURATION} s"
+awk '{ sent += $2; rate += $6 } END { printf "sent: %d frames, %.0f frames/s\n", sent, rate }' "${SC_TMP}"/send.*.log
+cat "${SC_TMP}/recv.log"
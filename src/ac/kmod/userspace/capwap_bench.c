@@ -0,0 +1,408 @@
+#include "config.h"
+#include <linux/module.h>
+#include <linux/if_ether.h>
+#include <unistd.h>
+#include "socket.h"
+#include "capwap.h"
+#include "nlsmartcapwap.h"
+#include "netlinkapp.h"
+
+/* Replay the Ethernet frames of a pcap file through encapsulation, decapsulation and
+   reassembly of capwap.c, the dependent implementation function are replaced by a
+   software wire between the two side of a single session */
+
+/* */
+#define BENCH_DEFAULT_ITERATIONS			100
+#define BENCH_SYNTHETIC_FRAMES				1024
+#define BENCH_SKB_HEADROOM					(SOCKET_SKB_HEADROOM + CAPWAP_HEADER_MAX_LENGTH)
+
+/* pcap file format */
+#define PCAP_MAGIC							0xa1b2c3d4
+#define PCAP_MAGIC_NSEC						0xa1b23c4d
+#define PCAP_LINKTYPE_ETHERNET				1
+
+struct pcap_file_header {
+	uint32_t magic;
+	uint16_t version_major;
+	uint16_t version_minor;
+	int32_t thiszone;
+	uint32_t sigfigs;
+	uint32_t snaplen;
+	uint32_t linktype;
+};
+
+struct pcap_packet_header {
+	uint32_t ts_sec;
+	uint32_t ts_usec;
+	uint32_t caplen;
+	uint32_t len;
+};
+
+/* */
+struct bench_frame {
+	uint8_t* data;
+	int length;
+};
+
+/* */
+struct bench_wire {
+	struct sk_buff* head;
+	struct sk_buff* tail;
+	unsigned long count;
+};
+
+/* */
+static struct bench_frame* bench_frames;
+static int bench_frames_count;
+
+static struct bench_wire bench_wire;
+static int bench_expected;
+static unsigned long bench_delivered;
+static unsigned long bench_mismatch;
+
+static uint8_t bench_bssid[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+/* */
+static uint32_t bench_swap32(uint32_t value, int swap) {
+	return (swap ? __builtin_bswap32(value) : value);
+}
+
+/* */
+static uint64_t bench_nsec(void) {
+	return (uint64_t)ktime_get().tv64;
+}
+
+/* */
+static int bench_add_frame(const uint8_t* data, int length) {
+	struct bench_frame* frames;
+
+	/* Only the Ethernet-II frames are converted without loss */
+	if ((length <= ETH_HLEN) || (length > MAX_MTU) || (ntohs(((struct ethhdr*)data)->h_proto) < ETH_P_802_3_MIN)) {
+		return 0;
+	}
+
+	frames = (struct bench_frame*)realloc(bench_frames, sizeof(struct bench_frame) * (bench_frames_count + 1));
+	if (!frames) {
+		return -ENOMEM;
+	}
+
+	bench_frames = frames;
+	bench_frames[bench_frames_count].data = (uint8_t*)malloc(length);
+	if (!bench_frames[bench_frames_count].data) {
+		return -ENOMEM;
+	}
+
+	memcpy(bench_frames[bench_frames_count].data, data, length);
+	bench_frames[bench_frames_count].length = length;
+	bench_frames_count++;
+
+	return 0;
+}
+
+/* */
+static int bench_load_pcap(const char* filename) {
+	int swap;
+	FILE* file;
+	uint8_t* buffer;
+	struct pcap_file_header header;
+	struct pcap_packet_header packet;
+	int ret = -EINVAL;
+
+	file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "Unable to open %s\n", filename);
+		return -ENOENT;
+	}
+
+	/* */
+	if (fread(&header, sizeof(struct pcap_file_header), 1, file) != 1) {
+		fprintf(stderr, "Invalid pcap file %s\n", filename);
+		goto error;
+	}
+
+	swap = ((header.magic != PCAP_MAGIC) && (header.magic != PCAP_MAGIC_NSEC));
+	if (swap && (bench_swap32(header.magic, 1) != PCAP_MAGIC) && (bench_swap32(header.magic, 1) != PCAP_MAGIC_NSEC)) {
+		fprintf(stderr, "Invalid pcap magic of %s\n", filename);
+		goto error;
+	} else if (bench_swap32(header.linktype, swap) != PCAP_LINKTYPE_ETHERNET) {
+		fprintf(stderr, "Only Ethernet pcap file is supported\n");
+		goto error;
+	}
+
+	/* */
+	buffer = (uint8_t*)malloc(0x10000);
+	if (!buffer) {
+		ret = -ENOMEM;
+		goto error;
+	}
+
+	ret = 0;
+	while (!ret && (fread(&packet, sizeof(struct pcap_packet_header), 1, file) == 1)) {
+		uint32_t caplen = bench_swap32(packet.caplen, swap);
+
+		if ((caplen > 0x10000) || (fread(buffer, caplen, 1, file) != 1)) {
+			fprintf(stderr, "Truncated pcap file %s\n", filename);
+			ret = -EINVAL;
+		} else if (caplen == bench_swap32(packet.len, swap)) {
+			ret = bench_add_frame(buffer, caplen);
+		}
+	}
+
+	free(buffer);
+
+error:
+	fclose(file);
+	return ret;
+}
+
+/* Mix of Internet frame size */
+static int bench_load_synthetic(void) {
+	int i;
+	int ret;
+	uint8_t buffer[1514];
+	static const int sizes[] = { 60, 60, 60, 60, 60, 60, 594, 1514, 1514, 1514, 1514, 1514 };
+
+	for (i = 0; i < sizeof(buffer); i++) {
+		buffer[i] = (uint8_t)i;
+	}
+
+	/* */
+	memset(buffer, 0, ETH_HLEN);
+	buffer[5] = 0x10;
+	buffer[11] = 0x20;
+	((struct ethhdr*)buffer)->h_proto = htons(ETH_P_IP);
+
+	for (i = 0; i < BENCH_SYNTHETIC_FRAMES; i++) {
+		ret = bench_add_frame(buffer, sizes[i % (sizeof(sizes) / sizeof(sizes[0]))]);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* */
+static void bench_wire_put(struct sk_buff* skb) {
+	skb->next = NULL;
+	if (bench_wire.tail) {
+		bench_wire.tail->next = skb;
+	} else {
+		bench_wire.head = skb;
+	}
+
+	bench_wire.tail = skb;
+	bench_wire.count++;
+}
+
+/* Dipendent implementation function */
+int sc_socket_bind(union capwap_addr* sockaddr) {
+	return 0;
+}
+
+/* */
+int sc_socket_send(int type, uint8_t* buffer, int length, union capwap_addr* sockaddr) {
+	struct sk_buff* skb;
+
+	skb = alloc_skb(length, GFP_ATOMIC);
+	if (!skb) {
+		return -ENOMEM;
+	}
+
+	memcpy(skb_put(skb, length), buffer, length);
+	bench_wire_put(skb);
+	return length;
+}
+
+/* */
+int sc_socket_send_skb(int type, struct sk_buff* skb, union capwap_addr* sockaddr) {
+	int length = skb->len;
+
+	bench_wire_put(skb);
+	return length;
+}
+
+/* */
+struct sc_capwap_session* sc_capwap_recvunknownkeepalive(const union capwap_addr* sockaddr, const struct sc_capwap_sessionid_element* sessionid) {
+	return NULL;
+}
+
+/* */
+int sc_netlink_notify_recv_keepalive(const union capwap_addr* sockaddr, struct sc_capwap_sessionid_element* sessionid) {
+	return 0;
+}
+
+/* Compare the delivered packet with the original frame without linearize it */
+void sc_capwap_parsingdatapacket(struct sc_capwap_session* session, struct sk_buff* skb) {
+	int offset;
+	struct sk_buff* frag;
+	struct bench_frame* frame = &bench_frames[bench_expected];
+	struct sc_capwap_header* header = (struct sc_capwap_header*)skb->data;
+
+	bench_expected = (bench_expected + 1) % bench_frames_count;
+	bench_delivered++;
+
+	/* */
+	skb_pull(skb, GET_HLEN_HEADER(header) * 4);
+	if (IS_FLAG_T_HEADER(header) && sc_capwap_80211_to_8023(skb)) {
+		bench_mismatch++;
+		kfree_skb(skb);
+		return;
+	}
+
+	if ((skb->len != frame->length) || memcmp(skb->data, frame->data, skb_headlen(skb))) {
+		bench_mismatch++;
+		kfree_skb(skb);
+		return;
+	}
+
+	offset = skb_headlen(skb);
+	for (frag = skb_shinfo(skb)->frag_list; frag; frag = frag->next) {
+		if (memcmp(frag->data, frame->data + offset, frag->len)) {
+			bench_mismatch++;
+			break;
+		}
+
+		offset += frag->len;
+	}
+
+	kfree_skb(skb);
+}
+
+/* */
+void sc_capwap_parsingmgmtpacket(struct sc_capwap_session* session, struct sk_buff* skb) {
+	kfree_skb(skb);
+}
+
+/* */
+static void bench_usage(const char* name) {
+	fprintf(stderr, "Usage: %s [-m mtu] [-n iterations] [-e] [file.pcap]\n", name);
+	fprintf(stderr, "  -m mtu         MTU of session (default %d)\n", DEFAULT_MTU);
+	fprintf(stderr, "  -n iterations  replay count of frames (default %d)\n", BENCH_DEFAULT_ITERATIONS);
+	fprintf(stderr, "  -e             IEEE 802.3 tunnel mode, without IEEE 802.11 conversion\n");
+}
+
+/* */
+int main(int argc, char** argv) {
+	int i;
+	int opt;
+	int ret;
+	int tunnel8023 = 0;
+	int iterations = BENCH_DEFAULT_ITERATIONS;
+	unsigned long packets = 0;
+	unsigned long fragments = 0;
+	uint64_t start;
+	uint64_t encaptime = 0;
+	uint64_t decaptime = 0;
+	uint8_t radioaddrbuffer[CAPWAP_RADIO_EUI48_LENGTH_PADDED];
+	struct sc_capwap_radio_addr* radioaddr = NULL;
+	struct sc_capwap_fragment_stats stats;
+	struct sc_capwap_session session;
+
+	/* */
+	memset(&session, 0, sizeof(struct sc_capwap_session));
+	session.mtu = DEFAULT_MTU;
+	session.peeraddr.sin.sin_family = AF_INET;
+	session.peeraddr.sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	session.peeraddr.sin.sin_port = htons(5247);
+
+	while ((opt = getopt(argc, argv, "m:n:eh")) != -1) {
+		switch (opt) {
+			case 'm': {
+				session.mtu = atoi(optarg);
+				break;
+			}
+
+			case 'n': {
+				iterations = atoi(optarg);
+				break;
+			}
+
+			case 'e': {
+				tunnel8023 = 1;
+				break;
+			}
+
+			default: {
+				bench_usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+
+	if ((session.mtu < MIN_MTU) || (session.mtu > MAX_MTU) || (iterations <= 0)) {
+		bench_usage(argv[0]);
+		return 1;
+	}
+
+	/* */
+	ret = ((optind < argc) ? bench_load_pcap(argv[optind]) : bench_load_synthetic());
+	if (ret) {
+		return 1;
+	} else if (!bench_frames_count) {
+		fprintf(stderr, "No Ethernet-II frame to replay\n");
+		return 1;
+	}
+
+	/* */
+	sc_capwap_fragment_init();
+	sc_capwap_initsession(&session);
+	if (tunnel8023) {
+		radioaddr = sc_capwap_setradiomacaddress(radioaddrbuffer, CAPWAP_RADIO_EUI48_LENGTH_PADDED, bench_bssid);
+	}
+
+	while (iterations-- > 0) {
+		/* Encapsulation */
+		start = bench_nsec();
+		for (i = 0; i < bench_frames_count; i++) {
+			struct sk_buff* skb = alloc_skb(BENCH_SKB_HEADROOM + bench_frames[i].length, GFP_ATOMIC);
+
+			if (!skb) {
+				return 1;
+			}
+
+			skb_reserve(skb, BENCH_SKB_HEADROOM);
+			memcpy(skb_put(skb, bench_frames[i].length), bench_frames[i].data, bench_frames[i].length);
+
+			if (tunnel8023) {
+				sc_capwap_forwarddata(&session, 1, CAPWAP_WIRELESS_BINDING_IEEE80211, skb, NLSMARTCAPWAP_FLAGS_TUNNEL_8023, radioaddr, CAPWAP_RADIO_EUI48_LENGTH_PADDED, NULL, 0);
+			} else if (!sc_capwap_8023_to_80211(skb, bench_bssid)) {
+				sc_capwap_forwarddata(&session, 1, CAPWAP_WIRELESS_BINDING_IEEE80211, skb, 0, NULL, 0, NULL, 0);
+			} else {
+				kfree_skb(skb);
+			}
+		}
+
+		encaptime += bench_nsec() - start;
+		packets += bench_frames_count;
+		fragments += bench_wire.count;
+
+		/* Decapsulation and reassembly */
+		start = bench_nsec();
+		while (bench_wire.head) {
+			struct sk_buff* skb = bench_wire.head;
+
+			bench_wire.head = skb->next;
+			skb->next = NULL;
+			if (sc_capwap_parsingpacket(&session, &session.peeraddr, skb)) {
+				kfree_skb(skb);
+			}
+		}
+
+		decaptime += bench_nsec() - start;
+		bench_wire.tail = NULL;
+		bench_wire.count = 0;
+	}
+
+	/* */
+	sc_capwap_fragment_stats(&stats);
+	sc_capwap_freesession(&session);
+
+	printf("frames: %d, mtu: %hu, tunnel: %s\n", bench_frames_count, session.mtu, (tunnel8023 ? "802.3" : "802.11"));
+	printf("packets: %lu, capwap packets: %lu, delivered: %lu, mismatch: %lu\n", packets, fragments, bench_delivered, bench_mismatch);
+	printf("fragment memory: %u, timeouts: %u, evictions: %u\n", stats.memory, stats.timeouts, stats.evictions);
+	printf("encap: %.1f ns/packet\n", (double)encaptime / packets);
+	printf("decap: %.1f ns/packet\n", (double)decaptime / packets);
+
+	return (((bench_delivered != packets) || bench_mismatch) ? 1 : 0);
+}
@@ -0,0 +1,2 @@
+/* Kernel API of userspace build */
+#include "kshim.h"
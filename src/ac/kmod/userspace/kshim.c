@@ -0,0 +1,122 @@
+#include "kshim.h"
+
+/* */
+void get_random_bytes(void* buffer, int length) {
+	FILE* file;
+	int count = 0;
+	uint8_t* pos = (uint8_t*)buffer;
+
+	file = fopen("/dev/urandom", "rb");
+	if (file) {
+		count = fread(pos, 1, length, file);
+		fclose(file);
+	}
+
+	for (; count < length; count++) {
+		pos[count] = (uint8_t)rand();
+	}
+}
+
+/* */
+struct sk_buff* alloc_skb(unsigned int size, gfp_t priority) {
+	struct sk_buff* skb;
+
+	skb = (struct sk_buff*)calloc(1, sizeof(struct sk_buff));
+	if (!skb) {
+		return NULL;
+	}
+
+	skb->head = (unsigned char*)malloc(size);
+	if (!skb->head) {
+		free(skb);
+		return NULL;
+	}
+
+	skb->data = skb->head;
+	skb->tail = skb->head;
+	skb->end = skb->head + size;
+	skb->truesize = size + sizeof(struct sk_buff);
+
+	return skb;
+}
+
+/* */
+void kfree_skb(struct sk_buff* skb) {
+	struct sk_buff* next;
+
+	if (!skb) {
+		return;
+	}
+
+	/* */
+	next = skb_shinfo(skb)->frag_list;
+	while (next) {
+		struct sk_buff* frag = next;
+
+		next = frag->next;
+		kfree_skb(frag);
+	}
+
+	free(skb->head);
+	free(skb);
+}
+
+/* */
+int pskb_expand_head(struct sk_buff* skb, int nhead, int ntail, gfp_t priority) {
+	unsigned char* head;
+	unsigned int size = (skb->end - skb->head) + nhead + ntail;
+
+	head = (unsigned char*)malloc(size);
+	if (!head) {
+		return -ENOMEM;
+	}
+
+	/* Copy only the linear data */
+	memcpy(head + nhead + skb_headroom(skb), skb->data, skb_headlen(skb));
+
+	skb->data = head + nhead + skb_headroom(skb);
+	skb->tail = skb->data + skb_headlen(skb);
+	if (skb->mac_header) {
+		skb->mac_header = head + nhead + (skb->mac_header - skb->head);
+	}
+
+	free(skb->head);
+	skb->head = head;
+	skb->end = head + size;
+
+	return 0;
+}
+
+/* Move delta bytes of frag_list into linear data */
+unsigned char* __pskb_pull_tail(struct sk_buff* skb, int delta) {
+	int eat = delta - skb_tailroom(skb);
+
+	if ((eat > 0) && pskb_expand_head(skb, 0, eat + 128, GFP_ATOMIC)) {
+		return NULL;
+	}
+
+	while (delta > 0) {
+		int length;
+		struct sk_buff* frag = skb_shinfo(skb)->frag_list;
+
+		if (!frag) {
+			return NULL;
+		}
+
+		/* */
+		length = min_t(int, delta, skb_headlen(frag));
+		memcpy(skb->tail, frag->data, length);
+		skb->tail += length;
+		skb->data_len -= length;
+		skb_pull(frag, length);
+		delta -= length;
+
+		if (!frag->len) {
+			skb_shinfo(skb)->frag_list = frag->next;
+			frag->next = NULL;
+			kfree_skb(frag);
+		}
+	}
+
+	return skb->tail;
+}
@@ -0,0 +1,436 @@
+#ifndef __KMOD_USERSPACE_KSHIM_HEADER__
+#define __KMOD_USERSPACE_KSHIM_HEADER__
+
+/* Subset of kernel API used by the independent implementation of capwap.c,
+   the same source of module is built in userspace against this header */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <endian.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/* */
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef uint16_t __be16;
+typedef uint16_t __le16;
+typedef uint32_t __be32;
+typedef unsigned int gfp_t;
+
+/* */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#define __LITTLE_ENDIAN_BITFIELD
+#define cpu_to_le16(x)						((__le16)(x))
+#define le16_to_cpu(x)						((uint16_t)(x))
+#else
+#define __BIG_ENDIAN_BITFIELD
+#define cpu_to_le16(x)						((__le16)__builtin_bswap16(x))
+#define le16_to_cpu(x)						((uint16_t)__builtin_bswap16(x))
+#endif
+
+#define cpu_to_be16(x)						((__be16)htons(x))
+#define be16_to_cpu(x)						((uint16_t)ntohs(x))
+
+/* */
+#define __packed							__attribute__((packed))
+#define __aligned(x)						__attribute__((aligned(x)))
+#define __rcu
+#define __percpu
+#define likely(x)							__builtin_expect(!!(x), 1)
+#define unlikely(x)							__builtin_expect(!!(x), 0)
+
+#define min(x, y)							({ typeof(x) _min1 = (x); typeof(y) _min2 = (y); (_min1 < _min2) ? _min1 : _min2; })
+#define max(x, y)							({ typeof(x) _max1 = (x); typeof(y) _max2 = (y); (_max1 > _max2) ? _max1 : _max2; })
+#define min_t(type, x, y)					({ type _min1 = (x); type _min2 = (y); (_min1 < _min2) ? _min1 : _min2; })
+
+#define container_of(ptr, type, member)		((type*)((char*)(ptr) - offsetof(type, member)))
+
+/* */
+#define MAX_ERRNO							4095
+#define IS_ERR_VALUE(x)						unlikely((unsigned long)(void*)(x) >= (unsigned long)-MAX_ERRNO)
+
+static inline void* ERR_PTR(long error) { return (void*)error; }
+static inline long PTR_ERR(const void* ptr) { return (long)ptr; }
+static inline bool IS_ERR(const void* ptr) { return IS_ERR_VALUE((unsigned long)ptr); }
+static inline bool IS_ERR_OR_NULL(const void* ptr) { return !ptr || IS_ERR_VALUE((unsigned long)ptr); }
+
+/* Trace */
+static inline int printk(const char* fmt, ...) { return 0; }
+#define smp_processor_id()					0
+
+/* Module */
+#define module_param_named(name, value, type, perm)
+#define MODULE_PARM_DESC(name, desc)
+
+/* Memory */
+#define GFP_ATOMIC							0
+#define GFP_KERNEL							0
+
+static inline void* kzalloc(size_t size, gfp_t flags) { return calloc(1, size); }
+static inline void* kmalloc(size_t size, gfp_t flags) { return malloc(size); }
+static inline void kfree(const void* ptr) { free((void*)ptr); }
+
+void get_random_bytes(void* buffer, int length);
+
+/* Atomic */
+typedef struct {
+	int counter;
+} atomic_t;
+
+#define ATOMIC_INIT(x)						{ (x) }
+
+static inline int atomic_read(const atomic_t* v) { return __atomic_load_n(&v->counter, __ATOMIC_RELAXED); }
+static inline void atomic_set(atomic_t* v, int i) { __atomic_store_n(&v->counter, i, __ATOMIC_RELAXED); }
+static inline void atomic_add(int i, atomic_t* v) { __atomic_add_fetch(&v->counter, i, __ATOMIC_RELAXED); }
+static inline void atomic_sub(int i, atomic_t* v) { __atomic_sub_fetch(&v->counter, i, __ATOMIC_RELAXED); }
+static inline void atomic_inc(atomic_t* v) { atomic_add(1, v); }
+static inline int atomic_dec_and_test(atomic_t* v) { return !__atomic_sub_fetch(&v->counter, 1, __ATOMIC_ACQ_REL); }
+
+/* Spinlock */
+typedef struct {
+	int locked;
+} spinlock_t;
+
+#define DEFINE_SPINLOCK(x)					spinlock_t x = { 0 }
+
+static inline void spin_lock_init(spinlock_t* lock) { lock->locked = 0; }
+static inline void spin_lock(spinlock_t* lock) { while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE)); }
+static inline void spin_unlock(spinlock_t* lock) { __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE); }
+
+#define spin_lock_bh(x)						spin_lock(x)
+#define spin_unlock_bh(x)					spin_unlock(x)
+
+/* List */
+struct list_head {
+	struct list_head* next;
+	struct list_head* prev;
+};
+
+#define LIST_HEAD_INIT(name)				{ &(name), &(name) }
+#define LIST_HEAD(name)						struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void INIT_LIST_HEAD(struct list_head* list) { list->next = list; list->prev = list; }
+static inline int list_empty(const struct list_head* head) { return head->next == head; }
+
+static inline void list_add_tail(struct list_head* entry, struct list_head* head) {
+	entry->next = head;
+	entry->prev = head->prev;
+	head->prev->next = entry;
+	head->prev = entry;
+}
+
+static inline void list_del(struct list_head* entry) {
+	entry->next->prev = entry->prev;
+	entry->prev->next = entry->next;
+	entry->next = NULL;
+	entry->prev = NULL;
+}
+
+#define list_entry(ptr, type, member)		container_of(ptr, type, member)
+#define list_first_entry_or_null(ptr, type, member)		(!list_empty(ptr) ? list_entry((ptr)->next, type, member) : NULL)
+
+/* Hash list */
+struct hlist_node {
+	struct hlist_node* next;
+	struct hlist_node** pprev;
+};
+
+struct hlist_head {
+	struct hlist_node* first;
+};
+
+static inline void INIT_HLIST_HEAD(struct hlist_head* head) { head->first = NULL; }
+
+static inline void hlist_add_head(struct hlist_node* node, struct hlist_head* head) {
+	node->next = head->first;
+	if (head->first) {
+		head->first->pprev = &node->next;
+	}
+
+	head->first = node;
+	node->pprev = &head->first;
+}
+
+static inline void hlist_del(struct hlist_node* node) {
+	*node->pprev = node->next;
+	if (node->next) {
+		node->next->pprev = node->pprev;
+	}
+
+	node->next = NULL;
+	node->pprev = NULL;
+}
+
+#define hlist_entry(ptr, type, member)		container_of(ptr, type, member)
+#define hlist_entry_safe(ptr, type, member)	({ typeof(ptr) _ptr = (ptr); _ptr ? hlist_entry(_ptr, type, member) : NULL; })
+
+#define hlist_for_each_entry(pos, head, member) \
+	for (pos = hlist_entry_safe((head)->first, typeof(*(pos)), member); pos; pos = hlist_entry_safe((pos)->member.next, typeof(*(pos)), member))
+
+#define hlist_for_each_entry_safe(pos, n, head, member) \
+	for (pos = hlist_entry_safe((head)->first, typeof(*pos), member); pos && ({ n = pos->member.next; 1; }); pos = hlist_entry_safe(n, typeof(*pos), member))
+
+/* Private headers are built as for kernel with rhashtable API */
+#define KERNEL_VERSION(a, b, c)				(((a) << 16) + ((b) << 8) + (c))
+#define LINUX_VERSION_CODE					KERNEL_VERSION(4, 1, 0)
+
+/* Opaque kernel objects of private headers */
+struct rhash_head {
+	struct rhash_head* next;
+};
+
+struct rhashtable {
+	int nelems;
+};
+
+struct task_struct;
+
+typedef struct {
+	int unused;
+} wait_queue_head_t;
+
+/* Time */
+#define NSEC_PER_SEC						1000000000L
+
+typedef union {
+	s64 tv64;
+} ktime_t;
+
+static inline ktime_t ktime_sub(ktime_t a, ktime_t b) { ktime_t res = { a.tv64 - b.tv64 }; return res; }
+
+static inline ktime_t ktime_get(void) {
+	ktime_t res;
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	res.tv64 = (s64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+	return res;
+}
+
+/* Jenkins hash */
+#define JHASH_INITVAL						0xdeadbeef
+
+static inline u32 rol32(u32 word, unsigned int shift) { return (word << shift) | (word >> ((-shift) & 31)); }
+
+static inline u32 jhash_3words(u32 a, u32 b, u32 c, u32 initval) {
+	initval += JHASH_INITVAL + (3 << 2);
+	a += initval;
+	b += initval;
+	c += initval;
+
+	c ^= b; c -= rol32(b, 14);
+	a ^= c; a -= rol32(c, 11);
+	b ^= a; b -= rol32(a, 25);
+	c ^= b; c -= rol32(b, 16);
+	a ^= c; a -= rol32(c, 4);
+	b ^= a; b -= rol32(a, 14);
+	c ^= b; c -= rol32(b, 24);
+
+	return c;
+}
+
+/* Ethernet */
+#define ETH_ALEN							6
+#define ETH_HLEN							14
+#define ETH_P_802_3_MIN						0x0600
+#define ETH_P_IP							0x0800
+#define ETH_P_AARP							0x80F3
+#define ETH_P_IPX							0x8137
+
+struct ethhdr {
+	unsigned char h_dest[ETH_ALEN];
+	unsigned char h_source[ETH_ALEN];
+	__be16 h_proto;
+} __packed;
+
+static inline bool ether_addr_equal(const u8* addr1, const u8* addr2) { return !memcmp(addr1, addr2, ETH_ALEN); }
+
+/* IP/UDP */
+#define LL_MAX_HEADER						128
+
+struct ipv6hdr {
+	u8 data[40];
+};
+
+struct udphdr {
+	__be16 source;
+	__be16 dest;
+	__be16 len;
+	__be16 check;
+};
+
+/* IEEE 802.11 */
+#define IEEE80211_FCTL_FTYPE				0x000c
+#define IEEE80211_FCTL_STYPE				0x00f0
+#define IEEE80211_FCTL_TODS					0x0100
+#define IEEE80211_FCTL_FROMDS				0x0200
+#define IEEE80211_FCTL_ORDER				0x8000
+
+#define IEEE80211_FTYPE_MGMT				0x0000
+#define IEEE80211_FTYPE_CTL					0x0004
+#define IEEE80211_FTYPE_DATA				0x0008
+
+#define IEEE80211_STYPE_DATA				0x0000
+#define IEEE80211_STYPE_NULLFUNC			0x0040
+#define IEEE80211_STYPE_QOS_DATA			0x0080
+
+#define IEEE80211_QOS_CTL_LEN				2
+#define IEEE80211_HT_CTL_LEN				4
+
+struct ieee80211_hdr {
+	__le16 frame_control;
+	__le16 duration_id;
+	u8 addr1[ETH_ALEN];
+	u8 addr2[ETH_ALEN];
+	u8 addr3[ETH_ALEN];
+	__le16 seq_ctrl;
+	u8 addr4[ETH_ALEN];
+} __packed __aligned(2);
+
+static inline bool ieee80211_has_tods(__le16 fc) { return !!(fc & cpu_to_le16(IEEE80211_FCTL_TODS)); }
+static inline bool ieee80211_has_fromds(__le16 fc) { return !!(fc & cpu_to_le16(IEEE80211_FCTL_FROMDS)); }
+static inline bool ieee80211_has_a4(__le16 fc) { __le16 tmp = cpu_to_le16(IEEE80211_FCTL_TODS | IEEE80211_FCTL_FROMDS); return (fc & tmp) == tmp; }
+static inline bool ieee80211_has_order(__le16 fc) { return !!(fc & cpu_to_le16(IEEE80211_FCTL_ORDER)); }
+static inline bool ieee80211_is_mgmt(__le16 fc) { return (fc & cpu_to_le16(IEEE80211_FCTL_FTYPE)) == cpu_to_le16(IEEE80211_FTYPE_MGMT); }
+static inline bool ieee80211_is_ctl(__le16 fc) { return (fc & cpu_to_le16(IEEE80211_FCTL_FTYPE)) == cpu_to_le16(IEEE80211_FTYPE_CTL); }
+static inline bool ieee80211_is_data(__le16 fc) { return (fc & cpu_to_le16(IEEE80211_FCTL_FTYPE)) == cpu_to_le16(IEEE80211_FTYPE_DATA); }
+static inline bool ieee80211_is_data_qos(__le16 fc) { return (fc & cpu_to_le16(IEEE80211_FCTL_FTYPE | IEEE80211_STYPE_QOS_DATA)) == cpu_to_le16(IEEE80211_FTYPE_DATA | IEEE80211_STYPE_QOS_DATA); }
+static inline bool ieee80211_is_data_present(__le16 fc) { return (fc & cpu_to_le16(0x40 | IEEE80211_FCTL_FTYPE)) == cpu_to_le16(IEEE80211_FTYPE_DATA); }
+
+static inline u8* ieee80211_get_DA(struct ieee80211_hdr* hdr) { return (ieee80211_has_tods(hdr->frame_control) ? hdr->addr3 : hdr->addr1); }
+
+static inline u8* ieee80211_get_SA(struct ieee80211_hdr* hdr) {
+	if (ieee80211_has_a4(hdr->frame_control)) {
+		return hdr->addr4;
+	} else if (ieee80211_has_fromds(hdr->frame_control)) {
+		return hdr->addr3;
+	}
+
+	return hdr->addr2;
+}
+
+/* Socket buffer, the body is linear and the other buffers are chained into frag_list */
+#define CHECKSUM_NONE						0
+#define CHECKSUM_UNNECESSARY				1
+#define CHECKSUM_COMPLETE					2
+#define CHECKSUM_PARTIAL					3
+
+struct skb_shared_info {
+	unsigned short gso_size;
+	struct sk_buff* frag_list;
+};
+
+struct sk_buff {
+	struct sk_buff* next;
+	struct sk_buff* prev;
+
+	ktime_t tstamp;
+	char cb[48] __aligned(8);
+
+	unsigned int len;
+	unsigned int data_len;
+	unsigned int truesize;
+	uint8_t ip_summed;
+
+	unsigned char* head;
+	unsigned char* data;
+	unsigned char* tail;
+	unsigned char* end;
+	unsigned char* mac_header;
+
+	struct skb_shared_info shinfo;
+};
+
+struct sk_buff_head {
+	struct sk_buff* next;
+	struct sk_buff* prev;
+	u32 qlen;
+	spinlock_t lock;
+};
+
+#define skb_shinfo(skb)						(&(skb)->shinfo)
+
+struct sk_buff* alloc_skb(unsigned int size, gfp_t priority);
+void kfree_skb(struct sk_buff* skb);
+
+int pskb_expand_head(struct sk_buff* skb, int nhead, int ntail, gfp_t priority);
+unsigned char* __pskb_pull_tail(struct sk_buff* skb, int delta);
+
+static inline unsigned int skb_headlen(const struct sk_buff* skb) { return skb->len - skb->data_len; }
+static inline unsigned int skb_headroom(const struct sk_buff* skb) { return skb->data - skb->head; }
+static inline int skb_tailroom(const struct sk_buff* skb) { return skb->end - skb->tail; }
+static inline int skb_cloned(const struct sk_buff* skb) { return 0; }
+static inline int skb_unclone(struct sk_buff* skb, gfp_t priority) { return 0; }
+static inline bool skb_is_gso(const struct sk_buff* skb) { return skb_shinfo(skb)->gso_size; }
+static inline int skb_network_offset(const struct sk_buff* skb) { return 0; }
+static inline unsigned int skb_gso_network_seglen(const struct sk_buff* skb) { return skb_shinfo(skb)->gso_size; }
+static inline void skb_orphan(struct sk_buff* skb) { }
+static inline void skb_reset_mac_header(struct sk_buff* skb) { skb->mac_header = skb->data; }
+static inline int skb_checksum_help(struct sk_buff* skb) { skb->ip_summed = CHECKSUM_NONE; return 0; }
+static inline struct sk_buff* skb_gso_segment(struct sk_buff* skb, int features) { return ERR_PTR(-EPROTONOSUPPORT); }
+
+static inline void skb_reserve(struct sk_buff* skb, int len) {
+	skb->data += len;
+	skb->tail += len;
+}
+
+static inline unsigned char* skb_put(struct sk_buff* skb, unsigned int len) {
+	unsigned char* tmp = skb->tail;
+
+	skb->tail += len;
+	skb->len += len;
+	return tmp;
+}
+
+static inline unsigned char* skb_push(struct sk_buff* skb, unsigned int len) {
+	skb->data -= len;
+	skb->len += len;
+	return skb->data;
+}
+
+static inline unsigned char* skb_pull(struct sk_buff* skb, unsigned int len) {
+	if (len > skb_headlen(skb)) {
+		return NULL;
+	}
+
+	skb->len -= len;
+	skb->data += len;
+	return skb->data;
+}
+
+static inline int pskb_may_pull(struct sk_buff* skb, unsigned int len) {
+	if (likely(len <= skb_headlen(skb))) {
+		return 1;
+	} else if (unlikely(len > skb->len)) {
+		return 0;
+	}
+
+	return __pskb_pull_tail(skb, len - skb_headlen(skb)) != NULL;
+}
+
+static inline int skb_linearize(struct sk_buff* skb) {
+	return (skb->data_len && !__pskb_pull_tail(skb, skb->data_len)) ? -ENOMEM : 0;
+}
+
+static inline int skb_cow_head(struct sk_buff* skb, unsigned int headroom) {
+	int delta = (headroom > skb_headroom(skb)) ? headroom - skb_headroom(skb) : 0;
+
+	return (delta ? pskb_expand_head(skb, (delta + 63) & ~63, 0, GFP_ATOMIC) : 0);
+}
+
+/* The UDP/IP encapsulation is made by the application of library */
+static inline struct sk_buff* udp_tunnel_handle_offloads(struct sk_buff* skb, bool udp_csum) { return skb; }
+
+#endif /* __KMOD_USERSPACE_KSHIM_HEADER__ */
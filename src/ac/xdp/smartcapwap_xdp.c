@@ -0,0 +1,153 @@
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/in.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/udp.h>
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_endian.h>
+#include "smartcapwap_xdp.h"
+
+/* Decapsulate the IEEE 802.3 data packets of known sessions and stations directly into
+   the uplink of capwap interface of station, any other packet is delivered to the stack
+   and kernel module */
+
+/* CAPWAP header, RFC 5415 */
+#define CAPWAP_HEADER_MIN_LENGTH			8
+#define CAPWAP_HLEN(x)						(((x)[1] >> 3) * 4)
+#define CAPWAP_FLAG_T(x)					((x)[2] & 0x01)
+#define CAPWAP_FLAG_F(x)					((x)[3] & 0x80)
+#define CAPWAP_FLAG_K(x)					((x)[3] & 0x08)
+
+/* */
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, SMARTCAPWAP_XDP_MAX_SESSIONS);
+	__type(key, struct smartcapwap_xdp_session_key);
+	__type(value, struct smartcapwap_xdp_session);
+} smartcapwap_sessions SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, SMARTCAPWAP_XDP_MAX_STATIONS);
+	__type(key, struct smartcapwap_xdp_station_key);
+	__type(value, struct smartcapwap_xdp_station);
+} smartcapwap_stations SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_ARRAY);
+	__uint(max_entries, 1);
+	__type(key, __u32);
+	__type(value, struct smartcapwap_xdp_config);
+} smartcapwap_config SEC(".maps");
+
+/* Uplink by ifindex of capwap interface */
+struct {
+	__uint(type, BPF_MAP_TYPE_DEVMAP_HASH);
+	__uint(max_entries, SMARTCAPWAP_XDP_MAX_INTERFACES);
+	__type(key, __u32);
+	__type(value, __u32);
+} smartcapwap_interfaces SEC(".maps");
+
+/* */
+SEC("xdp")
+int smartcapwap_xdp(struct xdp_md* ctx) {
+	__u32 index = 0;
+	__u8* capwap;
+	struct udphdr* udp;
+	struct ethhdr* inner;
+	struct smartcapwap_xdp_config* config;
+	struct smartcapwap_xdp_session* session;
+	struct smartcapwap_xdp_station* station;
+	struct smartcapwap_xdp_session_key sessionkey = { };
+	struct smartcapwap_xdp_station_key stationkey = { };
+	void* data = (void*)(long)ctx->data;
+	void* data_end = (void*)(long)ctx->data_end;
+	struct ethhdr* eth = (struct ethhdr*)data;
+
+	/* */
+	config = bpf_map_lookup_elem(&smartcapwap_config, &index);
+	if (!config || !config->dataport || ((void*)(eth + 1) > data_end)) {
+		return XDP_PASS;
+	}
+
+	/* IP/UDP header without options and fragments */
+	if (eth->h_proto == bpf_htons(ETH_P_IP)) {
+		struct iphdr* ip = (struct iphdr*)(eth + 1);
+
+		if (((void*)(ip + 1) > data_end) || (ip->ihl != 5) || (ip->protocol != IPPROTO_UDP) || (ip->frag_off & bpf_htons(0x3fff))) {
+			return XDP_PASS;
+		}
+
+		sessionkey.family = SMARTCAPWAP_XDP_FAMILY_IPV4;
+		__builtin_memcpy(sessionkey.addr, &ip->saddr, 4);
+		udp = (struct udphdr*)(ip + 1);
+	} else if (eth->h_proto == bpf_htons(ETH_P_IPV6)) {
+		struct ipv6hdr* ip6 = (struct ipv6hdr*)(eth + 1);
+
+		if (((void*)(ip6 + 1) > data_end) || (ip6->nexthdr != IPPROTO_UDP)) {
+			return XDP_PASS;
+		}
+
+		sessionkey.family = SMARTCAPWAP_XDP_FAMILY_IPV6;
+		__builtin_memcpy(sessionkey.addr, &ip6->saddr, 16);
+		udp = (struct udphdr*)(ip6 + 1);
+	} else {
+		return XDP_PASS;
+	}
+
+	if (((void*)(udp + 1) > data_end) || (udp->dest != bpf_htons(config->dataport))) {
+		return XDP_PASS;
+	}
+
+	/* Plain CAPWAP header of IEEE 802.3 data, not fragmented and not keep-alive */
+	capwap = (__u8*)(udp + 1);
+	if (((void*)(capwap + CAPWAP_HEADER_MIN_LENGTH) > data_end) || capwap[0] || CAPWAP_FLAG_T(capwap) || CAPWAP_FLAG_F(capwap) || CAPWAP_FLAG_K(capwap) || (CAPWAP_HLEN(capwap) < CAPWAP_HEADER_MIN_LENGTH)) {
+		return XDP_PASS;
+	}
+
+	inner = (struct ethhdr*)(capwap + CAPWAP_HLEN(capwap));
+	if ((void*)(inner + 1) > data_end) {
+		return XDP_PASS;
+	}
+
+	/* Known session */
+	sessionkey.port = udp->source;
+	session = bpf_map_lookup_elem(&smartcapwap_sessions, &sessionkey);
+	if (!session) {
+		return XDP_PASS;
+	}
+
+	/* Station authorized into the session */
+	__builtin_memcpy(stationkey.addr, inner->h_source, ETH_ALEN);
+	station = bpf_map_lookup_elem(&smartcapwap_stations, &stationkey);
+	if (!station || (station->session != session->id)) {
+		return XDP_PASS;
+	}
+
+	/* The multicast packets and the packets between stations are forwarded by kernel module */
+	if (inner->h_dest[0] & 0x01) {
+		return XDP_PASS;
+	}
+
+	__builtin_memcpy(stationkey.addr, inner->h_dest, ETH_ALEN);
+	if (bpf_map_lookup_elem(&smartcapwap_stations, &stationkey)) {
+		return XDP_PASS;
+	}
+
+	/* Capwap interface of station without uplink */
+	index = station->ifindex;
+	if (!bpf_map_lookup_elem(&smartcapwap_interfaces, &index)) {
+		return XDP_PASS;
+	}
+
+	/* Remove Ethernet/IP/UDP/CAPWAP header */
+	if (bpf_xdp_adjust_head(ctx, (int)((void*)inner - data))) {
+		return XDP_PASS;
+	}
+
+	return bpf_redirect_map(&smartcapwap_interfaces, index, 0);
+}
+
+/* */
+char _license[] SEC("license") = "GPL";
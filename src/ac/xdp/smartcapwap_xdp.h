@@ -0,0 +1,51 @@
+#ifndef __SMARTCAPWAP_XDP_HEADER__
+#define __SMARTCAPWAP_XDP_HEADER__
+
+#include <linux/types.h>
+
+/* Maps shared by XDP program and AC loader */
+#define SMARTCAPWAP_XDP_PROGRAM					"smartcapwap_xdp"
+#define SMARTCAPWAP_XDP_MAP_SESSIONS			"smartcapwap_sessions"
+#define SMARTCAPWAP_XDP_MAP_STATIONS			"smartcapwap_stations"
+#define SMARTCAPWAP_XDP_MAP_CONFIG				"smartcapwap_config"
+#define SMARTCAPWAP_XDP_MAP_INTERFACES			"smartcapwap_interfaces"
+
+/* */
+#define SMARTCAPWAP_XDP_MAX_SESSIONS			4096
+#define SMARTCAPWAP_XDP_MAX_STATIONS			65536
+#define SMARTCAPWAP_XDP_MAX_INTERFACES			256
+
+/* */
+#define SMARTCAPWAP_XDP_FAMILY_IPV4				4
+#define SMARTCAPWAP_XDP_FAMILY_IPV6				6
+
+/* Data channel session by address of WTP */
+struct smartcapwap_xdp_session_key {
+	__u8 family;
+	__u8 reserved;
+	__be16 port;
+	__u8 addr[16];
+};
+
+struct smartcapwap_xdp_session {
+	__u32 id;
+};
+
+/* Station authorized into a data channel session */
+struct smartcapwap_xdp_station_key {
+	__u8 addr[6];
+	__u16 reserved;
+};
+
+struct smartcapwap_xdp_station {
+	__u32 session;
+	__u32 ifindex;
+};
+
+/* */
+struct smartcapwap_xdp_config {
+	__u16 dataport;
+	__u16 reserved;
+};
+
+#endif /* __SMARTCAPWAP_XDP_HEADER__ */
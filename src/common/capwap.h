@@ -63,6 +63,7 @@
 #include "capwap_debug.h"
 #include "capwap_error.h"
 #include "capwap_timeout.h"
+#include "capwap_rtt.h"
 
 /* Helper exit */
 void capwap_exit(int errorcode);
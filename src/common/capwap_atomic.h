@@ -0,0 +1,14 @@
+#ifndef __CAPWAP_ATOMIC_HEADER__
+#define __CAPWAP_ATOMIC_HEADER__
+
+/* Atomic counter, full memory barrier on each operation */
+typedef struct {
+	volatile long value;
+} capwap_atomic_t;
+
+#define capwap_atomic_init(a, v)						((a)->value = (v))
+#define capwap_atomic_read(a)							__sync_add_and_fetch(&(a)->value, 0)
+#define capwap_atomic_inc(a)							__sync_add_and_fetch(&(a)->value, 1)
+#define capwap_atomic_dec_and_test(a)					(__sync_sub_and_fetch(&(a)->value, 1) == 0)
+
+#endif /* __CAPWAP_ATOMIC_HEADER__ */
@@ -7,9 +7,11 @@
 int capwap_get_message_element_category(uint16_t type) {
 	switch (type) {
 		case CAPWAP_ELEMENT_ACNAMEPRIORITY:
+		case CAPWAP_ELEMENT_ADDSTATION:
 		case CAPWAP_ELEMENT_CONTROLIPV4:
 		case CAPWAP_ELEMENT_CONTROLIPV6:
 		case CAPWAP_ELEMENT_DECRYPTERRORREPORTPERIOD:
+		case CAPWAP_ELEMENT_DELETESTATION:
 		case CAPWAP_ELEMENT_RADIOADMSTATE:
 		case CAPWAP_ELEMENT_RADIOOPRSTATE:
 		case CAPWAP_ELEMENT_RETURNEDMESSAGE:
@@ -20,6 +22,7 @@ int capwap_get_message_element_category(uint16_t type) {
 		case CAPWAP_ELEMENT_80211_MULTIDOMAINCAPABILITY:
 		case CAPWAP_ELEMENT_80211_OFDMCONTROL:
 		case CAPWAP_ELEMENT_80211_RATESET:
+		case CAPWAP_ELEMENT_80211_STATION:
 		case CAPWAP_ELEMENT_80211_STATISTICS:
 		case CAPWAP_ELEMENT_80211_SUPPORTEDRATES:
 		case CAPWAP_ELEMENT_80211_TXPOWER:
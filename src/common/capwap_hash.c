@@ -46,9 +46,9 @@ static struct capwap_hash_item* capwap_hash_search_items(struct capwap_hash* has
 		if (!result) {
 			return search;
 		} else if (result < 0) {
-			search = item->left;
+			search = search->left;
 		} else if (result > 0) {
-			search = item->right;
+			search = search->right;
 		}
 	}
 
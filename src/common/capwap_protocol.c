@@ -523,6 +523,91 @@ void capwap_packet_txmng_add_message_element(struct capwap_packet_txmng* txmngpa
 	capwap_fragment_write_u16_from_pos((capwap_message_elements_handle)txmngpacket, txmngpacket->writerpacketsize, &writepos);
 }
 
+/* */
+void capwap_packet_txmng_add_encoded_message_element(struct capwap_packet_txmng* txmngpacket, unsigned short type, const uint8_t* data, unsigned short length) {
+	ASSERT(txmngpacket != NULL);
+	ASSERT(data != NULL);
+	ASSERT(length > 0);
+
+	/* Value is already encoded by capwap_message_element_encode */
+	txmngpacket->write_ops.write_u16((capwap_message_elements_handle)txmngpacket, type);
+	txmngpacket->write_ops.write_u16((capwap_message_elements_handle)txmngpacket, length);
+	txmngpacket->write_ops.write_block((capwap_message_elements_handle)txmngpacket, data, length);
+}
+
+/* */
+struct capwap_message_element_buffer {
+	uint8_t* buffer;
+	unsigned short size;
+	unsigned short offset;
+	int overflow;
+};
+
+/* */
+static int capwap_buffer_write_block(capwap_message_elements_handle handle, const uint8_t* data, unsigned short length) {
+	struct capwap_message_element_buffer* elementbuffer = (struct capwap_message_element_buffer*)handle;
+
+	ASSERT(handle != NULL);
+	ASSERT(data != NULL);
+
+	if ((elementbuffer->offset + length) > elementbuffer->size) {
+		elementbuffer->overflow = 1;
+		return -1;
+	}
+
+	memcpy(&elementbuffer->buffer[elementbuffer->offset], data, length);
+	elementbuffer->offset += length;
+
+	return length;
+}
+
+/* */
+static int capwap_buffer_write_u8(capwap_message_elements_handle handle, uint8_t data) {
+	return capwap_buffer_write_block(handle, &data, sizeof(uint8_t));
+}
+
+/* */
+static int capwap_buffer_write_u16(capwap_message_elements_handle handle, uint16_t data) {
+	uint16_t temp = htons(data);
+	return capwap_buffer_write_block(handle, (uint8_t*)&temp, sizeof(uint16_t));
+}
+
+/* */
+static int capwap_buffer_write_u32(capwap_message_elements_handle handle, uint32_t data) {
+	uint32_t temp = htonl(data);
+	return capwap_buffer_write_block(handle, (uint8_t*)&temp, sizeof(uint32_t));
+}
+
+/* */
+static struct capwap_write_message_elements_ops capwap_buffer_write_ops = {
+	.write_u8 = capwap_buffer_write_u8,
+	.write_u16 = capwap_buffer_write_u16,
+	.write_u32 = capwap_buffer_write_u32,
+	.write_block = capwap_buffer_write_block
+};
+
+/* */
+int capwap_message_element_encode(unsigned short type, void* data, uint8_t* buffer, unsigned short size) {
+	struct capwap_message_elements_ops* func;
+	struct capwap_message_element_buffer elementbuffer;
+
+	ASSERT(buffer != NULL);
+
+	/* Retrieve message element function */
+	func = capwap_get_message_element_ops(type);
+	ASSERT(func != NULL);
+	ASSERT(func->create_message_element != NULL);
+
+	/* Build only value of message element */
+	elementbuffer.buffer = buffer;
+	elementbuffer.size = size;
+	elementbuffer.offset = 0;
+	elementbuffer.overflow = 0;
+	func->create_message_element(data, (capwap_message_elements_handle)&elementbuffer, &capwap_buffer_write_ops);
+
+	return (elementbuffer.overflow ? -1 : (int)elementbuffer.offset);
+}
+
 /* */
 void capwap_packet_txmng_get_fragment_packets(struct capwap_packet_txmng* txmngpacket, struct capwap_list* fragmentlist, unsigned short fragmentid) {
 	unsigned short fragmentoffset = 0;
@@ -60,9 +60,13 @@ struct capwap_packet_txmng {
 /* */
 struct capwap_packet_txmng* capwap_packet_txmng_create_ctrl_message(struct capwap_header_data* data, unsigned long type, unsigned char seq, unsigned short mtu);
 void capwap_packet_txmng_add_message_element(struct capwap_packet_txmng* txmngpacket, unsigned short type, void* data);
+void capwap_packet_txmng_add_encoded_message_element(struct capwap_packet_txmng* txmngpacket, unsigned short type, const uint8_t* data, unsigned short length);
 void capwap_packet_txmng_get_fragment_packets(struct capwap_packet_txmng* txmngpacket, struct capwap_list* fragmentlist, unsigned short fragmentid);
 void capwap_packet_txmng_free(struct capwap_packet_txmng* txmngpacket);
 
+/* Encode once the value of message element shared by many packets */
+int capwap_message_element_encode(unsigned short type, void* data, uint8_t* buffer, unsigned short size);
+
 /* Management rx capwap packet */
 struct read_block_from_pos {
 	struct capwap_list_item* item;
@@ -0,0 +1,112 @@
+#include "capwap.h"
+#include "capwap_rtt.h"
+
+/* */
+#define CAPWAP_RTT_K						4
+#define CAPWAP_RTT_CLOCK_GRANULARITY		1000	/* us */
+
+/* */
+static long capwap_rtt_bound(struct capwap_rtt* rtt, long value) {
+	if (value < rtt->minrto) {
+		return rtt->minrto;
+	} else if (value > rtt->maxrto) {
+		return rtt->maxrto;
+	}
+
+	return value;
+}
+
+/* */
+void capwap_rtt_init(struct capwap_rtt* rtt, long initrto, long minrto, long maxrto) {
+	ASSERT(rtt != NULL);
+	ASSERT(minrto > 0);
+	ASSERT(minrto <= maxrto);
+
+	memset(rtt, 0, sizeof(struct capwap_rtt));
+	rtt->initrto = initrto;
+	rtt->minrto = minrto;
+	rtt->maxrto = maxrto;
+	rtt->rto = capwap_rtt_bound(rtt, initrto);
+	rtt->timeout = rtt->rto;
+}
+
+/* Send new request, return the retransmission timeout */
+long capwap_rtt_start(struct capwap_rtt* rtt) {
+	ASSERT(rtt != NULL);
+
+	rtt->pending = 1;
+	rtt->retransmit = 0;
+	rtt->timeout = rtt->rto;
+	gettimeofday(&rtt->sendtime, NULL);
+
+	return rtt->timeout;
+}
+
+/* Retransmit request, return the backed off retransmission timeout with jitter */
+long capwap_rtt_backoff(struct capwap_rtt* rtt) {
+	long jitter;
+
+	ASSERT(rtt != NULL);
+
+	/* Exponential backoff */
+	rtt->retransmit = 1;
+	rtt->retransmissions++;
+	rtt->timeout = capwap_rtt_bound(rtt, rtt->timeout * 2);
+
+	/* Randomize of +/- 1/8 to avoid synchronization of many retransmission timers */
+	jitter = rtt->timeout / 4;
+	if (jitter > 0) {
+		return rtt->timeout - (jitter / 2) + capwap_get_rand(jitter + 1);
+	}
+
+	return rtt->timeout;
+}
+
+/* Receive response of request */
+void capwap_rtt_update(struct capwap_rtt* rtt) {
+	long delta;
+	long sample;
+	struct timeval now;
+
+	ASSERT(rtt != NULL);
+
+	/* */
+	if (!rtt->pending) {
+		return;
+	}
+
+	rtt->pending = 0;
+
+	/* Karn's algorithm: ignore ambiguous sample of retransmitted request and
+	   keep the backed off timeout until a valid sample is received */
+	if (rtt->retransmit) {
+		rtt->rto = rtt->timeout;
+		return;
+	}
+
+	/* */
+	gettimeofday(&now, NULL);
+	sample = (now.tv_sec - rtt->sendtime.tv_sec) * 1000000 + (now.tv_usec - rtt->sendtime.tv_usec);
+	if (sample < 0) {
+		return;
+	}
+
+	/* */
+	if (!rtt->samples) {
+		rtt->srtt = sample;
+		rtt->rttvar = sample / 2;
+	} else {
+		delta = rtt->srtt - sample;
+		if (delta < 0) {
+			delta = -delta;
+		}
+
+		/* beta = 1/4, alpha = 1/8 */
+		rtt->rttvar = (3 * rtt->rttvar + delta) / 4;
+		rtt->srtt = (7 * rtt->srtt + sample) / 8;
+	}
+
+	/* RTO = SRTT + max(G, K * RTTVAR) */
+	rtt->samples++;
+	rtt->rto = capwap_rtt_bound(rtt, (rtt->srtt + max(CAPWAP_RTT_CLOCK_GRANULARITY, CAPWAP_RTT_K * rtt->rttvar) + 999) / 1000);
+}
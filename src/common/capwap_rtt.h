@@ -0,0 +1,37 @@
+#ifndef __CAPWAP_RTT_HEADER__
+#define __CAPWAP_RTT_HEADER__
+
+/* Retransmission timer estimation, RFC 6298 */
+struct capwap_rtt {
+	/* Bounds in ms */
+	long initrto;
+	long minrto;
+	long maxrto;
+
+	/* Estimation in us */
+	long srtt;
+	long rttvar;
+
+	/* Retransmission timeout in ms */
+	long rto;
+	long timeout;
+
+	/* */
+	int pending;
+	int retransmit;
+	struct timeval sendtime;
+
+	/* */
+	unsigned long samples;
+	unsigned long retransmissions;
+};
+
+/* */
+void capwap_rtt_init(struct capwap_rtt* rtt, long initrto, long minrto, long maxrto);
+
+/* */
+long capwap_rtt_start(struct capwap_rtt* rtt);
+long capwap_rtt_backoff(struct capwap_rtt* rtt);
+void capwap_rtt_update(struct capwap_rtt* rtt);
+
+#endif /* __CAPWAP_RTT_HEADER__ */
@@ -148,9 +148,7 @@ void capwap_socket_crypto_freecontext(void* context) {
 }
 
 /* */
-struct capwap_socket_ssl* capwap_socket_ssl_connect(int sock, void* sslcontext, int timeout) {
-	int result;
-	struct pollfd fds;
+struct capwap_socket_ssl* capwap_socket_ssl_create(int sock, void* sslcontext) {
 	struct capwap_socket_ssl* sslsock;
 
 	ASSERT(sock >= 0);
@@ -175,6 +173,23 @@ struct capwap_socket_ssl* capwap_socket_ssl_connect(int sock, void* sslcontext,
 
 	/* */
 	CyaSSL_set_using_nonblock((CYASSL*)sslsock->sslsession, 1);
+	return sslsock;
+}
+
+/* */
+struct capwap_socket_ssl* capwap_socket_ssl_connect(int sock, void* sslcontext, int timeout) {
+	int result;
+	struct pollfd fds;
+	struct capwap_socket_ssl* sslsock;
+
+	ASSERT(sock >= 0);
+	ASSERT(sslcontext != NULL);
+
+	/* Create SSL session */
+	sslsock = capwap_socket_ssl_create(sock, sslcontext);
+	if (!sslsock) {
+		return NULL;
+	}
 
 	/* Establish SSL connection */
 	for (;;) {
@@ -386,3 +401,130 @@ int capwap_socket_recv(int sock, void* buffer, size_t length, int timeout) {
 
 	return -1;
 }
+
+/* */
+int capwap_socket_connect_async(int sock, union sockaddr_capwap* address) {
+	ASSERT(sock >= 0);
+	ASSERT(address != NULL);
+
+	/* Non blocking socket */
+	if (!capwap_socket_nonblocking(sock, 1)) {
+		return CAPWAP_SOCKET_ERROR;
+	}
+
+	/* */
+	if (connect(sock, &address->sa, sizeof(union sockaddr_capwap)) < 0) {
+		return ((errno == EINPROGRESS) ? CAPWAP_SOCKET_WANT_WRITE : CAPWAP_SOCKET_ERROR);
+	}
+
+	return 1;
+}
+
+/* */
+int capwap_socket_connect_result(int sock) {
+	int result;
+	socklen_t size = sizeof(int);
+
+	ASSERT(sock >= 0);
+
+	/* Check connection status */
+	if ((getsockopt(sock, SOL_SOCKET, SO_ERROR, (void*)&result, &size) < 0) || result) {
+		return CAPWAP_SOCKET_ERROR;
+	}
+
+	return 1;
+}
+
+/* */
+int capwap_socket_send_async(int sock, void* buffer, size_t length) {
+	int result;
+
+	ASSERT(sock >= 0);
+	ASSERT(buffer != NULL);
+	ASSERT(length > 0);
+
+	result = send(sock, buffer, length, MSG_NOSIGNAL);
+	if (result < 0) {
+		return (((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ? CAPWAP_SOCKET_WANT_WRITE : CAPWAP_SOCKET_ERROR);
+	}
+
+	return result;
+}
+
+/* */
+int capwap_socket_recv_async(int sock, void* buffer, size_t length) {
+	int result;
+
+	ASSERT(sock >= 0);
+	ASSERT(buffer != NULL);
+	ASSERT(length > 0);
+
+	result = recv(sock, buffer, length, 0);
+	if (result < 0) {
+		return (((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ? CAPWAP_SOCKET_WANT_READ : CAPWAP_SOCKET_ERROR);
+	}
+
+	return result;
+}
+
+/* */
+static int capwap_socket_crypto_error(struct capwap_socket_ssl* sslsock, int result) {
+	int error = CyaSSL_get_error((CYASSL*)sslsock->sslsession, result);
+
+	if (error == SSL_ERROR_WANT_READ) {
+		return CAPWAP_SOCKET_WANT_READ;
+	} else if (error == SSL_ERROR_WANT_WRITE) {
+		return CAPWAP_SOCKET_WANT_WRITE;
+	}
+
+	return CAPWAP_SOCKET_ERROR;
+}
+
+/* */
+int capwap_socket_ssl_connect_async(struct capwap_socket_ssl* sslsock) {
+	int result;
+
+	ASSERT(sslsock != NULL);
+	ASSERT(sslsock->sslsession != NULL);
+
+	result = CyaSSL_connect((CYASSL*)sslsock->sslsession);
+	if (result != SSL_SUCCESS) {
+		return capwap_socket_crypto_error(sslsock, result);
+	}
+
+	return 1;
+}
+
+/* */
+int capwap_socket_crypto_send_async(struct capwap_socket_ssl* sslsock, void* buffer, size_t length) {
+	int result;
+
+	ASSERT(sslsock != NULL);
+	ASSERT(sslsock->sslsession != NULL);
+	ASSERT(buffer != NULL);
+	ASSERT(length > 0);
+
+	result = CyaSSL_write((CYASSL*)sslsock->sslsession, buffer, length);
+	if (result <= 0) {
+		return capwap_socket_crypto_error(sslsock, result);
+	}
+
+	return result;
+}
+
+/* */
+int capwap_socket_crypto_recv_async(struct capwap_socket_ssl* sslsock, void* buffer, size_t length) {
+	int result;
+
+	ASSERT(sslsock != NULL);
+	ASSERT(sslsock->sslsession != NULL);
+	ASSERT(buffer != NULL);
+	ASSERT(length > 0);
+
+	result = CyaSSL_read((CYASSL*)sslsock->sslsession, buffer, length);
+	if (result < 0) {
+		return capwap_socket_crypto_error(sslsock, result);
+	}
+
+	return result;
+}
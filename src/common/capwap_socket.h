@@ -27,4 +27,19 @@ struct capwap_socket_ssl* capwap_socket_ssl_connect(int sock, void* sslcontext,
 void capwap_socket_ssl_shutdown(struct capwap_socket_ssl* sslsock, int timeout);
 void capwap_socket_ssl_close(struct capwap_socket_ssl* sslsock);
 
+/* Non blocking operations */
+#define CAPWAP_SOCKET_ERROR					-1
+#define CAPWAP_SOCKET_WANT_READ				-2
+#define CAPWAP_SOCKET_WANT_WRITE			-3
+
+int capwap_socket_connect_async(int sock, union sockaddr_capwap* address);
+int capwap_socket_connect_result(int sock);
+int capwap_socket_send_async(int sock, void* buffer, size_t length);
+int capwap_socket_recv_async(int sock, void* buffer, size_t length);
+
+struct capwap_socket_ssl* capwap_socket_ssl_create(int sock, void* sslcontext);
+int capwap_socket_ssl_connect_async(struct capwap_socket_ssl* sslsock);
+int capwap_socket_crypto_send_async(struct capwap_socket_ssl* sslsock, void* buffer, size_t length);
+int capwap_socket_crypto_recv_async(struct capwap_socket_ssl* sslsock, void* buffer, size_t length);
+
 #endif /* __CAPWAP_SOCKET_HEADER__ */
@@ -90,7 +90,7 @@ static void capwap_timeout_additem(struct capwap_list* itemstimeout, struct capw
 /* */
 static void capwap_timeout_setexpire(long durate, struct timeval* now, struct timeval* expire) {
 	expire->tv_sec = now->tv_sec + durate / 1000;
-	expire->tv_usec = now->tv_usec + durate % 1000;
+	expire->tv_usec = now->tv_usec + (durate % 1000) * 1000;
 	if (expire->tv_usec >= 1000000) {
 		expire->tv_sec++;
 		expire->tv_usec -= 1000000;
@@ -71,6 +71,8 @@ static int wtp_init(void) {
 	g_wtp.requestfragmentpacket = capwap_list_create();
 	g_wtp.responsefragmentpacket = capwap_list_create();
 	g_wtp.remoteseqnumber = WTP_INIT_REMOTE_SEQUENCE;
+	capwap_rtt_init(&g_wtp.rtt, WTP_RETRANSMIT_INTERVAL, WTP_MIN_RETRANSMIT_INTERVAL, WTP_MAX_RETRANSMIT_INTERVAL);
+	g_wtp.maxretransmit = WTP_MAX_RETRANSMIT;
 
 	/* AC information */
 	g_wtp.discoverytype.type = CAPWAP_DISCOVERYTYPE_TYPE_UNKNOWN;
@@ -933,6 +935,50 @@ static int wtp_parsing_configuration_1_0(config_t* config) {
 		}
 	}
 
+	/* Set retransmission timer of WTP */
+	if (config_lookup_int(config, "application.timer.retransmit.initial", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_wtp.rtt.initrto = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid application.timer.retransmit.initial value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "application.timer.retransmit.min", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_wtp.rtt.minrto = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid application.timer.retransmit.min value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "application.timer.retransmit.max", &configInt) == CONFIG_TRUE) {
+		if (configInt > 0) {
+			g_wtp.rtt.maxrto = (long)configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid application.timer.retransmit.max value");
+			return 0;
+		}
+	}
+
+	if (config_lookup_int(config, "application.timer.retransmit.count", &configInt) == CONFIG_TRUE) {
+		if ((configInt > 0) && (configInt < 256)) {
+			g_wtp.maxretransmit = configInt;
+		} else {
+			capwap_logging_error("Invalid configuration file, invalid application.timer.retransmit.count value");
+			return 0;
+		}
+	}
+
+	if ((g_wtp.rtt.minrto > g_wtp.rtt.initrto) || (g_wtp.rtt.initrto > g_wtp.rtt.maxrto)) {
+		capwap_logging_error("Invalid configuration file, application.timer.retransmit values must be min <= initial <= max");
+		return 0;
+	}
+
+	capwap_rtt_init(&g_wtp.rtt, g_wtp.rtt.initrto, g_wtp.rtt.minrto, g_wtp.rtt.maxrto);
+
 	/* Set DTLS of WTP */
 	if (config_lookup_bool(config, "application.dtls.enable", &configBool) == CONFIG_TRUE) {
 		if (configBool != 0) {
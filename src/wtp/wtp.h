@@ -30,7 +30,9 @@
 #define WTP_DTLS_SESSION_DELETE					5000
 #define WTP_FAILED_DTLS_SESSION_RETRY			3
 
+#define WTP_MIN_RETRANSMIT_INTERVAL				1000
 #define WTP_RETRANSMIT_INTERVAL					3000
+#define WTP_MAX_RETRANSMIT_INTERVAL				60000
 #define WTP_MAX_RETRANSMIT						5
 
 #define WTP_DATACHANNEL_KEEPALIVE_INTERVAL		30000
@@ -121,6 +123,8 @@ struct wtp_t {
 	uint8_t localseqnumber;
 	struct capwap_list* requestfragmentpacket;
 	int retransmitcount;
+	int maxretransmit;
+	struct capwap_rtt rtt;
 
 	/* */
 	uint32_t remotetype;
@@ -471,6 +471,12 @@ int wtp_dfa_running(void) {
 						continue;
 					}
 
+					/* Update round-trip time estimation with response of pending request */
+					if (!capwap_is_request_type(rxmngpacket->ctrlmsg.type) && g_wtp.requestfragmentpacket->count && (g_wtp.localseqnumber == rxmngpacket->ctrlmsg.seq)) {
+						capwap_rtt_update(&g_wtp.rtt);
+						capwap_logging_debug("Control channel srtt %ld us, rttvar %ld us, rto %ld ms", g_wtp.rtt.srtt, g_wtp.rtt.rttvar, g_wtp.rtt.rto);
+					}
+
 					/* Receive a complete packet */
 					wtp_dfa_execute(&packet);
 
@@ -513,6 +519,12 @@ void wtp_free_reference_last_response(void) {
 	g_wtp.remoteseqnumber = 0;
 }
 
+/* */
+void wtp_dfa_retransmition_start(void) {
+	g_wtp.retransmitcount = 0;
+	capwap_timeout_set(g_wtp.timeout, g_wtp.idtimercontrol, capwap_rtt_start(&g_wtp.rtt), wtp_dfa_retransmition_timeout, NULL, NULL);
+}
+
 /* */
 void wtp_dfa_retransmition_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param) {
 	if (!g_wtp.requestfragmentpacket->count) {
@@ -520,7 +532,7 @@ void wtp_dfa_retransmition_timeout(struct capwap_timeout* timeout, unsigned long
 		wtp_teardown_connection();
 	} else {
 		g_wtp.retransmitcount++;
-		if (g_wtp.retransmitcount >= WTP_MAX_RETRANSMIT) {
+		if (g_wtp.retransmitcount >= g_wtp.maxretransmit) {
 			capwap_logging_info("Retransmition request packet timeout");
 
 			/* Timeout state */
@@ -533,8 +545,8 @@ void wtp_dfa_retransmition_timeout(struct capwap_timeout* timeout, unsigned long
 				capwap_logging_error("Error to send request packet");
 			}
 
-			/* Update timeout */
-			capwap_timeout_set(g_wtp.timeout, g_wtp.idtimercontrol, WTP_RETRANSMIT_INTERVAL, wtp_dfa_retransmition_timeout, NULL, NULL);
+			/* Update timeout with exponential backoff */
+			capwap_timeout_set(g_wtp.timeout, g_wtp.idtimercontrol, capwap_rtt_backoff(&g_wtp.rtt), wtp_dfa_retransmition_timeout, NULL, NULL);
 		}
 	}
 }
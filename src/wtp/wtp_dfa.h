@@ -35,6 +35,7 @@ void wtp_send_configure(void);
 void wtp_send_datacheck(void);
 
 /* */
+void wtp_dfa_retransmition_start(void);
 void wtp_dfa_retransmition_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param);
 
 int wtp_dfa_update_fdspool(struct wtp_fds* fds);
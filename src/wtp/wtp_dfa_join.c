@@ -77,9 +77,8 @@ void wtp_send_join(void) {
 
 	/* Send join request to AC */
 	if (capwap_crypt_sendto_fragmentpacket(&g_wtp.dtls, g_wtp.requestfragmentpacket)) {
-		g_wtp.retransmitcount = 0;
 		wtp_dfa_change_state(CAPWAP_JOIN_STATE);
-		capwap_timeout_set(g_wtp.timeout, g_wtp.idtimercontrol, WTP_RETRANSMIT_INTERVAL, wtp_dfa_retransmition_timeout, NULL, NULL);
+		wtp_dfa_retransmition_start();
 	} else {
 		/* Error to send packets */
 		capwap_logging_debug("Warning: error to send join request packet");
@@ -213,8 +213,7 @@ static void receive_ieee80211_wlan_configuration_request(struct capwap_parsed_pa
 void wtp_dfa_state_run_echo_timeout(struct capwap_timeout* timeout, unsigned long index, void* context, void* param) {
 	capwap_logging_debug("Send Echo Request");
 	if (!send_echo_request()) {
-		g_wtp.retransmitcount = 0;
-		capwap_timeout_set(g_wtp.timeout, g_wtp.idtimercontrol, WTP_RETRANSMIT_INTERVAL, wtp_dfa_retransmition_timeout, NULL, NULL);
+		wtp_dfa_retransmition_start();
 	} else {
 		capwap_logging_error("Unable to send Echo Request");
 		wtp_teardown_connection();
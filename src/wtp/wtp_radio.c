@@ -705,17 +705,13 @@ uint32_t wtp_radio_delete_wlan(struct capwap_parsed_packet* packet) {
 }
 
 /* */
-uint32_t wtp_radio_add_station(struct capwap_parsed_packet* packet) {
-	struct capwap_addstation_element* addstation;
-	struct capwap_80211_station_element* station80211;
+static uint32_t wtp_radio_add_single_station(struct capwap_addstation_element* addstation, struct capwap_80211_station_element* station80211) {
 	struct wtp_radio* radio;
 	struct wtp_radio_wlan* wlan;
 	struct station_add_params stationparams;
 
-	/* Get message elements */
-	addstation = (struct capwap_addstation_element*)capwap_get_message_element_data(packet, CAPWAP_ELEMENT_ADDSTATION);
-	station80211 = (struct capwap_80211_station_element*)capwap_get_message_element_data(packet, CAPWAP_ELEMENT_80211_STATION);
-	if (!station80211 || (addstation->radioid != station80211->radioid)) {
+	/* */
+	if (addstation->radioid != station80211->radioid) {
 		return CAPWAP_RESULTCODE_FAILURE;
 	}
 
@@ -743,23 +739,66 @@ uint32_t wtp_radio_add_station(struct capwap_parsed_packet* packet) {
 }
 
 /* */
-uint32_t wtp_radio_delete_station(struct capwap_parsed_packet* packet) {
-	struct wtp_radio* radio;
-	struct capwap_deletestation_element* deletestation;
-
-	/* Get message elements */
-	deletestation = (struct capwap_deletestation_element*)capwap_get_message_element_data(packet, CAPWAP_ELEMENT_DELETESTATION);
-
-	/* Get physical radio */
-	radio = wtp_radio_get_phy(deletestation->radioid);
-	if (!radio) {
+uint32_t wtp_radio_add_station(struct capwap_parsed_packet* packet) {
+	int i;
+	struct capwap_array* addstations;
+	struct capwap_array* stations80211;
+	uint32_t result = CAPWAP_RESULTCODE_SUCCESS;
+
+	/* Get message elements, a request can carry more stations */
+	addstations = (struct capwap_array*)capwap_get_message_element_data(packet, CAPWAP_ELEMENT_ADDSTATION);
+	stations80211 = (struct capwap_array*)capwap_get_message_element_data(packet, CAPWAP_ELEMENT_80211_STATION);
+	if (!stations80211 || (addstations->count != stations80211->count)) {
 		return CAPWAP_RESULTCODE_FAILURE;
 	}
 
 	/* */
-	wifi_station_deauthorize(radio->devicehandle, deletestation->address);
+	for (i = 0; i < addstations->count; i++) {
+		result = wtp_radio_add_single_station(*(struct capwap_addstation_element**)capwap_array_get_item_pointer(addstations, i), *(struct capwap_80211_station_element**)capwap_array_get_item_pointer(stations80211, i));
+		if (!CAPWAP_RESULTCODE_OK(result)) {
+			break;
+		}
+	}
 
-	return CAPWAP_RESULTCODE_SUCCESS;
+	/* The Result Code is for all stations, rollback the stations already added */
+	if (!CAPWAP_RESULTCODE_OK(result)) {
+		while (--i >= 0) {
+			struct capwap_addstation_element* addstation = *(struct capwap_addstation_element**)capwap_array_get_item_pointer(addstations, i);
+			struct wtp_radio* radio = wtp_radio_get_phy(addstation->radioid);
+
+			if (radio) {
+				wifi_station_deauthorize(radio->devicehandle, addstation->address);
+			}
+		}
+	}
+
+	return result;
+}
+
+/* */
+uint32_t wtp_radio_delete_station(struct capwap_parsed_packet* packet) {
+	int i;
+	struct wtp_radio* radio;
+	struct capwap_array* deletestations;
+	uint32_t result = CAPWAP_RESULTCODE_SUCCESS;
+
+	/* Get message elements, a request can carry more stations */
+	deletestations = (struct capwap_array*)capwap_get_message_element_data(packet, CAPWAP_ELEMENT_DELETESTATION);
+	for (i = 0; i < deletestations->count; i++) {
+		struct capwap_deletestation_element* deletestation = *(struct capwap_deletestation_element**)capwap_array_get_item_pointer(deletestations, i);
+
+		/* Get physical radio */
+		radio = wtp_radio_get_phy(deletestation->radioid);
+		if (!radio) {
+			result = CAPWAP_RESULTCODE_FAILURE;
+			continue;
+		}
+
+		/* */
+		wifi_station_deauthorize(radio->devicehandle, deletestation->address);
+	}
+
+	return result;
 }
 
 /* */
@@ -0,0 +1,411 @@
+#!/usr/bin/env python3
+#
+# Reference Backend Server for the JSON transport of SmartCAPWAP AC
+#
+# The AC post every call as
+#   { "Method": [string], "Params": { <name>: [value] } }
+# and receive
+#   200 { "Return": [value] }
+#   500 { "Fault": { "Code": [string], "String": [string] } }
+#
+# The params and return values are the same JSON documents carried base64
+# encoded by the SOAP transport, see smartcapwap.wsdl. The calls of SOAP
+# transport, with Content-Type text/xml, are answered with the SOAP envelope
+# of the same return value or fault.
+#
+# Events are queued with a POST of { "Action": [string], "Params": {} } to
+# /event and delivered to AC by waitBackendEvent or streamBackendEvent.
+#
+# The latency of every call is changed at runtime with a POST of
+# { "Delay": [int] } to /delay, in milliseconds.
+#
+# The responses of joinWTPSession and configureStatusWTPSession with a
+# { "Profile": { "Key": [string], "Version": [int] } } element are shared by
+# the WTPs of a profile. When the AC announces in CachedProfiles the same key
+# and version, only the Profile element with "Cached": true is returned.
+# A POST of { "Key": [string] } to /profile changes the version of profile and
+# queues the InvalidateProfile event.
+#
+# Configure the AC with:
+#   server: ( { url = "http://127.0.0.1:8080/backend"; transport = "json"; } );
+
+import argparse
+import base64
+import json
+import threading
+import time
+import uuid
+import xml.etree.ElementTree as ElementTree
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from xml.sax.saxutils import escape
+
+# Return value of WTP session methods, can be overridden with --responses
+DEFAULT_RESPONSES = {
+	"authorizeWTPSession": True,
+	"joinWTPSession": {},
+	"configureStatusWTPSession": {},
+	"changeStateWTPSession": {},
+	"runningWTPSession": True,
+	"teardownWTPSession": True,
+	"checkWTPSession": True,
+	"authorizeStation": {},
+}
+
+# Param of WTP session methods with response shared by profile
+PROFILE_PARAMS = {
+	"joinWTPSession": "join",
+	"configureStatusWTPSession": "confstatus",
+}
+
+WAIT_EVENT_TIMEOUT = 30.0
+
+# SOAP transport
+SOAP_ENVELOPE_NAMESPACE = "http://schemas.xmlsoap.org/soap/envelope/"
+SOAP_NAMESPACE_URI = "http://smartcapwap/namespace"
+XSI_TYPE = "{http://www.w3.org/2001/XMLSchema-instance}type"
+
+
+class Fault(Exception):
+	def __init__(self, code, string):
+		Exception.__init__(self, string)
+		self.code = code
+		self.string = string
+
+
+# Method and params of SOAP request, the xs:base64Binary params are JSON documents
+def parse_soap_request(body):
+	envelope = ElementTree.fromstring(body)
+	request = envelope.find("{%s}Body/*" % SOAP_ENVELOPE_NAMESPACE)
+	if request is None:
+		raise ValueError("SOAP request without method")
+
+	params = {}
+	for param in request:
+		kind = param.get(XSI_TYPE, "xs:string").split(":")[-1]
+		value = param.text or ""
+		if kind == "base64Binary":
+			params[param.tag] = json.loads(base64.b64decode(value).decode("utf-8"))
+		elif kind == "boolean":
+			params[param.tag] = (value == "true")
+		elif kind in ("int", "long"):
+			params[param.tag] = int(value)
+		else:
+			params[param.tag] = value
+
+	return request.tag.split("}")[-1], params
+
+
+# SOAP envelope of return value or fault
+def soap_response(method, result=None, fault=None):
+	if fault:
+		body = "<SOAP-ENV:Fault><faultcode>SOAP-ENV:%s</faultcode><faultstring>%s</faultstring></SOAP-ENV:Fault>" % (escape(fault.code), escape(fault.string))
+	elif result is None:
+		body = "<tns:%sResponse/>" % method
+	elif isinstance(result, bool):
+		body = "<tns:%sResponse><return xsi:type=\"xsd:boolean\">%s</return></tns:%sResponse>" % (method, ("true" if result else "false"), method)
+	elif isinstance(result, (dict, list)):
+		encoded = base64.b64encode(json.dumps(result, separators=(",", ":")).encode("utf-8")).decode("ascii")
+		body = "<tns:%sResponse><return xsi:type=\"xsd:base64Binary\">%s</return></tns:%sResponse>" % (method, encoded, method)
+	else:
+		body = "<tns:%sResponse><return xsi:type=\"xsd:string\">%s</return></tns:%sResponse>" % (method, escape(str(result)), method)
+
+	return ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<SOAP-ENV:Envelope xmlns:SOAP-ENV=\"%s\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+		"xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" xmlns:tns=\"%s\"><SOAP-ENV:Body>%s</SOAP-ENV:Body></SOAP-ENV:Envelope>\n" % (SOAP_ENVELOPE_NAMESPACE, SOAP_NAMESPACE_URI, body)).encode("utf-8")
+
+
+class Backend(object):
+	def __init__(self, responses, delay):
+		self.responses = dict(DEFAULT_RESPONSES)
+		self.responses.update(responses)
+		self.delay = delay
+
+		self.lock = threading.Condition()
+		self.sessions = set()
+		self.events = []
+		self.sequence = 0
+		self.acked = 0
+		self.status = {}
+
+	# Events
+	def add_event(self, action, params):
+		with self.lock:
+			self.sequence += 1
+			self.events.append({
+				"Sequence": self.sequence,
+				"EventID": str(self.sequence),
+				"Action": action,
+				"Params": params,
+			})
+			self.lock.notify_all()
+			return self.sequence
+
+	def get_events(self, sequence, timeout):
+		deadline = time.time() + timeout
+		with self.lock:
+			while True:
+				events = [event for event in self.events if event["Sequence"] > sequence]
+				remaining = deadline - time.time()
+				if events or (remaining <= 0):
+					return events
+
+				self.lock.wait(remaining)
+
+	# AC session
+	def check_session(self, params):
+		if params.get("idsession") not in self.sessions:
+			raise Fault("Client", "Invalid session")
+
+	def joinBackend(self, params):
+		idsession = uuid.uuid4().hex
+		with self.lock:
+			if params.get("forcereset") is True:
+				self.sessions.clear()
+				self.events = []
+				self.acked = 0
+
+			self.sessions.add(idsession)
+
+		return idsession
+
+	def leaveBackend(self, params):
+		self.check_session(params)
+		with self.lock:
+			self.sessions.discard(params["idsession"])
+
+		return None
+
+	def getConfiguration(self, params):
+		self.check_session(params)
+		return {}
+
+	def waitBackendEvent(self, params):
+		self.check_session(params)
+		events = self.get_events(self.acked, WAIT_EVENT_TIMEOUT)
+		with self.lock:
+			if events:
+				self.acked = max(self.acked, events[-1]["Sequence"])
+
+		return [dict((key, event[key]) for key in ("EventID", "Action", "Params")) for event in events]
+
+	def ackBackendEvent(self, params):
+		self.check_session(params)
+		with self.lock:
+			self.acked = max(self.acked, int(params.get("sequence", 0)))
+
+		return None
+
+	def updateBackendEvent(self, params):
+		self.check_session(params)
+		with self.lock:
+			self.status[params.get("idevent")] = params.get("status")
+
+		return None
+
+	def updateWLANProvisioning(self, params):
+		self.check_session(params)
+		return None
+
+	def pingBackend(self, params):
+		return "pong"
+
+	# Profile
+	def change_profile(self, key):
+		count = 0
+		with self.lock:
+			for response in self.responses.values():
+				profile = (response.get("Profile") if isinstance(response, dict) else None)
+				if isinstance(profile, dict) and (profile.get("Key") == key):
+					profile["Version"] = int(profile.get("Version", 0)) + 1
+					count += 1
+
+		if count:
+			self.add_event("InvalidateProfile", { "Key": key })
+
+		return count
+
+	def get_profile_response(self, method, params):
+		response = self.responses[method]
+		profile = (response.get("Profile") if isinstance(response, dict) else None)
+		if not isinstance(profile, dict):
+			return response
+
+		request = params.get(PROFILE_PARAMS[method])
+		cached = (request.get("CachedProfiles", []) if isinstance(request, dict) else [])
+		for item in (cached if isinstance(cached, list) else []):
+			if isinstance(item, dict) and (item.get("Key") == profile.get("Key")) and (item.get("Version") == profile.get("Version")):
+				return { "Profile": { "Key": profile["Key"], "Version": profile["Version"], "Cached": True } }
+
+		return response
+
+	# WTP session
+	def call_session(self, method, params):
+		self.check_session(params)
+		if method not in self.responses:
+			raise Fault("Client", "Unknown method %s" % method)
+
+		if method in PROFILE_PARAMS:
+			with self.lock:
+				return json.loads(json.dumps(self.get_profile_response(method, params)))
+
+		return self.responses[method]
+
+	def executeBatch(self, params):
+		self.check_session(params)
+		batch = params.get("batch")
+		if not isinstance(batch, dict) or (batch.get("Method") not in self.responses):
+			raise Fault("Client", "Invalid batch")
+
+		responses = []
+		for request in batch.get("Requests", []):
+			responses.append({ "RequestID": request.get("RequestID"), "Return": self.responses[batch["Method"]] })
+
+		return { "Responses": responses }
+
+	def call(self, method, params):
+		if self.delay > 0:
+			time.sleep(self.delay / 1000.0)
+
+		if method in DEFAULT_RESPONSES:
+			return self.call_session(method, params)
+		elif method in ("joinBackend", "leaveBackend", "pingBackend", "getConfiguration", "waitBackendEvent", "ackBackendEvent", "updateBackendEvent", "updateWLANProvisioning", "executeBatch"):
+			return getattr(self, method)(params)
+
+		raise Fault("Client", "Unknown method %s" % method)
+
+
+class Handler(BaseHTTPRequestHandler):
+	protocol_version = "HTTP/1.1"
+	disable_nagle_algorithm = True
+
+	def log_message(self, format, *args):
+		if self.server.verbose:
+			BaseHTTPRequestHandler.log_message(self, format, *args)
+
+	def send_json(self, code, document):
+		body = json.dumps(document, separators=(",", ":")).encode("utf-8")
+		self.send_response(code)
+		self.send_header("Content-Type", "application/json")
+		self.send_header("Content-Length", str(len(body)))
+		self.end_headers()
+		self.wfile.write(body)
+
+	def send_soap(self, code, body):
+		self.send_response(code)
+		self.send_header("Content-Type", "text/xml")
+		self.send_header("Content-Length", str(len(body)))
+		self.end_headers()
+		self.wfile.write(body)
+
+	def send_chunk(self, data):
+		self.wfile.write(("%x\r\n" % len(data)).encode("ascii") + data + b"\r\n")
+		self.wfile.flush()
+
+	def stream_events(self, params):
+		backend = self.server.backend
+		backend.check_session(params)
+
+		self.send_response(200)
+		self.send_header("Content-Type", "application/x-ndjson")
+		self.send_header("Transfer-Encoding", "chunked")
+		self.end_headers()
+
+		sequence = int(params.get("sequence", 0))
+		while True:
+			events = backend.get_events(sequence, WAIT_EVENT_TIMEOUT)
+			if not events:
+				break
+
+			for event in events:
+				self.send_chunk(json.dumps(event, separators=(",", ":")).encode("utf-8") + b"\n")
+				sequence = event["Sequence"]
+
+		self.send_chunk(b"")
+
+	def do_SOAP(self, body):
+		try:
+			method, params = parse_soap_request(body)
+		except (ValueError, ElementTree.ParseError):
+			self.send_soap(500, soap_response(None, fault=Fault("Client", "Invalid SOAP request")))
+			return
+
+		try:
+			if method == "streamBackendEvent":
+				self.stream_events(params)
+				return
+
+			result = self.server.backend.call(method, params)
+		except Fault as fault:
+			self.send_soap(500, soap_response(method, fault=fault))
+			return
+
+		self.send_soap(200, soap_response(method, result))
+
+	def do_POST(self):
+		backend = self.server.backend
+		length = int(self.headers.get("Content-Length", 0))
+		body = self.rfile.read(length)
+		if self.headers.get("Content-Type", "").startswith("text/xml"):
+			self.do_SOAP(body)
+			return
+
+		try:
+			request = json.loads(body.decode("utf-8"))
+		except ValueError:
+			self.send_json(500, { "Fault": { "Code": "Client", "String": "Invalid JSON request" } })
+			return
+
+		# Event injection
+		if self.path == "/event":
+			sequence = backend.add_event(request.get("Action"), request.get("Params", {}))
+			self.send_json(200, { "Return": sequence })
+			return
+
+		# Profile change
+		if self.path == "/profile":
+			self.send_json(200, { "Return": backend.change_profile(request.get("Key")) })
+			return
+
+		# Latency injection
+		if self.path == "/delay":
+			backend.delay = int(request.get("Delay", 0))
+			self.send_json(200, { "Return": backend.delay })
+			return
+
+		method = request.get("Method")
+		params = request.get("Params", {})
+		try:
+			if method == "streamBackendEvent":
+				self.stream_events(params)
+				return
+
+			result = backend.call(method, params)
+		except Fault as fault:
+			self.send_json(500, { "Fault": { "Code": fault.code, "String": fault.string } })
+			return
+
+		self.send_json(200, ({} if result is None else { "Return": result }))
+
+
+def main():
+	parser = argparse.ArgumentParser(description="SmartCAPWAP reference JSON Backend Server")
+	parser.add_argument("--address", default="127.0.0.1")
+	parser.add_argument("--port", type=int, default=8080)
+	parser.add_argument("--responses", help="JSON file with return value of WTP session methods")
+	parser.add_argument("--delay", type=int, default=0, help="latency in milliseconds added to every call")
+	parser.add_argument("--verbose", action="store_true")
+	args = parser.parse_args()
+
+	responses = {}
+	if args.responses:
+		with open(args.responses) as fileresponses:
+			responses = json.load(fileresponses)
+
+	server = ThreadingHTTPServer((args.address, args.port), Handler)
+	server.daemon_threads = True
+	server.backend = Backend(responses, args.delay)
+	server.verbose = args.verbose
+	server.serve_forever()
+
+
+if __name__ == "__main__":
+	main()
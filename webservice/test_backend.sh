@@ -0,0 +1,57 @@
+#!/bin/bash
+#
+# Round trips of AC Backend transports against the reference Backend Server
+#
+# Starts jsonbackend.py on a local port and runs src/ac/bench/backend_check
+# with the JSON transport and with the XML SOAP transport. backend_check
+# encodes every call as the AC does and checks the decoded answers of
+# joinBackend, authorizeWTPSession, joinWTPSession, authorizeStation, of the
+# events delivered by streamBackendEvent and waitBackendEvent, of a fault and
+# of leaveBackend.
+#
+# Usage: test_backend.sh
+#
+# The environment variables are:
+#   BACKEND_CHECK  backend_check binary, otherwise it is built by make into
+#                  src/ac/bench after configure
+#   PORT           port of Backend Server (default 8083)
+#   PYTHON         python interpreter (default python3)
+
+WEBSERVICE_DIR="$(cd "$(dirname "$0")" && pwd)"
+BENCH_DIR="${WEBSERVICE_DIR}/../src/ac/bench"
+PYTHON="${PYTHON:-python3}"
+PORT="${PORT:-8083}"
+PID=""
+
+# */
+cleanup() {
+	if [ -n "${PID}" ]; then
+		kill "${PID}" 2>/dev/null
+		wait "${PID}" 2>/dev/null
+	fi
+}
+
+if [ -z "${BACKEND_CHECK}" ]; then
+	make -s -C "${BENCH_DIR}" backend_check || exit 1
+	BACKEND_CHECK="${BENCH_DIR}/backend_check"
+fi
+
+trap cleanup EXIT
+trap "exit 1" INT TERM
+
+# The stream of events is closed by backend_check while the server waits the next event, its errors are not shown
+"${PYTHON}" "${WEBSERVICE_DIR}/jsonbackend.py" --port "${PORT}" 2>/dev/null &
+PID=$!
+
+for i in $(seq 1 50); do
+	"${PYTHON}" -c "import socket, sys; socket.create_connection(('127.0.0.1', int(sys.argv[1])), 1).close()" "${PORT}" 2>/dev/null && break
+	sleep 0.1
+done
+
+RESULT=0
+for transport in "" "-x"; do
+	"${BACKEND_CHECK}" ${transport} "http://127.0.0.1:${PORT}/backend" || RESULT=1
+	echo
+done
+
+exit "${RESULT}"
@@ -0,0 +1,67 @@
+#!/bin/bash
+#
+# Circuit breaker of AC against two reference Backend Servers
+#
+# Starts two jsonbackend.py on local ports and runs src/ac/bench/health_bench
+# against them. health_bench injects the latency with POST /delay and checks
+# that the circuit of a slow Backend Server opens and the requests fail over
+# to the other one, that the probes close the circuit when it is fixed and
+# that the calls to a hung Backend Server end at the station deadline.
+#
+# Usage: test_health.sh [health_bench options]
+#
+# The environment variables are:
+#   HEALTH_BENCH  health_bench binary, otherwise it is built by make into
+#                 src/ac/bench after configure
+#   PORT          port of first Backend Server, the second one uses PORT + 1
+#                 (default 8081)
+#   PYTHON        python interpreter (default python3)
+
+WEBSERVICE_DIR="$(cd "$(dirname "$0")" && pwd)"
+BENCH_DIR="${WEBSERVICE_DIR}/../src/ac/bench"
+PYTHON="${PYTHON:-python3}"
+PORT="${PORT:-8081}"
+PIDS=()
+
+# */
+cleanup() {
+	local pid
+
+	for pid in "${PIDS[@]}"; do
+		kill "${pid}" 2>/dev/null
+		wait "${pid}" 2>/dev/null
+	done
+}
+
+# Usage: wait_backend port
+wait_backend() {
+	local i
+
+	for i in $(seq 1 50); do
+		if "${PYTHON}" -c "import socket, sys; socket.create_connection(('127.0.0.1', int(sys.argv[1])), 1).close()" "$1" 2>/dev/null; then
+			return 0
+		fi
+
+		sleep 0.1
+	done
+
+	echo "Backend Server on port $1 not started" >&2
+	return 1
+}
+
+if [ -z "${HEALTH_BENCH}" ]; then
+	make -s -C "${BENCH_DIR}" health_bench || exit 1
+	HEALTH_BENCH="${BENCH_DIR}/health_bench"
+fi
+
+trap cleanup EXIT
+trap "exit 1" INT TERM
+
+# The answers of hung Backend Server after the deadline fail with broken pipe, the errors are not shown
+for port in "${PORT}" "$((PORT + 1))"; do
+	"${PYTHON}" "${WEBSERVICE_DIR}/jsonbackend.py" --port "${port}" 2>/dev/null &
+	PIDS+=($!)
+	wait_backend "${port}" || exit 1
+done
+
+"${HEALTH_BENCH}" "$@" "http://127.0.0.1:${PORT}/backend" "http://127.0.0.1:$((PORT + 1))/backend"